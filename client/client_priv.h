@@ -92,6 +92,9 @@ enum options_client
   OPT_REPORT_PROGRESS,
   OPT_SKIP_ANNOTATE_ROWS_EVENTS,
   OPT_SSL_CRL, OPT_SSL_CRLPATH,
+  OPT_MYSQLDUMP_PARALLEL, OPT_MYSQLDUMP_CHUNK_ROWS,
+  OPT_SLAP_JSON, OPT_SLAP_RATE, OPT_SLAP_PREPARED_STATEMENTS,
+  OPT_SLAP_AUTO_GENERATE_READ_PERCENT,
   OPT_MAX_CLIENT_OPTION /* should be always the last */
 };
 
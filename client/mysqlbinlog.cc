@@ -121,6 +121,9 @@ static short binlog_flags = 0;
 static MYSQL* mysql = NULL;
 static const char* dirname_for_local_load= 0;
 static bool opt_skip_annotate_row_events= 0;
+static my_bool opt_gtid_domain_split= 0;
+static uint opt_decode_threads= 0;
+static char *result_file_name= 0;
 
 /**
   Pointer to the Format_description_log_event of the currently active binlog.
@@ -142,26 +145,59 @@ enum Exit_status {
   OK_STOP
 };
 
+struct Decode_thread;
+
 /**
-  Pointer to the last read Annotate_rows_log_event. Having read an
-  Annotate_rows event, we should not print it immediatedly because all
-  subsequent rbr events can be filtered away, and have to keep it for a while.
-  Also because of that when reading a remote Annotate event we have to keep
-  its binary log representation in a separately allocated buffer.
+  A stream of printed events, with the state kept between the events
+  printed into it.
+
+  Normally there is one, for result_file.  With --gtid-domain-split
+  there is one per GTID replication domain, each written to its own
+  file.
 */
-static Annotate_rows_log_event *annotate_event= NULL;
+struct Event_output
+{
+  FILE *file;
+  PRINT_EVENT_INFO print_event_info;
+  /*
+    The Format_description_log_event of the binlog the events printed
+    last were read from.  The reading thread keeps its own copy in
+    glob_description_event.
+  */
+  Format_description_log_event *description_event;
+  /*
+    The last read Annotate_rows_log_event. Having read an Annotate_rows
+    event, we should not print it immediatedly because all subsequent rbr
+    events can be filtered away, and have to keep it for a while. Also
+    because of that when reading a remote Annotate event we have to keep
+    its binary log representation in a separately allocated buffer.
+  */
+  Annotate_rows_log_event *annotate_event;
+  uint32 domain_id;
+  /* The thread printing the events, or NULL to print while reading. */
+  Decode_thread *thread;
+
+  Event_output(FILE *file_arg)
+    :file(file_arg), description_event(NULL), annotate_event(NULL),
+     domain_id(0), thread(NULL)
+  {}
+};
 
-void free_annotate_event()
+void free_annotate_event(Event_output *out)
 {
-  if (annotate_event)
+  if (out->annotate_event)
   {
-    delete annotate_event;
-    annotate_event= 0;
+    delete out->annotate_event;
+    out->annotate_event= 0;
   }
 }
 
-Log_event* read_remote_annotate_event(uchar* net_buf, ulong event_len,
-                                      const char **error_msg)
+/**
+  Construct an event from a packet read from the server, in a buffer
+  of its own so that it outlives the packet.
+*/
+Log_event* read_remote_event_copy(uchar* net_buf, ulong event_len,
+                                  const char **error_msg)
 {
   uchar *event_buf;
   Log_event* event;
@@ -191,24 +227,24 @@ Log_event* read_remote_annotate_event(uchar* net_buf, ulong event_len,
   return event;
 }
 
-void keep_annotate_event(Annotate_rows_log_event* event)
+void keep_annotate_event(Event_output *out, Annotate_rows_log_event* event)
 {
-  free_annotate_event();
-  annotate_event= event;
+  free_annotate_event(out);
+  out->annotate_event= event;
 }
 
-void print_annotate_event(PRINT_EVENT_INFO *print_event_info)
+void print_annotate_event(Event_output *out)
 {
-  if (annotate_event)
+  if (out->annotate_event)
   {
-    annotate_event->print(result_file, print_event_info);
-    delete annotate_event;  // the event should not be printed more than once
-    annotate_event= 0;
+    out->annotate_event->print(out->file, &out->print_event_info);
+    delete out->annotate_event;  // the event should not be printed more than once
+    out->annotate_event= 0;
   }
 }
 
-static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *, const char*);
-static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *, const char*);
+static Exit_status dump_local_log_entries(Event_output *, const char*);
+static Exit_status dump_remote_log_entries(Event_output *, const char*);
 static Exit_status dump_log_entries(const char* logname);
 static Exit_status safe_connect();
 
@@ -241,6 +277,11 @@ class Load_log_processor
     library data structures for this. /Sven
   */
   DYNAMIC_ARRAY file_names;
+  /*
+    Protects file_names: with --decode-threads, the LOAD DATA events of
+    different GTID domains are printed by different threads.
+  */
+  pthread_mutex_t lock;
 
   /**
     Looks for a non-existing filename by adding a numerical suffix to
@@ -277,6 +318,7 @@ public:
 
   int init()
   {
+    pthread_mutex_init(&lock, NULL);
     return my_init_dynamic_array(&file_names, sizeof(File_name_record),
                                  100, 100, MYF(0));
   }
@@ -307,6 +349,7 @@ public:
     }
 
     delete_dynamic(&file_names);
+    pthread_mutex_destroy(&lock);
   }
 
   /**
@@ -327,13 +370,16 @@ public:
   Create_file_log_event *grab_event(uint file_id)
     {
       File_name_record *ptr;
-      Create_file_log_event *res;
+      Create_file_log_event *res= 0;
 
-      if (file_id >= file_names.elements)
-        return 0;
-      ptr= dynamic_element(&file_names, file_id, File_name_record*);
-      if ((res= ptr->event))
-        bzero((char *)ptr, sizeof(File_name_record));
+      pthread_mutex_lock(&lock);
+      if (file_id < file_names.elements)
+      {
+        ptr= dynamic_element(&file_names, file_id, File_name_record*);
+        if ((res= ptr->event))
+          bzero((char *)ptr, sizeof(File_name_record));
+      }
+      pthread_mutex_unlock(&lock);
       return res;
     }
 
@@ -357,14 +403,17 @@ public:
       File_name_record *ptr;
       char *res= 0;
 
-      if (file_id >= file_names.elements)
-        return 0;
-      ptr= dynamic_element(&file_names, file_id, File_name_record*);
-      if (!ptr->event)
+      pthread_mutex_lock(&lock);
+      if (file_id < file_names.elements)
       {
-        res= ptr->fname;
-        bzero((char *)ptr, sizeof(File_name_record));
+        ptr= dynamic_element(&file_names, file_id, File_name_record*);
+        if (!ptr->event)
+        {
+          res= ptr->fname;
+          bzero((char *)ptr, sizeof(File_name_record));
+        }
       }
+      pthread_mutex_unlock(&lock);
       return res;
     }
   Exit_status process(Create_file_log_event *ce);
@@ -542,7 +591,10 @@ Exit_status Load_log_processor::process_first_event(const char *bname,
      after Execute_load_query_log_event or Execute_load_log_event
      will have been processed, otherwise in Load_log_processor::destroy()
   */
-  if (set_dynamic(&file_names, (uchar*)&rec, file_id))
+  pthread_mutex_lock(&lock);
+  bool set_failed= set_dynamic(&file_names, (uchar*)&rec, file_id);
+  pthread_mutex_unlock(&lock);
+  if (set_failed)
   {
     error("Out of memory.");
     my_free(fname);
@@ -629,9 +681,11 @@ Exit_status Load_log_processor::process(Begin_load_query_log_event *blqe)
 Exit_status Load_log_processor::process(Append_block_log_event *ae)
 {
   DBUG_ENTER("Load_log_processor::process");
+  pthread_mutex_lock(&lock);
   const char* fname= ((ae->file_id < file_names.elements) ?
                        dynamic_element(&file_names, ae->file_id,
                                        File_name_record*)->fname : 0);
+  pthread_mutex_unlock(&lock);
 
   if (fname)
   {
@@ -721,8 +775,9 @@ static bool shall_skip_database(const char *log_dbname)
 */
 
 static void
-print_use_stmt(PRINT_EVENT_INFO* pinfo, const Query_log_event *ev)
+print_use_stmt(Event_output *out, const Query_log_event *ev)
 {
+  PRINT_EVENT_INFO *pinfo= &out->print_event_info;
   const char* db= ev->db;
   const size_t db_len= ev->db_len;
 
@@ -745,7 +800,7 @@ print_use_stmt(PRINT_EVENT_INFO* pinfo, const Query_log_event *ev)
     return;
 
   // In case of rewrite rule print USE statement for db_to
-  my_fprintf(result_file, "use %`s%s\n", db_to, pinfo->delimiter);
+  my_fprintf(out->file, "use %`s%s\n", db_to, pinfo->delimiter);
 
   // Copy the *original* db to pinfo to suppress emiting
   // of USE stmts by log_event print-functions.
@@ -766,14 +821,15 @@ print_use_stmt(PRINT_EVENT_INFO* pinfo, const Query_log_event *ev)
    statement when it changes.
 */
 static void
-print_skip_replication_statement(PRINT_EVENT_INFO *pinfo, const Log_event *ev)
+print_skip_replication_statement(Event_output *out, const Log_event *ev)
 {
+  PRINT_EVENT_INFO *pinfo= &out->print_event_info;
   int cur_val;
 
   cur_val= (ev->flags & LOG_EVENT_SKIP_REPLICATION_F) != 0;
   if (cur_val == pinfo->skip_replication)
     return;                                     /* Not changed. */
-  fprintf(result_file, "/*!50521 SET skip_replication=%d*/%s\n",
+  fprintf(out->file, "/*!50521 SET skip_replication=%d*/%s\n",
           cur_val, pinfo->delimiter);
   pinfo->skip_replication= cur_val;
 }
@@ -817,8 +873,10 @@ write_event_header_and_base64(Log_event *ev, FILE *result_file,
 }
 
 
-static bool print_base64(PRINT_EVENT_INFO *print_event_info, Log_event *ev)
+static bool print_base64(Event_output *out, Log_event *ev)
 {
+  PRINT_EVENT_INFO *print_event_info= &out->print_event_info;
+
   /*
     These events must be printed in base64 format, if printed.
     base64 format requires a FD event to be safe, so if no FD
@@ -842,14 +900,15 @@ static bool print_base64(PRINT_EVENT_INFO *print_event_info, Log_event *ev)
             type_str);
     return 1;
   }
-  ev->print(result_file, print_event_info);
+  ev->print(out->file, print_event_info);
   return print_event_info->head_cache.error == -1;
 }
 
 
-static bool print_row_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
+static bool print_row_event(Event_output *out, Log_event *ev,
                             ulong table_id, bool is_stmt_end)
 {
+  PRINT_EVENT_INFO *print_event_info= &out->print_event_info;
   Table_map_log_event *ignored_map= 
     print_event_info->m_table_map_ignored.get_table(table_id);
   bool skip_event= (ignored_map != NULL);
@@ -877,49 +936,808 @@ static bool print_row_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
       rbr-events were filtered away, the Annotate event was not
       freed and it is just the time to do it.
     */
-      free_annotate_event();
+      free_annotate_event(out);
+
+    /* 
+       One needs to take into account an event that gets
+       filtered but was last event in the statement. If this is
+       the case, previous rows events that were written into
+       IO_CACHEs still need to be copied from cache to
+       result_file (as it would happen in ev->print(...) if
+       event was not skipped).
+    */
+    if (skip_event)
+    {
+      // append END-MARKER(') with delimiter
+      IO_CACHE *const body_cache= &print_event_info->body_cache;
+      if (my_b_tell(body_cache))
+        my_b_printf(body_cache, "'%s\n", print_event_info->delimiter);
+
+      // flush cache
+      if ((copy_event_cache_to_file_and_reinit(&print_event_info->head_cache, out->file) ||
+          copy_event_cache_to_file_and_reinit(&print_event_info->body_cache, out->file)))
+        return 1;
+    }
+  }
+
+  /* skip the event check */
+  if (skip_event)
+    return 0;
+
+  return print_base64(out, ev);
+}
+
+
+/**
+  Print the given event, and either delete it or delegate the deletion
+  to someone else.
+
+  The deletion may be delegated in two cases: (1) the event is a
+  Format_description_log_event, which is owned by the reading thread
+  (see set_description_event()); (2) the event is a
+  Create_file_log_event, and is saved in load_processor.
+
+  @param[in,out] out Where to print the event, and the context state
+  determining how to print.
+  @param[in] ev Log_event to print.
+  @param[in] pos Offset from beginning of binlog file.
+
+  @retval ERROR_STOP An error occurred - the program should terminate.
+  @retval OK_CONTINUE No error, the program should continue.
+*/
+static Exit_status print_event(Event_output *out, Log_event *ev, my_off_t pos)
+{
+  char ll_buff[21];
+  Log_event_type ev_type= ev->get_type_code();
+  my_bool destroy_evt= TRUE;
+  DBUG_ENTER("print_event");
+  PRINT_EVENT_INFO *print_event_info= &out->print_event_info;
+  print_event_info->short_form= short_form;
+  Exit_status retval= OK_CONTINUE;
+  IO_CACHE *const head= &print_event_info->head_cache;
+
+  if (!short_form)
+    fprintf(out->file, "# at %s\n",llstr(pos,ll_buff));
+
+  if (!opt_hexdump)
+    print_event_info->hexdump_from= 0; /* Disabled */
+  else
+    print_event_info->hexdump_from= pos;
+
+  print_event_info->base64_output_mode= opt_base64_output_mode;
+
+  DBUG_PRINT("debug", ("event_type: %s", ev->get_type_str()));
+
+  switch (ev_type) {
+  case QUERY_EVENT:
+  {
+    Query_log_event *qe= (Query_log_event*)ev;
+    if (!qe->is_trans_keyword())
+    {
+      if (shall_skip_database(qe->db))
+        goto end;
+    }
+    else
+    {
+      /*
+        In case the event for one of these statements is obtained
+        from binary log 5.0, make it compatible with 5.1
+      */
+      qe->flags|= LOG_EVENT_SUPPRESS_USE_F;
+    }
+    print_use_stmt(out, qe);
+    if (opt_base64_output_mode == BASE64_OUTPUT_ALWAYS)
+    {
+      if ((retval= write_event_header_and_base64(ev, out->file,
+                                                 print_event_info)) !=
+          OK_CONTINUE)
+        goto end;
+    }
+    else
+    {
+      print_skip_replication_statement(out, ev);
+      ev->print(out->file, print_event_info);
+    }
+    if (head->error == -1)
+      goto err;
+    break;
+  }
+
+  case CREATE_FILE_EVENT:
+  {
+    Create_file_log_event* ce= (Create_file_log_event*)ev;
+    /*
+      We test if this event has to be ignored. If yes, we don't save
+      this event; this will have the good side-effect of ignoring all
+      related Append_block and Exec_load.
+      Note that Load event from 3.23 is not tested.
+    */
+    if (shall_skip_database(ce->db))
+      goto end;                // Next event
+    /*
+      We print the event, but with a leading '#': this is just to inform 
+      the user of the original command; the command we want to execute 
+      will be a derivation of this original command (we will change the 
+      filename and use LOCAL), prepared in the 'case EXEC_LOAD_EVENT' 
+      below.
+    */
+    if (opt_base64_output_mode == BASE64_OUTPUT_ALWAYS)
+    {
+      if ((retval= write_event_header_and_base64(ce, out->file,
+                                                 print_event_info)) !=
+          OK_CONTINUE)
+        goto end;
+    }
+    else
+    {
+      print_skip_replication_statement(out, ev);
+      ce->print(out->file, print_event_info, TRUE);
+      if (head->error == -1)
+        goto err;
+    }
+    // If this binlog is not 3.23 ; why this test??
+    if (out->description_event->binlog_version >= 3)
+    {
+      /*
+        transfer the responsibility for destroying the event to
+        load_processor
+      */
+      ev= NULL;
+      if ((retval= load_processor.process(ce)) != OK_CONTINUE)
+        goto end;
+    }
+    break;
+  }
+
+  case APPEND_BLOCK_EVENT:
+    /*
+      Append_block_log_events can safely print themselves even if
+      the subsequent call load_processor.process fails, because the
+      output of Append_block_log_event::print is only a comment.
+    */
+    ev->print(out->file, print_event_info);
+    if (head->error == -1)
+      goto err;
+    if ((retval= load_processor.process((Append_block_log_event*) ev)) !=
+        OK_CONTINUE)
+      goto end;
+    break;
+
+  case EXEC_LOAD_EVENT:
+  {
+    ev->print(out->file, print_event_info);
+    if (head->error == -1)
+      goto err;
+    Execute_load_log_event *exv= (Execute_load_log_event*)ev;
+    Create_file_log_event *ce= load_processor.grab_event(exv->file_id);
+    /*
+      if ce is 0, it probably means that we have not seen the Create_file
+      event (a bad binlog, or most probably --start-position is after the
+      Create_file event). Print a warning comment.
+    */
+    if (ce)
+    {
+      /*
+        We must not convert earlier, since the file is used by
+        my_open() in Load_log_processor::append().
+      */
+      convert_path_to_forward_slashes((char*) ce->fname);
+      ce->print(out->file, print_event_info, TRUE);
+      my_free((void*)ce->fname);
+      delete ce;
+      if (head->error == -1)
+        goto err;
+    }
+    else
+      warning("Ignoring Execute_load_log_event as there is no "
+              "Create_file event for file_id: %u", exv->file_id);
+    break;
+  }
+  case FORMAT_DESCRIPTION_EVENT:
+    print_event_info->common_header_len=
+      ((Format_description_log_event*) ev)->common_header_len;
+    ev->print(out->file, print_event_info);
+    if (head->error == -1)
+      goto err;
+    /*
+      The event is not ours to delete: it is glob_description_event, or
+      was until the next binlog was read (see set_description_event()).
+    */
+    ev= 0;
+    break;
+  case BEGIN_LOAD_QUERY_EVENT:
+    ev->print(out->file, print_event_info);
+    if (head->error == -1)
+      goto err;
+    if ((retval= load_processor.process((Begin_load_query_log_event*) ev)) !=
+        OK_CONTINUE)
+      goto end;
+    break;
+  case EXECUTE_LOAD_QUERY_EVENT:
+  {
+    Execute_load_query_log_event *exlq= (Execute_load_query_log_event*)ev;
+    char *fname= load_processor.grab_fname(exlq->file_id);
+
+    if (!shall_skip_database(exlq->db))
+    {
+      print_use_stmt(out, exlq);
+      if (fname)
+      {
+        convert_path_to_forward_slashes(fname);
+        print_skip_replication_statement(out, ev);
+        exlq->print(out->file, print_event_info, fname);
+        if (head->error == -1)
+        {
+          if (fname)
+            my_free(fname);
+          goto err;
+        }
+      }
+      else
+        warning("Ignoring Execute_load_query since there is no "
+                "Begin_load_query event for file_id: %u", exlq->file_id);
+    }
+
+    if (fname)
+      my_free(fname);
+    break;
+  }
+  case ANNOTATE_ROWS_EVENT:
+    if (!opt_skip_annotate_row_events)
+    {
+      /*
+        We don't print Annotate event just now because all subsequent
+        rbr-events can be filtered away. Instead we'll keep the event
+        till it will be printed together with the first not filtered
+        away Table map or the last rbr will be processed.
+      */
+      keep_annotate_event(out, (Annotate_rows_log_event*) ev);
+      destroy_evt= FALSE;
+    }
+    break;
+  case TABLE_MAP_EVENT:
+  {
+    Table_map_log_event *map= ((Table_map_log_event *)ev);
+    if (shall_skip_database(map->get_db_name()))
+    {
+      print_event_info->m_table_map_ignored.set_table(map->get_table_id(), map);
+      destroy_evt= FALSE;
+      goto end;
+    }
+    /*
+      The Table map is to be printed, so it's just the time when we may
+      print the kept Annotate event (if there is any).
+      print_annotate_event() also deletes the kept Annotate event.
+    */
+    print_annotate_event(out);
+
+    size_t len_to= 0;
+    const char* db_to= binlog_filter->get_rewrite_db(map->get_db_name(), &len_to);
+    if (len_to && map->rewrite_db(db_to, len_to, out->description_event))
+    {
+      error("Could not rewrite database name");
+      goto err;
+    }
+    if (print_base64(out, ev))
+      goto err;
+    break;
+  }
+  case WRITE_ROWS_EVENT:
+  case DELETE_ROWS_EVENT:
+  case UPDATE_ROWS_EVENT:
+  {
+    Rows_log_event *e= (Rows_log_event*) ev;
+    if (print_row_event(out, ev, e->get_table_id(),
+                        e->get_flags(Rows_log_event::STMT_END_F)))
+      goto err;
+    break;
+  }
+  case PRE_GA_WRITE_ROWS_EVENT:
+  case PRE_GA_DELETE_ROWS_EVENT:
+  case PRE_GA_UPDATE_ROWS_EVENT:
+  {
+    Old_rows_log_event *e= (Old_rows_log_event*) ev;
+    if (print_row_event(out, ev, e->get_table_id(),
+                        e->get_flags(Old_rows_log_event::STMT_END_F)))
+      goto err;
+    break;
+  }
+  default:
+    print_skip_replication_statement(out, ev);
+    ev->print(out->file, print_event_info);
+    if (head->error == -1)
+      goto err;
+  }
+  goto end;
+
+err:
+  retval= ERROR_STOP;
+end:
+  /*
+    Destroy the log_event object. 
+    MariaDB MWL#36: mainline does this:
+      If reading from a remote host,
+      set the temp_buf to NULL so that memory isn't freed twice.
+    We no longer do that, we use Rpl_filter::event_owns_temp_buf instead.
+  */
+  if (ev)
+  {
+    if (destroy_evt) /* destroy it later if not set (ignored table map) */
+      delete ev;
+  }
+  DBUG_RETURN(retval);
+}
+
+
+/*
+  With --decode-threads, events are printed by a pool of threads while
+  the main thread goes on reading the binlog.  Each Event_output is
+  printed by one thread, so the events of an output stay in binlog
+  order.
+*/
+
+/** An event waiting to be printed by a Decode_thread. */
+struct Queued_event
+{
+  Event_output *out;
+  Log_event *ev;
+  my_off_t pos;
+  /* The Format_description_log_event the event was read with. */
+  Format_description_log_event *description_event;
+  Queued_event *next;
+};
+
+struct Decode_thread
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  /* Signalled when events are queued or printed, and on stop. */
+  pthread_cond_t cond;
+  Queued_event *first, *last;
+  uint queued;
+  /* The thread is printing an event that is no longer in the queue. */
+  bool busy;
+  bool stop;
+  /* ERROR_STOP once printing an event failed; later events are dropped. */
+  Exit_status status;
+};
+
+/*
+  How many events the reading thread may be ahead of a Decode_thread.
+  This bounds the memory used when printing is slower than reading.
+*/
+#define DECODE_QUEUE_MAX_EVENTS 1000
+
+static Decode_thread *decode_threads= NULL;
+/*
+  Format_description_log_events replaced while events read with them
+  could still be waiting in a queue.  They are deleted at the end.
+*/
+static DYNAMIC_ARRAY old_description_events;
+
+pthread_handler_t decode_thread_main(void *arg)
+{
+  Decode_thread *t= (Decode_thread *) arg;
+  Queued_event *qe;
+
+  my_thread_init();
+  pthread_mutex_lock(&t->lock);
+  for (;;)
+  {
+    while (!(qe= t->first) && !t->stop)
+      pthread_cond_wait(&t->cond, &t->lock);
+    if (!qe)
+      break;
+    if (!(t->first= qe->next))
+      t->last= NULL;
+    t->queued--;
+    t->busy= true;
+    Exit_status status= t->status;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+
+    if (status == OK_CONTINUE)
+    {
+      qe->out->description_event= qe->description_event;
+      status= print_event(qe->out, qe->ev, qe->pos);
+    }
+    else if (qe->ev->get_type_code() != FORMAT_DESCRIPTION_EVENT)
+      delete qe->ev;
+    my_free(qe);
+
+    pthread_mutex_lock(&t->lock);
+    t->status= status;
+    t->busy= false;
+    pthread_cond_broadcast(&t->cond);
+  }
+  pthread_mutex_unlock(&t->lock);
+  my_thread_end();
+  pthread_exit(0);
+  return 0;
+}
+
+
+/**
+  Hand an event over to the thread printing an output.  Waits while the
+  thread has DECODE_QUEUE_MAX_EVENTS events to print already.
+
+  @retval ERROR_STOP The thread failed to print an earlier event.
+  @retval OK_CONTINUE No error, the program should continue.
+*/
+static Exit_status queue_event(Event_output *out, Log_event *ev,
+                               my_off_t pos)
+{
+  Decode_thread *t= out->thread;
+  Queued_event *qe;
+  Exit_status status;
+
+  if (!(qe= (Queued_event *) my_malloc(sizeof(Queued_event), MYF(MY_WME))))
+  {
+    error("Out of memory.");
+    if (ev->get_type_code() != FORMAT_DESCRIPTION_EVENT)
+      delete ev;
+    return ERROR_STOP;
+  }
+  qe->out= out;
+  qe->ev= ev;
+  qe->pos= pos;
+  qe->description_event= glob_description_event;
+  qe->next= NULL;
+
+  pthread_mutex_lock(&t->lock);
+  while (t->queued >= DECODE_QUEUE_MAX_EVENTS && t->status == OK_CONTINUE)
+    pthread_cond_wait(&t->cond, &t->lock);
+  if ((status= t->status) == OK_CONTINUE)
+  {
+    if (t->last)
+      t->last->next= qe;
+    else
+      t->first= qe;
+    t->last= qe;
+    t->queued++;
+    pthread_cond_broadcast(&t->cond);
+  }
+  pthread_mutex_unlock(&t->lock);
+
+  if (status != OK_CONTINUE)
+  {
+    if (ev->get_type_code() != FORMAT_DESCRIPTION_EVENT)
+      delete ev;
+    my_free(qe);
+  }
+  return status;
+}
+
+
+/**
+  Wait until a Decode_thread has printed all the events queued for it.
+
+  @retval ERROR_STOP The thread failed to print an event.
+  @retval OK_CONTINUE No error, the program should continue.
+*/
+static Exit_status wait_for_decode_thread(Decode_thread *t)
+{
+  Exit_status status;
+
+  pthread_mutex_lock(&t->lock);
+  while (t->first || t->busy)
+    pthread_cond_wait(&t->cond, &t->lock);
+  status= t->status;
+  pthread_mutex_unlock(&t->lock);
+  return status;
+}
+
+
+static Exit_status start_decode_threads()
+{
+  if (my_init_dynamic_array(&old_description_events,
+                            sizeof(Format_description_log_event *),
+                            16, 16, MYF(0)) ||
+      !(decode_threads= (Decode_thread *)
+        my_malloc(opt_decode_threads * sizeof(Decode_thread),
+                  MYF(MY_WME | MY_ZEROFILL))))
+  {
+    error("Out of memory.");
+    return ERROR_STOP;
+  }
+  for (uint i= 0; i < opt_decode_threads; i++)
+  {
+    Decode_thread *t= decode_threads + i;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+    t->status= OK_CONTINUE;
+    if (pthread_create(&t->thread, NULL, decode_thread_main, t))
+    {
+      error("Could not create decoding thread (errno %d).", errno);
+      pthread_cond_destroy(&t->cond);
+      pthread_mutex_destroy(&t->lock);
+      opt_decode_threads= i;
+      return ERROR_STOP;
+    }
+  }
+  return OK_CONTINUE;
+}
+
+
+static void stop_decode_threads()
+{
+  if (!decode_threads)
+    return;
+  for (uint i= 0; i < opt_decode_threads; i++)
+  {
+    Decode_thread *t= decode_threads + i;
+    pthread_mutex_lock(&t->lock);
+    t->stop= true;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->lock);
+  }
+  my_free(decode_threads);
+  decode_threads= NULL;
+
+  for (uint i= 0; i < old_description_events.elements; i++)
+    delete *dynamic_element(&old_description_events, i,
+                            Format_description_log_event **);
+  delete_dynamic(&old_description_events);
+}
+
+
+/**
+  Print an event into an output, or have it printed by the thread of
+  the output.  Takes over the event like print_event().
+*/
+static Exit_status output_event(Event_output *out, Log_event *ev,
+                                my_off_t pos)
+{
+  if (out->thread)
+    return queue_event(out, ev, pos);
+  out->description_event= glob_description_event;
+  return print_event(out, ev, pos);
+}
+
+
+/** The statements that start the output of mysqlbinlog. */
+static void print_output_header(FILE *file)
+{
+  fprintf(file, "/*!50530 SET @@SESSION.PSEUDO_SLAVE_MODE=1*/;\n");
+
+  fprintf(file,
+	  "/*!40019 SET @@session.max_insert_delayed_threads=0*/;\n");
+
+  if (disable_log_bin)
+    fprintf(file,
+            "/*!32316 SET @OLD_SQL_LOG_BIN=@@SQL_LOG_BIN, SQL_LOG_BIN=0*/;\n");
+
+  /*
+    In mysqlbinlog|mysql, don't want mysql to be disconnected after each
+    transaction (which would be the case with GLOBAL.COMPLETION_TYPE==2).
+  */
+  fprintf(file,
+          "/*!50003 SET @OLD_COMPLETION_TYPE=@@COMPLETION_TYPE,"
+          "COMPLETION_TYPE=0*/;\n");
+
+  if (charset)
+    fprintf(file,
+            "\n/*!40101 SET @OLD_CHARACTER_SET_CLIENT=@@CHARACTER_SET_CLIENT */;"
+            "\n/*!40101 SET @OLD_CHARACTER_SET_RESULTS=@@CHARACTER_SET_RESULTS */;"
+            "\n/*!40101 SET @OLD_COLLATION_CONNECTION=@@COLLATION_CONNECTION */;"  
+            "\n/*!40101 SET NAMES %s */;\n", charset);
+}
+
+
+/** The statements that end the output of mysqlbinlog. */
+static void print_output_footer(FILE *file)
+{
+  /*
+    Issue a ROLLBACK in case the last printed binlog was crashed and had half
+    of transaction.
+  */
+  fprintf(file,
+          "# End of log file\nROLLBACK /* added by mysqlbinlog */;\n"
+          "/*!50003 SET COMPLETION_TYPE=@OLD_COMPLETION_TYPE*/;\n");
+  if (disable_log_bin)
+    fprintf(file, "/*!32316 SET SQL_LOG_BIN=@OLD_SQL_LOG_BIN*/;\n");
+
+  if (charset)
+    fprintf(file,
+            "/*!40101 SET CHARACTER_SET_CLIENT=@OLD_CHARACTER_SET_CLIENT */;\n"
+            "/*!40101 SET CHARACTER_SET_RESULTS=@OLD_CHARACTER_SET_RESULTS */;\n"
+            "/*!40101 SET COLLATION_CONNECTION=@OLD_COLLATION_CONNECTION */;\n");
+
+  fprintf(file, "/*!50530 SET @@SESSION.PSEUDO_SLAVE_MODE=0*/;\n");
+}
+
+
+/**
+  Prepare an output for printing the events of one or more binlogs.
+  Sets a safe delimiter, to dump things like CREATE PROCEDURE safely.
+*/
+static void open_event_output(Event_output *out)
+{
+  fprintf(out->file, "DELIMITER /*!*/;\n");
+  strmov(out->print_event_info.delimiter, "/*!*/;");
+  out->print_event_info.verbose= short_form ? 0 : verbose;
+}
+
+
+/**
+  Wait until all events of an output are printed, and set the
+  delimiter back to semicolon.
+*/
+static Exit_status close_event_output(Event_output *out)
+{
+  Exit_status status= OK_CONTINUE;
+
+  if (out->thread)
+    status= wait_for_decode_thread(out->thread);
+  free_annotate_event(out);
+  fprintf(out->file, "DELIMITER ;\n");
+  strmov(out->print_event_info.delimiter, ";");
+  return status;
+}
+
+
+/*
+  With --gtid-domain-split, the events of each GTID replication domain
+  are printed into a file of their own, result_file_name.<domain_id>.
+  Event groups of different domains do not depend on each other, so
+  these files can be applied to a server in parallel.
+*/
+
+/* The outputs of the domains seen so far, Event_output pointers. */
+static DYNAMIC_ARRAY domain_outputs;
+/* The output of the domain of the last GTID event read. */
+static Event_output *cur_domain_output= NULL;
+/*
+  Whether and where glob_description_event was printed, so that it can
+  be printed into the output of a domain seen later.
+*/
+static bool description_event_printed= false;
+static my_off_t description_event_pos= 0;
+
+
+static Event_output *get_domain_output(uint32 domain_id)
+{
+  Event_output *out;
+  FILE *file;
+  char name[FN_REFLEN];
+
+  for (uint i= 0; i < domain_outputs.elements; i++)
+  {
+    out= *dynamic_element(&domain_outputs, i, Event_output **);
+    if (out->domain_id == domain_id)
+      return out;
+  }
+
+  my_snprintf(name, sizeof(name), "%s.%u", result_file_name, domain_id);
+  if (!(file= my_fopen(name, O_WRONLY | O_BINARY, MYF(MY_WME))))
+    return NULL;
+  if (!(out= new Event_output(file)) || !out->print_event_info.init_ok() ||
+      insert_dynamic(&domain_outputs, (uchar *) &out))
+  {
+    error("Out of memory.");
+    delete out;
+    my_fclose(file, MYF(0));
+    return NULL;
+  }
+  out->domain_id= domain_id;
+  if (decode_threads)
+    out->thread= decode_threads +
+                 (domain_outputs.elements - 1) % opt_decode_threads;
+
+  print_output_header(file);
+  open_event_output(out);
+  if (description_event_printed &&
+      output_event(out, glob_description_event, description_event_pos))
+    return NULL;
+  return out;
+}
+
+
+static Exit_status close_domain_outputs()
+{
+  Exit_status retval= OK_CONTINUE;
+
+  for (uint i= 0; i < domain_outputs.elements; i++)
+  {
+    Event_output *out= *dynamic_element(&domain_outputs, i, Event_output **);
+    if (close_event_output(out) != OK_CONTINUE)
+      retval= ERROR_STOP;
+    print_output_footer(out->file);
+    my_fclose(out->file, MYF(0));
+    delete out;
+  }
+  delete_dynamic(&domain_outputs);
+  return retval;
+}
 
-    /* 
-       One needs to take into account an event that gets
-       filtered but was last event in the statement. If this is
-       the case, previous rows events that were written into
-       IO_CACHEs still need to be copied from cache to
-       result_file (as it would happen in ev->print(...) if
-       event was not skipped).
-    */
-    if (skip_event)
-    {
-      // append END-MARKER(') with delimiter
-      IO_CACHE *const body_cache= &print_event_info->body_cache;
-      if (my_b_tell(body_cache))
-        my_b_printf(body_cache, "'%s\n", print_event_info->delimiter);
 
-      // flush cache
-      if ((copy_event_cache_to_file_and_reinit(&print_event_info->head_cache, result_file) ||
-          copy_event_cache_to_file_and_reinit(&print_event_info->body_cache, result_file)))
-        return 1;
+/**
+  Print an event into the output of its GTID domain.  Takes over the
+  event like print_event().
+
+  An event belongs to the domain of the last GTID event read, or to
+  domain 0 if there was none.  The Format_description_log_event is
+  printed into every output, as the events that follow can not be
+  applied without it.  Other events that are not part of an event
+  group, and only print as comments, are dropped until a GTID event
+  has been read.
+*/
+static Exit_status split_event(Log_event *ev, my_off_t pos)
+{
+  Exit_status retval;
+
+  switch (ev->get_type_code()) {
+  case FORMAT_DESCRIPTION_EVENT:
+    description_event_printed= true;
+    description_event_pos= pos;
+    for (uint i= 0; i < domain_outputs.elements; i++)
+    {
+      Event_output *out= *dynamic_element(&domain_outputs, i, Event_output **);
+      if ((retval= output_event(out, ev, pos)) != OK_CONTINUE)
+        return retval;
+    }
+    return OK_CONTINUE;
+  case ROTATE_EVENT:
+  case STOP_EVENT:
+  case GTID_LIST_EVENT:
+  case BINLOG_CHECKPOINT_EVENT:
+    if (!cur_domain_output)
+    {
+      delete ev;
+      return OK_CONTINUE;
+    }
+    break;
+  case GTID_EVENT:
+    if (!(cur_domain_output=
+          get_domain_output(((Gtid_log_event *) ev)->domain_id)))
+    {
+      delete ev;
+      return ERROR_STOP;
+    }
+    break;
+  default:
+    if (!cur_domain_output && !(cur_domain_output= get_domain_output(0)))
+    {
+      delete ev;
+      return ERROR_STOP;
     }
   }
+  return output_event(cur_domain_output, ev, pos);
+}
 
-  /* skip the event check */
-  if (skip_event)
-    return 0;
 
-  return print_base64(print_event_info, ev);
+/**
+  Make a Format_description_log_event the one of the binlog being read.
+
+  With --decode-threads, events read with the previous one may still be
+  waiting to be printed, so that one is kept until the threads stop.
+*/
+static void set_description_event(Format_description_log_event *ev)
+{
+  if (!glob_description_event || !decode_threads ||
+      insert_dynamic(&old_description_events,
+                     (uchar *) &glob_description_event))
+  {
+    /* Out of memory: let the threads catch up instead. */
+    for (uint i= 0; decode_threads && i < opt_decode_threads; i++)
+      wait_for_decode_thread(decode_threads + i);
+    delete glob_description_event;
+  }
+  glob_description_event= ev;
+  description_event_printed= false;
 }
 
 
 /**
-  Print the given event, and either delete it or delegate the deletion
-  to someone else.
-
-  The deletion may be delegated in two cases: (1) the event is a
-  Format_description_log_event, and is saved in
-  glob_description_event; (2) the event is a Create_file_log_event,
-  and is saved in load_processor.
+  Process the given event: print it if it is in the range of events to
+  print, and delete it, or delegate the deletion like print_event().
+  A Format_description_log_event becomes glob_description_event.
 
-  @param[in,out] print_event_info Parameters and context state
-  determining how to print.
+  @param[in,out] output Where to print the event (not used with
+  --gtid-domain-split).
   @param[in] ev Log_event to process.
   @param[in] pos Offset from beginning of binlog file.
   @param[in] logname Name of input binlog.
@@ -929,16 +1747,12 @@ static bool print_row_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
   @retval OK_STOP No error, but the end of the specified range of
   events to process has been reached and the program should terminate.
 */
-Exit_status process_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
+Exit_status process_event(Event_output *output, Log_event *ev,
                           my_off_t pos, const char *logname)
 {
-  char ll_buff[21];
   Log_event_type ev_type= ev->get_type_code();
-  my_bool destroy_evt= TRUE;
   DBUG_ENTER("process_event");
-  print_event_info->short_form= short_form;
   Exit_status retval= OK_CONTINUE;
-  IO_CACHE *const head= &print_event_info->head_cache;
 
   /*
     Format events are not concerned by --offset and such, we always need to
@@ -976,169 +1790,22 @@ Exit_status process_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
       retval= OK_STOP;
       goto end;
     }
-    if (!short_form)
-      fprintf(result_file, "# at %s\n",llstr(pos,ll_buff));
-
-    if (!opt_hexdump)
-      print_event_info->hexdump_from= 0; /* Disabled */
-    else
-      print_event_info->hexdump_from= pos;
-
-    print_event_info->base64_output_mode= opt_base64_output_mode;
-
-    DBUG_PRINT("debug", ("event_type: %s", ev->get_type_str()));
-
-    switch (ev_type) {
-    case QUERY_EVENT:
-    {
-      Query_log_event *qe= (Query_log_event*)ev;
-      if (!qe->is_trans_keyword())
-      {
-        if (shall_skip_database(qe->db))
-          goto end;
-      }
-      else
-      {
-        /*
-          In case the event for one of these statements is obtained
-          from binary log 5.0, make it compatible with 5.1
-        */
-        qe->flags|= LOG_EVENT_SUPPRESS_USE_F;
-      }
-      print_use_stmt(print_event_info, qe);
-      if (opt_base64_output_mode == BASE64_OUTPUT_ALWAYS)
-      {
-        if ((retval= write_event_header_and_base64(ev, result_file,
-                                                   print_event_info)) !=
-            OK_CONTINUE)
-          goto end;
-      }
-      else
-      {
-        print_skip_replication_statement(print_event_info, ev);
-        ev->print(result_file, print_event_info);
-      }
-      if (head->error == -1)
-        goto err;
-      break;
-    }
-
-    case CREATE_FILE_EVENT:
-    {
-      Create_file_log_event* ce= (Create_file_log_event*)ev;
-      /*
-        We test if this event has to be ignored. If yes, we don't save
-        this event; this will have the good side-effect of ignoring all
-        related Append_block and Exec_load.
-        Note that Load event from 3.23 is not tested.
-      */
-      if (shall_skip_database(ce->db))
-        goto end;                // Next event
-      /*
-	We print the event, but with a leading '#': this is just to inform 
-	the user of the original command; the command we want to execute 
-	will be a derivation of this original command (we will change the 
-	filename and use LOCAL), prepared in the 'case EXEC_LOAD_EVENT' 
-	below.
-      */
-      if (opt_base64_output_mode == BASE64_OUTPUT_ALWAYS)
-      {
-        if ((retval= write_event_header_and_base64(ce, result_file,
-                                                   print_event_info)) !=
-            OK_CONTINUE)
-          goto end;
-      }
-      else
-      {
-        print_skip_replication_statement(print_event_info, ev);
-        ce->print(result_file, print_event_info, TRUE);
-        if (head->error == -1)
-          goto err;
-      }
-      // If this binlog is not 3.23 ; why this test??
-      if (glob_description_event->binlog_version >= 3)
-      {
-        /*
-          transfer the responsibility for destroying the event to
-          load_processor
-        */
-        ev= NULL;
-        if ((retval= load_processor.process(ce)) != OK_CONTINUE)
-          goto end;
-      }
-      break;
-    }
-
-    case APPEND_BLOCK_EVENT:
-      /*
-        Append_block_log_events can safely print themselves even if
-        the subsequent call load_processor.process fails, because the
-        output of Append_block_log_event::print is only a comment.
-      */
-      ev->print(result_file, print_event_info);
-      if (head->error == -1)
-        goto err;
-      if ((retval= load_processor.process((Append_block_log_event*) ev)) !=
-          OK_CONTINUE)
-        goto end;
-      break;
 
-    case EXEC_LOAD_EVENT:
+    if (ev_type == FORMAT_DESCRIPTION_EVENT)
     {
-      ev->print(result_file, print_event_info);
-      if (head->error == -1)
-        goto err;
-      Execute_load_log_event *exv= (Execute_load_log_event*)ev;
-      Create_file_log_event *ce= load_processor.grab_event(exv->file_id);
-      /*
-	if ce is 0, it probably means that we have not seen the Create_file
-	event (a bad binlog, or most probably --start-position is after the
-	Create_file event). Print a warning comment.
-      */
-      if (ce)
-      {
-        /*
-          We must not convert earlier, since the file is used by
-          my_open() in Load_log_processor::append().
-        */
-        convert_path_to_forward_slashes((char*) ce->fname);
-	ce->print(result_file, print_event_info, TRUE);
-	my_free((void*)ce->fname);
-	delete ce;
-        if (head->error == -1)
-          goto err;
-      }
-      else
-        warning("Ignoring Execute_load_log_event as there is no "
-                "Create_file event for file_id: %u", exv->file_id);
-      break;
-    }
-    case FORMAT_DESCRIPTION_EVENT:
-      delete glob_description_event;
-      glob_description_event= (Format_description_log_event*) ev;
-      print_event_info->common_header_len=
-        glob_description_event->common_header_len;
-      ev->print(result_file, print_event_info);
-      if (head->error == -1)
-        goto err;
-      if (!remote_opt)
-      {
-        ev->free_temp_buf(); // free memory allocated in dump_local_log_entries
-      }
-      else
-      {
-        /*
-          disassociate but not free dump_remote_log_entries time memory
-        */
-        ev->temp_buf= 0;
-      }
+      Format_description_log_event *fdev= (Format_description_log_event*) ev;
+      set_description_event(fdev);
+      rec_count++;
+      retval= (opt_gtid_domain_split ? split_event(ev, pos) :
+               output_event(output, ev, pos));
       /*
-        We don't want this event to be deleted now, so let's hide it (I
-        (Guilhem) should later see if this triggers a non-serious Valgrind
-        error). Not serious error, because we will free description_event
-        later.
+        Printed now, unless it may have to be printed later by a
+        Decode_thread or into the output of a GTID domain seen later.
       */
-      ev= 0;
+      if (!opt_gtid_domain_split && !decode_threads)
+        fdev->free_temp_buf(); // free memory allocated in dump_local_log_entries
+      if (retval != OK_CONTINUE)
+        DBUG_RETURN(retval);
       if (!force_if_open_opt &&
           (glob_description_event->flags & LOG_EVENT_BINLOG_IN_USE_F))
       {
@@ -1147,131 +1814,17 @@ Exit_status process_event(PRINT_EVENT_INFO *print_event_info, Log_event *ev,
               "Rerun with --force-if-open to ignore this problem.", logname);
         DBUG_RETURN(ERROR_STOP);
       }
-      break;
-    case BEGIN_LOAD_QUERY_EVENT:
-      ev->print(result_file, print_event_info);
-      if (head->error == -1)
-        goto err;
-      if ((retval= load_processor.process((Begin_load_query_log_event*) ev)) !=
-          OK_CONTINUE)
-        goto end;
-      break;
-    case EXECUTE_LOAD_QUERY_EVENT:
-    {
-      Execute_load_query_log_event *exlq= (Execute_load_query_log_event*)ev;
-      char *fname= load_processor.grab_fname(exlq->file_id);
-
-      if (!shall_skip_database(exlq->db))
-      {
-        print_use_stmt(print_event_info, exlq);
-        if (fname)
-        {
-          convert_path_to_forward_slashes(fname);
-          print_skip_replication_statement(print_event_info, ev);
-          exlq->print(result_file, print_event_info, fname);
-          if (head->error == -1)
-          {
-            if (fname)
-              my_free(fname);
-            goto err;
-          }
-        }
-        else
-          warning("Ignoring Execute_load_query since there is no "
-                  "Begin_load_query event for file_id: %u", exlq->file_id);
-      }
-
-      if (fname)
-	my_free(fname);
-      break;
+      DBUG_RETURN(OK_CONTINUE);
     }
-    case ANNOTATE_ROWS_EVENT:
-      if (!opt_skip_annotate_row_events)
-      {
-        /*
-          We don't print Annotate event just now because all subsequent
-          rbr-events can be filtered away. Instead we'll keep the event
-          till it will be printed together with the first not filtered
-          away Table map or the last rbr will be processed.
-        */
-        keep_annotate_event((Annotate_rows_log_event*) ev);
-        destroy_evt= FALSE;
-      }
-      break;
-    case TABLE_MAP_EVENT:
-    {
-      Table_map_log_event *map= ((Table_map_log_event *)ev);
-      if (shall_skip_database(map->get_db_name()))
-      {
-        print_event_info->m_table_map_ignored.set_table(map->get_table_id(), map);
-        destroy_evt= FALSE;
-        goto end;
-      }
-      /*
-        The Table map is to be printed, so it's just the time when we may
-        print the kept Annotate event (if there is any).
-        print_annotate_event() also deletes the kept Annotate event.
-      */
-      print_annotate_event(print_event_info);
 
-      size_t len_to= 0;
-      const char* db_to= binlog_filter->get_rewrite_db(map->get_db_name(), &len_to);
-      if (len_to && map->rewrite_db(db_to, len_to, glob_description_event))
-      {
-        error("Could not rewrite database name");
-        goto err;
-      }
-      if (print_base64(print_event_info, ev))
-        goto err;
-      break;
-    }
-    case WRITE_ROWS_EVENT:
-    case DELETE_ROWS_EVENT:
-    case UPDATE_ROWS_EVENT:
-    {
-      Rows_log_event *e= (Rows_log_event*) ev;
-      if (print_row_event(print_event_info, ev, e->get_table_id(),
-                          e->get_flags(Rows_log_event::STMT_END_F)))
-        goto err;
-      break;
-    }
-    case PRE_GA_WRITE_ROWS_EVENT:
-    case PRE_GA_DELETE_ROWS_EVENT:
-    case PRE_GA_UPDATE_ROWS_EVENT:
-    {
-      Old_rows_log_event *e= (Old_rows_log_event*) ev;
-      if (print_row_event(print_event_info, ev, e->get_table_id(),
-                          e->get_flags(Old_rows_log_event::STMT_END_F)))
-        goto err;
-      break;
-    }
-    default:
-      print_skip_replication_statement(print_event_info, ev);
-      ev->print(result_file, print_event_info);
-      if (head->error == -1)
-        goto err;
-    }
+    rec_count++;
+    DBUG_RETURN(opt_gtid_domain_split ? split_event(ev, pos) :
+                output_event(output, ev, pos));
   }
 
-  goto end;
-
-err:
-  retval= ERROR_STOP;
 end:
   rec_count++;
-  
-  /*
-    Destroy the log_event object. 
-    MariaDB MWL#36: mainline does this:
-      If reading from a remote host,
-      set the temp_buf to NULL so that memory isn't freed twice.
-    We no longer do that, we use Rpl_filter::event_owns_temp_buf instead.
-  */
-  if (ev)
-  {
-    if (destroy_evt) /* destroy it later if not set (ignored table map) */
-      delete ev;
-  }
+  delete ev;
   DBUG_RETURN(retval);
 }
 
@@ -1316,6 +1869,13 @@ static struct my_option my_options[] =
   {"debug-info", OPT_DEBUG_INFO, "Print some debug info at exit.",
    &debug_info_flag, &debug_info_flag,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"decode-threads", 0,
+   "Number of threads that print the events, while the binlog is read "
+   "in another thread. The events of one output are printed by one "
+   "thread, so without --gtid-domain-split only one of them is used. "
+   "0 prints the events in the thread that reads them.",
+   &opt_decode_threads, &opt_decode_threads, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 256, 0, 1, 0},
   {"default_auth", OPT_DEFAULT_AUTH,
    "Default authentication client-side plugin to use.",
    &opt_default_auth, &opt_default_auth, 0,
@@ -1333,6 +1893,14 @@ static struct my_option my_options[] =
   {"force-read", 'f', "Force reading unknown binlog events.",
    &force_opt, &force_opt, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0,
    0, 0},
+  {"gtid-domain-split", 0,
+   "Print the events of each GTID replication domain into a file of its "
+   "own, named after --result-file with the domain id appended, e.g. "
+   "binlog.sql.0, binlog.sql.1. Event groups of different domains are "
+   "independent, so these files can be applied in parallel, e.g. for a "
+   "faster point-in-time recovery. Requires --result-file.",
+   &opt_gtid_domain_split, &opt_gtid_domain_split, 0, GET_BOOL, NO_ARG,
+   0, 0, 0, 0, 0, 0},
   {"hexdump", 'H', "Augment output with hexadecimal and ASCII event dump.",
    &opt_hexdump, &opt_hexdump, 0, GET_BOOL, NO_ARG,
    0, 0, 0, 0, 0, 0},
@@ -1602,8 +2170,7 @@ get_one_option(int optid, const struct my_option *opt __attribute__((unused)),
       tty_password=1;
     break;
   case 'r':
-    if (!(result_file = my_fopen(argument, O_WRONLY | O_BINARY, MYF(MY_WME))))
-      exit(1);
+    result_file_name= argument;
     break;
   case 'R':
     remote_opt= 1;
@@ -1703,6 +2270,18 @@ static int parse_args(int *argc, char*** argv)
   result_file = stdout;
   if ((ho_error=handle_options(argc, argv, my_options, get_one_option)))
     exit(ho_error);
+  if (opt_gtid_domain_split)
+  {
+    if (!result_file_name)
+    {
+      error("--gtid-domain-split requires --result-file.");
+      exit(1);
+    }
+  }
+  else if (result_file_name &&
+           !(result_file= my_fopen(result_file_name, O_WRONLY | O_BINARY,
+                                   MYF(MY_WME))))
+    exit(1);
   if (debug_info_flag)
     my_end_arg= MY_CHECK_ERROR | MY_GIVE_INFO;
   if (debug_check_flag)
@@ -1774,25 +2353,23 @@ static Exit_status safe_connect()
 static Exit_status dump_log_entries(const char* logname)
 {
   Exit_status rc;
-  PRINT_EVENT_INFO print_event_info;
 
-  if (!print_event_info.init_ok())
+  /* The outputs of the GTID domains are shared by all binlogs */
+  if (opt_gtid_domain_split)
+    return (remote_opt ? dump_remote_log_entries(NULL, logname) :
+            dump_local_log_entries(NULL, logname));
+
+  Event_output output(result_file);
+  if (!output.print_event_info.init_ok())
     return ERROR_STOP;
-  /*
-     Set safe delimiter, to dump things
-     like CREATE PROCEDURE safely
-  */
-  fprintf(result_file, "DELIMITER /*!*/;\n");
-  strmov(print_event_info.delimiter, "/*!*/;");
-  
-  print_event_info.verbose= short_form ? 0 : verbose;
+  output.thread= decode_threads;
+  open_event_output(&output);
 
-  rc= (remote_opt ? dump_remote_log_entries(&print_event_info, logname) :
-       dump_local_log_entries(&print_event_info, logname));
+  rc= (remote_opt ? dump_remote_log_entries(&output, logname) :
+       dump_local_log_entries(&output, logname));
 
-  /* Set delimiter back to semicolon */
-  fprintf(result_file, "DELIMITER ;\n");
-  strmov(print_event_info.delimiter, ";");
+  if (close_event_output(&output) != OK_CONTINUE)
+    rc= ERROR_STOP;
   return rc;
 }
 
@@ -1858,13 +2435,12 @@ static Exit_status check_master_version()
     goto err;
   }
 
-  delete glob_description_event;
   switch (version) {
   case 3:
-    glob_description_event= new Format_description_log_event(1);
+    set_description_event(new Format_description_log_event(1));
     break;
   case 4:
-    glob_description_event= new Format_description_log_event(3);
+    set_description_event(new Format_description_log_event(3));
     break;
   case 5:
   case 10:
@@ -1874,10 +2450,10 @@ static Exit_status check_master_version()
       So we first assume that this is 4.0 (which is enough to read the
       Format_desc event if one comes).
     */
-    glob_description_event= new Format_description_log_event(3);
+    set_description_event(new Format_description_log_event(3));
     break;
   default:
-    glob_description_event= NULL;
+    set_description_event(NULL);
     error("Could not find server version: "
           "Master reported unrecognized MySQL version '%s'.", row[0]);
     goto err;
@@ -1901,8 +2477,7 @@ err:
   Requests binlog dump from a remote server and prints the events it
   receives.
 
-  @param[in,out] print_event_info Parameters and context state
-  determining how to print.
+  @param[in,out] output Where to print the events.
   @param[in] logname Name of input binlog.
 
   @retval ERROR_STOP An error occurred - the program should terminate.
@@ -1910,7 +2485,7 @@ err:
   @retval OK_STOP No error, but the end of the specified range of
   events to process has been reached and the program should terminate.
 */
-static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
+static Exit_status dump_remote_log_entries(Event_output *output,
                                            const char* logname)
 
 {
@@ -1974,12 +2549,18 @@ static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
       break; // end of data
     DBUG_PRINT("info",( "len: %lu  net->read_pos[5]: %d\n",
 			len, net->read_pos[5]));
-    if (net->read_pos[5] == ANNOTATE_ROWS_EVENT)
+    /*
+      Events printed by a Decode_thread, or kept for a GTID domain seen
+      later, must not refer to the packet, which is overwritten by the
+      next one.
+    */
+    if (net->read_pos[5] == ANNOTATE_ROWS_EVENT || opt_decode_threads ||
+        opt_gtid_domain_split)
     {
-      if (!(ev= read_remote_annotate_event(net->read_pos + 1, len - 1,
-                                           &error_msg)))
+      if (!(ev= read_remote_event_copy(net->read_pos + 1, len - 1,
+                                       &error_msg)))
       {
-        error("Could not construct annotate event object: %s", error_msg);
+        error("Could not construct log event object: %s", error_msg);
         DBUG_RETURN(ERROR_STOP);
       }   
     }
@@ -2055,7 +2636,7 @@ static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
         if (old_off != BIN_LOG_HEADER_SIZE)
           len= 1;         // fake event, don't increment old_off
       }
-      Exit_status retval= process_event(print_event_info, ev, old_off, logname);
+      Exit_status retval= process_event(output, ev, old_off, logname);
       if (retval != OK_CONTINUE)
         DBUG_RETURN(retval);
     }
@@ -2070,7 +2651,7 @@ static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
       if ((file= load_processor.prepare_new_file_for_old_format(le,fname)) < 0)
         DBUG_RETURN(ERROR_STOP);
 
-      retval= process_event(print_event_info, ev, old_off, logname);
+      retval= process_event(output, ev, old_off, logname);
       if (retval != OK_CONTINUE)
       {
         my_close(file,MYF(MY_WME));
@@ -2108,8 +2689,7 @@ static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
   @param file The file to which a @c Format_description_log_event will
   be printed.
 
-  @param[in,out] print_event_info Parameters and context state
-  determining how to print.
+  @param[in,out] output Where to print the events.
 
   @param[in] logname Name of input binlog.
 
@@ -2119,7 +2699,7 @@ static Exit_status dump_remote_log_entries(PRINT_EVENT_INFO *print_event_info,
   events to process has been reached and the program should terminate.
 */
 static Exit_status check_header(IO_CACHE* file,
-                                PRINT_EVENT_INFO *print_event_info,
+                                Event_output *output,
                                 const char* logname)
 {
   uchar header[BIN_LOG_HEADER_SIZE];
@@ -2127,8 +2707,8 @@ static Exit_status check_header(IO_CACHE* file,
   my_off_t tmp_pos, pos;
   MY_STAT my_file_stat;
 
-  delete glob_description_event;
-  if (!(glob_description_event= new Format_description_log_event(3)))
+  set_description_event(new Format_description_log_event(3));
+  if (!glob_description_event)
   {
     error("Failed creating Format_description_log_event; out of memory?");
     return ERROR_STOP;
@@ -2208,8 +2788,8 @@ static Exit_status check_header(IO_CACHE* file,
             (LOG_EVENT_MINIMAL_HEADER_LEN + START_V3_HEADER_LEN))
         {
           /* This is 3.23 (format 1) */
-          delete glob_description_event;
-          if (!(glob_description_event= new Format_description_log_event(1)))
+          set_description_event(new Format_description_log_event(1));
+          if (!glob_description_event)
           {
             error("Failed creating Format_description_log_event; "
                   "out of memory?");
@@ -2243,17 +2823,14 @@ static Exit_status check_header(IO_CACHE* file,
             the new one, so we should not do it ourselves in this
             case.
           */
-          Exit_status retval= process_event(print_event_info,
+          Exit_status retval= process_event(output,
                                             new_description_event, tmp_pos,
                                             logname);
           if (retval != OK_CONTINUE)
             return retval;
         }
         else
-        {
-          delete glob_description_event;
-          glob_description_event= new_description_event;
-        }
+          set_description_event(new_description_event);
         DBUG_PRINT("info",("Setting description_event"));
       }
       else if (buf[EVENT_TYPE_OFFSET] == ROTATE_EVENT)
@@ -2285,15 +2862,14 @@ static Exit_status check_header(IO_CACHE* file,
 
   @param[in] logname Name of input binlog.
 
-  @param[in,out] print_event_info Parameters and context state
-  determining how to print.
+  @param[in,out] output Where to print the events.
 
   @retval ERROR_STOP An error occurred - the program should terminate.
   @retval OK_CONTINUE No error, the program should continue.
   @retval OK_STOP No error, but the end of the specified range of
   events to process has been reached and the program should terminate.
 */
-static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *print_event_info,
+static Exit_status dump_local_log_entries(Event_output *output,
                                           const char* logname)
 {
   File fd = -1;
@@ -2312,7 +2888,7 @@ static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *print_event_info,
       my_close(fd, MYF(MY_WME));
       return ERROR_STOP;
     }
-    if ((retval= check_header(file, print_event_info, logname)) != OK_CONTINUE)
+    if ((retval= check_header(file, output, logname)) != OK_CONTINUE)
       goto end;
   }
   else
@@ -2339,7 +2915,7 @@ static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *print_event_info,
       error("Failed to init IO cache.");
       return ERROR_STOP;
     }
-    if ((retval= check_header(file, print_event_info, logname)) != OK_CONTINUE)
+    if ((retval= check_header(file, output, logname)) != OK_CONTINUE)
       goto end;
     if (start_position)
     {
@@ -2394,7 +2970,7 @@ static Exit_status dump_local_log_entries(PRINT_EVENT_INFO *print_event_info,
       // file->error == 0 means EOF, that's OK, we break in this case
       goto end;
     }
-    if ((retval= process_event(print_event_info, ev, old_off, logname)) !=
+    if ((retval= process_event(output, ev, old_off, logname)) !=
         OK_CONTINUE)
       goto end;
   }
@@ -2482,29 +3058,13 @@ int main(int argc, char** argv)
   else
     load_processor.init_by_cur_dir();
 
-  fprintf(result_file, "/*!50530 SET @@SESSION.PSEUDO_SLAVE_MODE=1*/;\n");
-
-  fprintf(result_file,
-	  "/*!40019 SET @@session.max_insert_delayed_threads=0*/;\n");
-
-  if (disable_log_bin)
-    fprintf(result_file,
-            "/*!32316 SET @OLD_SQL_LOG_BIN=@@SQL_LOG_BIN, SQL_LOG_BIN=0*/;\n");
-
-  /*
-    In mysqlbinlog|mysql, don't want mysql to be disconnected after each
-    transaction (which would be the case with GLOBAL.COMPLETION_TYPE==2).
-  */
-  fprintf(result_file,
-          "/*!50003 SET @OLD_COMPLETION_TYPE=@@COMPLETION_TYPE,"
-          "COMPLETION_TYPE=0*/;\n");
-
-  if (charset)
-    fprintf(result_file,
-            "\n/*!40101 SET @OLD_CHARACTER_SET_CLIENT=@@CHARACTER_SET_CLIENT */;"
-            "\n/*!40101 SET @OLD_CHARACTER_SET_RESULTS=@@CHARACTER_SET_RESULTS */;"
-            "\n/*!40101 SET @OLD_COLLATION_CONNECTION=@@COLLATION_CONNECTION */;"  
-            "\n/*!40101 SET NAMES %s */;\n", charset);
+  if (opt_decode_threads && start_decode_threads() != OK_CONTINUE)
+    exit(1);
+  if (opt_gtid_domain_split)
+    my_init_dynamic_array(&domain_outputs, sizeof(Event_output *), 16, 16,
+                          MYF(0));
+  else
+    print_output_header(result_file);
 
   for (save_stop_position= stop_position, stop_position= ~(my_off_t)0 ;
        (--argc >= 0) ; )
@@ -2518,30 +3078,20 @@ int main(int argc, char** argv)
     start_position= BIN_LOG_HEADER_SIZE;
   }
 
-  /*
-    Issue a ROLLBACK in case the last printed binlog was crashed and had half
-    of transaction.
-  */
-  fprintf(result_file,
-          "# End of log file\nROLLBACK /* added by mysqlbinlog */;\n"
-          "/*!50003 SET COMPLETION_TYPE=@OLD_COMPLETION_TYPE*/;\n");
-  if (disable_log_bin)
-    fprintf(result_file, "/*!32316 SET SQL_LOG_BIN=@OLD_SQL_LOG_BIN*/;\n");
-
-  if (charset)
-    fprintf(result_file,
-            "/*!40101 SET CHARACTER_SET_CLIENT=@OLD_CHARACTER_SET_CLIENT */;\n"
-            "/*!40101 SET CHARACTER_SET_RESULTS=@OLD_CHARACTER_SET_RESULTS */;\n"
-            "/*!40101 SET COLLATION_CONNECTION=@OLD_COLLATION_CONNECTION */;\n");
-
-  fprintf(result_file, "/*!50530 SET @@SESSION.PSEUDO_SLAVE_MODE=0*/;\n");
+  if (opt_gtid_domain_split)
+  {
+    if (close_domain_outputs() != OK_CONTINUE)
+      retval= ERROR_STOP;
+  }
+  else
+    print_output_footer(result_file);
+  stop_decode_threads();
 
   if (tmpdir.list)
     free_tmpdir(&tmpdir);
   if (result_file != stdout)
     my_fclose(result_file, MYF(0));
   cleanup();
-  free_annotate_event();
   free_root(&s_mem_root, MYF(0));
   free_defaults(defaults_argv);
   my_free_open_file_info();
@@ -47,6 +47,8 @@
 #include <m_string.h>
 #include <m_ctype.h>
 #include <hash.h>
+#include <my_pthread.h>
+#include <my_dir.h>
 #include <stdarg.h>
 
 #include "client_priv.h"
@@ -134,6 +136,8 @@ static ulong opt_compatible_mode= 0;
 #define MYSQL_OPT_SLAVE_DATA_COMMENTED_SQL 2
 static uint opt_mysql_port= 0, opt_master_data;
 static uint opt_slave_data;
+static uint opt_parallel= 0;
+static ulonglong opt_chunk_rows= 0;
 static uint my_end_arg;
 static char * opt_mysql_unix_port=0;
 static int   first_error=0;
@@ -226,6 +230,14 @@ static struct my_option my_long_options[] =
   {"character-sets-dir", OPT_CHARSETS_DIR,
    "Directory for character set files.", &charsets_dir,
    &charsets_dir, 0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"chunk-rows", OPT_MYSQLDUMP_CHUNK_ROWS,
+   "Used with --tab. Split the data file of a table with a primary key "
+   "on one integer column into ranges of the key of about this many rows "
+   "each, written to files named table.1.txt, table.2.txt and so on. "
+   "The files can be loaded in parallel, e.g. with mysqlimport "
+   "--use-threads. 0 means one file per table.",
+   &opt_chunk_rows, &opt_chunk_rows, 0, GET_ULL, REQUIRED_ARG,
+   0, 0, ULONGLONG_MAX, 0, 1, 0},
   {"comments", 'i', "Write additional information.",
    &opt_comments, &opt_comments, 0, GET_BOOL, NO_ARG,
    1, 0, 0, 0, 0, 0},
@@ -418,6 +430,13 @@ static struct my_option my_long_options[] =
   {"order-by-primary", OPT_ORDER_BY_PRIMARY,
    "Sorts each table's rows by primary key, or first unique key, if such a key exists.  Useful when dumping a MyISAM table to be loaded into an InnoDB table, but will make the dump itself take considerably longer.",
    &opt_order_by_primary, &opt_order_by_primary, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"parallel", OPT_MYSQLDUMP_PARALLEL,
+   "Used with --tab. Number of additional connections that write the data "
+   "files in parallel. These connections share the consistent snapshot "
+   "of --single-transaction; without it, --lock-all-tables is used. "
+   "0 writes the data files over the main connection.",
+   &opt_parallel, &opt_parallel, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 256, 0, 1, 0},
   {"password", 'p',
    "Password to use when connecting to server. If password is not given it's solicited on the tty.",
    0, 0, 0, GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
@@ -973,6 +992,18 @@ static int get_options(int *argc, char ***argv)
     opt_lock_all_tables= !opt_single_transaction;
     opt_slave_data= 0;
   }
+  if ((opt_parallel || opt_chunk_rows) && !path)
+  {
+    fprintf(stderr, "%s: --parallel and --chunk-rows can only be used "
+            "with --tab.\n", my_progname_short);
+    return(EX_USAGE);
+  }
+  /*
+    The other connections would see rows inserted concurrently under the
+    READ LOCAL locks of --lock-tables, so take the global read lock.
+  */
+  if (opt_parallel && !opt_single_transaction)
+    opt_lock_all_tables= 1;
   if (opt_single_transaction || opt_lock_all_tables)
     lock_tables= 0;
   if (enclosed && opt_enclosed)
@@ -1505,70 +1536,69 @@ static void maybe_exit(int error)
 
 
 /*
-  db_connect -- connects to the host and selects DB.
+  Open a connection to the server and set up the session for dumping.
+
+  SYNOPSIS
+    connect_to_server()
+    con        connection to open
+    host, user, passwd
+               where and how to connect
+
+  RETURN VALUES
+    0          ok
+    1          error, the connection may need mysql_close()
 */
 
-static int connect_to_db(char *host, char *user,char *passwd)
+static int connect_to_server(MYSQL *con, char *host, char *user, char *passwd)
 {
   char buff[20+FN_REFLEN];
-  DBUG_ENTER("connect_to_db");
+  DBUG_ENTER("connect_to_server");
 
-  verbose_msg("-- Connecting to %s...\n", host ? host : "localhost");
-  mysql_init(&mysql_connection);
+  mysql_init(con);
   if (opt_compress)
-    mysql_options(&mysql_connection,MYSQL_OPT_COMPRESS,NullS);
+    mysql_options(con,MYSQL_OPT_COMPRESS,NullS);
 #ifdef HAVE_OPENSSL
   if (opt_use_ssl)
   {
-    mysql_ssl_set(&mysql_connection, opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
+    mysql_ssl_set(con, opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
                   opt_ssl_capath, opt_ssl_cipher);
-    mysql_options(&mysql_connection, MYSQL_OPT_SSL_CRL, opt_ssl_crl);
-    mysql_options(&mysql_connection, MYSQL_OPT_SSL_CRLPATH, opt_ssl_crlpath);
+    mysql_options(con, MYSQL_OPT_SSL_CRL, opt_ssl_crl);
+    mysql_options(con, MYSQL_OPT_SSL_CRLPATH, opt_ssl_crlpath);
   }
-  mysql_options(&mysql_connection,MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
+  mysql_options(con,MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
                 (char*)&opt_ssl_verify_server_cert);
 #endif
   if (opt_protocol)
-    mysql_options(&mysql_connection,MYSQL_OPT_PROTOCOL,(char*)&opt_protocol);
+    mysql_options(con,MYSQL_OPT_PROTOCOL,(char*)&opt_protocol);
 #ifdef HAVE_SMEM
   if (shared_memory_base_name)
-    mysql_options(&mysql_connection,MYSQL_SHARED_MEMORY_BASE_NAME,shared_memory_base_name);
+    mysql_options(con,MYSQL_SHARED_MEMORY_BASE_NAME,shared_memory_base_name);
 #endif
-  mysql_options(&mysql_connection, MYSQL_SET_CHARSET_NAME, default_charset);
+  mysql_options(con, MYSQL_SET_CHARSET_NAME, default_charset);
 
   if (opt_plugin_dir && *opt_plugin_dir)
-    mysql_options(&mysql_connection, MYSQL_PLUGIN_DIR, opt_plugin_dir);
+    mysql_options(con, MYSQL_PLUGIN_DIR, opt_plugin_dir);
 
   if (opt_default_auth && *opt_default_auth)
-    mysql_options(&mysql_connection, MYSQL_DEFAULT_AUTH, opt_default_auth);
+    mysql_options(con, MYSQL_DEFAULT_AUTH, opt_default_auth);
 
-  mysql_options(&mysql_connection, MYSQL_OPT_CONNECT_ATTR_RESET, 0);
-  mysql_options4(&mysql_connection, MYSQL_OPT_CONNECT_ATTR_ADD,
+  mysql_options(con, MYSQL_OPT_CONNECT_ATTR_RESET, 0);
+  mysql_options4(con, MYSQL_OPT_CONNECT_ATTR_ADD,
                  "program_name", "mysqldump");
-  mysql= &mysql_connection;          /* So we can mysql_close() it properly */
-  if (!mysql_real_connect(&mysql_connection,host,user,passwd,
+  if (!mysql_real_connect(con,host,user,passwd,
                           NULL,opt_mysql_port,opt_mysql_unix_port, 0))
   {
-    DB_error(&mysql_connection, "when trying to connect");
+    DB_error(con, "when trying to connect");
     DBUG_RETURN(1);
   }
-  if ((mysql_get_server_version(&mysql_connection) < 40100) ||
-      (opt_compatible_mode & 3))
-  {
-    /* Don't dump SET NAMES with a pre-4.1 server (bug#7997).  */
-    opt_set_charset= 0;
-
-    /* Don't switch charsets for 4.1 and earlier.  (bug#34192). */
-    server_supports_switching_charsets= FALSE;
-  } 
   /*
     As we're going to set SQL_MODE, it would be lost on reconnect, so we
     cannot reconnect.
   */
-  mysql->reconnect= 0;
+  con->reconnect= 0;
   my_snprintf(buff, sizeof(buff), "/*!40100 SET @@SQL_MODE='%s' */",
               compatible_mode_normal_str);
-  if (mysql_query_with_error_report(mysql, 0, buff))
+  if (mysql_query_with_error_report(con, 0, buff))
     DBUG_RETURN(1);
   /*
     set time_zone to UTC to allow dumping date types between servers with
@@ -1577,10 +1607,35 @@ static int connect_to_db(char *host, char *user,char *passwd)
   if (opt_tz_utc)
   {
     my_snprintf(buff, sizeof(buff), "/*!40103 SET TIME_ZONE='+00:00' */");
-    if (mysql_query_with_error_report(mysql, 0, buff))
+    if (mysql_query_with_error_report(con, 0, buff))
       DBUG_RETURN(1);
   }
   DBUG_RETURN(0);
+} /* connect_to_server */
+
+
+/*
+  db_connect -- connects to the host and selects DB.
+*/
+
+static int connect_to_db(char *host, char *user,char *passwd)
+{
+  DBUG_ENTER("connect_to_db");
+
+  verbose_msg("-- Connecting to %s...\n", host ? host : "localhost");
+  mysql= &mysql_connection;          /* So we can mysql_close() it properly */
+  if (connect_to_server(&mysql_connection, host, user, passwd))
+    DBUG_RETURN(1);
+  if ((mysql_get_server_version(&mysql_connection) < 40100) ||
+      (opt_compatible_mode & 3))
+  {
+    /* Don't dump SET NAMES with a pre-4.1 server (bug#7997).  */
+    opt_set_charset= 0;
+
+    /* Don't switch charsets for 4.1 and earlier.  (bug#34192). */
+    server_supports_switching_charsets= FALSE;
+  } 
+  DBUG_RETURN(0);
 } /* connect_to_db */
 
 
@@ -1594,6 +1649,257 @@ static void dbDisconnect(char *host)
 } /* dbDisconnect */
 
 
+/*
+  Worker connections for --parallel.
+
+  With --tab the data files are written by the server, by SELECT ... INTO
+  OUTFILE.  With --parallel these queries are not sent over the main
+  connection, but queued for worker threads that have a connection of
+  their own.  The worker connections are opened before the dump starts,
+  so that they can join the consistent snapshot of --single-transaction,
+  or run while the main connection holds the global read lock.
+*/
+
+typedef struct st_dump_job
+{
+  struct st_dump_job *next;
+  char *db;                             /* Database of the table */
+  char *query;
+  size_t query_length;
+} DUMP_JOB;
+
+typedef struct st_dump_worker
+{
+  MYSQL mysql;
+  pthread_t thread;
+} DUMP_WORKER;
+
+static DUMP_WORKER *dump_workers= 0;
+static uint dump_workers_connected= 0, dump_workers_started= 0;
+
+/* Protects the job queue and the variables below */
+static pthread_mutex_t dump_job_mutex;
+/* Signalled when a job is queued or the workers are to stop */
+static pthread_cond_t dump_job_cond;
+/* Signalled when all jobs are done */
+static pthread_cond_t dump_jobs_done_cond;
+static DUMP_JOB *dump_job_first= 0, **dump_job_last= &dump_job_first;
+/* Number of jobs queued or being executed */
+static uint dump_jobs_pending= 0;
+static my_bool dump_workers_stop= 0;
+/* Error of a failed job, not yet reported by the main thread */
+static int dump_worker_error= 0;
+
+
+pthread_handler_t dump_worker_thread(void *arg)
+{
+  DUMP_WORKER *worker= (DUMP_WORKER *) arg;
+  char current_db[NAME_LEN+1];
+  DUMP_JOB *job;
+  int error;
+
+  mysql_thread_init();
+  current_db[0]= 0;
+  pthread_mutex_lock(&dump_job_mutex);
+  for (;;)
+  {
+    while (!dump_job_first && !dump_workers_stop)
+      pthread_cond_wait(&dump_job_cond, &dump_job_mutex);
+    if (!(job= dump_job_first))
+      break;
+    if (!(dump_job_first= job->next))
+      dump_job_last= &dump_job_first;
+    /* Without --force, the remaining jobs are dropped after an error */
+    error= dump_worker_error && !ignore_errors;
+    pthread_mutex_unlock(&dump_job_mutex);
+
+    if (!error)
+    {
+      if ((strcmp(current_db, job->db) &&
+           mysql_select_db(&worker->mysql, job->db)) ||
+          mysql_real_query(&worker->mysql, job->query, job->query_length))
+      {
+        fprintf(stderr, "%s: Got error: %d: \"%s\" %s\n",
+                my_progname_short, mysql_errno(&worker->mysql),
+                mysql_error(&worker->mysql),
+                "when executing 'SELECT INTO OUTFILE'");
+        fflush(stderr);
+        error= 1;
+      }
+      else
+        strmake(current_db, job->db, NAME_LEN);
+    }
+    my_free(job);
+
+    pthread_mutex_lock(&dump_job_mutex);
+    if (error && !dump_worker_error)
+      dump_worker_error= EX_MYSQLERR;
+    if (!--dump_jobs_pending)
+      pthread_cond_broadcast(&dump_jobs_done_cond);
+  }
+  pthread_mutex_unlock(&dump_job_mutex);
+  mysql_thread_end();
+  return 0;
+}
+
+
+/*
+  Report an error of a worker thread, see maybe_exit().
+*/
+
+static void check_dump_worker_error()
+{
+  int error;
+  pthread_mutex_lock(&dump_job_mutex);
+  error= dump_worker_error;
+  dump_worker_error= 0;
+  pthread_mutex_unlock(&dump_job_mutex);
+  if (error)
+    maybe_exit(error);
+}
+
+
+/*
+  Open the connections of the worker threads.
+
+  RETURN VALUES
+    0          ok
+    1          error
+*/
+
+static int connect_dump_workers()
+{
+  DBUG_ENTER("connect_dump_workers");
+
+  if (!(dump_workers= (DUMP_WORKER *)
+        my_malloc(opt_parallel * sizeof(DUMP_WORKER),
+                  MYF(MY_WME | MY_ZEROFILL))))
+    DBUG_RETURN(1);
+  pthread_mutex_init(&dump_job_mutex, NULL);
+  pthread_cond_init(&dump_job_cond, NULL);
+  pthread_cond_init(&dump_jobs_done_cond, NULL);
+
+  verbose_msg("-- Opening %u worker connections...\n", opt_parallel);
+  for (; dump_workers_connected < opt_parallel; dump_workers_connected++)
+  {
+    DUMP_WORKER *worker= dump_workers + dump_workers_connected;
+    if (connect_to_server(&worker->mysql, current_host, current_user,
+                          opt_password))
+    {
+      mysql_close(&worker->mysql);
+      DBUG_RETURN(1);
+    }
+  }
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Start the worker threads. The main thread must not use their
+  connections any more.
+*/
+
+static int start_dump_workers()
+{
+  DBUG_ENTER("start_dump_workers");
+  for (; dump_workers_started < dump_workers_connected;
+       dump_workers_started++)
+  {
+    DUMP_WORKER *worker= dump_workers + dump_workers_started;
+    if (pthread_create(&worker->thread, NULL, dump_worker_thread, worker))
+    {
+      fprintf(stderr, "%s: Could not create thread\n", my_progname_short);
+      DBUG_RETURN(1);
+    }
+  }
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Let the worker threads finish the queued jobs, then stop them and
+  close their connections.
+*/
+
+static void stop_dump_workers()
+{
+  uint i;
+  if (!dump_workers)
+    return;
+
+  pthread_mutex_lock(&dump_job_mutex);
+  dump_workers_stop= 1;
+  pthread_cond_broadcast(&dump_job_cond);
+  pthread_mutex_unlock(&dump_job_mutex);
+  for (i= 0; i < dump_workers_started; i++)
+    pthread_join(dump_workers[i].thread, NULL);
+  for (i= 0; i < dump_workers_connected; i++)
+    mysql_close(&dump_workers[i].mysql);
+
+  pthread_cond_destroy(&dump_jobs_done_cond);
+  pthread_cond_destroy(&dump_job_cond);
+  pthread_mutex_destroy(&dump_job_mutex);
+  my_free(dump_workers);
+  dump_workers= 0;
+  dump_workers_connected= dump_workers_started= 0;
+}
+
+
+/*
+  Execute a SELECT ... INTO OUTFILE of dump_table(), by a worker thread
+  with --parallel, otherwise over the main connection.
+*/
+
+static void run_outfile_query(const char *db, DYNAMIC_STRING *query)
+{
+  size_t db_length;
+  DUMP_JOB *job;
+
+  if (!dump_workers_started)
+  {
+    if (mysql_real_query(mysql, query->str, query->length))
+      DB_error(mysql, "when executing 'SELECT INTO OUTFILE'");
+    return;
+  }
+
+  db_length= strlen(db) + 1;
+  if (!(job= (DUMP_JOB *) my_malloc(sizeof(DUMP_JOB) + db_length +
+                                    query->length + 1, MYF(MY_WME))))
+    die(EX_MYSQLERR, "Couldn't allocate memory for a dump job");
+  job->next= 0;
+  job->db= (char *) (job + 1);
+  memcpy(job->db, db, db_length);
+  job->query= job->db + db_length;
+  memcpy(job->query, query->str, query->length + 1);
+  job->query_length= query->length;
+
+  pthread_mutex_lock(&dump_job_mutex);
+  *dump_job_last= job;
+  dump_job_last= &job->next;
+  dump_jobs_pending++;
+  pthread_cond_signal(&dump_job_cond);
+  pthread_mutex_unlock(&dump_job_mutex);
+
+  check_dump_worker_error();
+}
+
+
+/*
+  Wait until the worker threads have executed all queued jobs.
+*/
+
+static void wait_for_dump_workers()
+{
+  if (!dump_workers_started)
+    return;
+  pthread_mutex_lock(&dump_job_mutex);
+  while (dump_jobs_pending)
+    pthread_cond_wait(&dump_jobs_done_cond, &dump_job_mutex);
+  pthread_mutex_unlock(&dump_job_mutex);
+  check_dump_worker_error();
+}
+
+
 static void unescape(FILE *file,char *pos,uint length)
 {
   char *tmp;
@@ -3376,6 +3682,147 @@ static char *alloc_query_str(ulong size)
 }
 
 
+/*
+  Find the ranges of the primary key that the data file of a table is
+  split into, for --chunk-rows.
+
+  SYNOPSIS
+    get_table_chunks()
+    table         table name
+    result_table  quoted table name
+    key           [out] quoted name of the key column
+    start         [out] lowest value of the key
+    step          [out] width of a range of the key
+    is_unsigned   [out] whether the key is unsigned
+
+  DESCRIPTION
+    Only tables with a primary key on one integer column are split.  The
+    values between the lowest and the highest key are divided into ranges
+    of equal width, as many as the estimated number of rows divided by
+    --chunk-rows.  Gaps in the key make some of the files smaller.  The
+    first and the last range are open ended.
+
+  RETURN
+    number of ranges, 1 if the table is not split
+*/
+
+static uint get_table_chunks(const char *table, const char *result_table,
+                             char *key, ulonglong *start, ulonglong *step,
+                             my_bool *is_unsigned)
+{
+  char query_buff[QUERY_LENGTH], name_buff[NAME_LEN*2+3];
+  MYSQL_RES *res;
+  MYSQL_ROW row;
+  MYSQL_FIELD *field;
+  ulonglong rows, chunks, span;
+  uint key_parts= 0;
+  DBUG_ENTER("get_table_chunks");
+
+  my_snprintf(query_buff, sizeof(query_buff), "SHOW KEYS FROM %s",
+              result_table);
+  if (mysql_query_with_error_report(mysql, &res, query_buff))
+    DBUG_RETURN(1);
+  while ((row= mysql_fetch_row(res)))
+  {
+    if (!strcmp(row[2], "PRIMARY") && !key_parts++)
+      quote_name(row[4], key, 1);
+  }
+  mysql_free_result(res);
+  if (key_parts != 1)
+    DBUG_RETURN(1);
+
+  my_snprintf(query_buff, sizeof(query_buff),
+              "SELECT /*!40001 SQL_NO_CACHE */ MIN(%s), MAX(%s) FROM %s",
+              key, key, result_table);
+  if (mysql_query_with_error_report(mysql, &res, query_buff))
+    DBUG_RETURN(1);
+  row= mysql_fetch_row(res);
+  field= mysql_fetch_field(res);
+  if (!row || !row[0] || !row[1])
+  {
+    /* An empty table */
+    mysql_free_result(res);
+    DBUG_RETURN(1);
+  }
+  switch (field->type) {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    break;
+  default:
+    mysql_free_result(res);
+    DBUG_RETURN(1);
+  }
+  if ((*is_unsigned= test(field->flags & UNSIGNED_FLAG)))
+  {
+    *start= strtoull(row[0], NULL, 10);
+    span= strtoull(row[1], NULL, 10) - *start;
+  }
+  else
+  {
+    /* The difference fits in an unsigned longlong */
+    *start= (ulonglong) strtoll(row[0], NULL, 10);
+    span= (ulonglong) strtoll(row[1], NULL, 10) - *start;
+  }
+  mysql_free_result(res);
+
+  /* Use the estimate of the engine, COUNT(*) could take very long */
+  my_snprintf(query_buff, sizeof(query_buff), "SHOW TABLE STATUS LIKE %s",
+              quote_for_like(table, name_buff));
+  if (mysql_query_with_error_report(mysql, &res, query_buff))
+    DBUG_RETURN(1);
+  row= mysql_fetch_row(res);
+  rows= (row && row[4]) ? strtoull(row[4], NULL, 10) : 0;
+  mysql_free_result(res);
+
+  chunks= rows / opt_chunk_rows + 1;
+  if (chunks > UINT_MAX32)
+    chunks= UINT_MAX32;
+  if (chunks < 2 || span == 0)
+    DBUG_RETURN(1);
+  *step= span / chunks + 1;
+  chunks= span / *step + 1;
+  verbose_msg("-- Splitting data of table %s into %u files\n",
+              result_table, (uint) chunks);
+  DBUG_RETURN((uint) chunks);
+}
+
+
+/*
+  Delete the data files of a table in the --tab directory, including
+  those of ranges of its key.  The ranges of an earlier dump can be
+  different, and the files left over would be loaded too.
+*/
+
+static void remove_chunk_files(const char *dir, const char *table)
+{
+  MY_DIR *dir_info;
+  size_t table_length= strlen(table);
+  uint i;
+
+  if (!(dir_info= my_dir(dir, MYF(0))))
+    return;
+  for (i= 0; i < dir_info->number_of_files; i++)
+  {
+    const char *name= dir_info->dir_entry[i].name, *number, *pos;
+    char filename[FN_REFLEN];
+
+    if (strncmp(name, table, table_length) || name[table_length] != '.')
+      continue;
+    /* table.txt or table.<number>.txt */
+    for (number= pos= name + table_length + 1;
+         my_isdigit(&my_charset_latin1, *pos); pos++)
+    {}
+    if (pos == number ? strcmp(pos, "txt") : strcmp(pos, ".txt"))
+      continue;
+    my_delete(fn_format(filename, name, dir, "", MYF(0)), MYF(0));
+  }
+  my_dirend(dir_info);
+}
+
+
 /*
 
  SYNOPSIS
@@ -3470,6 +3917,10 @@ static void dump_table(char *table, char *db)
   if (path)
   {
     char filename[FN_REFLEN], tmp_path[FN_REFLEN];
+    char chunk_name[FN_REFLEN], key_buff[NAME_LEN*2+3], value_buff[22];
+    ulonglong key_start= 0, key_step= 0;
+    my_bool key_unsigned= 0;
+    uint chunks= 1, chunk;
 
     /*
       Convert the path to native os format
@@ -3477,55 +3928,95 @@ static void dump_table(char *table, char *db)
     */
     convert_dirname(tmp_path,path,NullS);    
     my_load_path(tmp_path, tmp_path, NULL);
-    fn_format(filename, table, tmp_path, ".txt", MYF(MY_UNPACK_FILENAME));
 
-    /* Must delete the file that 'INTO OUTFILE' will write to */
-    my_delete(filename, MYF(0));
+    if (opt_chunk_rows)
+    {
+      chunks= get_table_chunks(table, result_table, key_buff, &key_start,
+                               &key_step, &key_unsigned);
+      remove_chunk_files(tmp_path, table);
+    }
 
-    /* convert to a unix path name to stick into the query */
-    to_unix_path(filename);
+    for (chunk= 0; chunk < chunks; chunk++)
+    {
+      if (chunks > 1)
+      {
+        my_snprintf(chunk_name, sizeof(chunk_name), "%s.%u.txt",
+                    table, chunk + 1);
+        fn_format(filename, chunk_name, tmp_path, "",
+                  MYF(MY_UNPACK_FILENAME));
+      }
+      else
+        fn_format(filename, table, tmp_path, ".txt", MYF(MY_UNPACK_FILENAME));
 
-    /* now build the query string */
+      /* Must delete the file that 'INTO OUTFILE' will write to */
+      my_delete(filename, MYF(0));
 
-    dynstr_append_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ * INTO OUTFILE '");
-    dynstr_append_checked(&query_string, filename);
-    dynstr_append_checked(&query_string, "'");
+      /* convert to a unix path name to stick into the query */
+      to_unix_path(filename);
 
-    dynstr_append_checked(&query_string, " /*!50138 CHARACTER SET ");
-    dynstr_append_checked(&query_string, default_charset == mysql_universal_client_charset ?
-                                         my_charset_bin.name : /* backward compatibility */
-                                         default_charset);
-    dynstr_append_checked(&query_string, " */");
+      /* now build the query string */
 
-    if (fields_terminated || enclosed || opt_enclosed || escaped)
-      dynstr_append_checked(&query_string, " FIELDS");
-    
-    add_load_option(&query_string, " TERMINATED BY ", fields_terminated);
-    add_load_option(&query_string, " ENCLOSED BY ", enclosed);
-    add_load_option(&query_string, " OPTIONALLY ENCLOSED BY ", opt_enclosed);
-    add_load_option(&query_string, " ESCAPED BY ", escaped);
-    add_load_option(&query_string, " LINES TERMINATED BY ", lines_terminated);
+      dynstr_set_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ * INTO OUTFILE '");
+      dynstr_append_checked(&query_string, filename);
+      dynstr_append_checked(&query_string, "'");
 
-    dynstr_append_checked(&query_string, " FROM ");
-    dynstr_append_checked(&query_string, result_table);
+      dynstr_append_checked(&query_string, " /*!50138 CHARACTER SET ");
+      dynstr_append_checked(&query_string, default_charset == mysql_universal_client_charset ?
+                                           my_charset_bin.name : /* backward compatibility */
+                                           default_charset);
+      dynstr_append_checked(&query_string, " */");
 
-    if (where)
-    {
-      dynstr_append_checked(&query_string, " WHERE ");
-      dynstr_append_checked(&query_string, where);
-    }
+      if (fields_terminated || enclosed || opt_enclosed || escaped)
+        dynstr_append_checked(&query_string, " FIELDS");
+      
+      add_load_option(&query_string, " TERMINATED BY ", fields_terminated);
+      add_load_option(&query_string, " ENCLOSED BY ", enclosed);
+      add_load_option(&query_string, " OPTIONALLY ENCLOSED BY ", opt_enclosed);
+      add_load_option(&query_string, " ESCAPED BY ", escaped);
+      add_load_option(&query_string, " LINES TERMINATED BY ", lines_terminated);
 
-    if (order_by)
-    {
-      dynstr_append_checked(&query_string, " ORDER BY ");
-      dynstr_append_checked(&query_string, order_by);
-    }
+      dynstr_append_checked(&query_string, " FROM ");
+      dynstr_append_checked(&query_string, result_table);
 
-    if (mysql_real_query(mysql, query_string.str, query_string.length))
-    {
-      DB_error(mysql, "when executing 'SELECT INTO OUTFILE'");
-      dynstr_free(&query_string);
-      DBUG_VOID_RETURN;
+      if (where || chunks > 1)
+        dynstr_append_checked(&query_string, " WHERE ");
+      if (where && chunks > 1)
+      {
+        dynstr_append_checked(&query_string, "(");
+        dynstr_append_checked(&query_string, where);
+        dynstr_append_checked(&query_string, ") AND ");
+      }
+      else if (where)
+        dynstr_append_checked(&query_string, where);
+      if (chunks > 1)
+      {
+        ulonglong chunk_start= key_start + chunk * key_step;
+        if (chunk > 0)
+        {
+          longlong10_to_str(chunk_start, value_buff, key_unsigned ? 10 : -10);
+          dynstr_append_checked(&query_string, key_buff);
+          dynstr_append_checked(&query_string, " >= ");
+          dynstr_append_checked(&query_string, value_buff);
+        }
+        if (chunk > 0 && chunk < chunks - 1)
+          dynstr_append_checked(&query_string, " AND ");
+        if (chunk < chunks - 1)
+        {
+          longlong10_to_str(chunk_start + key_step, value_buff,
+                            key_unsigned ? 10 : -10);
+          dynstr_append_checked(&query_string, key_buff);
+          dynstr_append_checked(&query_string, " < ");
+          dynstr_append_checked(&query_string, value_buff);
+        }
+      }
+
+      if (order_by)
+      {
+        dynstr_append_checked(&query_string, " ORDER BY ");
+        dynstr_append_checked(&query_string, order_by);
+      }
+
+      run_outfile_query(db, &query_string);
     }
   }
   else
@@ -5536,6 +6027,7 @@ int main(int argc, char **argv)
   char bin_log_name[FN_REFLEN];
   int exit_code;
   int consistent_binlog_pos= 0;
+  uint i;
   MY_INIT(argv[0]);
 
   sf_leaking_memory=1; /* don't report memory leaks on early exits */
@@ -5574,6 +6066,9 @@ int main(int argc, char **argv)
   if (!path)
     write_header(md_result_file, *argv);
 
+  if (opt_parallel && connect_dump_workers())
+    goto err;
+
   if (opt_slave_data && do_stop_slave_sql(mysql))
     goto err;
 
@@ -5583,8 +6078,12 @@ int main(int argc, char **argv)
     consistent_binlog_pos= check_consistent_binlog_pos(NULL, NULL);
   }
 
+  /*
+    The worker connections of --parallel start their transactions under
+    the global read lock, so that they all see the same snapshot.
+  */
   if ((opt_lock_all_tables || (opt_master_data && !consistent_binlog_pos) ||
-       (opt_single_transaction && flush_logs)) &&
+       (opt_single_transaction && (flush_logs || opt_parallel))) &&
       do_flush_tables_read_lock(mysql))
     goto err;
 
@@ -5615,6 +6114,12 @@ int main(int argc, char **argv)
 
   if (opt_single_transaction && start_transaction(mysql))
     goto err;
+  if (opt_single_transaction)
+  {
+    for (i= 0; i < dump_workers_connected; i++)
+      if (start_transaction(&dump_workers[i].mysql))
+        goto err;
+  }
 
   /* Add 'STOP SLAVE to beginning of dump */
   if (opt_slave_apply && add_stop_slave())
@@ -5626,6 +6131,9 @@ int main(int argc, char **argv)
   if (opt_single_transaction && do_unlock_tables(mysql)) /* unlock but no commit! */
     goto err;
 
+  if (opt_parallel && start_dump_workers())
+    goto err;
+
   if (opt_alltspcs)
     dump_all_tablespaces();
 
@@ -5653,6 +6161,9 @@ int main(int argc, char **argv)
     dump_databases(argv);
   }
 
+  /* The data files must be complete before the slave is started again */
+  wait_for_dump_workers();
+
   /* if --dump-slave , start the slave sql thread */
   if (opt_slave_data && do_start_slave_sql(mysql))
     goto err;
@@ -5682,6 +6193,7 @@ int main(int argc, char **argv)
     server.
   */
 err:
+  stop_dump_workers();
   dbDisconnect(current_host);
   if (!path)
     write_footer(md_result_file);
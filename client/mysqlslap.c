@@ -45,6 +45,15 @@
               --number-int-cols=2 --number-char-cols=3 \
               --auto-generate-sql
 
+  Run an OLTP like load of key lookups, key updates and inserts with
+  prepared statements, at 2000 queries per second in total, and write the
+  results including the latency percentiles as JSON:
+
+    mysqlslap --concurrency=8 --number-of-queries=100000 \
+              --auto-generate-sql --auto-generate-sql-add-autoincrement \
+              --auto-generate-sql-load-type=oltp --prepared-statements \
+              --rate=2000 --json=results.json
+
   Tell the program to load the create, insert and query SQL statements from
   the specified files, where the create.sql file has multiple table creation
   statements delimited by ';' and multiple insert statements delimited by ';'.
@@ -135,7 +144,7 @@ static my_bool opt_preserve= TRUE, opt_no_drop= FALSE;
 static my_bool debug_info_flag= 0, debug_check_flag= 0;
 static my_bool opt_only_print= FALSE;
 static my_bool opt_compress= FALSE, tty_password= FALSE,
-               opt_silent= FALSE,
+               opt_silent= FALSE, opt_prepared_statements= FALSE,
                auto_generate_sql_autoincrement= FALSE,
                auto_generate_sql_guid_primary= FALSE,
                auto_generate_sql= FALSE;
@@ -148,6 +157,8 @@ static unsigned long connect_flags= CLIENT_MULTI_RESULTS |
 static int verbose, delimiter_length;
 static uint commit_rate;
 static uint detach_rate;
+static uint opt_rate;
+static uint auto_generate_sql_read_percent;
 const char *num_int_cols_opt;
 const char *num_char_cols_opt;
 
@@ -173,6 +184,8 @@ uint *concurrency;
 const char *default_dbug_option="d:t:o,/tmp/mysqlslap.trace";
 const char *opt_csv_str;
 File csv_file;
+const char *opt_json_str;
+File json_file;
 
 static uint opt_protocol= 0;
 
@@ -203,12 +216,31 @@ struct option_string {
   option_string *next;
 };
 
+/*
+  Histogram of query latencies, in microseconds.  Values below
+  LATENCY_SUB_BUCKETS have a bucket of their own.  Above that, every power
+  of two is divided into LATENCY_SUB_BUCKETS buckets, which keeps the
+  relative error of the percentiles below 1/LATENCY_SUB_BUCKETS.
+*/
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * 40)
+
+typedef struct latency_histogram latency_histogram;
+
+struct latency_histogram {
+  ulonglong count[LATENCY_BUCKETS];
+  ulonglong total;                      /* Number of queries */
+  ulonglong sum;                        /* Sum of the latencies */
+  ulonglong max;                        /* Highest latency */
+};
+
 typedef struct stats stats;
 
 struct stats {
   long int timing;
   uint users;
   unsigned long long rows;
+  latency_histogram latency;
 };
 
 typedef struct thread_context thread_context;
@@ -216,6 +248,11 @@ typedef struct thread_context thread_context;
 struct thread_context {
   statement *stmt;
   ulonglong limit;
+  /* Where the clients add the latencies of their queries */
+  latency_histogram *latency;
+  /* Number of clients started, protected by sleeper_mutex */
+  uint started;
+  uint clients;
 };
 
 typedef struct conclusions conclusions;
@@ -227,6 +264,8 @@ struct conclusions {
   long int min_timing;
   uint users;
   unsigned long long avg_rows;
+  /* Latencies of all iterations */
+  latency_histogram latency;
   /* The following are not used yet */
   unsigned long long max_rows;
   unsigned long long min_rows;
@@ -241,6 +280,7 @@ static statement *create_statements= NULL,
 /* Prototypes */
 void print_conclusions(conclusions *con);
 void print_conclusions_csv(conclusions *con);
+void print_conclusions_json(conclusions *con);
 void generate_stats(conclusions *con, option_string *eng, stats *sptr);
 uint parse_comma(const char *string, uint **range);
 uint parse_delimiter(const char *script, statement **stmt, char delm);
@@ -264,6 +304,9 @@ void concurrency_loop(MYSQL *mysql, uint current, option_string *eptr);
 static int run_statements(MYSQL *mysql, statement *stmt);
 int slap_connect(MYSQL *mysql);
 static int run_query(MYSQL *mysql, const char *query, int len);
+static int run_prepared(MYSQL *mysql, MYSQL_STMT **stmt, statement *ptr,
+                        ulonglong *rows);
+static void close_prepared_statements(MYSQL_STMT **stmts, uint count);
 
 static const char ALPHANUMERICS[]=
   "0123456789ABCDEFGHIJKLMNOPQRSTWXYZabcdefghijklmnopqrstuvwxyz";
@@ -294,6 +337,82 @@ static int gettimeofday(struct timeval *tp, void *tzp)
 }
 #endif
 
+static uint latency_bucket(ulonglong us)
+{
+  uint shift= 0;
+
+  if (us < LATENCY_SUB_BUCKETS)
+    return (uint) us;
+  while ((us >> shift) >= 2 * LATENCY_SUB_BUCKETS)
+    shift++;
+  return MY_MIN(LATENCY_SUB_BUCKETS * (shift + 1) +
+                (uint) (us >> shift) - LATENCY_SUB_BUCKETS,
+                LATENCY_BUCKETS - 1);
+}
+
+
+/* Highest latency, in microseconds, that is counted in a bucket */
+
+static ulonglong latency_bucket_limit(uint bucket)
+{
+  uint shift;
+
+  if (bucket < LATENCY_SUB_BUCKETS)
+    return bucket;
+  shift= bucket / LATENCY_SUB_BUCKETS - 1;
+  return (((ulonglong) (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS)
+           << shift) + (1ULL << shift) - 1);
+}
+
+
+static void latency_add(latency_histogram *hist, ulonglong us)
+{
+  hist->count[latency_bucket(us)]++;
+  hist->total++;
+  hist->sum+= us;
+  if (us > hist->max)
+    hist->max= us;
+}
+
+
+static void latency_merge(latency_histogram *to, const latency_histogram *from)
+{
+  uint x;
+
+  for (x= 0; x < LATENCY_BUCKETS; x++)
+    to->count[x]+= from->count[x];
+  to->total+= from->total;
+  to->sum+= from->sum;
+  if (from->max > to->max)
+    to->max= from->max;
+}
+
+
+/*
+  Latency, in microseconds, below which the given fraction of the queries
+  completed.  This is the upper limit of the bucket, so the value is never
+  too low.
+*/
+
+static ulonglong latency_percentile(const latency_histogram *hist,
+                                    double fraction)
+{
+  ulonglong rank, seen= 0;
+  uint x;
+
+  if (!hist->total)
+    return 0;
+  rank= (ulonglong) ceil(fraction * hist->total);
+  if (rank == 0)
+    rank= 1;
+  for (x= 0; x < LATENCY_BUCKETS; x++)
+  {
+    if ((seen+= hist->count[x]) >= rank)
+      return MY_MIN(latency_bucket_limit(x), hist->max);
+  }
+  return hist->max;
+}
+
 void set_mysql_connect_options(MYSQL *mysql)
 {
   if (opt_compress)
@@ -532,6 +651,8 @@ void concurrency_loop(MYSQL *mysql, uint current, option_string *eptr)
     print_conclusions(&conclusion);
   if (opt_csv_str)
     print_conclusions_csv(&conclusion);
+  if (opt_json_str)
+    print_conclusions_json(&conclusion);
 
   my_free(head_sptr);
 
@@ -561,9 +682,16 @@ static struct my_option my_long_options[] =
     &auto_generate_sql_guid_primary,
     0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"auto-generate-sql-load-type", OPT_SLAP_AUTO_GENERATE_SQL_LOAD_TYPE,
-    "Specify test load type: mixed, update, write, key, or read; default is mixed.",
+    "Specify test load type: mixed, update, write, key, read, or oltp; "
+    "default is mixed. oltp mixes reads by key with updates by key and "
+    "inserts, see --auto-generate-sql-read-percent.",
    (char**) &auto_generate_sql_type, (char**) &auto_generate_sql_type,
     0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"auto-generate-sql-read-percent", OPT_SLAP_AUTO_GENERATE_READ_PERCENT,
+    "Percentage of reads by key in the oltp load type. The other queries "
+    "are updates by key and inserts, in equal parts.",
+    &auto_generate_sql_read_percent, &auto_generate_sql_read_percent,
+    0, GET_UINT, REQUIRED_ARG, 80, 0, 100, 0, 0, 0},
   {"auto-generate-sql-secondary-indexes", 
     OPT_SLAP_AUTO_GENERATE_SECONDARY_INDEXES, 
     "Number of secondary indexes to add to auto-generated tables.",
@@ -637,6 +765,11 @@ static struct my_option my_long_options[] =
     GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
   {"host", 'h', "Connect to host.", &host, &host, 0, GET_STR,
     REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"json", OPT_SLAP_JSON,
+    "Write the results, including the latency percentiles and histogram, "
+    "as one line of JSON per test to the named file, or to stdout if no "
+    "file is named.",
+    NULL, NULL, 0, GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
   {"init-command", OPT_INIT_COMMAND,
    "SQL Command to execute when connecting to MySQL server. Will "
    "automatically be re-executed when reconnecting.",
@@ -692,9 +825,22 @@ static struct my_option my_long_options[] =
     "system() string to execute before running tests.",
     &pre_system, &pre_system,
     0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"prepared-statements", OPT_SLAP_PREPARED_STATEMENTS,
+    "Run the queries as prepared statements. Each client prepares every "
+    "query once; the key of queries by key is sent as a parameter.",
+    &opt_prepared_statements, &opt_prepared_statements, 0, GET_BOOL, NO_ARG,
+    0, 0, 0, 0, 0, 0},
   {"protocol", OPT_MYSQL_PROTOCOL,
     "The protocol to use for connection (tcp, socket, pipe, memory).",
     0, 0, 0, GET_STR,  REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"rate", OPT_SLAP_RATE,
+    "Number of queries per second to send, for all clients together. "
+    "Each client waits for the scheduled time of its next query; a client "
+    "that is behind schedule sends it as soon as its previous query is "
+    "done. Latency is measured from the scheduled time, so the time spent "
+    "behind schedule is included. 0 sends each query as soon as the "
+    "previous one is done.",
+    &opt_rate, &opt_rate, 0, GET_UINT, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
   {"query", 'q', "Query to run or file containing query to run.",
     &user_supplied_query, &user_supplied_query,
     0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
@@ -786,6 +932,11 @@ get_one_option(int optid, const struct my_option *opt __attribute__((unused)),
       argument= (char *)"-"; /* use stdout */
     opt_csv_str= argument;
     break;
+  case OPT_SLAP_JSON:
+    if (!argument)
+      argument= (char *)"-"; /* use stdout */
+    opt_json_str= argument;
+    break;
 #include <sslopt-case.h>
   case 'V':
     print_version();
@@ -1218,7 +1369,8 @@ get_options(int *argc,char ***argv)
     We are testing to make sure that if someone specified a key search
     that we actually added a key!
   */
-  if (auto_generate_sql && auto_generate_sql_type[0] == 'k')
+  if (auto_generate_sql &&
+      (auto_generate_sql_type[0] == 'k' || auto_generate_sql_type[0] == 'o'))
     if ( auto_generate_sql_autoincrement == FALSE &&
          auto_generate_sql_guid_primary == FALSE)
     {
@@ -1258,6 +1410,26 @@ get_options(int *argc,char ***argv)
     }
   }
 
+  if (opt_json_str)
+  {
+    opt_silent= TRUE;
+
+    if (opt_json_str[0] == '-')
+    {
+      json_file= my_fileno(stdout);
+    }
+    else
+    {
+      if ((json_file= my_open(opt_json_str, O_CREAT|O_WRONLY|O_APPEND,
+                              MYF(0))) == -1)
+      {
+        fprintf(stderr,"%s: Could not open json file: %s\n",
+                my_progname, opt_json_str);
+        exit(1);
+      }
+    }
+  }
+
   if (opt_only_print)
     opt_silent= TRUE;
 
@@ -1361,6 +1533,29 @@ get_options(int *argc,char ***argv)
           ptr_statement->next= build_update_string();
       }
     }
+    else if (auto_generate_sql_type[0] == 'o')
+    {
+      /*
+        Reads by key, with the writes spread evenly between them.  Every
+        other write is an update by key, the rest are inserts.
+      */
+      uint write_percent= 100 - auto_generate_sql_read_percent;
+      ulonglong writes= 0;
+
+      if (verbose >= 2)
+        printf("Generating OLTP Statements for Auto\n");
+      query_statements= build_select_string(TRUE);
+      for (ptr_statement= query_statements, x= 0; 
+           x < auto_generate_sql_unique_query_number; 
+           x++, ptr_statement= ptr_statement->next)
+      {
+        if ((x + 2) * write_percent / 100 > writes)
+          ptr_statement->next= (writes++ % 2) ? build_insert_string() :
+                                                build_update_string();
+        else
+          ptr_statement->next= build_select_string(TRUE);
+      }
+    }
     else /* Mixed mode is default */
     {
       int coin= 0;
@@ -1536,6 +1731,101 @@ static int run_query(MYSQL *mysql, const char *query, int len)
 }
 
 
+/*
+  Run a statement as a prepared statement, preparing it on first use.
+  Queries by key get the key as a parameter.
+*/
+
+static int run_prepared(MYSQL *mysql, MYSQL_STMT **stmt, statement *ptr,
+                        ulonglong *rows)
+{
+  my_bool by_key= (ptr->type == UPDATE_TYPE_REQUIRES_PREFIX ||
+                   ptr->type == SELECT_TYPE_REQUIRES_PREFIX);
+
+  if (!*stmt)
+  {
+    char buffer[HUGE_STRING_LENGTH];
+    size_t length= ptr->length;
+
+    /* Generated statements count the terminating null */
+    if (length && !ptr->string[length - 1])
+      length--;
+    if (by_key)
+      length= snprintf(buffer, sizeof(buffer), "%.*s ?",
+                       (int) length, ptr->string);
+    else
+      length= snprintf(buffer, sizeof(buffer), "%.*s",
+                       (int) length, ptr->string);
+
+    if (verbose >= 3)
+      printf("PREPARE %s;\n", buffer);
+    if (!(*stmt= mysql_stmt_init(mysql)) ||
+        mysql_stmt_prepare(*stmt, buffer, (ulong) length))
+    {
+      fprintf(stderr,"%s: Cannot prepare query %s ERROR : %s\n",
+              my_progname, buffer,
+              *stmt ? mysql_stmt_error(*stmt) : mysql_error(mysql));
+      return 1;
+    }
+  }
+
+  if (by_key)
+  {
+    MYSQL_BIND param;
+    char *key;
+
+    DBUG_ASSERT(primary_keys_number_of);
+    key= primary_keys[random() % primary_keys_number_of];
+
+    bzero(&param, sizeof(param));
+    param.buffer_type= MYSQL_TYPE_STRING;
+    param.buffer= key;
+    param.buffer_length= (ulong) strlen(key);
+    if (mysql_stmt_bind_param(*stmt, &param))
+      goto err;
+  }
+
+  if (mysql_stmt_execute(*stmt))
+    goto err;
+
+  do
+  {
+    if (mysql_stmt_field_count(*stmt))
+    {
+      if (mysql_stmt_store_result(*stmt))
+        fprintf(stderr, "%s: Error when storing result: %d %s\n",
+                my_progname, mysql_stmt_errno(*stmt),
+                mysql_stmt_error(*stmt));
+      else
+        *rows+= mysql_stmt_num_rows(*stmt);
+      mysql_stmt_free_result(*stmt);
+    }
+  } while (mysql_stmt_next_result(*stmt) == 0);
+  return 0;
+
+err:
+  fprintf(stderr,"%s: Cannot run query %.*s ERROR : %s\n",
+          my_progname, (int) ptr->length, ptr->string,
+          mysql_stmt_error(*stmt));
+  return 1;
+}
+
+
+static void close_prepared_statements(MYSQL_STMT **stmts, uint count)
+{
+  uint x;
+
+  for (x= 0; x < count; x++)
+  {
+    if (stmts[x])
+    {
+      mysql_stmt_close(stmts[x]);
+      stmts[x]= NULL;
+    }
+  }
+}
+
+
 static int
 generate_primary_key_list(MYSQL *mysql, option_string *engine_stmt)
 {
@@ -1766,6 +2056,9 @@ run_scheduler(stats *sptr, statement *stmts, uint concur, ulonglong limit)
 
   con.stmt= stmts;
   con.limit= limit;
+  con.latency= &sptr->latency;
+  con.started= 0;
+  con.clients= concur;
 
   pthread_attr_init(&attr);
   pthread_attr_setdetachstate(&attr,
@@ -1828,20 +2121,36 @@ pthread_handler_t run_task(void *p)
   ulonglong counter= 0, queries;
   ulonglong detach_counter;
   unsigned int commit_counter;
+  uint thread_no, stmt_count= 0;
+  ulonglong start_time, query_start;
   MYSQL *mysql;
   MYSQL_RES *result;
   MYSQL_ROW row;
+  MYSQL_STMT **prepared= NULL;
   statement *ptr;
+  latency_histogram *latency;
   thread_context *con= (thread_context *)p;
 
   DBUG_ENTER("run_task");
   DBUG_PRINT("info", ("task script \"%s\"", con->stmt ? con->stmt->string : ""));
 
+  latency= (latency_histogram *)my_malloc(sizeof(latency_histogram),
+                                          MYF(MY_ZEROFILL|MY_FAE|MY_WME));
+  if (opt_prepared_statements && !opt_only_print)
+  {
+    for (ptr= con->stmt; ptr && ptr->length; ptr= ptr->next)
+      stmt_count++;
+    prepared= (MYSQL_STMT **)my_malloc(sizeof(MYSQL_STMT *) *
+                                       (stmt_count + 1),
+                                       MYF(MY_ZEROFILL|MY_FAE|MY_WME));
+  }
+
   pthread_mutex_lock(&sleeper_mutex);
   while (master_wakeup)
   {
     pthread_cond_wait(&sleep_threshhold, &sleeper_mutex);
   }
+  thread_no= con->started++;
   pthread_mutex_unlock(&sleeper_mutex);
 
   if (!(mysql= mysql_init(NULL)))
@@ -1876,6 +2185,12 @@ pthread_handler_t run_task(void *p)
   if (commit_rate)
     run_query(mysql, "SET AUTOCOMMIT=0", strlen("SET AUTOCOMMIT=0"));
 
+  /*
+    With --rate every client sends its queries on a fixed schedule, the
+    clients offset from each other so the queries are spread evenly.
+  */
+  start_time= microsecond_interval_timer();
+
 limit_not_met:
     for (ptr= con->stmt, detach_counter= 0; 
          ptr && ptr->length; 
@@ -1891,13 +2206,33 @@ limit_not_met:
                   my_progname, mysql_error(mysql));
           exit(0);
         }
+        if (prepared)
+          close_prepared_statements(prepared, stmt_count);
         if (slap_connect(mysql))
           goto end;
       }
 
+      if (opt_rate)
+      {
+        ulonglong now;
+        query_start= start_time + (thread_no + queries * con->clients) *
+                                  1000000ULL / opt_rate;
+        if ((now= microsecond_interval_timer()) < query_start)
+          my_sleep((ulong) (query_start - now));
+      }
+      else
+        query_start= microsecond_interval_timer();
+
       /* 
         We have to execute differently based on query type. This should become a function.
       */
+      if (prepared)
+      {
+        if (run_prepared(mysql, prepared + detach_counter % stmt_count, ptr,
+                         &counter))
+          exit(0);
+        goto query_done;
+      }
       if ((ptr->type == UPDATE_TYPE_REQUIRES_PREFIX) ||
           (ptr->type == SELECT_TYPE_REQUIRES_PREFIX))
       {
@@ -1957,6 +2292,8 @@ limit_not_met:
           }
         }
       } while(mysql_next_result(mysql) == 0);
+query_done:
+      latency_add(latency, microsecond_interval_timer() - query_start);
       queries++;
 
       if (commit_rate && (++commit_counter == commit_rate))
@@ -1976,15 +2313,23 @@ end:
   if (commit_rate)
     run_query(mysql, "COMMIT", strlen("COMMIT"));
 
+  if (prepared)
+  {
+    close_prepared_statements(prepared, stmt_count);
+    my_free(prepared);
+  }
+
   if (!opt_only_print) 
     mysql_close(mysql);
 
   mysql_thread_end();
 
   pthread_mutex_lock(&counter_mutex);
+  latency_merge(con->latency, latency);
   thread_counter--;
   pthread_cond_signal(&count_threshhold);
   pthread_mutex_unlock(&counter_mutex);
+  my_free(latency);
 
   DBUG_RETURN(0);
 }
@@ -2158,6 +2503,21 @@ print_conclusions(conclusions *con)
                     con->max_timing / 1000, con->max_timing % 1000);
   printf("\tNumber of clients running queries: %d\n", con->users);
   printf("\tAverage number of queries per client: %llu\n", con->avg_rows); 
+  if (con->latency.total)
+  {
+    ulonglong mean= con->latency.sum / con->latency.total;
+    ulonglong p50= latency_percentile(&con->latency, 0.5);
+    ulonglong p95= latency_percentile(&con->latency, 0.95);
+    ulonglong p99= latency_percentile(&con->latency, 0.99);
+    ulonglong p999= latency_percentile(&con->latency, 0.999);
+    printf("\tQuery latency in milliseconds: mean %llu.%03llu, "
+           "p50 %llu.%03llu, p95 %llu.%03llu, p99 %llu.%03llu, "
+           "p99.9 %llu.%03llu, max %llu.%03llu\n",
+           mean / 1000, mean % 1000, p50 / 1000, p50 % 1000,
+           p95 / 1000, p95 % 1000, p99 / 1000, p99 % 1000,
+           p999 / 1000, p999 % 1000,
+           con->latency.max / 1000, con->latency.max % 1000);
+  }
   printf("\n");
 }
 
@@ -2180,6 +2540,79 @@ print_conclusions_csv(conclusions *con)
   my_write(csv_file, (uchar*) buffer, (uint)strlen(buffer), MYF(0));
 }
 
+static void dynstr_append_latency_ms(DYNAMIC_STRING *str, const char *name,
+                                     ulonglong us)
+{
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "\"%s\":%llu.%03llu", name,
+           us / 1000, us % 1000);
+  dynstr_append(str, buffer);
+}
+
+void
+print_conclusions_json(conclusions *con)
+{
+  DYNAMIC_STRING str;
+  char buffer[HUGE_STRING_LENGTH];
+  const char *ptr= auto_generate_sql_type ? auto_generate_sql_type : "query";
+  const char *eng;
+  ulonglong queries= con->avg_rows * con->users;
+  uint x;
+  my_bool first= TRUE;
+
+  init_dynamic_string(&str, "{\"engine\":\"", 1024, 1024);
+  for (eng= con->engine ? con->engine : ""; *eng; eng++)
+  {
+    if (*eng == '"' || *eng == '\\')
+      dynstr_append_mem(&str, "\\", 1);
+    dynstr_append_mem(&str, eng, 1);
+  }
+  snprintf(buffer, sizeof(buffer),
+           "\",\"load_type\":\"%s\",\"clients\":%u,\"iterations\":%u,"
+           "\"avg_seconds\":%ld.%03ld,\"min_seconds\":%ld.%03ld,"
+           "\"max_seconds\":%ld.%03ld,\"queries_per_client\":%llu,"
+           "\"queries\":%llu,\"queries_per_second\":%llu,\"latency_ms\":{",
+           ptr, con->users, iterations,
+           con->avg_timing / 1000, con->avg_timing % 1000,
+           con->min_timing / 1000, con->min_timing % 1000,
+           con->max_timing / 1000, con->max_timing % 1000,
+           con->avg_rows, queries,
+           con->avg_timing ? queries * 1000 / con->avg_timing : 0);
+  dynstr_append(&str, buffer);
+  dynstr_append_latency_ms(&str, "mean", con->latency.total ?
+                           con->latency.sum / con->latency.total : 0);
+  dynstr_append(&str, ",");
+  dynstr_append_latency_ms(&str, "p50",
+                           latency_percentile(&con->latency, 0.5));
+  dynstr_append(&str, ",");
+  dynstr_append_latency_ms(&str, "p95",
+                           latency_percentile(&con->latency, 0.95));
+  dynstr_append(&str, ",");
+  dynstr_append_latency_ms(&str, "p99",
+                           latency_percentile(&con->latency, 0.99));
+  dynstr_append(&str, ",");
+  dynstr_append_latency_ms(&str, "p999",
+                           latency_percentile(&con->latency, 0.999));
+  dynstr_append(&str, ",");
+  dynstr_append_latency_ms(&str, "max", con->latency.max);
+
+  /* Upper limit in microseconds and count of every bucket that was hit */
+  dynstr_append(&str, "},\"histogram\":[");
+  for (x= 0; x < LATENCY_BUCKETS; x++)
+  {
+    if (!con->latency.count[x])
+      continue;
+    snprintf(buffer, sizeof(buffer), "%s[%llu,%llu]", first ? "" : ",",
+             latency_bucket_limit(x), con->latency.count[x]);
+    dynstr_append(&str, buffer);
+    first= FALSE;
+  }
+  dynstr_append(&str, "]}\n");
+
+  my_write(json_file, (uchar*) str.str, str.length, MYF(0));
+  dynstr_free(&str);
+}
+
 void
 generate_stats(conclusions *con, option_string *eng, stats *sptr)
 {
@@ -2207,6 +2640,9 @@ generate_stats(conclusions *con, option_string *eng, stats *sptr)
   }
   con->avg_timing= con->avg_timing/iterations;
 
+  for (ptr= sptr, x= 0; x < iterations; ptr++, x++)
+    latency_merge(&con->latency, &ptr->latency);
+
   if (eng && eng->string)
     con->engine= eng->string;
   else
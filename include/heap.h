@@ -109,6 +109,12 @@ typedef struct st_heap_block
 
 struct st_heap_info;			/* For referense */
 
+typedef struct st_hp_blob_desc		/* Blob column in record */
+{
+  uint offset;				/* Position of blob in record */
+  uint packlength;			/* Bytes used to store the length */
+} HP_BLOB_DESC;
+
 typedef struct st_hp_keydef		/* Key definition with open */
 {
   uint flag;				/* HA_NOSAME | HA_NULL_PART_KEY */
@@ -134,6 +140,7 @@ typedef struct st_heap_share
 {
   HP_BLOCK block;
   HP_KEYDEF  *keydef;
+  HP_BLOB_DESC *blob_descs;		/* Blob columns, see hp_blob.c */
   ulong min_records,max_records;	/* Params to open */
   ulonglong data_length,index_length,max_table_size;
   uint key_stat_version;                /* version to indicate insert/delete */
@@ -145,6 +152,7 @@ typedef struct st_heap_share
   uint reclength;			/* Length of one record */
   uint changed;
   uint keys,max_key_length;
+  uint blobs;				/* Number of blob columns */
   uint currently_disabled_keys;    /* saved value from "keys" when disabled */
   uint open_count;
   uchar *del_link;			/* Link to next block with del. rec */
@@ -173,6 +181,7 @@ typedef struct st_heap_info
   uint opt_flag,update;
   uchar *lastkey;			/* Last used key with rkey */
   uchar *recbuf;                         /* Record buffer for rb-tree keys */
+  uchar **blob_copies;                  /* Blob values of row being written */
   enum ha_rkey_function last_find_flag;
   TREE_ELEMENT *parents[MAX_TREE_HEIGHT+1];
   TREE_ELEMENT **last_pos;
@@ -188,6 +197,8 @@ typedef struct st_heap_info
 typedef struct st_heap_create_info
 {
   HP_KEYDEF *keydef;
+  HP_BLOB_DESC *blob_descs;
+  uint blobs;
   ulong max_records;
   ulong min_records;
   uint auto_key;                        /* keynr [1 - maxkey] for auto key */
@@ -96,6 +96,8 @@ nolock_wrap(lf_dynarray_iterate, int,
 
 #define LF_PINBOX_PINS 4
 #define LF_PURGATORY_SIZE 100
+/* max. number of reclaimed objects an LF_PINS keeps for its own reuse */
+#define LF_PINS_CACHE_SIZE 32
 
 typedef void lf_pinbox_free_func(void *, void *, void*);
 
@@ -106,6 +108,7 @@ typedef struct {
   uint free_ptr_offset;
   uint32 volatile pinstack_top_ver;         /* this is a versioned pointer */
   uint32 volatile pins_in_array;            /* number of elements in array */
+  void * volatile orphans;    /* purgatory left behind by lf_pinbox_put_pins */
 } LF_PINBOX;
 
 typedef struct {
@@ -113,12 +116,14 @@ typedef struct {
   LF_PINBOX *pinbox;
   void  **stack_ends_here;
   void  *purgatory;
+  void  *cache;                         /* reclaimed objects, for reuse */
   uint32 purgatory_count;
+  uint32 cache_count;
   uint32 volatile link;
 /* we want sizeof(LF_PINS) to be 128 to avoid false sharing */
-  char pad[128-sizeof(uint32)*2
+  char pad[128-sizeof(uint32)*3
               -sizeof(LF_PINBOX *)
-              -sizeof(void*)
+              -sizeof(void*)*2
               -sizeof(void *)*(LF_PINBOX_PINS+1)];
 } LF_PINS;
 
@@ -232,6 +237,8 @@ void lf_hash_destroy(LF_HASH *hash);
 int lf_hash_insert(LF_HASH *hash, LF_PINS *pins, const void *data);
 void *lf_hash_search(LF_HASH *hash, LF_PINS *pins, const void *key, uint keylen);
 int lf_hash_delete(LF_HASH *hash, LF_PINS *pins, const void *key, uint keylen);
+int lf_hash_iterate(LF_HASH *hash, LF_PINS *pins,
+                    my_hash_walk_action action, void *argument);
 /*
   shortcut macros to access underlying pinbox functions from an LF_HASH
   see _lf_pinbox_get_pins() and _lf_pinbox_put_pins()
@@ -446,11 +446,16 @@ void safe_mutex_free_deadlock_data(safe_mutex_t *mp);
 typedef struct st_my_pthread_fastmutex_t
 {
   pthread_mutex_t mutex;
-  uint spins;
+  my_bool spin;                         /* MY_MUTEX_INIT_FAST and SMP */
   uint rng_state;
 } my_pthread_fastmutex_t;
 void fastmutex_global_init(void);
 
+/* Tunables and contention counters of all fast mutexes */
+extern uint my_fastmutex_spin_loops, my_fastmutex_spin_delay;
+void get_fastmutex_stats(ulonglong *spin_waits, ulonglong *spin_rounds,
+                         ulonglong *os_waits);
+
 int my_pthread_fastmutex_init(my_pthread_fastmutex_t *mp, 
                               const pthread_mutexattr_t *attr);
 int my_pthread_fastmutex_lock(my_pthread_fastmutex_t *mp);
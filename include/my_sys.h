@@ -133,6 +133,8 @@ typedef struct my_aio_result {
 #define MY_WAIT_FOR_USER_TO_FIX_PANIC	60	/* in seconds */
 #define MY_WAIT_GIVE_USER_A_MESSAGE	10	/* Every 10 times of prev */
 #define MIN_COMPRESS_LENGTH		50	/* Don't compress small bl. */
+/* Buffer size needed for the compressed data of a packet */
+#define my_compress_bound(len)		((len) * 120 / 100 + 12)
 #define DFLT_INIT_HITS  3
 
 	/* root_alloc flags */
@@ -170,6 +172,8 @@ extern void *my_malloc(size_t Size,myf MyFlags);
 extern void *my_multi_malloc(myf MyFlags, ...);
 extern void *my_realloc(void *oldpoint, size_t Size, myf MyFlags);
 extern void my_free(void *ptr);
+extern void my_malloc_set_thread_specific(void *ptr,
+                                          my_bool is_thread_specific);
 extern void *my_memdup(const void *from,size_t length,myf MyFlags);
 extern char *my_strdup(const char *from,myf MyFlags);
 extern char *my_strndup(const char *from, size_t length, myf MyFlags);
@@ -853,10 +857,18 @@ static inline char *safe_strdup_root(MEM_ROOT *root, const char *str)
 }
 extern char *strmake_root(MEM_ROOT *root,const char *str,size_t len);
 extern void *memdup_root(MEM_ROOT *root,const void *str, size_t len);
+extern ulong my_mem_root_cache_size;
+extern void init_mem_root_cache(void);
+extern void trim_mem_root_cache(void);
+extern void end_mem_root_cache(void);
+extern void get_mem_root_cache_stats(ulonglong *hits, ulonglong *misses,
+                                     ulonglong *bytes);
 extern my_bool my_compress(uchar *, size_t *, size_t *);
 extern my_bool my_uncompress(uchar *, size_t , size_t *);
 extern uchar *my_compress_alloc(const uchar *packet, size_t *len,
                                 size_t *complen);
+extern void my_compress_into(uchar *dest, const uchar *packet, size_t *len,
+                             size_t *complen);
 extern void *my_az_allocator(void *dummy, unsigned int items, unsigned int size);
 extern void my_az_free(void *dummy, void *address);
 extern int my_compress_buffer(uchar *dest, size_t *destLen,
@@ -866,6 +878,9 @@ extern int unpackfrm(uchar **, size_t *, const uchar *);
 
 extern ha_checksum my_checksum(ha_checksum crc, const uchar *mem,
                                size_t count);
+extern void my_crc32c_init(void);
+extern ha_checksum my_crc32c(ha_checksum crc, const uchar *mem,
+                             size_t count);
 #ifndef DBUG_OFF
 extern void my_debug_put_break_here(void);
 #else
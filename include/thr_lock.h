@@ -23,6 +23,7 @@ extern "C" {
 
 #include <my_pthread.h>
 #include <my_list.h>
+#include <my_atomic.h>
 
 struct st_thr_lock;
 extern ulong locks_immediate,locks_waited ;
@@ -82,6 +83,16 @@ enum enum_thr_lock_result { THR_LOCK_SUCCESS= 0, THR_LOCK_ABORTED= 1,
 
 #define THR_UNLOCK_UPDATE_STATUS 1
 
+/*
+  THR_LOCK::fast_read_state holds the number of TL_READ locks taken without
+  lock->mutex in the low bits.  FAST_READ_BLOCKED is set (under lock->mutex)
+  as long as any write lock is active or any lock is waiting; new readers
+  must then go through the mutex.
+  THR_LOCK::fast_read_status counts the fast readers that may be calling
+  get_status() without the mutex.
+*/
+#define THR_LOCK_FAST_READ_BLOCKED (1 << 30)
+
 extern ulong max_write_lock_count;
 extern my_bool thr_lock_inited;
 extern enum thr_lock_type thr_upgraded_concurrent_insert_lock;
@@ -95,6 +106,7 @@ typedef struct st_thr_lock_info
 {
   pthread_t thread;
   my_thread_id thread_id;
+  struct st_thr_lock_data *fast_reads;  /* TL_READ locks taken w/o mutex */
 } THR_LOCK_INFO;
 
 
@@ -109,6 +121,8 @@ typedef struct st_thr_lock_data {
   enum thr_lock_type type;
   enum thr_lock_type org_type;		/* Cache for MariaDB */
   uint priority;
+  struct st_thr_lock_data *next_fast_read; /* In owner->fast_reads */
+  my_bool fast_read;                    /* Counted in fast_read_state */
 } THR_LOCK_DATA;
 
 struct st_lock_list {
@@ -133,7 +147,19 @@ typedef struct st_thr_lock {
   my_bool (*check_status)(void *);
   void   (*fix_status)(void *, void *);/* For thr_merge_locks() */
   const char *name;                     /* Used for error reporting */
+  /* Readers and the blocked flag of the TL_READ fast path, see above */
+  int32 volatile fast_read_state;
+  int32 volatile fast_read_status;
+  my_atomic_rwlock_t fast_read_rwlock;
   my_bool allow_multiple_concurrent_insert;
+  /*
+    Set by the engine if TL_READ locks may be taken without lock->mutex.
+    get_status() is then called for them without the mutex. A write lock
+    request waits until such calls are done before it is handled, so they
+    never run at the same time as the status functions of a write lock,
+    including one for a concurrent insert.
+  */
+  my_bool allow_fast_read;
 } THR_LOCK;
 
 
@@ -38,3 +38,159 @@ ha_checksum my_checksum(ha_checksum crc, const uchar *pos, size_t length)
     my_debug_put_break_here();
   return crc;
 }
+
+
+/*
+  CRC-32C (Castagnoli polynomial 0x1EDC6F41), as computed by the SSE 4.2
+  crc32 instruction. The code is the one of storage/innobase/ut/ut0crc32.cc,
+  extended to continue a running checksum like my_checksum() does:
+  my_crc32c(0, NULL, 0) is the start value, and the result of one call can
+  be passed as start value to the next call over the following bytes.
+*/
+
+static uint32 crc32c_slice8_table[8][256];
+static ha_checksum (*crc32c_func)(ha_checksum crc, const uchar *pos,
+                                  size_t length);
+
+#if defined(__GNUC__) && defined(__x86_64__)
+static my_bool crc32c_cpu_has_sse42(void)
+{
+  uint32 features_ecx, features_edx, sig;
+  __asm__("cpuid" : "=a" (sig), "=c" (features_ecx), "=d" (features_edx)
+      : "a" (1)
+      : "ebx");
+  return (features_ecx >> 20) & 1;
+}
+
+/* opcodes of "crc32b (%%rdx), %%rcx" and "crc32q (%%rdx), %%rcx" */
+#define crc32c_sse42_byte \
+  __asm__(".byte 0xf2, 0x48, 0x0f, 0x38, 0xf0, 0x0a" \
+      : "=c"(crc) : "c"(crc), "d"(pos)); \
+  length--, pos++
+
+#define crc32c_sse42_quadword \
+  __asm__(".byte 0xf2, 0x48, 0x0f, 0x38, 0xf1, 0x0a" \
+      : "=c"(crc) : "c"(crc), "d"(pos)); \
+  length-= 8, pos+= 8
+
+static ha_checksum crc32c_sse42(ha_checksum crc_arg, const uchar *pos,
+                                size_t length)
+{
+  ulonglong crc= (uint32) ~crc_arg;
+
+  while (length && ((size_t) pos & 7))
+  {
+    crc32c_sse42_byte;
+  }
+  while (length >= 32)
+  {
+    crc32c_sse42_quadword;
+    crc32c_sse42_quadword;
+    crc32c_sse42_quadword;
+    crc32c_sse42_quadword;
+  }
+  while (length >= 8)
+  {
+    crc32c_sse42_quadword;
+  }
+  while (length)
+  {
+    crc32c_sse42_byte;
+  }
+  return (ha_checksum) ~crc;
+}
+#endif /* defined(__GNUC__) && defined(__x86_64__) */
+
+static void crc32c_slice8_table_init(void)
+{
+  /* bit-reversed poly 0x1EDC6F41 */
+  static const uint32 poly= 0x82f63b78;
+  uint32 n, k, c;
+
+  for (n= 0; n < 256; n++)
+  {
+    c= n;
+    for (k= 0; k < 8; k++)
+      c= (c & 1) ? (poly ^ (c >> 1)) : (c >> 1);
+    crc32c_slice8_table[0][n]= c;
+  }
+  for (n= 0; n < 256; n++)
+  {
+    c= crc32c_slice8_table[0][n];
+    for (k= 1; k < 8; k++)
+    {
+      c= crc32c_slice8_table[0][c & 0xFF] ^ (c >> 8);
+      crc32c_slice8_table[k][n]= c;
+    }
+  }
+}
+
+static ha_checksum crc32c_slice8(ha_checksum crc_arg, const uchar *pos,
+                                 size_t length)
+{
+  uint32 crc= (uint32) ~crc_arg;
+
+  while (length && ((size_t) pos & 3))
+  {
+    crc= (crc >> 8) ^ crc32c_slice8_table[0][(crc ^ *pos++) & 0xFF];
+    length--;
+  }
+  while (length >= 8)
+  {
+    /* Little-endian byte order, as the table layout assumes */
+    uint32 lo= crc ^ uint4korr(pos);
+    uint32 hi= uint4korr(pos + 4);
+    crc= crc32c_slice8_table[7][lo & 0xFF] ^
+         crc32c_slice8_table[6][(lo >> 8) & 0xFF] ^
+         crc32c_slice8_table[5][(lo >> 16) & 0xFF] ^
+         crc32c_slice8_table[4][lo >> 24] ^
+         crc32c_slice8_table[3][hi & 0xFF] ^
+         crc32c_slice8_table[2][(hi >> 8) & 0xFF] ^
+         crc32c_slice8_table[1][(hi >> 16) & 0xFF] ^
+         crc32c_slice8_table[0][hi >> 24];
+    pos+= 8;
+    length-= 8;
+  }
+  while (length)
+  {
+    crc= (crc >> 8) ^ crc32c_slice8_table[0][(crc ^ *pos++) & 0xFF];
+    length--;
+  }
+  return (ha_checksum) ~crc;
+}
+
+/*
+  Pick the CRC-32C implementation for this CPU. Called from my_init().
+*/
+
+void my_crc32c_init(void)
+{
+  if (crc32c_func)
+    return;
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(HAVE_valgrind)
+  /* Valgrind does not understand the crc32 instruction */
+  if (crc32c_cpu_has_sse42())
+  {
+    crc32c_func= crc32c_sse42;
+    return;
+  }
+#endif
+  crc32c_slice8_table_init();
+  crc32c_func= crc32c_slice8;
+}
+
+/*
+  Calculate a CRC-32C checksum for a memory block.
+
+  SYNOPSIS
+    my_crc32c()
+      crc       start value for crc
+      pos       pointer to memory block
+      length    length of the block
+*/
+
+ha_checksum my_crc32c(ha_checksum crc, const uchar *pos, size_t length)
+{
+  DBUG_ASSERT(crc32c_func);
+  return crc32c_func(crc, pos, length);
+}
@@ -98,6 +98,16 @@
   It is assumed that pins belong to a THD and are not transferable
   between THD's (LF_PINS::stack_ends_here being a primary reason
   for this limitation).
+
+  Objects that are still pinned when their owner puts the pins back are
+  not waited for; they are moved to the "orphans" list of the pinbox and
+  the next purgatory scan of any thread takes them over.
+
+  Unpinned objects found by a purgatory scan are first kept in the
+  (thread-local) cache of the LF_PINS, up to LF_PINS_CACHE_SIZE of them,
+  and the next lf_alloc_new() calls of that thread take them from there
+  without touching the shared allocator stack.  Only the rest, and the
+  cache when the pins are put back, go to the shared stack.
 */
 #include <my_global.h>
 #include <my_sys.h>
@@ -105,8 +115,20 @@
 
 #define LF_PINBOX_MAX_PINS 65536
 
+#define next_node(P, X) (*((uchar * volatile *)(((uchar *)(X)) + (P)->free_ptr_offset)))
+#define anext_node(X) next_node(&allocator->pinbox, (X))
+
 static void _lf_pinbox_real_free(LF_PINS *pins);
 
+/* the last element of a non-empty list linked via free_ptr_offset */
+static void *list_last(LF_PINBOX *pinbox, void *node)
+{
+  void *next;
+  while ((next= next_node(pinbox, node)))
+    node= next;
+  return node;
+}
+
 /*
   Initialize a pinbox. Normally called from lf_alloc_init.
   See the latter for details.
@@ -119,13 +141,23 @@ void lf_pinbox_init(LF_PINBOX *pinbox, uint free_ptr_offset,
   lf_dynarray_init(&pinbox->pinarray, sizeof(LF_PINS));
   pinbox->pinstack_top_ver= 0;
   pinbox->pins_in_array= 0;
+  pinbox->orphans= 0;
   pinbox->free_ptr_offset= free_ptr_offset;
   pinbox->free_func= free_func;
   pinbox->free_func_arg= free_func_arg;
 }
 
+/*
+  Destroy a pinbox. Nobody may use it any more, so whatever is left in
+  the orphans list is not pinned and is freed.
+*/
 void lf_pinbox_destroy(LF_PINBOX *pinbox)
 {
+  void *first= pinbox->orphans;
+  if (first)
+    pinbox->free_func(first, list_last(pinbox, first),
+                      pinbox->free_func_arg);
+  pinbox->orphans= 0;
   lf_dynarray_destroy(&pinbox->pinarray);
 }
 
@@ -187,7 +219,10 @@ LF_PINS *_lf_pinbox_get_pins(LF_PINBOX *pinbox)
     - if element is free, it's its next element in the free stack
   */
   el->link= pins;
+  el->purgatory= 0;
   el->purgatory_count= 0;
+  el->cache= 0;
+  el->cache_count= 0;
   el->pinbox= pinbox;
   var= my_thread_var;
   /*
@@ -203,13 +238,14 @@ LF_PINS *_lf_pinbox_get_pins(LF_PINBOX *pinbox)
   lf_hash_put_pins().
 
   DESCRIPTION
-    empty the purgatory (XXX deadlock warning below!),
-    push LF_PINS structure to a stack
+    empty the purgatory, hand what is still pinned over to the pinbox,
+    return the cache to the allocator, push LF_PINS structure to a stack
 */
 void _lf_pinbox_put_pins(LF_PINS *pins)
 {
   LF_PINBOX *pinbox= pins->pinbox;
   uint32 top_ver, nr;
+  void *first, *last;
   nr= pins->link;
 
 #ifndef DBUG_OFF
@@ -221,22 +257,35 @@ void _lf_pinbox_put_pins(LF_PINS *pins)
   }
 #endif /* DBUG_OFF */
 
+  if (pins->purgatory_count)
+    _lf_pinbox_real_free(pins);
+
   /*
-    XXX this will deadlock if other threads will wait for
-    the caller to do something after _lf_pinbox_put_pins(),
-    and they would have pinned addresses that the caller wants to free.
-    Thus: only free pins when all work is done and nobody can wait for you!!!
+    Don't wait until other threads unpin the rest of the purgatory, they
+    may be waiting for us.  Whoever scans a purgatory next frees them.
   */
-  while (pins->purgatory_count)
+  if ((first= pins->purgatory))
   {
-    _lf_pinbox_real_free(pins);
-    if (pins->purgatory_count)
+    union { void *node; void *ptr; } tmp;
+    last= list_last(pinbox, first);
+    tmp.node= pinbox->orphans;
+    do
     {
-      my_atomic_rwlock_wrunlock(&pins->pinbox->pinarray.lock);
-      pthread_yield();
-      my_atomic_rwlock_wrlock(&pins->pinbox->pinarray.lock);
-    }
+      next_node(pinbox, last)= tmp.node;
+    } while (!my_atomic_casptr((void **)(char *)&pinbox->orphans,
+                               &tmp.ptr, first) && LF_BACKOFF);
+    pins->purgatory= 0;
+    pins->purgatory_count= 0;
   }
+
+  if ((first= pins->cache))
+  {
+    pinbox->free_func(first, list_last(pinbox, first),
+                      pinbox->free_func_arg);
+    pins->cache= 0;
+    pins->cache_count= 0;
+  }
+
   top_ver= pinbox->pinstack_top_ver;
   do
   {
@@ -328,44 +377,55 @@ static int match_pins(LF_PINS *el, void *addr)
 #define available_stack_size(CUR,END) (long) ((char*)(END) - (char*)(CUR))
 #endif
 
-#define next_node(P, X) (*((uchar * volatile *)(((uchar *)(X)) + (P)->free_ptr_offset)))
-#define anext_node(X) next_node(&allocator->pinbox, (X))
-
 /*
   Scan the purgatory and free everything that can be freed
 */
 static void _lf_pinbox_real_free(LF_PINS *pins)
 {
-  int npins;
+  int npins, granary_size;
   void *list;
-  void **addr= NULL;
+  void **addr= NULL, **granary= NULL;
   void *first= NULL, *last= NULL;
   LF_PINBOX *pinbox= pins->pinbox;
 
+  /* take over the purgatories of the pins that were put back */
+  if (pinbox->orphans)
+  {
+    list= my_atomic_fasptr((void * volatile *)&pinbox->orphans, NULL);
+    while (list)
+    {
+      void *cur= list;
+      list= next_node(pinbox, cur);
+      add_to_purgatory(pins, cur);
+    }
+  }
+
   npins= pinbox->pins_in_array+1;
+  granary_size= sizeof(void *)*LF_PINBOX_PINS*npins;
 
 #ifdef HAVE_ALLOCA
-  if (pins->stack_ends_here != NULL)
+  if (pins->stack_ends_here != NULL &&
+      available_stack_size(&pinbox, *pins->stack_ends_here) > granary_size)
+    addr= (void **) alloca(granary_size);
+#endif
+  /* a linear search for every object is much slower than a malloc */
+  if (!addr)
+    addr= granary= (void **) my_malloc(granary_size, MYF(0));
+  if (addr)
   {
-    int alloca_size= sizeof(void *)*LF_PINBOX_PINS*npins;
     /* create a sorted list of pinned addresses, to speed up searches */
-    if (available_stack_size(&pinbox, *pins->stack_ends_here) > alloca_size)
-    {
-      struct st_harvester hv;
-      addr= (void **) alloca(alloca_size);
-      hv.granary= addr;
-      hv.npins= npins;
-      /* scan the dynarray and accumulate all pinned addresses */
-      _lf_dynarray_iterate(&pinbox->pinarray,
-                           (lf_dynarray_func)harvest_pins, &hv);
-
-      npins= hv.granary-addr;
-      /* and sort them */
-      if (npins)
-        qsort(addr, npins, sizeof(void *), (qsort_cmp)ptr_cmp);
-    }
+    struct st_harvester hv;
+    hv.granary= addr;
+    hv.npins= npins;
+    /* scan the dynarray and accumulate all pinned addresses */
+    _lf_dynarray_iterate(&pinbox->pinarray,
+                         (lf_dynarray_func)harvest_pins, &hv);
+
+    npins= hv.granary-addr;
+    /* and sort them */
+    if (npins)
+      qsort(addr, npins, sizeof(void *), (qsort_cmp)ptr_cmp);
   }
-#endif
 
   list= pins->purgatory;
   pins->purgatory= 0;
@@ -389,14 +449,21 @@ static void _lf_pinbox_real_free(LF_PINS *pins)
         if (cur == *a || cur == *b)
           goto found;
       }
-      else /* no alloca - no cookie. linear search here */
+      else /* no memory - no cookie. linear search here */
       {
         if (_lf_dynarray_iterate(&pinbox->pinarray,
                                  (lf_dynarray_func)match_pins, cur))
           goto found;
       }
     }
-    /* not pinned - freeing */
+    /* not pinned - keep it for our own reuse, or free it */
+    if (pins->cache_count < LF_PINS_CACHE_SIZE)
+    {
+      next_node(pinbox, cur)= (uchar *)pins->cache;
+      pins->cache= cur;
+      pins->cache_count++;
+      continue;
+    }
     if (last)
       last= next_node(pinbox, last)= (uchar *)cur;
     else
@@ -408,6 +475,7 @@ found:
   }
   if (last)
     pinbox->free_func(first, last, pinbox->free_func_arg);
+  my_free(granary);
 }
 
 /* lock-free memory allocator for fixed-size objects */
@@ -475,7 +543,10 @@ void lf_alloc_init(LF_ALLOCATOR *allocator, uint size, uint free_ptr_offset)
 */
 void lf_alloc_destroy(LF_ALLOCATOR *allocator)
 {
-  uchar *node= allocator->top;
+  uchar *node;
+  /* this moves the orphans to the stack */
+  lf_pinbox_destroy(&allocator->pinbox);
+  node= allocator->top;
   while (node)
   {
     uchar *tmp= anext_node(node);
@@ -484,7 +555,6 @@ void lf_alloc_destroy(LF_ALLOCATOR *allocator)
     my_free(node);
     node= tmp;
   }
-  lf_pinbox_destroy(&allocator->pinbox);
   allocator->top= 0;
 }
 
@@ -492,13 +562,21 @@ void lf_alloc_destroy(LF_ALLOCATOR *allocator)
   Allocate and return an new object.
 
   DESCRIPTION
-    Pop an unused object from the stack or malloc it is the stack is empty.
+    Take an object from the cache of the pins, or pop an unused object
+    from the stack, or malloc it is the stack is empty.
     pin[0] is used, it's removed on return.
 */
 void *_lf_alloc_new(LF_PINS *pins)
 {
   LF_ALLOCATOR *allocator= (LF_ALLOCATOR *)(pins->pinbox->free_func_arg);
   uchar *node;
+  if ((node= pins->cache))
+  {
+    /* nobody else can see the cache, no pinning needed */
+    pins->cache= anext_node(node);
+    pins->cache_count--;
+    return node;
+  }
   for (;;)
   {
     do
@@ -62,16 +62,22 @@ typedef struct {
     Search for hashnr/key/keylen in the list starting from 'head' and
     position the cursor. The list is ORDER BY hashnr, key
 
+    If callback is not 0, the whole list is walked instead and callback
+    is called for every normal (not dummy) element with the element data
+    and 'key' as arguments, until it returns TRUE.
+
   RETURN
     0 - not found
-    1 - found
+    1 - found (or the callback returned TRUE)
 
   NOTE
     cursor is positioned in either case
     pins[0..2] are used, they are NOT removed on return
+    the element passed to the callback is pinned by pins[1]
 */
 static int lfind(LF_SLIST * volatile *head, CHARSET_INFO *cs, uint32 hashnr,
-                 const uchar *key, uint keylen, CURSOR *cursor, LF_PINS *pins)
+                 const uchar *key, uint keylen, CURSOR *cursor, LF_PINS *pins,
+                 my_hash_walk_action callback)
 {
   uint32       cur_hashnr;
   const uchar  *cur_key;
@@ -104,7 +110,12 @@ retry:
     }
     if (!DELETED(link))
     {
-      if (cur_hashnr >= hashnr)
+      if (unlikely(callback))
+      {
+        if ((cur_hashnr & 1) && callback(cursor->curr + 1, (void*) key))
+          return 1;
+      }
+      else if (cur_hashnr >= hashnr)
       {
         int r= 1;
         if (cur_hashnr > hashnr ||
@@ -157,7 +168,7 @@ static LF_SLIST *linsert(LF_SLIST * volatile *head, CHARSET_INFO *cs,
   for (;;)
   {
     if (lfind(head, cs, node->hashnr, node->key, node->keylen,
-              &cursor, pins) &&
+              &cursor, pins, 0) &&
         (flags & LF_HASH_UNIQUE))
     {
       res= 0; /* duplicate found */
@@ -208,7 +219,7 @@ static int ldelete(LF_SLIST * volatile *head, CHARSET_INFO *cs, uint32 hashnr,
 
   for (;;)
   {
-    if (!lfind(head, cs, hashnr, key, keylen, &cursor, pins))
+    if (!lfind(head, cs, hashnr, key, keylen, &cursor, pins, 0))
     {
       res= 1; /* not found */
       break;
@@ -232,7 +243,7 @@ static int ldelete(LF_SLIST * volatile *head, CHARSET_INFO *cs, uint32 hashnr,
             (to ensure the number of "set DELETED flag" actions
             is equal to the number of "remove from the list" actions)
           */
-          lfind(head, cs, hashnr, key, keylen, &cursor, pins);
+          lfind(head, cs, hashnr, key, keylen, &cursor, pins, 0);
         }
         res= 0;
         break;
@@ -263,7 +274,7 @@ static LF_SLIST *lsearch(LF_SLIST * volatile *head, CHARSET_INFO *cs,
                          LF_PINS *pins)
 {
   CURSOR cursor;
-  int res= lfind(head, cs, hashnr, key, keylen, &cursor, pins);
+  int res= lfind(head, cs, hashnr, key, keylen, &cursor, pins, 0);
   if (res)
     _lf_pin(pins, 2, cursor.curr);
   else
@@ -466,6 +477,47 @@ void *lf_hash_search(LF_HASH *hash, LF_PINS *pins, const void *key, uint keylen)
   return found ? found+1 : 0;
 }
 
+/*
+  DESCRIPTION
+    Calls 'action' for every element of the hash, with the element and
+    'argument' as arguments, until it returns TRUE.
+
+    The element passed to 'action' is pinned, but the same pins must not
+    be used by 'action' itself. Elements inserted or deleted concurrently
+    may or may not be visited.
+
+  RETURN
+    0 - all elements were visited
+    1 - 'action' returned TRUE
+*/
+int lf_hash_iterate(LF_HASH *hash, LF_PINS *pins,
+                    my_hash_walk_action action, void *argument)
+{
+  CURSOR cursor;
+  int res;
+  LF_SLIST * volatile *el;
+
+  lf_rwlock_by_pins(pins);
+  el= _lf_dynarray_lvalue(&hash->array, 0);
+  if (unlikely(!el))
+  {
+    lf_rwunlock_by_pins(pins);
+    return 0; /* if there is no bucket 0, the hash is empty */
+  }
+  if (*el == NULL && unlikely(initialize_bucket(hash, el, 0, pins)))
+  {
+    lf_rwunlock_by_pins(pins);
+    return 0;
+  }
+  /* bucket 0 heads the list of all elements */
+  res= lfind(el, 0, 0, (uchar*) argument, 0, &cursor, pins, action);
+  _lf_unpin(pins, 2);
+  _lf_unpin(pins, 1);
+  _lf_unpin(pins, 0);
+  lf_rwunlock_by_pins(pins);
+  return res;
+}
+
 static const uchar *dummy_key= (uchar*)"";
 
 /*
@@ -71,6 +71,17 @@
   free blocks. blocks_used is the number of blocks fetched from the pool and
   as such gives the maximum number of in-use blocks at any time.
 
+  A read of at most KEYCACHE_MAX_LOCKED_COPY bytes that finds its page in
+  a block that nobody is changing copies the data while holding cache_lock
+  and does not register a request on the block (see find_block_for_read()).
+  The block is then not moved in the LRU ring; it is only marked
+  BLOCK_REFERENCED, like the reference bit of a CLOCK cache. The move is
+  done later, when the block comes up for eviction or for aging from the
+  hot to the warm sub-chain (see relink_referenced_block()). A block hit
+  takes thus only the hash lookup and the copy under cache_lock. Larger
+  reads register a request and release cache_lock for the copy, so that
+  other threads don't wait for it.
+
   Key Cache Locking
   =================
 
@@ -236,6 +247,10 @@ typedef struct st_simple_key_cache_cb
     if the KEYCACHE_DEBUG flag is not set up and we are in a debug
     mode, i.e. when ! defined(DBUG_OFF), the debug information from the
     module is sent to the regular debug log.
+  - to set the largest read of a page in the cache that is copied while
+    holding cache_lock, without registering a request on the block
+    (default 1024, the default MyISAM index block size), add
+      #define KEYCACHE_MAX_LOCKED_COPY <N>
 
   Example of the settings:
     #define SERIALIZED_READ_FROM_CACHE
@@ -245,6 +260,10 @@ typedef struct st_simple_key_cache_cb
     #define KEYCACHE_DEBUG_LOG  "my_key_cache_debug.log"
 */
 
+#ifndef KEYCACHE_MAX_LOCKED_COPY
+#define KEYCACHE_MAX_LOCKED_COPY 1024
+#endif
+
 #define STRUCT_PTR(TYPE, MEMBER, a)                                           \
           (TYPE *) ((char *) (a) - offsetof(TYPE, MEMBER))
 
@@ -283,6 +302,7 @@ struct st_hash_link
 #define BLOCK_IN_EVICTION   128 /* block is selected for eviction            */
 #define BLOCK_IN_FLUSHWRITE 256 /* block is in write to file                 */
 #define BLOCK_FOR_UPDATE    512 /* block is selected for buffer modification */
+#define BLOCK_REFERENCED   1024 /* hit without a request since linked in LRU */
 
 /* page status, returned by find_key_block */
 #define PAGE_READ               0
@@ -1398,6 +1418,7 @@ static void link_block(SIMPLE_KEY_CACHE_CB *keycache, BLOCK_LINK *block,
       probably easier to read.
     */
     block->status|= BLOCK_IN_EVICTION;
+    block->status&= ~BLOCK_REFERENCED;
     KEYCACHE_THREAD_TRACE("link_block: after signaling");
 #if defined(KEYCACHE_DEBUG)
     KEYCACHE_DBUG_PRINT("link_block",
@@ -1522,6 +1543,47 @@ static void reg_requests(SIMPLE_KEY_CACHE_CB *keycache,
 }
 
 
+/*
+  Give a referenced block the move in the LRU ring it missed at its hits
+
+  SYNOPSIS
+    relink_referenced_block()
+      keycache          Pointer to a key cache data structure.
+      block             Pointer to a block in the LRU ring.
+
+  NOTE
+    The block is linked at the end of the hot or warm sub-chain, as
+    unreg_request() would have done at a hit with a registered request.
+    The caller must make sure that no thread waits for a block, so that
+    link_block() puts the block back in the LRU ring.
+
+  RETURN
+    void
+*/
+
+static void relink_referenced_block(SIMPLE_KEY_CACHE_CB *keycache,
+                                    BLOCK_LINK *block)
+{
+  my_bool hot;
+  DBUG_ASSERT(block->status & BLOCK_REFERENCED);
+  DBUG_ASSERT(!keycache->waiting_for_block.last_thread);
+
+  unlink_block(keycache, block);
+  block->status&= ~BLOCK_REFERENCED;
+  hot= !block->hits_left &&
+    keycache->warm_blocks > keycache->min_warm_blocks;
+  if (hot)
+  {
+    if (block->temperature == BLOCK_WARM)
+      keycache->warm_blocks--;
+    block->temperature= BLOCK_HOT;
+  }
+  link_block(keycache, block, hot, 1);
+  block->last_hit_time= keycache->keycache_time;
+  keycache->keycache_time++;
+}
+
+
 /*
   Unregister request for a block
   linking it to the LRU chain if it's the last request
@@ -1570,6 +1632,8 @@ static void unreg_request(SIMPLE_KEY_CACHE_CB *keycache,
   if (!--block->requests && !(block->status & BLOCK_ERROR))
   {
     my_bool hot;
+    /* Hits without a request while we had it are covered by this move */
+    block->status&= ~BLOCK_REFERENCED;
     if (block->hits_left)
       block->hits_left--;
     hot= !block->hits_left && at_end &&
@@ -1604,15 +1668,24 @@ static void unreg_request(SIMPLE_KEY_CACHE_CB *keycache,
     if (block && keycache->keycache_time - block->last_hit_time >
 	keycache->age_threshold)
     {
-      unlink_block(keycache, block);
-      link_block(keycache, block, 0, 0);
-      if (block->temperature != BLOCK_WARM)
+      if ((block->status & BLOCK_REFERENCED) &&
+          !keycache->waiting_for_block.last_thread)
       {
-        keycache->warm_blocks++;
-        block->temperature= BLOCK_WARM;
+        /* The block has been hit since it was linked; Don't age it */
+        relink_referenced_block(keycache, block);
+      }
+      else
+      {
+        unlink_block(keycache, block);
+        link_block(keycache, block, 0, 0);
+        if (block->temperature != BLOCK_WARM)
+        {
+          keycache->warm_blocks++;
+          block->temperature= BLOCK_WARM;
+        }
+        KEYCACHE_DBUG_PRINT("unreg_request", ("#warm_blocks: %lu",
+                             keycache->warm_blocks));
       }
-      KEYCACHE_DBUG_PRINT("unreg_request", ("#warm_blocks: %lu",
-                           keycache->warm_blocks));
     }
   }
 }
@@ -2333,8 +2406,15 @@ restart:
         block= hash_link->block;
         if (! block)
         {
-          /* Select the last block from the LRU ring. */
-          block= keycache->used_last->next_used;
+          /*
+            Select the last block from the LRU ring. Blocks that have been
+            hit since they were linked get a second chance.
+          */
+          while (((block= keycache->used_last->next_used)->status &
+                  BLOCK_REFERENCED) &&
+                 !keycache->waiting_for_block.last_thread)
+            relink_referenced_block(keycache, block);
+          block->status&= ~BLOCK_REFERENCED;
           block->hits_left= init_hits_left;
           block->last_hit_time= 0;
           hash_link->block= block;
@@ -2692,6 +2772,57 @@ static void read_block(SIMPLE_KEY_CACHE_CB *keycache,
 }
 
 
+/*
+  Find a block that can be read without registering a request on it
+
+  SYNOPSIS
+    find_block_for_read()
+      keycache            pointer to a key cache data structure
+      file                handler for the file to read page from
+      filepos             position of the page in the file
+      length              length of the data to read from the block
+
+  DESCRIPTION
+    Returns the block with the contents of the page if the page is in the
+    cache and the block is not in switch, in eviction, to be freed or
+    modified by another thread. Such a block cannot change while we hold
+    cache_lock, so the data can be copied from it right away. This is
+    what a request would protect the block against otherwise.
+    The hit is noted in the block only; It is moved in the LRU ring when
+    it is selected for eviction or aging (see relink_referenced_block()).
+
+  RETURN VALUE
+    Pointer to the block, 0 if the read must go through find_key_block()
+*/
+
+static BLOCK_LINK *find_block_for_read(SIMPLE_KEY_CACHE_CB *keycache,
+                                       File file, my_off_t filepos,
+                                       uint length)
+{
+  HASH_LINK *hash_link;
+  BLOCK_LINK *block;
+
+  if (keycache->in_resize)
+    return 0;
+  hash_link= keycache->hash_root[KEYCACHE_HASH(file, filepos)];
+  while (hash_link &&
+         (hash_link->diskpos != filepos || hash_link->file != file))
+    hash_link= hash_link->next;
+  if (!hash_link || !(block= hash_link->block) ||
+      block->hash_link != hash_link ||
+      (block->status & (BLOCK_READ | BLOCK_ERROR | BLOCK_IN_SWITCH |
+                        BLOCK_REASSIGNED | BLOCK_IN_EVICTION |
+                        BLOCK_FOR_UPDATE)) != BLOCK_READ ||
+      block->length < length)
+    return 0;
+
+  if (block->hits_left)
+    block->hits_left--;
+  block->status|= BLOCK_REFERENCED;
+  return block;
+}
+
+
 /*
   Read a block of data from a simple key cache into a buffer
 
@@ -2816,6 +2947,16 @@ uchar *simple_key_cache_read(SIMPLE_KEY_CACHE_CB *keycache,
 
       MYSQL_KEYCACHE_READ_BLOCK(keycache->key_cache_block_size);
 
+      if (read_length <= KEYCACHE_MAX_LOCKED_COPY &&
+          (block= find_block_for_read(keycache, file, filepos,
+                                      read_length + offset)))
+      {
+        MYSQL_KEYCACHE_READ_HIT();
+        /* Copy data from the cache buffer, under cache_lock */
+        memcpy(buff, block->buffer+offset, (size_t) read_length);
+        goto next_block;
+      }
+
       block=find_key_block(keycache, file, filepos, level, 0, &page_st);
       if (!block)
       {
@@ -16,9 +16,9 @@
 
 /* Routines to handle mallocing of results which will be freed the same time */
 
-#include <my_global.h>
-#include <my_sys.h>
+#include "mysys_priv.h"
 #include <m_string.h>
+#include <my_atomic.h>
 #undef EXTRA_DEBUG
 #define EXTRA_DEBUG
 
@@ -26,6 +26,243 @@
 
 #define MALLOC_FLAG(A) ((A & 1) ? MY_THREAD_SPECIFIC : 0)
 
+/*
+  Cache of free memory root blocks
+
+  free_root() gives blocks of common sizes to this cache instead of freeing
+  them and alloc_root() takes them from here before calling my_malloc(), so
+  that a busy server doesn't malloc and free the same blocks for every
+  statement and connection.
+
+  While the cache is enabled, block sizes between MEM_ROOT_CACHE_MIN_SIZE
+  and MEM_ROOT_CACHE_MAX_SIZE are rounded up to a multiple of
+  MEM_ROOT_CACHE_GRANULARITY. Each such size has its own list of free
+  blocks. The total size of the cached blocks is limited by
+  my_mem_root_cache_size.
+
+  Cached blocks are not thread specific. A block is given to the calling
+  thread with my_malloc_set_thread_specific() when it's taken by a
+  MY_THREAD_SPECIFIC memory root, which keeps the memory usage of each
+  thread correct.
+*/
+
+#define MEM_ROOT_CACHE_GRANULARITY 1024
+#define MEM_ROOT_CACHE_CLASSES     64
+#define MEM_ROOT_CACHE_MIN_SIZE    (2 * MEM_ROOT_CACHE_GRANULARITY)
+#define MEM_ROOT_CACHE_MAX_SIZE    (MEM_ROOT_CACHE_CLASSES * \
+                                    MEM_ROOT_CACHE_GRANULARITY)
+
+typedef struct st_mem_root_cache_class
+{
+  mysql_mutex_t lock;
+  USED_MEM *blocks;                     /* Free blocks of this size */
+  ulonglong hits, misses;
+} MEM_ROOT_CACHE_CLASS;
+
+static MEM_ROOT_CACHE_CLASS mem_root_cache[MEM_ROOT_CACHE_CLASSES];
+static my_bool mem_root_cache_inited= 0;
+static my_atomic_rwlock_t mem_root_cache_rwlock;
+static volatile int64 mem_root_cache_bytes= 0;
+
+/* Max total size of cached blocks, 0 disables the cache */
+ulong my_mem_root_cache_size= 0;
+
+
+static inline my_bool mem_root_cache_enabled(void)
+{
+  return mem_root_cache_inited && my_mem_root_cache_size != 0;
+}
+
+static inline MEM_ROOT_CACHE_CLASS *mem_root_cache_class(size_t size)
+{
+#if defined(HAVE_valgrind) && defined(EXTRA_DEBUG)
+  /* Let valgrind see every block */
+  return 0;
+#else
+  if (size < MEM_ROOT_CACHE_MIN_SIZE || size > MEM_ROOT_CACHE_MAX_SIZE ||
+      size % MEM_ROOT_CACHE_GRANULARITY)
+    return 0;
+  return &mem_root_cache[size / MEM_ROOT_CACHE_GRANULARITY - 1];
+#endif
+}
+
+static int64 mem_root_cache_add_bytes(int64 size)
+{
+  int64 bytes;
+  my_atomic_rwlock_wrlock(&mem_root_cache_rwlock);
+  bytes= my_atomic_add64(&mem_root_cache_bytes, size) + size;
+  my_atomic_rwlock_wrunlock(&mem_root_cache_rwlock);
+  return bytes;
+}
+
+
+/*
+  Return the size to allocate for a block of at least 'size' bytes
+*/
+
+static size_t mem_root_block_size(size_t size)
+{
+  if (mem_root_cache_enabled() &&
+      size >= MEM_ROOT_CACHE_MIN_SIZE && size <= MEM_ROOT_CACHE_MAX_SIZE)
+    return MY_ALIGN(size, MEM_ROOT_CACHE_GRANULARITY);
+  return size;
+}
+
+
+/*
+  Allocate a block of exactly 'size' bytes, from the cache if possible
+*/
+
+static USED_MEM *mem_root_block_alloc(size_t size, myf my_flags)
+{
+  MEM_ROOT_CACHE_CLASS *cache;
+  if (mem_root_cache_enabled() && (cache= mem_root_cache_class(size)))
+  {
+    USED_MEM *block;
+    mysql_mutex_lock(&cache->lock);
+    if ((block= cache->blocks))
+    {
+      cache->blocks= block->next;
+      cache->hits++;
+    }
+    else
+      cache->misses++;
+    mysql_mutex_unlock(&cache->lock);
+    if (block)
+    {
+      mem_root_cache_add_bytes(-(int64) size);
+      if (my_flags & MY_THREAD_SPECIFIC)
+        my_malloc_set_thread_specific(block, 1);
+      return block;
+    }
+  }
+  return (USED_MEM*) my_malloc(size, my_flags);
+}
+
+
+/*
+  Give a block back to the cache, or free it if it doesn't fit there
+*/
+
+static void mem_root_block_free(USED_MEM *block)
+{
+  MEM_ROOT_CACHE_CLASS *cache;
+  size_t size= block->size;
+  if (mem_root_cache_enabled() && (cache= mem_root_cache_class(size)))
+  {
+    if ((size_t) mem_root_cache_add_bytes((int64) size) <=
+        my_mem_root_cache_size)
+    {
+      my_malloc_set_thread_specific(block, 0);
+      mysql_mutex_lock(&cache->lock);
+      block->next= cache->blocks;
+      cache->blocks= block;
+      mysql_mutex_unlock(&cache->lock);
+      return;
+    }
+    mem_root_cache_add_bytes(-(int64) size);
+  }
+  my_free(block);
+}
+
+
+void init_mem_root_cache(void)
+{
+  uint i;
+  for (i= 0; i < MEM_ROOT_CACHE_CLASSES; i++)
+  {
+    mysql_mutex_init(key_THR_LOCK_mem_root_cache, &mem_root_cache[i].lock,
+                     MY_MUTEX_INIT_FAST);
+    mem_root_cache[i].blocks= 0;
+    mem_root_cache[i].hits= mem_root_cache[i].misses= 0;
+  }
+  my_atomic_rwlock_init(&mem_root_cache_rwlock);
+  mem_root_cache_bytes= 0;
+  mem_root_cache_inited= 1;
+}
+
+
+/*
+  Free cached blocks until the cache is no bigger than
+  my_mem_root_cache_size. Largest blocks are freed first.
+*/
+
+void trim_mem_root_cache(void)
+{
+  uint i;
+  if (!mem_root_cache_inited)
+    return;
+  for (i= MEM_ROOT_CACHE_CLASSES; i-- > 0; )
+  {
+    MEM_ROOT_CACHE_CLASS *cache= &mem_root_cache[i];
+    size_t size= (i + 1) * MEM_ROOT_CACHE_GRANULARITY;
+    USED_MEM *block, *to_free= 0;
+    mysql_mutex_lock(&cache->lock);
+    while ((block= cache->blocks) &&
+           (size_t) mem_root_cache_add_bytes(0) > my_mem_root_cache_size)
+    {
+      cache->blocks= block->next;
+      block->next= to_free;
+      to_free= block;
+      mem_root_cache_add_bytes(-(int64) size);
+    }
+    mysql_mutex_unlock(&cache->lock);
+    while ((block= to_free))
+    {
+      to_free= block->next;
+      my_free(block);
+    }
+  }
+}
+
+
+void end_mem_root_cache(void)
+{
+  uint i;
+  if (!mem_root_cache_inited)
+    return;
+  mem_root_cache_inited= 0;
+  for (i= 0; i < MEM_ROOT_CACHE_CLASSES; i++)
+  {
+    USED_MEM *block;
+    while ((block= mem_root_cache[i].blocks))
+    {
+      mem_root_cache[i].blocks= block->next;
+      my_free(block);
+    }
+    mysql_mutex_destroy(&mem_root_cache[i].lock);
+  }
+  my_atomic_rwlock_destroy(&mem_root_cache_rwlock);
+  mem_root_cache_bytes= 0;
+}
+
+
+/*
+  Return statistics of the memory root block cache
+
+  SYNOPSIS
+    get_mem_root_cache_stats()
+      hits     Store number of blocks taken from the cache here
+      misses   Store number of cacheable blocks that had to be malloced here
+      bytes    Store total size of blocks in the cache here
+*/
+
+void get_mem_root_cache_stats(ulonglong *hits, ulonglong *misses,
+                              ulonglong *bytes)
+{
+  uint i;
+  *hits= *misses= 0;
+  if (mem_root_cache_inited)
+  {
+    for (i= 0; i < MEM_ROOT_CACHE_CLASSES; i++)
+    {
+      *hits+= mem_root_cache[i].hits;
+      *misses+= mem_root_cache[i].misses;
+    }
+  }
+  *bytes= (ulonglong) mem_root_cache_add_bytes(0);
+}
+
 /*
   Initialize memory root
 
@@ -71,12 +308,13 @@ void init_alloc_root(MEM_ROOT *mem_root, size_t block_size,
 #if !(defined(HAVE_valgrind) && defined(EXTRA_DEBUG))
   if (pre_alloc_size)
   {
+    size_t size= mem_root_block_size(pre_alloc_size +
+                                     ALIGN_SIZE(sizeof(USED_MEM)));
     if ((mem_root->free= mem_root->pre_alloc=
-	 (USED_MEM*) my_malloc(pre_alloc_size+ ALIGN_SIZE(sizeof(USED_MEM)),
-			       MYF(my_flags))))
+         mem_root_block_alloc(size, MYF(my_flags))))
     {
-      mem_root->free->size= pre_alloc_size+ALIGN_SIZE(sizeof(USED_MEM));
-      mem_root->free->left= pre_alloc_size;
+      mem_root->free->size= size;
+      mem_root->free->left= size - ALIGN_SIZE(sizeof(USED_MEM));
       mem_root->free->next= 0;
     }
   }
@@ -111,7 +349,8 @@ void reset_root_defaults(MEM_ROOT *mem_root, size_t block_size,
 #if !(defined(HAVE_valgrind) && defined(EXTRA_DEBUG))
   if (pre_alloc_size)
   {
-    size_t size= pre_alloc_size + ALIGN_SIZE(sizeof(USED_MEM));
+    size_t size= mem_root_block_size(pre_alloc_size +
+                                     ALIGN_SIZE(sizeof(USED_MEM)));
     if (!mem_root->pre_alloc || mem_root->pre_alloc->size != size)
     {
       USED_MEM *mem, **prev= &mem_root->free;
@@ -132,18 +371,18 @@ void reset_root_defaults(MEM_ROOT *mem_root, size_t block_size,
         {
           /* remove block from the list and free it */
           *prev= mem->next;
-          my_free(mem);
+          mem_root_block_free(mem);
         }
         else
           prev= &mem->next;
       }
       /* Allocate new prealloc block and add it to the end of free list */
-      if ((mem= (USED_MEM *) my_malloc(size,
-                                       MYF(MALLOC_FLAG(mem_root->
-                                                       block_size)))))
+      if ((mem= mem_root_block_alloc(size,
+                                     MYF(MALLOC_FLAG(mem_root->
+                                                     block_size)))))
       {
         mem->size= size; 
-        mem->left= pre_alloc_size;
+        mem->left= size - ALIGN_SIZE(sizeof(USED_MEM));
         mem->next= *prev;
         *prev= mem_root->pre_alloc= mem; 
       }
@@ -228,12 +467,12 @@ void *alloc_root(MEM_ROOT *mem_root, size_t length)
   {						/* Time to alloc new block */
     block_size= (mem_root->block_size & ~1) * (mem_root->block_num >> 2);
     get_size= length+ALIGN_SIZE(sizeof(USED_MEM));
-    get_size= MY_MAX(get_size, block_size);
+    get_size= mem_root_block_size(MY_MAX(get_size, block_size));
 
-    if (!(next = (USED_MEM*) my_malloc(get_size,
-                                       MYF(MY_WME | ME_FATALERROR |
-                                           MALLOC_FLAG(mem_root->
-                                                       block_size)))))
+    if (!(next= mem_root_block_alloc(get_size,
+                                     MYF(MY_WME | ME_FATALERROR |
+                                         MALLOC_FLAG(mem_root->
+                                                     block_size)))))
     {
       if (mem_root->error_handler)
 	(*mem_root->error_handler)();
@@ -382,13 +621,13 @@ void free_root(MEM_ROOT *root, myf MyFlags)
   {
     old=next; next= next->next ;
     if (old != root->pre_alloc)
-      my_free(old);
+      mem_root_block_free(old);
   }
   for (next=root->free ; next ;)
   {
     old=next; next= next->next;
     if (old != root->pre_alloc)
-      my_free(old);
+      mem_root_block_free(old);
   }
   root->used=root->free=0;
   if (root->pre_alloc)
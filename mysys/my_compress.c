@@ -131,7 +131,7 @@ uchar *my_compress_alloc(const uchar *packet, size_t *len, size_t *complen)
 {
   uchar *compbuf;
   int res;
-  *complen=  *len * 120 / 100 + 12;
+  *complen=  my_compress_bound(*len);
 
   if (!(compbuf= (uchar *) my_malloc(*complen, MYF(MY_WME))))
     return 0;					/* Not enough memory */
@@ -157,6 +157,45 @@ uchar *my_compress_alloc(const uchar *packet, size_t *len, size_t *complen)
 }
 
 
+/*
+  Compress a packet into another buffer
+
+   SYNOPSIS
+     my_compress_into()
+     dest	Buffer for the result, at least my_compress_bound(*len) bytes.
+		Gets the compressed data, or a copy of 'packet' if it was
+		not compressed.
+     packet	Data to compress
+     len	in:  Length of data to compress at 'packet'
+		out: Length of the data stored at 'dest'
+     complen	out: 0 if packet was not compressed, otherwise the original
+		length
+
+   NOTES
+     Unlike my_compress() this doesn't need a temporary buffer and a copy
+     back of the compressed data.
+*/
+
+void my_compress_into(uchar *dest, const uchar *packet, size_t *len,
+                      size_t *complen)
+{
+  DBUG_ENTER("my_compress_into");
+  *complen= my_compress_bound(*len);
+  if (*len < MIN_COMPRESS_LENGTH ||
+      my_compress_buffer(dest, complen, packet, *len) != Z_OK ||
+      *complen >= *len)
+  {
+    DBUG_PRINT("note",("Packet not compressed"));
+    memcpy(dest, packet, *len);
+    *complen= 0;
+    DBUG_VOID_RETURN;
+  }
+  /* Store length of compressed packet in *len */
+  swap_variables(size_t, *len, *complen);
+  DBUG_VOID_RETURN;
+}
+
+
 /*
   Uncompress packet
 
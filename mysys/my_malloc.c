@@ -217,6 +217,34 @@ void my_free(void *ptr)
 }
 
 
+/**
+  Change if a block allocated with my_malloc() is thread specific
+
+  @param ptr                 Block allocated with my_malloc()
+  @param is_thread_specific  1 if the block should be marked as
+                             MY_THREAD_SPECIFIC for the calling thread
+
+  The memory usage of the block is moved from the old owner to the new
+  one. This is used when a block is handed from one thread to another.
+*/
+
+void my_malloc_set_thread_specific(void *ptr, my_bool is_thread_specific)
+{
+  size_t size;
+  my_bool old_flags;
+  size= MALLOC_SIZE_AND_FLAG(ptr, &old_flags);
+  if (old_flags == is_thread_specific)
+    return;
+#if defined(SAFEMALLOC)
+  sf_set_thread_specific(ptr, is_thread_specific);
+#else
+  *(size_t*) MALLOC_FIX_POINTER_FOR_FREE(ptr)= size | is_thread_specific;
+#endif
+  update_malloc_size(- (longlong) size - MALLOC_PREFIX_SIZE, old_flags);
+  update_malloc_size((longlong) size + MALLOC_PREFIX_SIZE, is_thread_specific);
+}
+
+
 void *my_memdup(const void *from, size_t length, myf my_flags)
 {
   void *ptr;
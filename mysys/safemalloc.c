@@ -215,6 +215,23 @@ size_t sf_malloc_usable_size(void *ptr, my_bool *is_thread_specific)
   DBUG_RETURN(irem->datasize);
 }
 
+/**
+  Change the MY_THREAD_SPECIFIC marker of a block
+
+  The block is also given to the calling thread, so that it's not
+  reported as freed by the wrong thread or as leaked by its old owner.
+*/
+
+void sf_set_thread_specific(void *ptr, my_bool is_thread_specific)
+{
+  struct st_irem *irem= (struct st_irem *)ptr - 1;
+  if (is_thread_specific)
+    irem->flags|= MY_THREAD_SPECIFIC;
+  else
+    irem->flags&= ~MY_THREAD_SPECIFIC;
+  irem->thread_id= sf_malloc_dbug_id();
+}
+
 #ifdef HAVE_BACKTRACE
 static void print_stack(void **frame)
 {
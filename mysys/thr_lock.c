@@ -78,6 +78,19 @@ one TL_WRITE_DELAYED lock at the same time as multiple read locks.
 
 In addition, if lock->allow_multiple_concurrent_insert is set then there can
 be any number of TL_WRITE_CONCURRENT_INSERT locks aktive at the same time.
+
+If lock->allow_fast_read is set, TL_READ locks are normally not put in the
+read list. They are only counted in lock->fast_read_state with an atomic
+operation, so that read-mostly tables don't serialize all statements on
+lock->mutex. This is possible as long as no write lock is active or
+waiting; the first write lock request sets THR_LOCK_FAST_READ_BLOCKED
+under the mutex and from then on new readers take the normal path. The
+flag is cleared when the last write lock is gone. A writer waiting for
+fast readers is woken up by the last of them in thr_unlock().
+Fast readers call get_status() without the mutex. A write lock request
+waits for those calls to finish after setting the flag, as a concurrent
+insert can be given at once and would otherwise change the status under
+them.
 */
 
 #if !defined(MAIN) && !defined(DBUG_OFF) && !defined(EXTRA_DEBUG)
@@ -172,6 +185,154 @@ thr_lock_owner_equal(THR_LOCK_INFO *rhs, THR_LOCK_INFO *lhs)
 }
 
 
+/*
+  Functions for the TL_READ fast path.
+  The BLOCKED flag is only changed with lock->mutex held.
+*/
+
+static inline int32 fast_read_state(THR_LOCK *lock)
+{
+  int32 state;
+  my_atomic_rwlock_rdlock(&lock->fast_read_rwlock);
+  state= my_atomic_load32(&lock->fast_read_state);
+  my_atomic_rwlock_rdunlock(&lock->fast_read_rwlock);
+  return state;
+}
+
+/* Check if there are read locks, with or without the mutex */
+
+static inline my_bool has_readers(THR_LOCK *lock)
+{
+  return (lock->read.data != 0 ||
+          (fast_read_state(lock) & ~THR_LOCK_FAST_READ_BLOCKED) != 0);
+}
+
+/* Results of fast_read_lock() */
+#define FAST_READ_LOCKED         1
+#define FAST_READ_LOCKED_BLOCKED 2     /* Must use the mutex for the status */
+
+/*
+  Try to get a TL_READ lock without lock->mutex.
+  If force is set the lock is given even if the fast path is blocked;
+  This is used when the thread already has a fast read lock on the table.
+  Returns 0 if the lock was not given.
+*/
+
+static inline int fast_read_lock(THR_LOCK *lock, my_bool force)
+{
+  int32 state;
+  int res= 0;
+  my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+  if (force)
+  {
+    state= my_atomic_add32(&lock->fast_read_state, 1);
+    res= (state & THR_LOCK_FAST_READ_BLOCKED) ? FAST_READ_LOCKED_BLOCKED :
+                                                FAST_READ_LOCKED;
+  }
+  else
+  {
+    state= my_atomic_load32(&lock->fast_read_state);
+    while (!(state & THR_LOCK_FAST_READ_BLOCKED))
+    {
+      if (my_atomic_cas32(&lock->fast_read_state, &state, state + 1))
+      {
+        res= FAST_READ_LOCKED;
+        break;
+      }
+    }
+  }
+  my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+  return res;
+}
+
+/* Release a fast read lock. Returns the number of fast readers before */
+
+static inline int32 fast_read_unlock(THR_LOCK *lock)
+{
+  int32 old_state;
+  my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+  old_state= my_atomic_add32(&lock->fast_read_state, -1);
+  my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+  return old_state;
+}
+
+/*
+  A fast reader is counted in fast_read_status while it tries to get the
+  lock and calls get_status() without the mutex.
+*/
+
+static inline void fast_read_status_start(THR_LOCK *lock)
+{
+  my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+  my_atomic_add32(&lock->fast_read_status, 1);
+  my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+}
+
+static inline void fast_read_status_end(THR_LOCK *lock)
+{
+  my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+  my_atomic_add32(&lock->fast_read_status, -1);
+  my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+}
+
+/*
+  Stop new fast read locks; Must be called before checking has_readers()
+
+  After the flag is set, wait for the fast readers that may still be in
+  get_status(). A reader counts itself in fast_read_status before it
+  checks the flag, so either we see it here or it sees the flag. The
+  wait is short as no new reader can start calling get_status().
+*/
+
+static inline void fast_read_block(THR_LOCK *lock)
+{
+  mysql_mutex_assert_owner(&lock->mutex);
+  if (!lock->allow_fast_read)
+    return;
+  if (!(fast_read_state(lock) & THR_LOCK_FAST_READ_BLOCKED))
+  {
+    my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+    my_atomic_add32(&lock->fast_read_state, THR_LOCK_FAST_READ_BLOCKED);
+    my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+  }
+  for (;;)
+  {
+    int32 status;
+    my_atomic_rwlock_rdlock(&lock->fast_read_rwlock);
+    status= my_atomic_load32(&lock->fast_read_status);
+    my_atomic_rwlock_rdunlock(&lock->fast_read_rwlock);
+    if (!status)
+      break;
+    pthread_yield();
+  }
+}
+
+/* Check if the thread has a fast read lock on the table */
+
+static inline my_bool has_fast_read(THR_LOCK_INFO *owner, THR_LOCK *lock)
+{
+  THR_LOCK_DATA *data;
+  for (data= owner->fast_reads; data; data= data->next_fast_read)
+    if (data->lock == lock)
+      return 1;
+  return 0;
+}
+
+/* Allow fast read locks again if there is no write lock active or waiting */
+
+static inline void fast_read_unblock(THR_LOCK *lock)
+{
+  mysql_mutex_assert_owner(&lock->mutex);
+  if (!lock->write.data && !lock->write_wait.data && !lock->read_wait.data &&
+      (fast_read_state(lock) & THR_LOCK_FAST_READ_BLOCKED))
+  {
+    my_atomic_rwlock_wrlock(&lock->fast_read_rwlock);
+    my_atomic_add32(&lock->fast_read_state, -THR_LOCK_FAST_READ_BLOCKED);
+    my_atomic_rwlock_wrunlock(&lock->fast_read_rwlock);
+  }
+}
+
+
 #ifdef EXTRA_DEBUG
 #define MAX_FOUND_ERRORS	10		/* Report 10 first errors */
 static uint found_errors=0;
@@ -295,7 +456,7 @@ static void check_locks(THR_LOCK *lock, const char *where,
 
       if (!lock->write.data)
       {
-	if (!allow_no_locks && !lock->read.data &&
+	if (!allow_no_locks && !has_readers(lock) &&
 	    (lock->write_wait.data || lock->read_wait.data))
 	{
 	  found_errors++;
@@ -320,7 +481,7 @@ static void check_locks(THR_LOCK *lock, const char *where,
 		 lock->write_wait.data->type == TL_WRITE_ALLOW_WRITE) &&
 		!lock->read_no_write_count) ||
 	       (lock->write_wait.data->type == TL_WRITE_DELAYED &&
-		!lock->read.data)))
+		!has_readers(lock))))
 	  {
 	    found_errors++;
 	    fprintf(stderr,
@@ -425,6 +586,7 @@ void thr_lock_init(THR_LOCK *lock)
   DBUG_ENTER("thr_lock_init");
   bzero((char*) lock,sizeof(*lock));
   mysql_mutex_init(key_THR_LOCK_mutex, &lock->mutex, MY_MUTEX_INIT_FAST);
+  my_atomic_rwlock_init(&lock->fast_read_rwlock);
   lock->read.last= &lock->read.data;
   lock->read_wait.last= &lock->read_wait.data;
   lock->write_wait.last= &lock->write_wait.data;
@@ -444,6 +606,8 @@ void thr_lock_delete(THR_LOCK *lock)
   mysql_mutex_lock(&THR_LOCK_lock);
   thr_lock_thread_list=list_delete(thr_lock_thread_list,&lock->list);
   mysql_mutex_unlock(&THR_LOCK_lock);
+  DBUG_ASSERT(lock->fast_read_state == 0 && lock->fast_read_status == 0);
+  my_atomic_rwlock_destroy(&lock->fast_read_rwlock);
   mysql_mutex_destroy(&lock->mutex);
   DBUG_VOID_RETURN;
 }
@@ -454,6 +618,7 @@ void thr_lock_info_init(THR_LOCK_INFO *info)
   struct st_my_thread_var *tmp= my_thread_var;
   info->thread=    tmp->pthread_self;
   info->thread_id= tmp->id;
+  info->fast_reads= 0;
 }
 
 	/* Initialize a lock instance */
@@ -467,6 +632,8 @@ void thr_lock_data_init(THR_LOCK *lock,THR_LOCK_DATA *data, void *param)
   data->cond=0;
   data->priority= 0;
   data->debug_print_param= 0;
+  data->next_fast_read= 0;
+  data->fast_read= 0;
 }
 
 
@@ -647,8 +814,16 @@ wait_for_lock(struct st_lock_list *wait, THR_LOCK_DATA *data,
 }
 
 
+/*
+  Get a lock
+
+  'prev' is the lock before 'data' in the sorted lock array of
+  thr_multi_lock(), or 0 if there is none.
+*/
+
 static enum enum_thr_lock_result
-thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
+thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, THR_LOCK_DATA *prev,
+         ulong lock_wait_timeout)
 {
   THR_LOCK *lock=data->lock;
   enum enum_thr_lock_result result= THR_LOCK_SUCCESS;
@@ -661,10 +836,47 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
   data->cond=0;					/* safety */
   data->owner= owner;                           /* Must be reset ! */
   data->priority&= ~THR_LOCK_LATE_PRIV;
+  data->fast_read= 0;
 
   MYSQL_START_TABLE_LOCK_WAIT(locker, &state, data->m_psi,
                               PSI_TABLE_LOCK, lock_type);
 
+  if (lock_type == TL_READ && lock->allow_fast_read)
+  {
+    /*
+      A second lock on the same table must be given if the first one was
+      given, as for has_old_lock() below. If the first one was a normal
+      lock, this one has to be a normal lock too.
+    */
+    int locked;
+    fast_read_status_start(lock);
+    if (prev && prev->lock == lock)
+      locked= prev->fast_read ? fast_read_lock(lock, 1) : 0;
+    else
+      locked= fast_read_lock(lock, 0);
+    if (locked == FAST_READ_LOCKED && lock->get_status)
+      (*lock->get_status)(data->status_param, 0);
+    fast_read_status_end(lock);
+    if (locked)
+    {
+      DBUG_PRINT("lock",("data: 0x%lx  thread: 0x%lx  lock: 0x%lx  fast read",
+                         (long) data, data->owner->thread_id, (long) lock));
+      data->fast_read= 1;
+      data->next_fast_read= owner->fast_reads;
+      owner->fast_reads= data;
+      if (locked == FAST_READ_LOCKED_BLOCKED && lock->get_status)
+      {
+        /* A writer may use the status; It doesn't wait for us */
+        mysql_mutex_lock(&lock->mutex);
+        (*lock->get_status)(data->status_param, 0);
+        mysql_mutex_unlock(&lock->mutex);
+      }
+      statistic_increment(locks_immediate,&THR_LOCK_lock);
+      MYSQL_END_TABLE_LOCK_WAIT(locker);
+      DBUG_RETURN(result);
+    }
+  }
+
   mysql_mutex_lock(&lock->mutex);
   DBUG_PRINT("lock",("data: 0x%lx  thread: 0x%lx  lock: 0x%lx  type: %d",
                      (long) data, data->owner->thread_id,
@@ -732,7 +944,8 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
     else if (!lock->write_wait.data ||
 	     lock->write_wait.data->type <= TL_WRITE_LOW_PRIORITY ||
 	     lock_type == TL_READ_HIGH_PRIORITY ||
-	     has_old_lock(lock->read.data, data->owner)) /* Has old read lock */
+	     has_old_lock(lock->read.data, data->owner) || /* Has old read lock */
+             has_fast_read(data->owner, lock))
     {						/* No important write-locks */
       (*lock->read.last)=data;			/* Add to running FIFO */
       data->prev=lock->read.last;
@@ -749,11 +962,15 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
       We're here if there is an active write lock or no write
       lock but a high priority write waiting in the write_wait queue.
       In the latter case we should yield the lock to the writer.
+      Fast read locks are not in lock->read; A fast read lock of this
+      thread on the table is found with has_fast_read() above and treated
+      as an old read lock, as the writer may be waiting for it.
     */
     wait_queue= &lock->read_wait;
   }
   else						/* Request for WRITE lock */
   {
+    fast_read_block(lock);
     if (lock_type == TL_WRITE_DELAYED)
     {
       if (lock->write.data && lock->write.data->type == TL_WRITE_ONLY)
@@ -762,7 +979,7 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
         result= THR_LOCK_ABORTED;               /* Can't wait for this one */
 	goto end;
       }
-      if (lock->write.data || lock->read.data)
+      if (lock->write.data || has_readers(lock))
       {
 	/* Add delayed write lock to write_wait queue, and return at once */
 	(*lock->write_wait.last)=data;
@@ -872,7 +1089,7 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
           }
         }
 
-	if (!lock->read.data ||
+	if (!has_readers(lock) ||
 	    (lock_type <= TL_WRITE_DELAYED &&
 	     ((lock_type != TL_WRITE_CONCURRENT_INSERT &&
 	       lock_type != TL_WRITE_ALLOW_WRITE) ||
@@ -889,7 +1106,8 @@ thr_lock(THR_LOCK_DATA *data, THR_LOCK_INFO *owner, ulong lock_wait_timeout)
 	}
       }
       DBUG_PRINT("lock",("write locked 3 by thread: 0x%lx  type: %d",
-			 lock->read.data->owner->thread_id, data->type));
+			 lock->read.data ? lock->read.data->owner->thread_id :
+                         0, data->type));
     }
     wait_queue= &lock->write_wait;
   }
@@ -963,6 +1181,27 @@ void thr_unlock(THR_LOCK_DATA *data, uint unlock_flags)
   DBUG_ENTER("thr_unlock");
   DBUG_PRINT("lock",("data: 0x%lx  thread: 0x%lx  lock: 0x%lx",
                      (long) data, data->owner->thread_id, (long) lock));
+  if (data->fast_read)
+  {
+    THR_LOCK_DATA **fast_read;
+    if ((unlock_flags & THR_UNLOCK_UPDATE_STATUS) && lock->restore_status)
+      (*lock->restore_status)(data->status_param);
+    /* Remove from the fast read locks of the thread */
+    for (fast_read= &data->owner->fast_reads; *fast_read != data;
+         fast_read= &(*fast_read)->next_fast_read) ;
+    *fast_read= data->next_fast_read;
+    data->next_fast_read= 0;
+    data->fast_read= 0;
+    data->type=TL_UNLOCK;			/* Mark unlocked */
+    /* Wake up a writer if it was waiting for us */
+    if (fast_read_unlock(lock) == (THR_LOCK_FAST_READ_BLOCKED | 1))
+    {
+      mysql_mutex_lock(&lock->mutex);
+      wake_up_waiters(lock);
+      mysql_mutex_unlock(&lock->mutex);
+    }
+    DBUG_VOID_RETURN;
+  }
   mysql_mutex_lock(&lock->mutex);
   check_locks(lock,"start of release lock", lock_type, 0);
 
@@ -1022,7 +1261,7 @@ static void wake_up_waiters(THR_LOCK *lock)
   if (!lock->write.data)			/* If no active write locks */
   {
     data=lock->write_wait.data;
-    if (!lock->read.data)			/* If no more locks in use */
+    if (!has_readers(lock))			/* If no more locks in use */
     {
       /* Release write-locks with TL_WRITE or TL_WRITE_ONLY priority first */
       if (data &&
@@ -1124,6 +1363,7 @@ static void wake_up_waiters(THR_LOCK *lock)
       free_all_read_locks(lock,0);
   }
 end:
+  fast_read_unblock(lock);
   check_locks(lock, "after waking up waiters", TL_UNLOCK, 0);
   DBUG_VOID_RETURN;
 }
@@ -1173,7 +1413,9 @@ thr_multi_lock(THR_LOCK_DATA **data, uint count, THR_LOCK_INFO *owner,
   /* lock everything */
   for (pos=data,end=data+count; pos < end ; pos++)
   {
-    enum enum_thr_lock_result result= thr_lock(*pos, owner, lock_wait_timeout);
+    enum enum_thr_lock_result result= thr_lock(*pos, owner,
+                                               pos > data ? pos[-1] : 0,
+                                               lock_wait_timeout);
     if (result != THR_LOCK_SUCCESS)
     {						/* Aborted */
       thr_multi_unlock(data,(uint) (pos-data), 0);
@@ -1334,6 +1576,7 @@ void thr_abort_locks(THR_LOCK *lock, my_bool upgrade_lock)
   lock->read_wait.data=lock->write_wait.data=0;
   if (upgrade_lock && lock->write.data)
     lock->write.data->type=TL_WRITE_ONLY;
+  fast_read_unblock(lock);
   mysql_mutex_unlock(&lock->mutex);
   DBUG_VOID_RETURN;
 }
@@ -1460,7 +1703,7 @@ my_bool thr_upgrade_write_delay_lock(THR_LOCK_DATA *data,
   /* Check if someone has given us the lock */
   if (!data->cond)
   {
-    if (!lock->read.data)			/* No read locks */
+    if (!has_readers(lock))			/* No read locks */
     {						/* We have the lock */
       if (data->lock->get_status)
 	(*data->lock->get_status)(data->status_param, 0);
@@ -1573,7 +1816,7 @@ void thr_print_locks(void)
     mysql_mutex_lock(&lock->mutex);
     printf("lock: 0x%lx:",(ulong) lock);
     if ((lock->write_wait.data || lock->read_wait.data) &&
-	(! lock->read.data && ! lock->write.data))
+	(! has_readers(lock) && ! lock->write.data))
       printf(" WARNING: ");
     if (lock->write.data)
       printf(" write");
@@ -1583,6 +1826,8 @@ void thr_print_locks(void)
       printf(" read");
     if (lock->read_wait.data)
       printf(" read_wait");
+    if (has_readers(lock) && !lock->read.data)
+      printf(" fast_read");
     puts("");
     thr_print_lock("write",&lock->write);
     thr_print_lock("write_wait",&lock->write_wait);
@@ -31,6 +31,7 @@
 #include "my_static.h"
 #include <m_string.h>
 #include <hash.h>
+#include <my_atomic.h>
 
 #ifndef DO_NOT_REMOVE_THREAD_WRAPPERS
 /* Remove wrappers */
@@ -840,31 +841,70 @@ static void print_deadlock_warning(safe_mutex_t *new_mutex,
 
 #elif defined(MY_PTHREAD_FASTMUTEX) /* !SAFE_MUTEX_DEFINED */
 
-static ulong mutex_delay(ulong delayloops)
+/*
+  Tell the CPU that we are in a spin loop: this saves power, leaves the
+  core to the other hyperthread and avoids the memory order violation
+  penalty when the loop ends.
+*/
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define relax_cpu() __asm__ __volatile__ ("pause")
+#elif defined(_MSC_VER)
+#define relax_cpu() YieldProcessor()
+#else
+#define relax_cpu() do {} while (0)
+#endif
+
+static void mutex_delay(ulong delayloops)
 {
   ulong	i;
-  volatile ulong j;
-
-  j = 0;
 
-  for (i = 0; i < delayloops * 50; i++)
-    j += i;
-
-  return(j); 
+  for (i = 0; i < delayloops * 10; i++)
+    relax_cpu();
 }	
 
 #define MY_PTHREAD_FASTMUTEX_SPINS 8
 #define MY_PTHREAD_FASTMUTEX_DELAY 4
 
+/*
+  Number of times a contended lock tries again before it sleeps in
+  pthread_mutex_lock() (a futex wait on Linux), and the initial delay
+  between the tries.  The delay grows by a random amount after each try,
+  so that the waiters don't retry in lockstep.
+*/
+uint my_fastmutex_spin_loops= MY_PTHREAD_FASTMUTEX_SPINS;
+uint my_fastmutex_spin_delay= MY_PTHREAD_FASTMUTEX_DELAY;
+
+/*
+  Contention statistics, like the mutex counters of InnoDB: the number of
+  locks that found the mutex taken, the delay rounds they spun, and how
+  many of them had to sleep.  They are only updated on contention.
+
+  The threads that spin on a hot mutex would also fight over shared
+  counters, so every thread counts in one of FASTMUTEX_STAT_SLOTS slots,
+  each in a cache line of its own.  get_fastmutex_stats() adds them up.
+*/
+#define FASTMUTEX_STAT_SLOTS 64
+
+static struct st_fastmutex_stats
+{
+  int64 volatile spin_waits, spin_rounds, os_waits;
+  char pad[64 - 3 * sizeof(int64)];
+} fastmutex_stats[FASTMUTEX_STAT_SLOTS];
+static my_atomic_rwlock_t fastmutex_stats_rwlock;
+
+static struct st_fastmutex_stats *fastmutex_stats_slot(void)
+{
+  /* Thread handles are stack addresses or ids: spread them over slots */
+  uint32 self= (uint32) ((size_t) pthread_self() >> 12);
+  return &fastmutex_stats[(self * 2654435761U) >> 26];
+}
+
 static int cpu_count= 0;
 
 int my_pthread_fastmutex_init(my_pthread_fastmutex_t *mp,
                               const pthread_mutexattr_t *attr)
 {
-  if ((cpu_count > 1) && (attr == MY_MUTEX_INIT_FAST))
-    mp->spins= MY_PTHREAD_FASTMUTEX_SPINS; 
-  else
-    mp->spins= 0;
+  mp->spin= (cpu_count > 1) && (attr == MY_MUTEX_INIT_FAST);
   mp->rng_state= 1;
   return pthread_mutex_init(&mp->mutex, attr); 
 }
@@ -895,31 +935,72 @@ static double park_rng(my_pthread_fastmutex_t *mp)
 int my_pthread_fastmutex_lock(my_pthread_fastmutex_t *mp)
 {
   int   res;
-  uint  i;
-  uint  maxdelay= MY_PTHREAD_FASTMUTEX_DELAY;
+  uint  i, spins;
+  struct st_fastmutex_stats *stats;
+  uint  delay= my_fastmutex_spin_delay;
+  uint  maxdelay= delay;
+
+  if (!mp->spin || !(spins= my_fastmutex_spin_loops))
+    return pthread_mutex_lock(&mp->mutex);
 
-  for (i= 0; i < mp->spins; i++)
+  if ((res= pthread_mutex_trylock(&mp->mutex)) != EBUSY)
+    return res;
+
+  for (i= 0; i < spins; i++)
   {
-    res= pthread_mutex_trylock(&mp->mutex);
+    mutex_delay(maxdelay);
+    maxdelay += park_rng(mp) * delay + 1;
 
-    if (res == 0)
-      return 0;
+    res= pthread_mutex_trylock(&mp->mutex);
 
     if (res != EBUSY)
-      return res;
-
-    mutex_delay(maxdelay);
-    maxdelay += park_rng(mp) * MY_PTHREAD_FASTMUTEX_DELAY + 1;
+      break;
   }
+
+  stats= fastmutex_stats_slot();
+  my_atomic_rwlock_wrlock(&fastmutex_stats_rwlock);
+  my_atomic_add64(&stats->spin_waits, (int64) 1);
+  my_atomic_add64(&stats->spin_rounds, (int64) (i < spins ? i + 1 : spins));
+  if (i == spins)
+    my_atomic_add64(&stats->os_waits, (int64) 1);
+  my_atomic_rwlock_wrunlock(&fastmutex_stats_rwlock);
+
+  if (i < spins)
+    return res;
   return pthread_mutex_lock(&mp->mutex);
 }
 
 
+/*
+  Return the contention statistics of all fast mutexes
+
+  SYNOPSIS
+    get_fastmutex_stats()
+      spin_waits    Store number of locks that found the mutex taken here
+      spin_rounds   Store number of delay rounds they spun here
+      os_waits      Store number of them that had to sleep here
+*/
+
+void get_fastmutex_stats(ulonglong *spin_waits, ulonglong *spin_rounds,
+                         ulonglong *os_waits)
+{
+  uint i;
+  *spin_waits= *spin_rounds= *os_waits= 0;
+  my_atomic_rwlock_rdlock(&fastmutex_stats_rwlock);
+  for (i= 0; i < FASTMUTEX_STAT_SLOTS; i++)
+  {
+    *spin_waits+= my_atomic_load64(&fastmutex_stats[i].spin_waits);
+    *spin_rounds+= my_atomic_load64(&fastmutex_stats[i].spin_rounds);
+    *os_waits+= my_atomic_load64(&fastmutex_stats[i].os_waits);
+  }
+  my_atomic_rwlock_rdunlock(&fastmutex_stats_rwlock);
+}
+
+
 void fastmutex_global_init(void)
 {
-#ifdef _SC_NPROCESSORS_CONF
-  cpu_count= sysconf(_SC_NPROCESSORS_CONF);
-#endif
+  cpu_count= my_getncpus();
+  my_atomic_rwlock_init(&fastmutex_stats_rwlock);
 }
 
 #endif /* defined(MY_PTHREAD_FASTMUTEX) && defined(SAFE_MUTEX_DEFINED) */
@@ -191,12 +191,9 @@ int ActiveTranx::insert_tranx_node(const char *log_file_name,
   return function_exit(kWho, result);
 }
 
-bool ActiveTranx::is_tranx_end_pos(const char *log_file_name,
-				   my_off_t    log_file_pos)
+TranxNode *ActiveTranx::find_tranx_node(const char *log_file_name,
+                                        my_off_t    log_file_pos)
 {
-  const char *kWho = "ActiveTranx::is_tranx_end_pos";
-  function_enter(kWho);
-
   unsigned int hash_val = get_hash_value(log_file_name, log_file_pos);
   TranxNode *entry = trx_htb_[hash_val];
 
@@ -209,13 +206,74 @@ bool ActiveTranx::is_tranx_end_pos(const char *log_file_name,
   }
 
   if (trace_level_ & kTraceDetail)
-    sql_print_information("%s: probe (%s, %lu) in entry(%u)", kWho,
-                          log_file_name, (unsigned long)log_file_pos, hash_val);
+    sql_print_information("ActiveTranx::find_tranx_node: probe (%s, %lu) "
+                          "in entry(%u)", log_file_name,
+                          (unsigned long)log_file_pos, hash_val);
+  return entry;
+}
+
+bool ActiveTranx::is_tranx_end_pos(const char *log_file_name,
+				   my_off_t    log_file_pos)
+{
+  const char *kWho = "ActiveTranx::is_tranx_end_pos";
+  function_enter(kWho);
+
+  TranxNode *entry = find_tranx_node(log_file_name, log_file_pos);
 
   function_exit(kWho, (entry != NULL));
   return (entry != NULL);
 }
 
+bool ActiveTranx::add_waiter(const char *log_file_name,
+                             my_off_t    log_file_pos,
+                             TranxWaiter *waiter)
+{
+  TranxNode *entry = find_tranx_node(log_file_name, log_file_pos);
+
+  if (entry == NULL)
+    return false;
+
+  link_waiter(&entry->waiters_, waiter);
+  return true;
+}
+
+void ActiveTranx::link_waiter(TranxWaiter **list, TranxWaiter *waiter)
+{
+  waiter->next_ = *list;
+  waiter->list_ = list;
+  *list = waiter;
+}
+
+void ActiveTranx::unlink_waiter(TranxWaiter *waiter)
+{
+  if (waiter->list_ == NULL)
+    return;
+
+  TranxWaiter **ptr = waiter->list_;
+  while (*ptr != waiter)
+    ptr = &((*ptr)->next_);
+  *ptr = waiter->next_;
+
+  waiter->next_ = NULL;
+  waiter->list_ = NULL;
+}
+
+void ActiveTranx::signal_waiters(TranxWaiter **list)
+{
+  TranxWaiter *waiter = *list;
+
+  *list = NULL;
+  while (waiter != NULL)
+  {
+    TranxWaiter *next = waiter->next_;
+
+    waiter->next_ = NULL;
+    waiter->list_ = NULL;
+    mysql_cond_signal(&waiter->cond_);
+    waiter = next;
+  }
+}
+
 int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
 					  my_off_t log_file_pos)
 {
@@ -245,6 +303,10 @@ int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
   {
     /* No active transaction nodes after the call. */
 
+    /* Wake up everybody waiting for any of the cleared transactions. */
+    for (TranxNode *node = trx_front_; node != NULL; node = node->next_)
+      signal_waiters(&node->waiters_);
+
     /* Clear the hash table. */
     memset(trx_htb_, 0, num_entries_ * sizeof(TranxNode *));
     allocator_.free_all_nodes();
@@ -271,6 +333,9 @@ int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
       next_node = curr_node->next_;
       n_frees++;
 
+      /* The transaction is acknowledged: wake up the sessions waiting for it. */
+      signal_waiters(&curr_node->waiters_);
+
       /* Remove the node from the hash table. */
       unsigned int hash_val = get_hash_value(curr_node->log_name_, curr_node->log_pos_);
       TranxNode **hash_ptr = &(trx_htb_[hash_val]);
@@ -308,8 +373,10 @@ int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
  * The most important functions during semi-syn replication listed:
  *
  * Master:
- *  . reportReplyBinlog():  called by the binlog dump thread when it receives
- *                          the slave's status information.
+ *  . reportReplyBinlog():  called by the ACK receiver thread (or the binlog
+ *                          dump thread, for connections the receiver does
+ *                          not handle) when it receives the slave's status
+ *                          information.
  *  . updateSyncHeader():   based on transaction waiting information, decide
  *                          whether to request the slave to reply.
  *  . writeTranxInBinlog(): called by the transaction thread when it finishes
@@ -326,6 +393,7 @@ int ActiveTranx::clear_active_tranx_nodes(const char *log_file_name,
 ReplSemiSyncMaster::ReplSemiSyncMaster()
   : active_tranxs_(NULL),
     init_done_(false),
+    other_waiters_(NULL),
     reply_file_name_inited_(false),
     reply_file_pos_(0L),
     wait_file_name_inited_(false),
@@ -357,8 +425,6 @@ int ReplSemiSyncMaster::initObject()
   /* Mutex initialization can only be done after MY_INIT(). */
   mysql_mutex_init(key_ss_mutex_LOCK_binlog_,
                    &LOCK_binlog_, MY_MUTEX_INIT_FAST);
-  mysql_cond_init(key_ss_cond_COND_binlog_send_,
-                  &COND_binlog_send_, NULL);
 
   if (rpl_semi_sync_master_enabled)
     result = enableMaster();
@@ -434,7 +500,6 @@ void ReplSemiSyncMaster::cleanup()
   if (init_done_)
   {
     mysql_mutex_destroy(&LOCK_binlog_);
-    mysql_cond_destroy(&COND_binlog_send_);
     init_done_= 0;
   }
 
@@ -453,17 +518,30 @@ void ReplSemiSyncMaster::unlock()
 
 void ReplSemiSyncMaster::cond_broadcast()
 {
-  mysql_cond_broadcast(&COND_binlog_send_);
+  ActiveTranx::signal_waiters(&other_waiters_);
 }
 
-int ReplSemiSyncMaster::cond_timewait(struct timespec *wait_time)
+int ReplSemiSyncMaster::cond_timewait(TranxWaiter *waiter,
+                                      const char *log_file_name,
+                                      my_off_t log_file_pos,
+                                      struct timespec *wait_time)
 {
   const char *kWho = "ReplSemiSyncMaster::cond_timewait()";
   int wait_res;
 
   function_enter(kWho);
-  wait_res= mysql_cond_timedwait(&COND_binlog_send_,
+
+  /* Wait on the transaction's own node when it is in the active list, so
+   * that we are only woken up once a reply covers it.
+   */
+  if (!active_tranxs_->add_waiter(log_file_name, log_file_pos, waiter))
+    ActiveTranx::link_waiter(&other_waiters_, waiter);
+
+  wait_res= mysql_cond_timedwait(&waiter->cond_,
                                  &LOCK_binlog_, wait_time);
+
+  /* Still linked if we timed out or were killed. */
+  ActiveTranx::unlink_waiter(waiter);
   return function_exit(kWho, wait_res);
 }
 
@@ -606,15 +684,19 @@ int ReplSemiSyncMaster::commitTrx(const char* trx_wait_binlog_name,
     struct timespec abstime;
     int wait_result;
     PSI_stage_info old_stage;
+    TranxWaiter waiter;
 
     set_timespec(start_ts, 0);
+    mysql_cond_init(key_ss_cond_COND_binlog_send_, &waiter.cond_, NULL);
+    waiter.next_ = NULL;
+    waiter.list_ = NULL;
 
     DEBUG_SYNC(current_thd, "rpl_semisync_master_commit_trx_before_lock");
     /* Acquire the mutex. */
     lock();
 
     /* This must be called after acquired the lock */
-    THD_ENTER_COND(NULL, &COND_binlog_send_, &LOCK_binlog_,
+    THD_ENTER_COND(NULL, &waiter.cond_, &LOCK_binlog_,
                    & stage_waiting_for_semi_sync_ack_from_slave,
                    & old_stage);
 
@@ -699,7 +781,8 @@ int ReplSemiSyncMaster::commitTrx(const char* trx_wait_binlog_name,
                               kWho, wait_timeout_,
                               wait_file_name_, (unsigned long)wait_file_pos_);
       
-      wait_result = cond_timewait(&abstime);
+      wait_result = cond_timewait(&waiter, trx_wait_binlog_name,
+                                  trx_wait_binlog_pos, &abstime);
       rpl_semi_sync_master_wait_sessions--;
       
       if (wait_result != 0)
@@ -755,6 +838,7 @@ int ReplSemiSyncMaster::commitTrx(const char* trx_wait_binlog_name,
     /* The lock held will be released by thd_exit_cond, so no need to
        call unlock() here */
     THD_EXIT_COND(NULL, & old_stage);
+    mysql_cond_destroy(&waiter.cond_);
   }
 
   return function_exit(kWho, 0);
@@ -1040,10 +1124,6 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
                                        const char *event_buf)
 {
   const char *kWho = "ReplSemiSyncMaster::readSlaveReply";
-  const unsigned char *packet;
-  char     log_file_name[FN_REFLEN];
-  my_off_t log_file_pos;
-  ulong    log_file_len = 0;
   ulong    packet_len;
   int      result = -1;
   struct timespec start_ts;
@@ -1113,7 +1193,30 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
     goto l_end;
   }
 
-  packet = net->read_pos;
+  result = reportReplyPacket(server_id, net->read_pos, packet_len);
+
+ l_end:
+  return function_exit(kWho, result);
+}
+
+int ReplSemiSyncMaster::reportReplyPacket(uint32 server_id,
+                                          const unsigned char *packet,
+                                          ulong packet_len)
+{
+  const char *kWho = "ReplSemiSyncMaster::reportReplyPacket";
+  char     log_file_name[FN_REFLEN];
+  my_off_t log_file_pos;
+  ulong    log_file_len = 0;
+  int      result = -1;
+
+  function_enter(kWho);
+
+  if (packet_len < REPLY_BINLOG_NAME_OFFSET)
+  {
+    sql_print_error("Read semi-sync reply length error");
+    goto l_end;
+  }
+
   if (packet[REPLY_MAGIC_NUM_OFFSET] != ReplSemiSyncMaster::kPacketMagicNum)
   {
     sql_print_error("Read semi-sync reply magic number error");
@@ -1130,7 +1233,7 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
   strncpy(log_file_name, (const char*)packet + REPLY_BINLOG_NAME_OFFSET, log_file_len);
   log_file_name[log_file_len] = 0;
 
-  if (trc_level & kTraceDetail)
+  if (trace_level_ & kTraceDetail)
     sql_print_information("%s: Got reply (%s, %lu)",
                           kWho, log_file_name, (ulong)log_file_pos);
 
@@ -1140,6 +1243,36 @@ int ReplSemiSyncMaster::readSlaveReply(NET *net, uint32 server_id,
   return function_exit(kWho, result);
 }
 
+int ReplSemiSyncMaster::flushNet(NET *net)
+{
+  const char *kWho = "ReplSemiSyncMaster::flushNet";
+
+  function_enter(kWho);
+
+  /* We flush to make sure that the current event is sent to the network,
+   * instead of being buffered in the TCP/IP stack.
+   */
+  if (net_flush(net))
+  {
+    /* Most likely the slave went away; the binlog dump thread notices and
+     * reports it when it sends the next event.
+     */
+    if (trace_level_ & kTraceGeneral)
+      sql_print_information("%s: net_flush() failed", kWho);
+    return function_exit(kWho, -1);
+  }
+
+  /* The slave restarts its packet numbering for the reply, and expects the
+   * next event to follow it.  Number the next packet as readSlaveReply()
+   * would have after reading the reply.
+   */
+  net_clear(net, 0);
+  net->pkt_nr++;
+  net->compress_pkt_nr++;
+
+  return function_exit(kWho, 0);
+}
+
 
 int ReplSemiSyncMaster::resetMaster()
 {
@@ -28,11 +28,25 @@ extern PSI_cond_key key_ss_cond_COND_binlog_send_;
 
 extern PSI_stage_info stage_waiting_for_semi_sync_ack_from_slave;
 
+/**
+  A session waiting in commitTrx() for the reply to its transaction.
+
+  The waiter lives on the stack of the waiting session and is linked into
+  the waiter list of the TranxNode of its transaction, so that a reply only
+  wakes up the sessions whose transactions it acknowledges.
+*/
+struct TranxWaiter {
+  mysql_cond_t        cond_;      /* signalled when the waiter may proceed */
+  struct TranxWaiter *next_;      /* the next waiter in the same list */
+  struct TranxWaiter **list_;     /* the list we are linked into, or NULL */
+};
+
 struct TranxNode {
   char             log_name_[FN_REFLEN];
   my_off_t          log_pos_;
   struct TranxNode *next_;            /* the next node in the sorted list */
   struct TranxNode *hash_next_;    /* the next node during hash collision */
+  struct TranxWaiter *waiters_;  /* sessions waiting for this transaction */
 };
 
 /**
@@ -128,6 +142,7 @@ public:
     trx_node->log_pos_= 0;
     trx_node->next_= 0;
     trx_node->hash_next_= 0;
+    trx_node->waiters_= 0;
     return trx_node;
   }
 
@@ -313,6 +328,7 @@ private:
 
   inline unsigned int calc_hash(const unsigned char *key,unsigned int length);
   unsigned int get_hash_value(const char *log_file_name, my_off_t log_file_pos);
+  TranxNode *find_tranx_node(const char *log_file_name, my_off_t log_file_pos);
 
   int compare(const char *log_file_name1, my_off_t log_file_pos1,
               const TranxNode *node2) {
@@ -341,7 +357,7 @@ public:
   int insert_tranx_node(const char *log_file_name, my_off_t log_file_pos);
 
   /* Clear the active transaction nodes until(inclusive) the specified
-   * position.
+   * position, waking up the sessions waiting for them.
    * If log_file_name is NULL, everything will be cleared: the sorted
    * list and the hash table will be reset to empty.
    * 
@@ -356,6 +372,22 @@ public:
    */
   bool is_tranx_end_pos(const char *log_file_name, my_off_t log_file_pos);
 
+  /* Link a waiter to the node of the transaction ending at the given
+   * position, so that it is signalled when the node is cleared.
+   *
+   * Return:
+   *  true: the waiter was linked;  false: no such active transaction
+   */
+  bool add_waiter(const char *log_file_name, my_off_t log_file_pos,
+                  TranxWaiter *waiter);
+
+  /* Link a waiter into a list / unlink it from whatever list it is in. */
+  static void link_waiter(TranxWaiter **list, TranxWaiter *waiter);
+  static void unlink_waiter(TranxWaiter *waiter);
+
+  /* Wake up and unlink all waiters in a list. */
+  static void signal_waiters(TranxWaiter **list);
+
   /* Given two binlog positions, compare which one is bigger based on
    * (file_name, file_position).
    */
@@ -376,10 +408,13 @@ class ReplSemiSyncMaster
   /* True when initObject has been called */
   bool init_done_;
 
-  /* This cond variable is signaled when enough binlog has been sent to slave,
-   * so that a waiting trx can return the 'ok' to the client for a commit.
+  /* Sessions waiting for a reply whose transaction is not in the active
+   * transaction list (eg. semi-sync was switched on after it was written).
+   * They are all signalled whenever replies pass the smallest wait position.
+   * Waiters for active transactions are linked to their TranxNode instead,
+   * so only they are signalled when their transaction is acknowledged.
    */
-  mysql_cond_t  COND_binlog_send_;
+  TranxWaiter  *other_waiters_;
 
   /* Mutex that protects the following state variables and the active
    * transaction list.
@@ -435,7 +470,8 @@ class ReplSemiSyncMaster
   void lock();
   void unlock();
   void cond_broadcast();
-  int  cond_timewait(struct timespec *wait_time);
+  int  cond_timewait(TranxWaiter *waiter, const char *log_file_name,
+                     my_off_t log_file_pos, struct timespec *wait_time);
 
   /* Is semi-sync replication on? */
   bool is_on() {
@@ -585,6 +621,37 @@ class ReplSemiSyncMaster
    */
   int readSlaveReply(NET *net, uint32 server_id, const char *event_buf);
 
+  /* Parse a slave's reply packet and report the position in it.
+   *
+   * Input:
+   *  server_id    - (IN)  slave server id number
+   *  packet       - (IN)  the reply packet
+   *  packet_len   - (IN)  length of the reply packet
+   *
+   * Return:
+   *  0: success;  non-zero: error
+   */
+  int reportReplyPacket(uint32 server_id, const unsigned char *packet,
+                        ulong packet_len);
+
+  /* Does the event sent in event_buf request a reply from the slave? */
+  static bool needSlaveReply(const char *event_buf)
+  {
+    return (unsigned char)event_buf[2] == kPacketFlagSync;
+  }
+
+  /* Flush the event that requested a reply, leaving the reply to be read
+   * by the ACK receiver thread.  The packet number of the connection is
+   * advanced as if the reply had been read here.
+   *
+   * Input:
+   *  net          - (IN)  the connection to the slave
+   *
+   * Return:
+   *  0: success;  non-zero: error
+   */
+  int flushNet(NET *net);
+
   /* Export internal statistics for semi-sync replication. */
   void setExportStats();
 
@@ -0,0 +1,322 @@
+/* Copyright (c) 2014, MariaDB
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+
+#include "semisync_master_ack_receiver.h"
+
+#ifdef HAVE_POLL
+#include <poll.h>
+#endif
+
+pthread_handler_t ack_receiver_thread(void *arg)
+{
+  AckReceiver *receiver = (AckReceiver *)arg;
+
+  my_thread_init();
+  receiver->run();
+  my_thread_end();
+  pthread_exit(0);
+  return 0;
+}
+
+AckReceiver::AckReceiver()
+  : init_done_(false),
+    status_(kStatusDown),
+    master_(NULL),
+    slaves_changed_(false)
+{}
+
+void AckReceiver::init(ReplSemiSyncMaster *master)
+{
+  master_ = master;
+  trace_level_ = rpl_semi_sync_master_trace_level;
+
+#ifdef HAVE_POLL
+  if (pipe(wakeup_pipe_))
+  {
+    sql_print_warning("Semi-sync ACK receiver disabled: pipe() failed, "
+                      "errno: %d", errno);
+    return;
+  }
+  fcntl(wakeup_pipe_[0], F_SETFL, O_NONBLOCK);
+  fcntl(wakeup_pipe_[1], F_SETFL, O_NONBLOCK);
+
+  mysql_mutex_init(key_ss_mutex_Ack_receiver_mutex, &mutex_,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_ss_cond_Ack_receiver_cond, &cond_, NULL);
+  my_init_dynamic_array(&slaves_, sizeof(Slave), 8, 8, MYF(0));
+  init_done_ = true;
+#endif
+}
+
+void AckReceiver::cleanup()
+{
+  if (!init_done_)
+    return;
+
+  mysql_mutex_lock(&mutex_);
+  stop();
+  mysql_mutex_unlock(&mutex_);
+
+  delete_dynamic(&slaves_);
+  mysql_cond_destroy(&cond_);
+  mysql_mutex_destroy(&mutex_);
+  close(wakeup_pipe_[0]);
+  close(wakeup_pipe_[1]);
+  init_done_ = false;
+}
+
+/* Must be called with mutex_ held. */
+bool AckReceiver::start()
+{
+  const char *kWho = "AckReceiver::start";
+
+  function_enter(kWho);
+
+  status_ = kStatusUp;
+  if (mysql_thread_create(key_ss_thread_Ack_receiver_thread, &thread_,
+                          NULL, ack_receiver_thread, this))
+  {
+    sql_print_error("Failed to start semi-sync ACK receiver thread, "
+                    "errno: %d", errno);
+    status_ = kStatusDown;
+    return function_exit(kWho, false);
+  }
+
+  sql_print_information("Starting semi-sync ACK receiver thread.");
+  return function_exit(kWho, true);
+}
+
+/* Must be called with mutex_ held. */
+void AckReceiver::stop()
+{
+  if (status_ != kStatusUp)
+    return;
+
+  status_ = kStatusStopping;
+  wakeup();
+  mysql_mutex_unlock(&mutex_);
+
+  pthread_join(thread_, NULL);
+
+  mysql_mutex_lock(&mutex_);
+  status_ = kStatusDown;
+  sql_print_information("Stopped semi-sync ACK receiver thread.");
+}
+
+/* Must be called with mutex_ held. */
+void AckReceiver::wakeup()
+{
+  char c = 0;
+
+  mysql_cond_broadcast(&cond_);
+  if (write(wakeup_pipe_[1], &c, 1) < 0)
+  {
+    /* The pipe is full, so the thread has a wakeup pending anyway. */
+  }
+}
+
+int AckReceiver::find_slave(THD *thd)
+{
+  for (uint i = 0; i < slaves_.elements; i++)
+  {
+    if (dynamic_element(&slaves_, i, Slave *)->thd == thd)
+      return (int)i;
+  }
+  return -1;
+}
+
+bool AckReceiver::add_slave(THD *thd, uint32 server_id)
+{
+#ifdef HAVE_POLL
+  Vio *vio = thd->net.vio;
+  Slave slave;
+  bool result = false;
+
+  /* An SSL connection cannot be read and written by two threads. */
+  if (!init_done_ || vio == NULL ||
+      (vio->type != VIO_TYPE_TCPIP && vio->type != VIO_TYPE_SOCKET))
+    return false;
+
+  slave.thd = thd;
+  slave.vio = vio;
+  slave.server_id = server_id;
+  slave.compress = thd->net.compress;
+
+  mysql_mutex_lock(&mutex_);
+  if ((status_ == kStatusUp || (status_ == kStatusDown && start())) &&
+      !insert_dynamic(&slaves_, (uchar *)&slave))
+  {
+    slaves_changed_ = true;
+    wakeup();
+    result = true;
+  }
+  mysql_mutex_unlock(&mutex_);
+
+  return result;
+#else
+  return false;
+#endif
+}
+
+void AckReceiver::remove_slave(THD *thd)
+{
+  int idx;
+
+  if (!init_done_)
+    return;
+
+  mysql_mutex_lock(&mutex_);
+  if ((idx = find_slave(thd)) >= 0)
+  {
+    delete_dynamic_element(&slaves_, idx);
+    slaves_changed_ = true;
+    wakeup();
+
+    /* Wait until the receiver thread no longer uses the connection. */
+    while (slaves_changed_ && status_ == kStatusUp)
+      mysql_cond_wait(&cond_, &mutex_);
+  }
+  mysql_mutex_unlock(&mutex_);
+}
+
+bool AckReceiver::has_slave(THD *thd)
+{
+  bool found;
+
+  if (!init_done_)
+    return false;
+
+  mysql_mutex_lock(&mutex_);
+  found = find_slave(thd) >= 0;
+  mysql_mutex_unlock(&mutex_);
+
+  return found;
+}
+
+void AckReceiver::run()
+{
+#ifdef HAVE_POLL
+  THD *thd;
+  NET net;
+  Slave *slaves = NULL;
+  struct pollfd *fds = NULL;
+  uint num_slaves = 0;
+  uint max_slaves = 0;
+
+  thd = new THD;
+  thd->thread_stack = (char*) &thd;
+  mysql_mutex_lock(&LOCK_thread_count);
+  thd->thread_id = thread_id++;
+  mysql_mutex_unlock(&LOCK_thread_count);
+  thd->store_globals();
+
+  /* The NET is only used to read replies; it gets the vio of each slave. */
+  my_net_init(&net, NULL, MYF(0));
+
+  mysql_mutex_lock(&mutex_);
+  slaves_changed_ = true;
+  while (status_ == kStatusUp)
+  {
+    if (slaves_changed_)
+    {
+      /* Take a private copy of the list, so we can poll without mutex_. */
+      num_slaves = slaves_.elements;
+      if (num_slaves > max_slaves)
+      {
+        my_free(slaves);
+        my_free(fds);
+        slaves = (Slave *)my_malloc(num_slaves * sizeof(Slave), MYF(MY_WME));
+        fds = (struct pollfd *)my_malloc((num_slaves + 1) *
+                                         sizeof(struct pollfd), MYF(MY_WME));
+        max_slaves = num_slaves;
+        if (!slaves || !fds)
+        {
+          /* The transactions will time out and switch semi-sync off. */
+          num_slaves = max_slaves = 0;
+        }
+      }
+      for (uint i = 0; i < num_slaves; i++)
+      {
+        slaves[i] = *dynamic_element(&slaves_, i, Slave *);
+        fds[i + 1].fd = vio_fd(slaves[i].vio);
+        fds[i + 1].events = POLLIN;
+      }
+      slaves_changed_ = false;
+      mysql_cond_broadcast(&cond_);
+    }
+
+    if (num_slaves == 0)
+    {
+      mysql_cond_wait(&cond_, &mutex_);
+      continue;
+    }
+    mysql_mutex_unlock(&mutex_);
+
+    fds[0].fd = wakeup_pipe_[0];
+    fds[0].events = POLLIN;
+    int ready = poll(fds, num_slaves + 1, -1);
+    if (ready > 0 && fds[0].revents)
+    {
+      char buf[64];
+      while (read(wakeup_pipe_[0], buf, sizeof(buf)) > 0) {}
+      ready--;
+    }
+    for (uint i = 0; ready > 0 && i < num_slaves; i++)
+    {
+      if (!fds[i + 1].revents)
+        continue;
+      ready--;
+
+      Vio *vio = slaves[i].vio;
+      net.vio = vio;
+      net.fd = fds[i + 1].fd;
+      net.compress = slaves[i].compress;
+      do
+      {
+        /* The slave restarts its packet numbering for each reply. */
+        net_clear(&net, 0);
+        ulong len = my_net_read(&net);
+        if (len == packet_error)
+        {
+          /* The slave went away; its dump thread will unregister it. */
+          if (trace_level_ & kTraceGeneral)
+            sql_print_information("Semi-sync ACK receiver stops reading "
+                                  "from slave (server_id: %d): %s "
+                                  "(errno: %d)", slaves[i].server_id,
+                                  net.last_error, net.last_errno);
+          fds[i + 1].fd = -1;
+          break;
+        }
+        master_->reportReplyPacket(slaves[i].server_id, net.read_pos, len);
+        /* Replies already buffered in the vio are not seen by poll(). */
+      } while (vio->read_pos < vio->read_end);
+      thd->clear_error();
+    }
+
+    mysql_mutex_lock(&mutex_);
+  }
+  mysql_mutex_unlock(&mutex_);
+
+  net.vio = NULL;
+  net_end(&net);
+  my_free(slaves);
+  my_free(fds);
+
+  mysql_mutex_lock(&LOCK_thread_count);
+  delete thd;
+  mysql_mutex_unlock(&LOCK_thread_count);
+#endif
+}
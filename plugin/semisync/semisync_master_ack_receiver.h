@@ -0,0 +1,121 @@
+/* Copyright (c) 2014, MariaDB
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+
+#ifndef SEMISYNC_MASTER_ACK_RECEIVER_H
+#define SEMISYNC_MASTER_ACK_RECEIVER_H
+
+#include "semisync_master.h"
+
+#ifdef HAVE_PSI_INTERFACE
+extern PSI_mutex_key key_ss_mutex_Ack_receiver_mutex;
+extern PSI_cond_key key_ss_cond_Ack_receiver_cond;
+extern PSI_thread_key key_ss_thread_Ack_receiver_thread;
+#endif
+
+/**
+   The ACK receiver reads the replies of all semi-sync slaves in one thread.
+
+   Without it, every binlog dump thread blocks on its own connection after
+   each event that requested a reply, so it cannot send the next
+   transaction before the slave has acknowledged the previous one.  With
+   it, dump threads only flush the event and carry on; this thread polls
+   the connections of all registered slaves and reports the replies to
+   ReplSemiSyncMaster as they arrive.
+
+   Connections that cannot be shared between two threads (SSL), or
+   platforms without poll(), are not registered; their dump threads keep
+   reading the replies themselves.
+*/
+class AckReceiver
+  :public Trace {
+public:
+  AckReceiver();
+  ~AckReceiver() {}
+
+  /* Initialize the object; must be called once at plugin init.
+   *
+   * Input:
+   *  master       - (IN)  the object the replies are reported to
+   */
+  void init(ReplSemiSyncMaster *master);
+
+  /* Stop the receiver thread, if any, and free all resources. */
+  void cleanup();
+
+  /* Register the binlog dump connection of a semi-sync slave.  The
+   * receiver thread is started on first use.
+   *
+   * Input:
+   *  thd          - (IN)  the binlog dump thread
+   *  server_id    - (IN)  slave server id number
+   *
+   * Return:
+   *  true: replies will be read by the receiver thread;
+   *  false: the dump thread must read the replies itself
+   */
+  bool add_slave(THD *thd, uint32 server_id);
+
+  /* Unregister a binlog dump connection.  On return the receiver thread
+   * no longer uses the connection.
+   */
+  void remove_slave(THD *thd);
+
+  /* Are the replies on this dump connection read by the receiver thread? */
+  bool has_slave(THD *thd);
+
+  /* The receiver thread main loop. */
+  void run();
+
+private:
+  struct Slave {
+    THD      *thd;
+    Vio      *vio;
+    uint32    server_id;
+    my_bool   compress;
+  };
+
+  enum status { kStatusDown, kStatusUp, kStatusStopping };
+
+  bool init_done_;
+  status status_;
+  ReplSemiSyncMaster *master_;
+
+  /* Protects the members below. */
+  mysql_mutex_t mutex_;
+  /* Signalled when the slave list changes and when the thread starts or
+   * stops.
+   */
+  mysql_cond_t cond_;
+  pthread_t thread_;
+
+  /* Registered slaves: an array of Slave. */
+  DYNAMIC_ARRAY slaves_;
+  /* Set when slaves_ changed and the receiver thread has not yet picked
+   * up the change.
+   */
+  bool slaves_changed_;
+  /* A pipe polled together with the slaves, written to wake the receiver
+   * thread up when slaves_ or status_ changed.
+   */
+  int wakeup_pipe_[2];
+
+  bool start();
+  void stop();
+  void wakeup();
+  int find_slave(THD *thd);
+};
+
+#endif /* SEMISYNC_MASTER_ACK_RECEIVER_H */
@@ -17,9 +17,11 @@
 
 
 #include "semisync_master.h"
+#include "semisync_master_ack_receiver.h"
 #include "sql_class.h"                          // THD
 
 static ReplSemiSyncMaster repl_semisync;
+static AckReceiver ack_receiver;
 
 C_MODE_START
 
@@ -76,6 +78,9 @@ int repl_semi_binlog_dump_start(Binlog_transmit_param *param,
   {
     /* One more semi-sync slave */
     repl_semisync.add_slave();
+
+    /* Let the ACK receiver thread read the replies of this slave. */
+    ack_receiver.add_slave(current_thd, param->server_id);
     
     /*
       Let's assume this semi-sync slave has already received all
@@ -99,6 +104,8 @@ int repl_semi_binlog_dump_end(Binlog_transmit_param *param)
                         param->server_id);
   if (semi_sync_slave)
   {
+    ack_receiver.remove_slave(current_thd);
+
     /* One less semi-sync slave */
     repl_semisync.remove_slave();
   }
@@ -134,8 +141,18 @@ int repl_semi_after_send_event(Binlog_transmit_param *param,
       because we do not want dump thread to quit on this. Error
       messages are already reported.
     */
-    (void) repl_semisync.readSlaveReply(&thd->net,
-                                        param->server_id, event_buf);
+    if (ReplSemiSyncMaster::needSlaveReply(event_buf) &&
+        ack_receiver.has_slave(thd))
+    {
+      /*
+        The ACK receiver thread reads the reply, so we can go on sending
+        the following events without waiting for the slave.
+      */
+      (void) repl_semisync.flushNet(&thd->net);
+    }
+    else
+      (void) repl_semisync.readSlaveReply(&thd->net,
+                                          param->server_id, event_buf);
     thd->clear_error();
   }
   return 0;
@@ -222,6 +239,7 @@ static void fix_rpl_semi_sync_master_trace_level(MYSQL_THD thd,
 {
   *(unsigned long *)ptr= *(unsigned long *)val;
   repl_semisync.setTraceLevel(rpl_semi_sync_master_trace_level);
+  ack_receiver.trace_level_= rpl_semi_sync_master_trace_level;
   return;
 }
 
@@ -342,17 +360,28 @@ static SHOW_VAR semi_sync_master_status_vars[]= {
 
 #ifdef HAVE_PSI_INTERFACE
 PSI_mutex_key key_ss_mutex_LOCK_binlog_;
+PSI_mutex_key key_ss_mutex_Ack_receiver_mutex;
 
 static PSI_mutex_info all_semisync_mutexes[]=
 {
-  { &key_ss_mutex_LOCK_binlog_, "LOCK_binlog_", 0}
+  { &key_ss_mutex_LOCK_binlog_, "LOCK_binlog_", 0},
+  { &key_ss_mutex_Ack_receiver_mutex, "Ack_receiver::mutex", 0}
 };
 
 PSI_cond_key key_ss_cond_COND_binlog_send_;
+PSI_cond_key key_ss_cond_Ack_receiver_cond;
 
 static PSI_cond_info all_semisync_conds[]=
 {
-  { &key_ss_cond_COND_binlog_send_, "COND_binlog_send_", 0}
+  { &key_ss_cond_COND_binlog_send_, "COND_binlog_send_", 0},
+  { &key_ss_cond_Ack_receiver_cond, "Ack_receiver::cond", 0}
+};
+
+PSI_thread_key key_ss_thread_Ack_receiver_thread;
+
+static PSI_thread_info all_semisync_threads[]=
+{
+  { &key_ss_thread_Ack_receiver_thread, "Ack_receiver", 0}
 };
 #endif /* HAVE_PSI_INTERFACE */
 
@@ -376,6 +405,9 @@ static void init_semisync_psi_keys(void)
   count= array_elements(all_semisync_conds);
   mysql_cond_register(category, all_semisync_conds, count);
 
+  count= array_elements(all_semisync_threads);
+  mysql_thread_register(category, all_semisync_threads, count);
+
   count= array_elements(all_semisync_stages);
   mysql_stage_register(category, all_semisync_stages, count);
 }
@@ -389,6 +421,7 @@ static int semi_sync_master_plugin_init(void *p)
 
   if (repl_semisync.initObject())
     return 1;
+  ack_receiver.init(&repl_semisync);
   if (register_trans_observer(&trans_observer, p))
     return 1;
   if (register_binlog_storage_observer(&storage_observer, p))
@@ -415,6 +448,7 @@ static int semi_sync_master_plugin_deinit(void *p)
     sql_print_error("unregister_binlog_transmit_observer failed");
     return 1;
   }
+  ack_receiver.cleanup();
   repl_semisync.cleanup();
   sql_print_information("unregister_replicator OK");
   return 0;
@@ -7605,7 +7605,7 @@ void Item_cache_wrapper::cleanup()
 
 
 /**
-  Create an expression cache that uses a temporary table
+  Create an expression cache that uses the record format of a temporary table
 
   @param thd           Thread handle
   @param depends_on    Parameters of the expression to create cache for
@@ -7613,8 +7613,8 @@ void Item_cache_wrapper::cleanup()
   @details
   The function takes 'depends_on' as the list of all parameters for
   the expression wrapped into this object and creates an expression
-  cache in a temporary table containing the field for the parameters
-  and the result of the expression.
+  cache of records containing the field for the parameters and the result
+  of the expression.
 
   @retval FALSE OK
   @retval TRUE  Error
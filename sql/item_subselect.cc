@@ -39,6 +39,7 @@
 #include "set_var.h"
 #include "sql_select.h"
 #include "sql_parse.h"                          // check_stack_overrun
+#include "key.h"                                // key_restore
 #include "sql_test.h"
 
 double get_post_group_estimate(JOIN* join, double join_op_rows);
@@ -3416,6 +3417,8 @@ void subselect_uniquesubquery_engine::cleanup()
       has been already dropped by close_thread_tables(), while we here are
       called from cleanup_items()
   */
+  delete key_filter;
+  key_filter= NULL;
   DBUG_VOID_RETURN;
 }
 
@@ -3889,6 +3892,14 @@ int subselect_uniquesubquery_engine::exec()
     DBUG_RETURN(0);
   }
 
+  if (key_filter &&
+      !key_filter->may_contain(tab->ref.key_buff, tab->ref.key_length))
+  {
+    /* The key is not in the materialized subquery, no need to look */
+    in_subs->value= 0;
+    DBUG_RETURN(0);
+  }
+
   if (!table->file->inited &&
       (error= table->file->ha_index_init(tab->ref.key, 0)))
   {
@@ -3966,6 +3977,7 @@ subselect_uniquesubquery_engine::~subselect_uniquesubquery_engine()
   /* Tell handler we don't need the index anymore */
   //psergey-merge-todo: the following was gone in 6.0:
  //psergey-merge: don't need this after all: tab->table->file->ha_index_end();
+  delete key_filter;
 }
 
 
@@ -4820,6 +4832,18 @@ bool subselect_hash_sj_engine::init(List<Item> *tmp_columns, uint subquery_id)
       !(lookup_engine= make_unique_engine()))
     DBUG_RETURN(TRUE);
 
+  /* Hash the keys during materialization, see Subq_key_filter */
+  if (!((Item_in_subselect *) item)->is_jtbm_merged &&
+      Subq_key_filter::is_applicable(tmp_table))
+  {
+    subselect_uniquesubquery_engine *unique_engine=
+      (subselect_uniquesubquery_engine *) lookup_engine;
+    if (!(unique_engine->key_filter= new Subq_key_filter(tmp_table)))
+      DBUG_RETURN(TRUE);
+    ((select_materialize_with_stats *) result_sink)->key_filter=
+      unique_engine->key_filter;
+  }
+
   /*
     Repeat name resolution for 'cond' since cond is not part of any
     clause of the query, and it is not 'fixed' during JOIN::prepare.
@@ -5215,6 +5239,256 @@ double get_post_group_estimate(JOIN* join, double join_op_rows)
 }
 
 
+/*
+  Number of bits of a Subq_key_filter per row of the materialized table,
+  and number of bits set for each key. This gives about 3% false positives.
+*/
+#define SUBQ_KEY_FILTER_BITS_PER_ROW 8
+#define SUBQ_KEY_FILTER_HASHES 3
+
+/**
+  Check if the keys of a materialized subquery table can be filtered with
+  a Subq_key_filter.
+
+  @details
+  Floating point columns are not supported, because values that are equal
+  for the index (0 and -0) can have different hashes.
+*/
+
+bool Subq_key_filter::is_applicable(TABLE *table)
+{
+  KEY *key= table->key_info;
+  KEY_PART_INFO *part, *end;
+
+  if (table->s->keys != 1)
+    return FALSE;
+  for (part= key->key_part, end= part + key->user_defined_key_parts;
+       part < end; part++)
+  {
+    if (part->field->result_type() == REAL_RESULT ||
+        (part->field->flags & BLOB_FLAG))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
+Subq_key_filter::Subq_key_filter(TABLE *table_arg)
+  :overflow(FALSE), keys_pending(table_arg->s->db_type() == heap_hton),
+   table(table_arg), key(table_arg->key_info)
+{
+  bits.bitmap= NULL;
+  my_init_dynamic_array(&hashes, sizeof(Key_hash), 1024, 1024,
+                        MYF(MY_THREAD_SPECIFIC));
+}
+
+
+/*
+  Final mixing step of MurmurHash3, spreads every input bit over the result
+*/
+
+static inline ulonglong subq_key_filter_mix(ulonglong h)
+{
+  h^= h >> 33;
+  h*= 0xff51afd7ed558ccdULL;
+  h^= h >> 33;
+  h*= 0xc4ceb9fe1a85ec53ULL;
+  h^= h >> 33;
+  return h;
+}
+
+
+/*
+  Compute the hashes of the key in the record buffer of the table
+
+  @details
+  The second value of a Field::hash() chain only counts the hashed bytes,
+  so it can't be used as a second hash. Instead, the key is hashed twice
+  with different seeds, and both results are mixed.
+*/
+
+void Subq_key_filter::hash_key(uint32 *nr, uint32 *nr2)
+{
+  KEY_PART_INFO *part, *end;
+  ulong n1= 1, n2= 4, m1= 0x9e3779b9, m2= 7;
+  for (part= key->key_part, end= part + key->user_defined_key_parts;
+       part < end; part++)
+  {
+    part->field->hash(&n1, &n2);
+    part->field->hash(&m1, &m2);
+  }
+  *nr= (uint32) subq_key_filter_mix(n1);
+  *nr2= (uint32) subq_key_filter_mix(m1) | 1;
+}
+
+
+/*
+  Bit of the filter for the i-th hash of a key
+*/
+
+static inline uint subq_key_filter_bit(uint32 nr, uint32 nr2, uint i,
+                                       uint n_bits)
+{
+  return (uint) (((ulonglong) nr + (ulonglong) i * nr2) % n_bits);
+}
+
+
+/*
+  Remember the hash of the key in the record buffer of the table.
+  When the hashes would take more than tmp_table_size, they are dropped
+  and no filter is built.
+*/
+
+void Subq_key_filter::store_key_hash()
+{
+  Key_hash hash;
+  if (overflow)
+    return;
+  if ((hashes.elements + 1) * (ulonglong) sizeof(Key_hash) >
+      table->in_use->variables.tmp_table_size ||
+      hashes.elements >= UINT_MAX32 / SUBQ_KEY_FILTER_BITS_PER_ROW)
+  {
+    overflow= TRUE;
+    delete_dynamic(&hashes);
+    return;
+  }
+  hash_key(&hash.nr, &hash.nr2);
+  if (insert_dynamic(&hashes, (uchar*) &hash))
+  {
+    overflow= TRUE;
+    delete_dynamic(&hashes);
+  }
+}
+
+
+/**
+  Hash the keys of the rows that were written while the table was a heap
+  table.
+
+  @details
+  The table has just been converted to a disk-based table, so it holds
+  only the rows that fitted in memory, and the row that was written last.
+
+  @retval FALSE  ok
+  @retval TRUE   error, which has been reported
+*/
+
+bool Subq_key_filter::add_table_keys()
+{
+  int error;
+  DBUG_ENTER("Subq_key_filter::add_table_keys");
+
+  keys_pending= FALSE;
+  store_record(table, record[1]);
+  if (table->file->ha_rnd_init_with_error(1))
+    DBUG_RETURN(TRUE);
+  while ((error= table->file->ha_rnd_next(table->record[0])) !=
+         HA_ERR_END_OF_FILE)
+  {
+    if (error == HA_ERR_RECORD_DELETED)
+      continue;
+    if (error)
+    {
+      table->file->print_error(error, MYF(0));
+      break;
+    }
+    store_key_hash();
+  }
+  table->file->ha_rnd_end();
+  restore_record(table, record[1]);
+  DBUG_RETURN(error != HA_ERR_END_OF_FILE);
+}
+
+
+/**
+  Remember the key of the row that was just written to the table.
+
+  @details
+  Called by the materialization result sink for every row it writes.
+  Rows are not hashed while the table is a heap table, as the filter is
+  not used for it.
+
+  @retval FALSE  ok
+  @retval TRUE   error, which has been reported
+*/
+
+bool Subq_key_filter::add_key()
+{
+  if (table->s->db_type() == heap_hton)
+    return FALSE;
+  if (keys_pending)
+    return add_table_keys();
+  store_key_hash();
+  return FALSE;
+}
+
+
+/**
+  Build the filter from the hashes collected by add_key().
+
+  @details
+  The filter is built only when the table was converted to a disk-based
+  table, so that a lookup costs more than computing the hash of the key.
+  Check is_built() to see if it was.
+
+  @retval FALSE  ok
+  @retval TRUE   error, which has been reported
+*/
+
+bool Subq_key_filter::build()
+{
+  uint n_bits;
+  Key_hash *hash, *end;
+  DBUG_ENTER("Subq_key_filter::build");
+
+  if (table->s->db_type() == heap_hton)
+    DBUG_RETURN(FALSE);
+  if (keys_pending && add_table_keys())
+    DBUG_RETURN(TRUE);
+  if (overflow || !hashes.elements)
+    DBUG_RETURN(FALSE);
+  n_bits= hashes.elements * SUBQ_KEY_FILTER_BITS_PER_ROW;
+  if (bitmap_init(&bits, NULL, n_bits, FALSE))
+    DBUG_RETURN(TRUE);
+  for (hash= dynamic_element(&hashes, 0, Key_hash*), end= hash + hashes.elements;
+       hash < end; hash++)
+  {
+    for (uint i= 0; i < SUBQ_KEY_FILTER_HASHES; i++)
+      bitmap_set_bit(&bits, subq_key_filter_bit(hash->nr, hash->nr2, i,
+                                                n_bits));
+  }
+  delete_dynamic(&hashes);
+  DBUG_RETURN(FALSE);
+}
+
+
+/**
+  Check if a key may be in the table.
+
+  @param key_buff    key in the format of the index of the table
+  @param key_length  length of the key
+
+  @retval FALSE  the key is not in the table
+  @retval TRUE   the key may be in the table, an index lookup is needed
+
+  @note The record buffer of the table is overwritten.
+*/
+
+bool Subq_key_filter::may_contain(uchar *key_buff, uint key_length)
+{
+  uint32 nr, nr2;
+  uint n_bits= bits.n_bits;
+  key_restore(table->record[0], key_buff, key, key_length);
+  hash_key(&nr, &nr2);
+  for (uint i= 0; i < SUBQ_KEY_FILTER_HASHES; i++)
+  {
+    if (!bitmap_is_set(&bits, subq_key_filter_bit(nr, nr2, i, n_bits)))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
 /**
   Execute a subquery IN predicate via materialization.
 
@@ -5282,6 +5556,27 @@ int subselect_hash_sj_engine::exec()
   strategy= get_strategy_using_schema();
   /* This call may discover that we don't need partial matching at all. */
   strategy= get_strategy_using_data();
+
+  /*
+    Lookups into a materialized table that did not fit in memory are index
+    reads from disk. Filter out most of the keys that will not be found.
+  */
+  {
+    subselect_uniquesubquery_engine *unique_engine=
+      (subselect_uniquesubquery_engine *) lookup_engine;
+    Subq_key_filter *key_filter= unique_engine->key_filter;
+    ((select_materialize_with_stats *) result)->key_filter= NULL;
+    if (key_filter && strategy == COMPLETE_MATCH && key_filter->build())
+    {
+      res= 1;
+      goto err;
+    }
+    if (key_filter && !key_filter->is_built())
+    {
+      delete key_filter;
+      unique_engine->key_filter= NULL;
+    }
+  }
   if (strategy == PARTIAL_MATCH)
   {
     uint count_pm_keys; /* Total number of keys needed for partial matching. */
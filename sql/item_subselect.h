@@ -895,6 +895,57 @@ struct st_join_table;
   functions, etc.
 */
 
+/*
+  A Bloom filter over the keys of a materialized subquery table.
+
+  When the materialized table had to be converted to a disk-based table,
+  every lookup is an index read through the storage engine. The filter
+  tells for most of the keys that are not in the table that there is no
+  need to read the index. The keys are hashed while the rows are written
+  to the table (add_key()), and the filter is built from these hashes
+  when the table is complete (build()). Nothing is hashed while the table
+  is a heap table; the rows written until then are hashed once, right
+  after the conversion.
+
+  The keys are hashed with Field::hash(), which treats values equal for
+  the index as equal (e.g. it respects the collation of string columns),
+  so a key that is in the table is never filtered out.
+*/
+
+class Subq_key_filter : public Sql_alloc
+{
+  struct Key_hash
+  {
+    uint32 nr, nr2;
+  };
+  /* Hashes of the keys written to the table, until the filter is built */
+  DYNAMIC_ARRAY hashes;
+  /* Set if there were too many keys to keep their hashes */
+  bool overflow;
+  /* Set if rows written while the table was a heap table are not hashed */
+  bool keys_pending;
+  MY_BITMAP bits;
+  TABLE *table;
+  KEY *key;
+
+  void hash_key(uint32 *nr, uint32 *nr2);
+  void store_key_hash();
+  bool add_table_keys();
+public:
+  Subq_key_filter(TABLE *table_arg);
+  ~Subq_key_filter()
+  {
+    bitmap_free(&bits);
+    delete_dynamic(&hashes);
+  }
+  static bool is_applicable(TABLE *table);
+  bool add_key();
+  bool build();
+  bool is_built() { return bits.bitmap != NULL; }
+  bool may_contain(uchar *key_buff, uint key_length);
+};
+
+
 class subselect_uniquesubquery_engine: public subselect_engine
 {
 protected:
@@ -906,11 +957,17 @@ protected:
   */
   bool empty_result_set;
 public:
+  /*
+    Filter of the keys in tab->table, if the table is a materialized
+    subquery with many rows. Owned by this engine.
+  */
+  Subq_key_filter *key_filter;
 
   // constructor can assign THD because it will be called after JOIN::prepare
   subselect_uniquesubquery_engine(THD *thd_arg, st_join_table *tab_arg,
 				  Item_subselect *subs, Item *where)
-    :subselect_engine(thd_arg, subs, 0), tab(tab_arg), cond(where)
+    :subselect_engine(thd_arg, subs, 0), tab(tab_arg), cond(where),
+     key_filter(NULL)
   {}
   ~subselect_uniquesubquery_engine();
   void cleanup();
@@ -4901,6 +4901,47 @@ err:
   DBUG_RETURN(error);
 }
 
+/**
+  Append data to the relay log without flushing it.
+
+  The slave I/O thread uses this for events that are followed by more
+  events already received from the master, and calls flush_appended()
+  at the end of the batch. The SQL thread is not woken up until then.
+*/
+
+bool MYSQL_BIN_LOG::append_buffered(const char* buf, uint len)
+{
+  bool error= 0;
+  DBUG_ENTER("MYSQL_BIN_LOG::append_buffered");
+
+  DBUG_ASSERT(log_file.type == SEQ_READ_APPEND);
+
+  mysql_mutex_assert_owner(&LOCK_log);
+  if (my_b_append(&log_file, (uchar*) buf, len))
+    DBUG_RETURN(1);
+  bytes_written+= len;
+  if (my_b_append_tell(&log_file) > max_size)
+    error= new_file_without_locking();
+  DBUG_RETURN(error);
+}
+
+
+/**
+  Flush data appended with append_buffered() and wake up the readers.
+*/
+
+bool MYSQL_BIN_LOG::flush_appended()
+{
+  bool error;
+  DBUG_ENTER("MYSQL_BIN_LOG::flush_appended");
+
+  mysql_mutex_lock(&LOCK_log);
+  if (!(error= flush_and_sync(0)))
+    signal_update();
+  mysql_mutex_unlock(&LOCK_log);
+  DBUG_RETURN(error);
+}
+
 bool MYSQL_BIN_LOG::flush_and_sync(bool *synced)
 {
   int err=0, fd=log_file.file;
@@ -6169,6 +6210,7 @@ uint MYSQL_BIN_LOG::next_file_id()
   @param    event_len no-checksum length of the event
   @param    length    the current size of the buffer
 
+  @param    alg       the checksum algorithm
   @param    crc       [in-out] the checksum
 
   Event size in incremented by @c BINLOG_CHECKSUM_LEN.
@@ -6177,13 +6219,13 @@ uint MYSQL_BIN_LOG::next_file_id()
             the checksum part.
 */
   static ulong fix_log_event_crc(uchar *buf, uint off, uint event_len,
-                                 uint length, ha_checksum *crc)
+                                 uint length, uint8 alg, ha_checksum *crc)
 {
   ulong ret;
   uchar *event_begin= buf + off;
 
   ret= length >= off + event_len ? 0 : off + event_len - length;
-  *crc= my_checksum(*crc, event_begin, event_len - ret); 
+  *crc= binlog_checksum(alg, *crc, event_begin, event_len - ret); 
   return ret;
 }
 
@@ -6215,12 +6257,11 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
   ulong end_log_pos_inc= 0; // each event processed adds BINLOG_CHECKSUM_LEN 2 t
   uchar header[LOG_EVENT_HEADER_LEN];
   ha_checksum crc= 0, crc_0= 0; // assignments to keep compiler happy
-  my_bool do_checksum= (binlog_checksum_options != BINLOG_CHECKSUM_ALG_OFF);
+  uint8 checksum_alg= (uint8) binlog_checksum_options;
+  my_bool do_checksum= (checksum_alg != BINLOG_CHECKSUM_ALG_OFF);
   uchar buf[BINLOG_CHECKSUM_LEN];
 
-  // while there is just one alg the following must hold:
-  DBUG_ASSERT(!do_checksum ||
-              binlog_checksum_options == BINLOG_CHECKSUM_ALG_CRC32);
+  DBUG_ASSERT(!do_checksum || binlog_checksum_is_on(checksum_alg));
 
   /*
     The events in the buffer have incorrect end_log_pos data
@@ -6239,7 +6280,7 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
   group= (uint)my_b_tell(&log_file);
   hdr_offs= carry= 0;
   if (do_checksum)
-    crc= crc_0= my_checksum(0L, NULL, 0);
+    crc= crc_0= binlog_checksum(checksum_alg, 0L, NULL, 0);
 
   do
   {
@@ -6286,7 +6327,7 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
       if (do_checksum)
       {
         DBUG_ASSERT(crc == crc_0 && remains == 0);
-        crc= my_checksum(crc, header, carry);
+        crc= binlog_checksum(checksum_alg, crc, header, carry);
         remains= uint4korr(header + EVENT_LEN_OFFSET) - carry -
           BINLOG_CHECKSUM_LEN;
       }
@@ -6310,7 +6351,7 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
 
         DBUG_ASSERT(remains != 0 && crc != crc_0);
 
-        crc= my_checksum(crc, cache->read_pos, length); 
+        crc= binlog_checksum(checksum_alg, crc, cache->read_pos, length);
         remains -= length;
         if (my_b_write(&log_file, cache->read_pos, length))
           return ER_ERROR_ON_WRITE;
@@ -6339,7 +6380,8 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
               from previous into the current buffer
             */
             DBUG_ASSERT(crc != crc_0);
-            crc= my_checksum(crc, cache->read_pos, hdr_offs);
+            crc= binlog_checksum(checksum_alg, crc, cache->read_pos,
+                                 hdr_offs);
             int4store(buf, crc);
             remains -= hdr_offs;
             DBUG_ASSERT(remains == 0);
@@ -6374,7 +6416,7 @@ int MYSQL_BIN_LOG::write_cache(THD *thd, IO_CACHE *cache)
             /* fix length */
             int4store(ev + EVENT_LEN_OFFSET, event_len + BINLOG_CHECKSUM_LEN);
             remains= fix_log_event_crc(cache->read_pos, hdr_offs, event_len,
-                                       length, &crc);
+                                       length, checksum_alg, &crc);
             if (my_b_write(&log_file, ev, 
                            remains == 0 ? event_len : length - hdr_offs))
               return ER_ERROR_ON_WRITE;
@@ -9354,7 +9396,8 @@ static MYSQL_SYSVAR_ENUM(
   binlog_checksum_options,
   PLUGIN_VAR_RQCMDARG,
   "Type of BINLOG_CHECKSUM_ALG. Include checksum for "
-  "log events in the binary log. Possible values are NONE and CRC32; "
+  "log events in the binary log. Possible values are NONE, CRC32 and "
+  "CRC32C (computed with the SSE 4.2 crc32 instruction when available); "
   "default is NONE.",
   NULL,
   binlog_checksum_update,
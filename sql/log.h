@@ -727,6 +727,8 @@ public:
     invoked as appendv(buf1,len1,buf2,len2,...,bufn,lenn,0)
   */
   bool appendv(const char* buf,uint len,...);
+  bool append_buffered(const char* buf, uint len);
+  bool flush_appended();
   bool append(Log_event* ev);
   bool append_no_lock(Log_event* ev);
 
@@ -47,6 +47,7 @@
 
 #include <base64.h>
 #include <my_bitmap.h>
+#include <zlib.h>
 #include "rpl_utility.h"
 
 #define my_b_write_string(A, B) my_b_write((A), (B), (uint) (sizeof(B) - 1))
@@ -57,12 +58,14 @@
 const char *binlog_checksum_type_names[]= {
   "NONE",
   "CRC32",
+  "CRC32C",
   NullS
 };
 
 unsigned int binlog_checksum_type_length[]= {
   sizeof("NONE") - 1,
   sizeof("CRC32") - 1,
+  sizeof("CRC32C") - 1,
   0
 };
 
@@ -797,13 +800,16 @@ const char* Log_event::get_type_str(Log_event_type type)
   case BINLOG_CHECKPOINT_EVENT: return "Binlog_checkpoint";
   case GTID_EVENT: return "Gtid";
   case GTID_LIST_EVENT: return "Gtid_list";
+  case WRITE_ROWS_COMPRESSED_EVENT: return "Write_rows_compressed";
+  case UPDATE_ROWS_COMPRESSED_EVENT: return "Update_rows_compressed";
+  case DELETE_ROWS_COMPRESSED_EVENT: return "Delete_rows_compressed";
   default: return "Unknown";				/* impossible */
   }
 }
 
 const char* Log_event::get_type_str()
 {
-  return get_type_str(get_type_code());
+  return get_type_str(get_header_type_code());
 }
 
 
@@ -1135,7 +1141,7 @@ my_bool Log_event::need_checksum()
 bool Log_event::wrapper_my_b_safe_write(IO_CACHE* file, const uchar* buf, ulong size)
 {
   if (need_checksum() && size != 0)
-    crc= my_checksum(crc, buf, size);
+    crc= binlog_checksum(checksum_alg, crc, buf, size);
 
   return my_b_safe_write(file, buf, size);
 }
@@ -1174,7 +1180,7 @@ bool Log_event::write_header(IO_CACHE* file, ulong event_data_length)
 
   if (need_checksum())
   {
-    crc= my_checksum(0L, NULL, 0);
+    crc= binlog_checksum(checksum_alg, 0L, NULL, 0);
     data_written += BINLOG_CHECKSUM_LEN;
   }
 
@@ -1232,7 +1238,7 @@ bool Log_event::write_header(IO_CACHE* file, ulong event_data_length)
   */
 
   int4store(header, now);              // timestamp
-  header[EVENT_TYPE_OFFSET]= get_type_code();
+  header[EVENT_TYPE_OFFSET]= get_header_type_code();
   int4store(header+ SERVER_ID_OFFSET, server_id);
   int4store(header+ EVENT_LEN_OFFSET, data_written);
   int4store(header+ LOG_POS_OFFSET, log_pos);
@@ -1255,7 +1261,8 @@ bool Log_event::write_header(IO_CACHE* file, ulong event_data_length)
     {
       flags &= ~LOG_EVENT_BINLOG_IN_USE_F;
       int2store(header + FLAGS_OFFSET, flags);
-      crc= my_checksum(crc, header + FLAGS_OFFSET, sizeof(flags));
+      crc= binlog_checksum(checksum_alg, crc, header + FLAGS_OFFSET,
+                           sizeof(flags));
       flags |= LOG_EVENT_BINLOG_IN_USE_F;    
       int2store(header + FLAGS_OFFSET, flags);
       ret= (my_b_safe_write(file, header + FLAGS_OFFSET, sizeof(flags)) != 0);
@@ -1510,7 +1517,8 @@ Log_event* Log_event::read_log_event(const char* buf, uint event_len,
 
   /* Check the integrity */
   if (event_len < EVENT_LEN_OFFSET ||
-      (uchar)buf[EVENT_TYPE_OFFSET] >= ENUM_END_EVENT ||
+      ((uchar)buf[EVENT_TYPE_OFFSET] >= ENUM_END_EVENT &&
+       !is_compressed_rows_event((uchar)buf[EVENT_TYPE_OFFSET])) ||
       (uint) event_len != uint4korr(buf+EVENT_LEN_OFFSET))
   {
     *error="Sanity check failed";		// Needed to free buffer
@@ -1572,7 +1580,9 @@ Log_event* Log_event::read_log_event(const char* buf, uint event_len,
 #endif
   }
 
-  if (event_type > description_event->number_of_event_types &&
+  if ((is_compressed_rows_event(event_type) ?
+       uncompressed_rows_event(event_type) : event_type) >
+      description_event->number_of_event_types &&
       event_type != FORMAT_DESCRIPTION_EVENT)
   {
     /*
@@ -1682,12 +1692,15 @@ Log_event* Log_event::read_log_event(const char* buf, uint event_len,
       ev = new Delete_rows_log_event_old(buf, event_len, description_event);
       break;
     case WRITE_ROWS_EVENT:
+    case WRITE_ROWS_COMPRESSED_EVENT:
       ev = new Write_rows_log_event(buf, event_len, description_event);
       break;
     case UPDATE_ROWS_EVENT:
+    case UPDATE_ROWS_COMPRESSED_EVENT:
       ev = new Update_rows_log_event(buf, event_len, description_event);
       break;
     case DELETE_ROWS_EVENT:
+    case DELETE_ROWS_COMPRESSED_EVENT:
       ev = new Delete_rows_log_event(buf, event_len, description_event);
       break;
     case TABLE_MAP_EVENT:
@@ -2622,17 +2635,20 @@ void Log_event::print_base64(IO_CACHE* file,
                                    glob_description_event);
       print_event_info->m_table_map.set_table(map->get_table_id(), map);
     }
-    else if (ptr[4] == WRITE_ROWS_EVENT)
+    else if (ptr[4] == WRITE_ROWS_EVENT ||
+             ptr[4] == WRITE_ROWS_COMPRESSED_EVENT)
     {
       ev= new Write_rows_log_event((const char*) ptr, size,
                                    glob_description_event);
     }
-    else if (ptr[4] == DELETE_ROWS_EVENT)
+    else if (ptr[4] == DELETE_ROWS_EVENT ||
+             ptr[4] == DELETE_ROWS_COMPRESSED_EVENT)
     {
       ev= new Delete_rows_log_event((const char*) ptr, size,
                                     glob_description_event);
     }
-    else if (ptr[4] == UPDATE_ROWS_EVENT)
+    else if (ptr[4] == UPDATE_ROWS_EVENT ||
+             ptr[4] == UPDATE_ROWS_COMPRESSED_EVENT)
     {
       ev= new Update_rows_log_event((const char*) ptr, size,
                                     glob_description_event);
@@ -2656,12 +2672,13 @@ void Log_event::print_base64(IO_CACHE* file,
 
 void Log_event::print_timestamp(IO_CACHE* file, time_t* ts)
 {
-  struct tm *res;
+  struct tm tm_tmp, *res= &tm_tmp;
   time_t my_when= when;
   DBUG_ENTER("Log_event::print_timestamp");
   if (!ts)
     ts = &my_when;
-  res=localtime(ts);
+  /* mysqlbinlog may print event headers in several threads at once */
+  localtime_r(ts, &tm_tmp);
 
   my_b_printf(file,"%02d%02d%02d %2d:%02d:%02d",
               res->tm_year % 100,
@@ -3589,7 +3606,7 @@ Query_log_event::dummy_event(String *packet, ulong ev_offset,
   static const size_t min_query_event_len=
     LOG_EVENT_HEADER_LEN + QUERY_HEADER_LEN + 1 + 1; // 34
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
     data_len-= BINLOG_CHECKSUM_LEN;
   else
     DBUG_ASSERT(checksum_alg == BINLOG_CHECKSUM_ALG_UNDEF ||
@@ -3657,9 +3674,9 @@ Query_log_event::dummy_event(String *packet, ulong ev_offset,
     }
   }
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
   {
-    ha_checksum crc= my_checksum(0L, p, data_len);
+    ha_checksum crc= binlog_checksum(checksum_alg, 0L, p, data_len);
     int4store(p + data_len, crc);
   }
   return 0;
@@ -3678,7 +3695,7 @@ Query_log_event::begin_event(String *packet, ulong ev_offset,
   size_t data_len= packet->length() - ev_offset;
   uint16 flags;
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
     data_len-= BINLOG_CHECKSUM_LEN;
   else
     DBUG_ASSERT(checksum_alg == BINLOG_CHECKSUM_ALG_UNDEF ||
@@ -3704,9 +3721,9 @@ Query_log_event::begin_event(String *packet, ulong ev_offset,
   q+= Q_DATA_OFFSET + 1;
   memcpy(q, "BEGIN", 5);
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
   {
-    ha_checksum crc= my_checksum(0L, p, data_len);
+    ha_checksum crc= binlog_checksum(checksum_alg, 0L, p, data_len);
     int4store(p + data_len, crc);
   }
   return 0;
@@ -4448,7 +4465,7 @@ bool
 Query_log_event::peek_is_commit_rollback(const char *event_start,
                                          size_t event_len, uint8 checksum_alg)
 {
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
   {
     if (event_len > BINLOG_CHECKSUM_LEN)
       event_len-= BINLOG_CHECKSUM_LEN;
@@ -5145,7 +5162,7 @@ uint8 get_checksum_alg(const char* buf, ulong len)
     * (uint8*) (buf + len - BINLOG_CHECKSUM_LEN - BINLOG_CHECKSUM_ALG_DESC_LEN);
   DBUG_ASSERT(ret == BINLOG_CHECKSUM_ALG_OFF ||
               ret == BINLOG_CHECKSUM_ALG_UNDEF ||
-              ret == BINLOG_CHECKSUM_ALG_CRC32);
+              binlog_checksum_is_on(ret));
   DBUG_RETURN(ret);
 }
   
@@ -6283,7 +6300,7 @@ Gtid_log_event::peek(const char *event_start, size_t event_len,
 {
   const char *p;
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
   {
     if (event_len > BINLOG_CHECKSUM_LEN)
       event_len-= BINLOG_CHECKSUM_LEN;
@@ -6771,7 +6788,7 @@ Gtid_list_log_event::peek(const char *event_start, uint32 event_len,
   uint32 count_field, count;
   rpl_gtid *gtid_list;
 
-  if (checksum_alg == BINLOG_CHECKSUM_ALG_CRC32)
+  if (binlog_checksum_is_on(checksum_alg))
   {
     if (event_len > BINLOG_CHECKSUM_LEN)
       event_len-= BINLOG_CHECKSUM_LEN;
@@ -9038,10 +9055,12 @@ Rows_log_event::Rows_log_event(THD *thd_arg, TABLE *tbl_arg, ulong tid,
     m_table(tbl_arg),
     m_table_id(tid),
     m_width(tbl_arg ? tbl_arg->s->fields : 1),
-    m_rows_buf(0), m_rows_cur(0), m_rows_end(0), m_flags(0) 
+    m_rows_buf(0), m_rows_cur(0), m_rows_end(0),
+    m_compressed(false), m_compressed_buf(0), m_compressed_len(0),
+    m_flags(0) 
 #ifdef HAVE_REPLICATION
     , m_curr_row(NULL), m_curr_row_end(NULL),
-    m_key(NULL), m_key_info(NULL), m_key_nr(0)
+    m_key(NULL), m_key_info(NULL), m_key_nr(0), m_hash_row(NULL)
 #endif
 {
   /*
@@ -9087,10 +9106,12 @@ Rows_log_event::Rows_log_event(const char *buf, uint event_len,
 #ifndef MYSQL_CLIENT
     m_table(NULL),
 #endif
-    m_table_id(0), m_rows_buf(0), m_rows_cur(0), m_rows_end(0)
+    m_table_id(0), m_rows_buf(0), m_rows_cur(0), m_rows_end(0),
+    m_compressed(is_compressed_rows_event((uchar) buf[EVENT_TYPE_OFFSET])),
+    m_compressed_buf(0), m_compressed_len(0)
 #if !defined(MYSQL_CLIENT) && defined(HAVE_REPLICATION)
     , m_curr_row(NULL), m_curr_row_end(NULL),
-    m_key(NULL), m_key_info(NULL), m_key_nr(0)
+    m_key(NULL), m_key_info(NULL), m_key_nr(0), m_hash_row(NULL)
 #endif
 {
   DBUG_ENTER("Rows_log_event::Rows_log_event(const char*,...)");
@@ -9171,13 +9192,50 @@ Rows_log_event::Rows_log_event(const char *buf, uint event_len,
     }
   }
 
-  const uchar* const ptr_rows_data= (const uchar*) ptr_after_width;
+  const uchar* ptr_rows_data= (const uchar*) ptr_after_width;
 
-  size_t const data_size= event_len - (ptr_rows_data - (const uchar *) buf);
+  size_t data_size= event_len - (ptr_rows_data - (const uchar *) buf);
   DBUG_PRINT("info",("m_table_id: %lu  m_flags: %d  m_width: %lu  data_size: %lu",
                      m_table_id, m_flags, m_width, (ulong) data_size));
 
-  m_rows_buf= (uchar*) my_malloc(data_size, MYF(MY_WME));
+  if (m_compressed)
+  {
+    /* An invalid rows part leaves m_rows_buf NULL, caught in is_valid() */
+    if (data_size < RW_COMPRESSED_HEADER_LEN ||
+        ptr_rows_data[RW_COMPRESSED_ALG_OFFSET] != RW_COMPRESSED_ALG_ZLIB)
+      DBUG_VOID_RETURN;
+    uLongf uncompressed_size=
+      uint4korr(ptr_rows_data + RW_COMPRESSED_LEN_OFFSET);
+#ifndef max_allowed_packet
+    THD *thd= current_thd;
+    uint max_allowed_packet= thd ? slave_max_allowed_packet : ~(uint)0;
+#endif
+    /* Don't trust the length of a corrupt event for the allocation */
+    if (uncompressed_size > max_allowed_packet)
+    {
+      DBUG_PRINT("error", ("uncompressed rows too big: %lu",
+                           (ulong) uncompressed_size));
+      DBUG_VOID_RETURN;
+    }
+    if (!(m_rows_buf= (uchar*) my_malloc(uncompressed_size + 1, MYF(MY_WME))))
+      DBUG_VOID_RETURN;
+    if (uncompress(m_rows_buf, &uncompressed_size,
+                   ptr_rows_data + RW_COMPRESSED_HEADER_LEN,
+                   data_size - RW_COMPRESSED_HEADER_LEN) != Z_OK ||
+        uncompressed_size !=
+        uint4korr(ptr_rows_data + RW_COMPRESSED_LEN_OFFSET))
+    {
+      DBUG_PRINT("error", ("corrupt compressed rows"));
+      my_free(m_rows_buf);
+      m_rows_buf= NULL;
+      DBUG_VOID_RETURN;
+    }
+    data_size= uncompressed_size;
+    ptr_rows_data= NULL;
+  }
+  else
+    m_rows_buf= (uchar*) my_malloc(data_size, MYF(MY_WME));
+
   if (likely((bool)m_rows_buf))
   {
 #if !defined(MYSQL_CLIENT) && defined(HAVE_REPLICATION)
@@ -9185,7 +9243,8 @@ Rows_log_event::Rows_log_event(const char *buf, uint event_len,
 #endif
     m_rows_end= m_rows_buf + data_size;
     m_rows_cur= m_rows_end;
-    memcpy(m_rows_buf, ptr_rows_data, data_size);
+    if (ptr_rows_data)
+      memcpy(m_rows_buf, ptr_rows_data, data_size);
   }
   else
     m_cols.bitmap= 0; // to not free it
@@ -9199,6 +9258,7 @@ Rows_log_event::~Rows_log_event()
     m_cols.bitmap= 0; // so no my_free in bitmap_free
   bitmap_free(&m_cols); // To pair with bitmap_init().
   my_free(m_rows_buf);
+  my_free(m_compressed_buf);
 }
 
 int Rows_log_event::get_data_size()
@@ -9219,7 +9279,10 @@ int Rows_log_event::get_data_size()
   if (type_code == UPDATE_ROWS_EVENT)
     data_size+= no_bytes_in_map(&m_cols_ai);
 
-  data_size+= (uint) (m_rows_cur - m_rows_buf);
+  if (m_compressed_buf)
+    data_size+= (uint) m_compressed_len;
+  else
+    data_size+= (uint) (m_rows_cur - m_rows_buf);
   return data_size; 
 }
 
@@ -9527,6 +9590,26 @@ int Rows_log_event::do_apply_event(rpl_group_info *rgi)
      */
     rgi->set_row_stmt_start_timestamp();
 
+    /*
+      Without a key to search with, find_row() would scan the whole
+      table once per row. Locate all rows of the event with a single
+      scan instead and let find_row() fetch them by position.
+    */
+    bool hash_scan= (error == 0 && opt_slave_rows_hash_scan && !m_key_info &&
+                     (get_type_code() == UPDATE_ROWS_EVENT ||
+                      get_type_code() == DELETE_ROWS_EVENT) &&
+                     !((table->file->ha_table_flags() &
+                        HA_PRIMARY_KEY_REQUIRED_FOR_POSITION) &&
+                       table->s->primary_key < MAX_KEY));
+    if (hash_scan)
+    {
+      THD* old_thd= table->in_use;
+      if (!table->in_use)
+        table->in_use= thd;
+      error= do_hash_scan(rgi);
+      table->in_use= old_thd;
+    }
+
     while (error == 0 && m_curr_row < m_rows_end)
     {
       /* in_use can have been set to NULL in close_tables_for_reopen */
@@ -9588,6 +9671,9 @@ int Rows_log_event::do_apply_event(rpl_group_info *rgi)
           thd->transaction.stmt.modified_non_trans_table= TRUE;
     } // row processing loop
 
+    if (hash_scan)
+      free_hash_scan();
+
     /*
       Restore the sql_mode after the rows event is processed.
     */
@@ -9827,12 +9913,61 @@ bool Rows_log_event::write_data_body(IO_CACHE*file)
     res= res || wrapper_my_b_safe_write(file, (uchar*) m_cols_ai.bitmap,
                                 no_bytes_in_map(&m_cols_ai));
   }
+  if (m_compressed_buf)
+  {
+    DBUG_DUMP("compressed rows", m_compressed_buf, m_compressed_len);
+    res= res || wrapper_my_b_safe_write(file, m_compressed_buf,
+                                        m_compressed_len);
+    return res;
+  }
   DBUG_DUMP("rows", m_rows_buf, data_size);
   res= res || wrapper_my_b_safe_write(file, m_rows_buf, (size_t) data_size);
 
   return res;
 
 }
+
+/**
+  Write the event, as a *_ROWS_COMPRESSED_EVENT if @@log_bin_compress
+  is set and the rows take at least @@log_bin_compress_min_len bytes.
+*/
+bool Rows_log_event::write(IO_CACHE *file)
+{
+  my_free(m_compressed_buf);
+  m_compressed_buf= NULL;
+  m_compressed= false;
+  if (opt_log_bin_compress &&
+      (size_t) (m_rows_cur - m_rows_buf) >= opt_log_bin_compress_min_len)
+    compress_rows();
+  return Log_event::write(file);
+}
+
+/**
+  Compress the rows into m_compressed_buf. The event stays uncompressed
+  if that fails or does not make it smaller.
+*/
+void Rows_log_event::compress_rows()
+{
+  size_t const data_size= m_rows_cur - m_rows_buf;
+  uLongf len= compressBound((uLong) data_size);
+  uchar *buf;
+
+  if (!(buf= (uchar*) my_malloc(RW_COMPRESSED_HEADER_LEN + len, MYF(0))))
+    return;
+  buf[RW_COMPRESSED_ALG_OFFSET]= RW_COMPRESSED_ALG_ZLIB;
+  int4store(buf + RW_COMPRESSED_LEN_OFFSET, (uint32) data_size);
+  /* Favour speed: this runs in the binlog write path of every statement */
+  if (compress2(buf + RW_COMPRESSED_HEADER_LEN, &len, m_rows_buf,
+                (uLong) data_size, Z_BEST_SPEED) != Z_OK ||
+      RW_COMPRESSED_HEADER_LEN + len >= data_size)
+  {
+    my_free(buf);
+    return;
+  }
+  m_compressed_buf= buf;
+  m_compressed_len= RW_COMPRESSED_HEADER_LEN + len;
+  m_compressed= true;
+}
 #endif
 
 #if defined(HAVE_REPLICATION) && !defined(MYSQL_CLIENT)
@@ -9858,8 +9993,8 @@ void Rows_log_event::print_helper(FILE *file,
   {
     bool const last_stmt_event= get_flags(STMT_END_F);
     print_header(head, print_event_info, !last_stmt_event);
-    my_b_printf(head, "\t%s: table id %lu%s\n",
-                name, m_table_id,
+    my_b_printf(head, "\t%s%s: table id %lu%s\n",
+                name, m_compressed ? "_compressed" : "", m_table_id,
                 last_stmt_event ? " flags: STMT_END_F" : "");
     print_base64(body, print_event_info, !last_stmt_event);
   }
@@ -11270,6 +11405,47 @@ record_compare_exit:
 }
 
 
+/*
+  Before image of one row of an update or delete event, see
+  do_hash_scan().
+*/
+struct Rows_log_event::hash_row
+{
+  ulong hash;                         /* hash_record() of the before image */
+  const uchar *row;                   /* Before image in m_rows_buf */
+  uchar *pos;                         /* position() of the row, or NULL */
+  hash_row *next;                     /* Next row of the event */
+};
+
+
+/*
+  Hash the fields of table->record[0].
+
+  Records that record_compare() considers equal must hash the same, so
+  only field contents are used. Field::hash() would hash the data
+  pointer of a blob, so blobs hash their data here.
+*/
+static ulong hash_record(TABLE *table)
+{
+  ulong nr= 1, nr2= 4;
+  for (Field **ptr= table->field; *ptr; ptr++)
+  {
+    Field *field= *ptr;
+    if ((field->flags & BLOB_FLAG) && !field->is_null())
+    {
+      Field_blob *blob= (Field_blob*) field;
+      CHARSET_INFO *cs= blob->charset();
+      uchar *data;
+      blob->get_ptr(&data);
+      cs->coll->hash_sort(cs, data, blob->get_length(), &nr, &nr2);
+    }
+    else
+      field->hash(&nr, &nr2);
+  }
+  return nr;
+}
+
+
 /**
   Find the best key to use when locating the row in @c find_row().
 
@@ -11451,6 +11627,34 @@ int Rows_log_event::find_row(rpl_group_info *rgi)
   DBUG_DUMP("record[0]", table->record[0], table->s->reclength);
 #endif
 
+  if (m_hash_row && m_hash_row->row == m_curr_row)
+  {
+    /*
+      The row was already located by do_hash_scan(); fetch it by the
+      position saved there. A row that was not found reports the same
+      error as the table scan below.
+    */
+    hash_row *row= m_hash_row;
+    m_hash_row= row->next;
+    DBUG_PRINT("info",("locating record using hash scan (rnd_pos)"));
+
+    if (!row->pos)
+      DBUG_RETURN(HA_ERR_END_OF_FILE);
+
+    if (!table->file->inited &&
+        (error= table->file->ha_rnd_init_with_error(0)))
+      DBUG_RETURN(error);
+
+    if ((error= table->file->ha_rnd_pos(table->record[0], row->pos)))
+    {
+      DBUG_PRINT("info",("rnd_pos returns error %d",error));
+      if (error == HA_ERR_RECORD_DELETED)
+        error= HA_ERR_KEY_NOT_FOUND;
+      table->file->print_error(error, MYF(0));
+    }
+    DBUG_RETURN(error);
+  }
+
   if ((table->file->ha_table_flags() & HA_PRIMARY_KEY_REQUIRED_FOR_POSITION) &&
       table->s->primary_key < MAX_KEY)
   {
@@ -11720,6 +11924,148 @@ end:
   DBUG_RETURN(error);
 }
 
+
+/**
+  Locate all rows of an update or delete event with one table scan.
+
+  The before image of every row in the event is hashed into m_hash.
+  The table is then scanned once, and each table row whose hash
+  matches an unclaimed before image is compared to it with
+  record_compare(). On a match the handler position of the row is
+  saved in the entry, so that find_row() can fetch it with rnd_pos()
+  when the row is applied. Each table row is claimed by at most one
+  before image, which keeps events with duplicate rows correct.
+
+  Nothing is changed in the table here; rows are still applied one
+  by one in event order by do_exec_row().
+
+  @return Error code, or 0. On success m_hash_row points to the entry
+  for the first row of the event.
+*/
+
+int Rows_log_event::do_hash_scan(rpl_group_info *rgi)
+{
+  TABLE *table= m_table;
+  handler *file= table->file;
+  hash_row *first= NULL, **last= &first;
+  ulong unmatched= 0;
+  int error= 0;
+  DBUG_ENTER("Rows_log_event::do_hash_scan");
+
+  init_alloc_root(&m_hash_root, 8192, 0, MYF(0));
+  if (my_hash_init(&m_hash, &my_charset_bin, 64, offsetof(hash_row, hash),
+                   sizeof(ulong), 0, 0, 0))
+    DBUG_RETURN(HA_ERR_OUT_OF_MEM);
+
+  table->use_all_columns();
+
+  for (m_curr_row= m_rows_buf; m_curr_row < m_rows_end;
+       m_curr_row= m_curr_row_end)
+  {
+    hash_row *row;
+
+    prepare_record(table, m_width, FALSE);
+    if ((error= unpack_current_row(rgi)))
+      goto end;
+    if (!(row= (hash_row*) alloc_root(&m_hash_root, sizeof(hash_row))))
+    {
+      error= HA_ERR_OUT_OF_MEM;
+      goto end;
+    }
+    row->hash= hash_record(table);
+    row->row= m_curr_row;
+    row->pos= NULL;
+    row->next= NULL;
+    *last= row;
+    last= &row->next;
+    if (my_hash_insert(&m_hash, (uchar*) row))
+    {
+      error= HA_ERR_OUT_OF_MEM;
+      goto end;
+    }
+    unmatched++;
+
+    /* Skip the after image */
+    if (get_type_code() == UPDATE_ROWS_EVENT)
+    {
+      m_curr_row= m_curr_row_end;
+      if ((error= unpack_current_row(rgi)))
+        goto end;
+    }
+  }
+
+  DBUG_PRINT("info",("locating %lu rows using hash scan", unmatched));
+
+  if ((error= file->ha_rnd_init_with_error(1)))
+    goto end;
+
+  while (unmatched)
+  {
+    HASH_SEARCH_STATE state;
+    hash_row *row;
+    ulong hash;
+
+    if ((error= file->ha_rnd_next(table->record[0])))
+    {
+      if (error == HA_ERR_RECORD_DELETED)
+        continue;
+      if (error == HA_ERR_END_OF_FILE)
+        error= 0;
+      else
+        file->print_error(error, MYF(0));
+      break;
+    }
+
+    hash= hash_record(table);
+    if (!(row= (hash_row*) my_hash_first(&m_hash, (uchar*) &hash,
+                                         sizeof(hash), &state)))
+      continue;
+
+    /*
+      Keep the table row in record[1] for record_compare() and unpack
+      the candidate before images into record[0].
+    */
+    file->position(table->record[0]);
+    store_record(table, record[1]);
+    for (; row; row= (hash_row*) my_hash_next(&m_hash, (uchar*) &hash,
+                                               sizeof(hash), &state))
+    {
+      if (row->pos)
+        continue;
+      m_curr_row= row->row;
+      prepare_record(table, m_width, FALSE);
+      if ((error= unpack_current_row(rgi)))
+        break;
+      if (!record_compare(table))
+      {
+        if (!(row->pos= (uchar*) memdup_root(&m_hash_root, file->ref,
+                                             file->ref_length)))
+          error= HA_ERR_OUT_OF_MEM;
+        unmatched--;
+        break;
+      }
+    }
+    if (error)
+      break;
+  }
+  file->ha_rnd_end();
+
+end:
+  table->default_column_bitmaps();
+  m_curr_row= m_rows_buf;
+  m_curr_row_end= NULL;
+  m_hash_row= error ? NULL : first;
+  DBUG_RETURN(error);
+}
+
+
+void Rows_log_event::free_hash_scan()
+{
+  m_hash_row= NULL;
+  my_hash_free(&m_hash);
+  free_root(&m_hash_root, MYF(0));
+}
+
 #endif
 
 /*
@@ -12095,10 +12441,11 @@ Incident_log_event::write_data_body(IO_CACHE *file)
   uchar tmp[1];
   DBUG_ENTER("Incident_log_event::write_data_body");
   tmp[0]= (uchar) m_message.length;
-  crc= my_checksum(crc, (uchar*) tmp, 1);
+  crc= binlog_checksum(checksum_alg, crc, (uchar*) tmp, 1);
   if (m_message.length > 0)
   {
-    crc= my_checksum(crc, (uchar*) m_message.str, m_message.length);
+    crc= binlog_checksum(checksum_alg, crc, (uchar*) m_message.str,
+                         m_message.length);
     // todo: report a bug on write_str accepts uint but treats it as uchar
   }
   DBUG_RETURN(write_str(file, m_message.str, (uint) m_message.length));
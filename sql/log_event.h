@@ -416,6 +416,15 @@ struct sql_ex_info
 #define RW_MAPID_OFFSET    0
 #define RW_FLAGS_OFFSET    6
 
+/*
+  The rows part of a *_ROWS_COMPRESSED_EVENT: a 1 byte algorithm, the
+  4 byte length of the uncompressed rows, then the compressed rows.
+*/
+#define RW_COMPRESSED_ALG_OFFSET 0
+#define RW_COMPRESSED_LEN_OFFSET 1
+#define RW_COMPRESSED_HEADER_LEN 5
+#define RW_COMPRESSED_ALG_ZLIB   0
+
 /* ELQ = "Execute Load Query" */
 #define ELQ_FILE_ID_OFFSET QUERY_HEADER_LEN
 #define ELQ_FN_POS_START_OFFSET ELQ_FILE_ID_OFFSET + 4
@@ -566,6 +575,7 @@ enum enum_binlog_checksum_alg {
   BINLOG_CHECKSUM_ALG_OFF= 0,    // Events are without checksum though its generator
                                  // is checksum-capable New Master (NM).
   BINLOG_CHECKSUM_ALG_CRC32= 1,  // CRC32 of zlib algorithm.
+  BINLOG_CHECKSUM_ALG_CRC32C= 2, // CRC-32C (Castagnoli), SSE 4.2 instruction.
   BINLOG_CHECKSUM_ALG_ENUM_END,  // the cut line: valid alg range is [1, 0x7f].
   BINLOG_CHECKSUM_ALG_UNDEF= 255 // special value to tag undetermined yet checksum
                                  // or events from checksum-unaware servers
@@ -573,11 +583,31 @@ enum enum_binlog_checksum_alg {
 
 #define CHECKSUM_CRC32_SIGNATURE_LEN 4
 /**
-   defined statically while there is just one alg implemented
+   defined statically while all implemented algs have 4 byte checksums
 */
 #define BINLOG_CHECKSUM_LEN CHECKSUM_CRC32_SIGNATURE_LEN
 #define BINLOG_CHECKSUM_ALG_DESC_LEN 1  /* 1 byte checksum alg descriptor */
 
+/**
+   Whether events written with the checksum alg carry a checksum.
+*/
+static inline bool binlog_checksum_is_on(uint8 alg)
+{
+  return alg > BINLOG_CHECKSUM_ALG_OFF && alg < BINLOG_CHECKSUM_ALG_ENUM_END;
+}
+
+/**
+   Continue the checksum of an event with the next bytes of the event.
+   The checksum of an event starts from binlog_checksum(alg, 0, NULL, 0).
+*/
+static inline ha_checksum binlog_checksum(uint8 alg, ha_checksum crc,
+                                          const uchar *pos, size_t length)
+{
+  if (alg == BINLOG_CHECKSUM_ALG_CRC32C)
+    return my_crc32c(crc, pos, length);
+  return my_checksum(crc, pos, length);
+}
+
 /*
   These are capability numbers for MariaDB slave servers.
 
@@ -607,9 +637,14 @@ enum enum_binlog_checksum_alg {
 #define MARIA_SLAVE_CAPABILITY_BINLOG_CHECKPOINT 3
 /* MariaDB >= 10.0.1, which knows about global transaction id events. */
 #define MARIA_SLAVE_CAPABILITY_GTID 4
+/*
+  MariaDB >= 10.0.7, which knows about CRC32C checksums and compressed
+  row events.
+*/
+#define MARIA_SLAVE_CAPABILITY_COMPRESSED_EVENTS 5
 
 /* Our capability. */
-#define MARIA_SLAVE_CAPABILITY_MINE MARIA_SLAVE_CAPABILITY_GTID
+#define MARIA_SLAVE_CAPABILITY_MINE MARIA_SLAVE_CAPABILITY_COMPRESSED_EVENTS
 
 
 /**
@@ -710,9 +745,40 @@ enum Log_event_type
 
   /* Add new MariaDB events here - right above this comment!  */
 
-  ENUM_END_EVENT /* end marker */
+  ENUM_END_EVENT, /* end marker */
+
+  /*
+    Row events with a compressed rows part, written when log_bin_compress
+    is set. They have the post-header of the uncompressed row events, so
+    they have no post_header_len entry in Format_description_log_event and
+    are kept out of the range it describes.
+  */
+  WRITE_ROWS_COMPRESSED_EVENT= 166,
+  UPDATE_ROWS_COMPRESSED_EVENT= 167,
+  DELETE_ROWS_COMPRESSED_EVENT= 168
 };
 
+static inline bool is_compressed_rows_event(uint type)
+{
+  return type >= WRITE_ROWS_COMPRESSED_EVENT &&
+         type <= DELETE_ROWS_COMPRESSED_EVENT;
+}
+
+/**
+   Map between a row event type and its compressed variant.
+*/
+static inline Log_event_type compressed_rows_event(Log_event_type type)
+{
+  return (Log_event_type) (type - WRITE_ROWS_EVENT +
+                           WRITE_ROWS_COMPRESSED_EVENT);
+}
+
+static inline Log_event_type uncompressed_rows_event(uint type)
+{
+  return (Log_event_type) (type - WRITE_ROWS_COMPRESSED_EVENT +
+                           WRITE_ROWS_EVENT);
+}
+
 /*
    The number of types we handle in Format_description_log_event (UNKNOWN_EVENT
    is not to be handled, it does not exist in binlogs, it does not have a
@@ -1251,6 +1317,11 @@ public:
   }
 #endif
   virtual Log_event_type get_type_code() = 0;
+  /*
+    The type stored in the event header. It differs from get_type_code()
+    for events stored in a compressed form.
+  */
+  virtual Log_event_type get_header_type_code() { return get_type_code(); }
   virtual bool is_valid() const = 0;
   virtual my_off_t get_header_len(my_off_t len) { return len; }
   void set_artificial_event() { flags |= LOG_EVENT_ARTIFICIAL_F; }
@@ -4208,10 +4279,16 @@ public:
   ulong get_table_id() const        { return m_table_id; }
 
 #ifdef MYSQL_SERVER
+  virtual bool write(IO_CACHE *file);
   virtual bool write_data_header(IO_CACHE *file);
   virtual bool write_data_body(IO_CACHE *file);
   virtual const char *get_db() { return m_table->s->db.str; }
 #endif
+  virtual Log_event_type get_header_type_code()
+  {
+    return m_compressed ? compressed_rows_event(get_type_code()) :
+                          get_type_code();
+  }
   /*
     Check that malloc() succeeded in allocating memory for the rows
     buffer and the COLS vector. Checking that an Update_rows_log_event
@@ -4245,6 +4322,7 @@ protected:
 
 #ifdef MYSQL_SERVER
   virtual int do_add_row_data(uchar *data, size_t length);
+  void compress_rows();
 #endif
 
 #ifdef MYSQL_SERVER
@@ -4272,6 +4350,14 @@ protected:
   uchar    *m_rows_cur;		/* One-after the end of the data */
   uchar    *m_rows_end;		/* One-after the end of the allocated space */
 
+  /*
+    The event is, or is being written as, a *_ROWS_COMPRESSED_EVENT.
+    When writing, m_compressed_buf holds the compressed rows part.
+  */
+  bool      m_compressed;
+  uchar    *m_compressed_buf;
+  size_t    m_compressed_len;
+
   flag_set m_flags;		/* Flags for row-level events */
 
   /* helper functions */
@@ -4283,8 +4369,19 @@ protected:
   KEY      *m_key_info; /* Pointer to KEY info for m_key_nr */
   uint      m_key_nr;   /* Key number */
 
+  /*
+    Rows located by a single table scan when --slave-rows-hash-scan is
+    set and the table has no usable key, see do_hash_scan().
+  */
+  struct hash_row;
+  HASH      m_hash;     /* Before images keyed by record hash */
+  MEM_ROOT  m_hash_root; /* Storage for hash_row entries and positions */
+  hash_row *m_hash_row; /* Entry for the next row given to find_row() */
+
   int find_key(); // Find a best key to use in find_row()
   int find_row(rpl_group_info *);
+  int do_hash_scan(rpl_group_info *);
+  void free_hash_scan();
   int write_row(rpl_group_info *, const bool);
 
   // Unpack the current row into m_table->record[0]
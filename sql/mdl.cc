@@ -18,6 +18,7 @@
 #include "debug_sync.h"
 #include "sql_array.h"
 #include <hash.h>
+#include <my_atomic.h>
 #include <mysqld_error.h>
 #include <mysql/plugin.h>
 #include <mysql/service_thd_wait.h>
@@ -108,6 +109,9 @@ void MDL_key::init_psi_keys()
 
 static bool mdl_initialized= 0;
 
+/** Protects MDL_lock::m_fast_path_state when atomics are emulated. */
+static my_atomic_rwlock_t LOCK_mdl_fast_path;
+
 
 class MDL_object_lock;
 class MDL_object_lock_cache_adapter;
@@ -125,7 +129,9 @@ public:
   MDL_map_partition();
   ~MDL_map_partition();
   inline MDL_lock *find_or_insert(const MDL_key *mdl_key,
-                                  my_hash_value_type hash_value);
+                                  my_hash_value_type hash_value,
+                                  int64 fast_path_increment,
+                                  bool *fast_path);
   unsigned long get_lock_owner(const MDL_key *key,
                                my_hash_value_type hash_value);
   inline void remove(MDL_lock *lock);
@@ -177,7 +183,8 @@ class MDL_map
 public:
   void init();
   void destroy();
-  MDL_lock *find_or_insert(const MDL_key *key);
+  MDL_lock *find_or_insert(const MDL_key *key, int64 fast_path_increment,
+                           bool *fast_path);
   unsigned long get_lock_owner(const MDL_key *key);
   void remove(MDL_lock *lock);
 private:
@@ -424,6 +431,29 @@ public:
 
   virtual const bitmap_t *incompatible_granted_types_bitmap() const = 0;
   virtual const bitmap_t *incompatible_waiting_types_bitmap() const = 0;
+  virtual const int64 *fast_path_increments() const = 0;
+  virtual bitmap_t obtrusive_types_bitmap() const = 0;
+
+  static int64 fast_path_increment(const MDL_key *key, enum_mdl_type type);
+
+  int64 fast_path_state() const
+  {
+    int64 state;
+    my_atomic_rwlock_rdlock(&LOCK_mdl_fast_path);
+    state= my_atomic_load64(const_cast<volatile int64 *>(&m_fast_path_state));
+    my_atomic_rwlock_rdunlock(&LOCK_mdl_fast_path);
+    return state;
+  }
+  bool has_fast_path_locks() const
+  {
+    return fast_path_state() & FAST_PATH_COUNTERS;
+  }
+  bitmap_t fast_path_granted_bitmap() const;
+  bool fast_path_acquire(int64 increment);
+  void fast_path_release(int64 increment);
+  void materialize_fast_path_ticket(MDL_ticket *ticket);
+  void update_fast_path_obtrusive_flag();
+  void set_fast_path_obtrusive_flag();
 
   bool has_pending_conflicting_lock(enum_mdl_type type);
 
@@ -438,6 +468,7 @@ public:
   void reschedule_waiters();
 
   void remove_ticket(Ticket_list MDL_lock::*queue, MDL_ticket *ticket);
+  void unlock_or_remove();
 
   bool visit_subgraph(MDL_ticket *waiting_ticket,
                       MDL_wait_for_graph_visitor *gvisitor);
@@ -458,11 +489,41 @@ public:
   */
   ulong m_hog_lock_count;
 
+  /**
+    Locks of "unobtrusive" types (S, SH, SR and SW for per-object locks,
+    IX for scoped locks) which are compatible with each other are granted
+    on the fast path, without taking m_rwlock and without adding tickets
+    to m_granted. Instead, a per-type counter packed into this word is
+    incremented with a single compare-and-swap.
+
+    Each counter takes FAST_PATH_COUNTER_BITS bits, its position is given
+    by fast_path_increments(). FAST_PATH_HAS_OBTRUSIVE is set while there
+    are granted or waiting locks of "obtrusive" types (the ones that
+    conflict with unobtrusive locks, @sa obtrusive_types_bitmap()).
+    The flag is only changed under write-locked m_rwlock and disables the
+    fast path, so while it is set and m_rwlock is write-locked counters can
+    only change under m_rwlock and can be taken into account when checking
+    whether obtrusive lock can be granted.
+
+    A non-zero counter keeps the object in MDL_map, like a ticket in
+    m_granted does. To avoid races with MDL_map_partition::remove() fast
+    path locks for objects in partitioned hash are acquired only under
+    MDL_map_partition::m_mutex, and the last fast path lock is released
+    under m_rwlock.
+  */
+  volatile int64 m_fast_path_state;
+
+  static const uint FAST_PATH_COUNTER_BITS= 15;
+  static const int64 FAST_PATH_COUNTER_MAX= (1LL << FAST_PATH_COUNTER_BITS) - 1;
+  static const int64 FAST_PATH_COUNTERS= (1LL << (4 * FAST_PATH_COUNTER_BITS)) - 1;
+  static const int64 FAST_PATH_HAS_OBTRUSIVE= 1LL << 62;
+
 public:
 
   MDL_lock(const MDL_key *key_arg, MDL_map_partition *map_part)
   : key(key_arg),
     m_hog_lock_count(0),
+    m_fast_path_state(0),
     m_ref_usage(0),
     m_ref_release(0),
     m_is_destroyed(FALSE),
@@ -546,6 +607,14 @@ public:
   {
     return m_waiting_incompatible;
   }
+  virtual const int64 *fast_path_increments() const
+  {
+    return m_fast_path_increment;
+  }
+  virtual bitmap_t obtrusive_types_bitmap() const
+  {
+    return MDL_BIT(MDL_SHARED) | MDL_BIT(MDL_EXCLUSIVE);
+  }
   virtual bool needs_notification(const MDL_ticket *ticket) const
   {
     return (ticket->get_type() == MDL_SHARED);
@@ -561,6 +630,8 @@ public:
     return 0;
   }
 
+  static const int64 m_fast_path_increment[MDL_TYPE_END];
+
 private:
   static const bitmap_t m_granted_incompatible[MDL_TYPE_END];
   static const bitmap_t m_waiting_incompatible[MDL_TYPE_END];
@@ -591,6 +662,7 @@ public:
     DBUG_ASSERT(is_empty());
     /* Object should not be marked as destroyed. */
     DBUG_ASSERT(! m_is_destroyed);
+    DBUG_ASSERT(! m_fast_path_state);
     /*
       Values of the rest of the fields should be preserved between old and
       new versions of the object. E.g., m_version and m_ref_usage/release
@@ -607,6 +679,16 @@ public:
   {
     return m_waiting_incompatible;
   }
+  virtual const int64 *fast_path_increments() const
+  {
+    return m_fast_path_increment;
+  }
+  virtual bitmap_t obtrusive_types_bitmap() const
+  {
+    return (MDL_BIT(MDL_SHARED_NO_WRITE) |
+            MDL_BIT(MDL_SHARED_NO_READ_WRITE) |
+            MDL_BIT(MDL_EXCLUSIVE));
+  }
   virtual bool needs_notification(const MDL_ticket *ticket) const
   {
     return (ticket->get_type() >= MDL_SHARED_NO_WRITE);
@@ -625,6 +707,8 @@ public:
             MDL_BIT(MDL_EXCLUSIVE));
   }
 
+  static const int64 m_fast_path_increment[MDL_TYPE_END];
+
 private:
   static const bitmap_t m_granted_incompatible[MDL_TYPE_END];
   static const bitmap_t m_waiting_incompatible[MDL_TYPE_END];
@@ -685,6 +769,7 @@ void mdl_init()
   init_mdl_psi_keys();
 #endif
 
+  my_atomic_rwlock_init(&LOCK_mdl_fast_path);
   mdl_locks.init();
 }
 
@@ -702,6 +787,7 @@ void mdl_destroy()
   {
     mdl_initialized= FALSE;
     mdl_locks.destroy();
+    my_atomic_rwlock_destroy(&LOCK_mdl_fast_path);
   }
 }
 
@@ -773,12 +859,22 @@ MDL_map_partition::~MDL_map_partition()
   Find MDL_lock object corresponding to the key, create it
   if it does not exist.
 
+  @param      mdl_key              Key of the lock.
+  @param      fast_path_increment  If non-0, try to grant the lock on the
+                                   fast path by adding this value to
+                                   MDL_lock::m_fast_path_state.
+  @param[out] fast_path            Set to TRUE if the lock was granted on
+                                   the fast path, FALSE otherwise.
+
   @retval non-NULL - Success. MDL_lock instance for the key with
-                     locked MDL_lock::m_rwlock.
+                     locked MDL_lock::m_rwlock, unless the lock
+                     was granted on the fast path.
   @retval NULL     - Failure (OOM).
 */
 
-MDL_lock* MDL_map::find_or_insert(const MDL_key *mdl_key)
+MDL_lock* MDL_map::find_or_insert(const MDL_key *mdl_key,
+                                  int64 fast_path_increment,
+                                  bool *fast_path)
 {
   MDL_lock *lock;
 
@@ -799,6 +895,14 @@ MDL_lock* MDL_map::find_or_insert(const MDL_key *mdl_key)
     lock= (mdl_key->mdl_namespace() == MDL_key::GLOBAL) ? m_global_lock :
                                                           m_commit_lock;
 
+    /*
+      Pre-allocated objects are never destroyed, so the fast path
+      doesn't need any mutex at all for them.
+    */
+    if ((*fast_path= (fast_path_increment &&
+                      lock->fast_path_acquire(fast_path_increment))))
+      return lock;
+
     mysql_prlock_wrlock(&lock->m_rwlock);
 
     return lock;
@@ -808,7 +912,8 @@ MDL_lock* MDL_map::find_or_insert(const MDL_key *mdl_key)
   uint part_id= hash_value % mdl_locks_hash_partitions;
   MDL_map_partition *part= m_partitions.at(part_id);
 
-  return part->find_or_insert(mdl_key, hash_value);
+  return part->find_or_insert(mdl_key, hash_value, fast_path_increment,
+                              fast_path);
 }
 
 
@@ -816,16 +921,22 @@ MDL_lock* MDL_map::find_or_insert(const MDL_key *mdl_key)
   Find MDL_lock object corresponding to the key and hash value in
   MDL_map partition, create it if it does not exist.
 
+  @sa MDL_map::find_or_insert().
+
   @retval non-NULL - Success. MDL_lock instance for the key with
-                     locked MDL_lock::m_rwlock.
+                     locked MDL_lock::m_rwlock, unless the lock
+                     was granted on the fast path.
   @retval NULL     - Failure (OOM).
 */
 
 MDL_lock* MDL_map_partition::find_or_insert(const MDL_key *mdl_key,
-                                            my_hash_value_type hash_value)
+                                            my_hash_value_type hash_value,
+                                            int64 fast_path_increment,
+                                            bool *fast_path)
 {
   MDL_lock *lock;
 
+  *fast_path= FALSE;
 retry:
   mysql_mutex_lock(&m_mutex);
   if (!(lock= (MDL_lock*) my_hash_search_using_hash_value(&m_locks,
@@ -880,6 +991,18 @@ retry:
     }
   }
 
+  /*
+    The object can't be removed from the hash while we hold m_mutex,
+    and once the fast path counter is incremented it won't be removed
+    until the counter drops to zero.
+  */
+  if (fast_path_increment && lock->fast_path_acquire(fast_path_increment))
+  {
+    mysql_mutex_unlock(&m_mutex);
+    *fast_path= TRUE;
+    return lock;
+  }
+
   if (move_from_hash_to_lock_mutex(lock))
     goto retry;
 
@@ -1043,6 +1166,17 @@ void MDL_map::remove(MDL_lock *lock)
 void MDL_map_partition::remove(MDL_lock *lock)
 {
   mysql_mutex_lock(&m_mutex);
+  if (lock->has_fast_path_locks())
+  {
+    /*
+      Some other thread has acquired a lock on the fast path after we
+      have found the object unused. The last fast path lock to be
+      released will take care of removing it.
+    */
+    mysql_mutex_unlock(&m_mutex);
+    mysql_prlock_unlock(&lock->m_rwlock);
+    return;
+  }
   my_hash_delete(&m_locks, (uchar*) lock);
   /*
     To let threads holding references to the MDL_lock object know that it was
@@ -1115,6 +1249,7 @@ MDL_context::MDL_context()
   :
   m_owner(NULL),
   m_needs_thr_lock_abort(FALSE),
+  m_has_fast_path_locks(FALSE),
   m_waiting_for(NULL)
 {
   mysql_prlock_init(key_MDL_context_LOCK_waiting_for, &m_LOCK_waiting_for);
@@ -1747,6 +1882,207 @@ MDL_object_lock::m_waiting_incompatible[MDL_TYPE_END] =
 };
 
 
+/**
+  Increments of MDL_lock::m_fast_path_state for lock types which can be
+  granted on the fast path, 0 for types which are always granted on the
+  slow path.
+
+  For scoped locks only IX is "unobtrusive". For per-object locks these
+  are S, SH, SR and SW: they are compatible with each other and are only
+  in conflict with "obtrusive" SNW, SNRW and X locks (see the matrices
+  above). SU is neither: it conflicts only with itself and obtrusive
+  locks, so it never needs to look at fast path counters.
+*/
+
+const int64 MDL_scoped_lock::m_fast_path_increment[MDL_TYPE_END] =
+{
+  1, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+const int64 MDL_object_lock::m_fast_path_increment[MDL_TYPE_END] =
+{
+  0,
+  1,
+  1LL << FAST_PATH_COUNTER_BITS,
+  1LL << (2 * FAST_PATH_COUNTER_BITS),
+  1LL << (3 * FAST_PATH_COUNTER_BITS),
+  0, 0, 0, 0
+};
+
+
+/**
+  Return increment of MDL_lock::m_fast_path_state to be used when the
+  lock of the given type is granted on the fast path, 0 if it must be
+  granted on the slow path.
+
+  @note Chooses the table based on namespace of the key, like
+        MDL_lock::create() chooses MDL_lock descendant.
+*/
+
+int64 MDL_lock::fast_path_increment(const MDL_key *key, enum_mdl_type type)
+{
+  switch (key->mdl_namespace())
+  {
+    case MDL_key::GLOBAL:
+    case MDL_key::SCHEMA:
+    case MDL_key::COMMIT:
+      return MDL_scoped_lock::m_fast_path_increment[type];
+    default:
+      return MDL_object_lock::m_fast_path_increment[type];
+  }
+}
+
+
+/** Return bitmap of lock types which are currently granted on the fast path. */
+
+MDL_lock::bitmap_t MDL_lock::fast_path_granted_bitmap() const
+{
+  const int64 *increment= fast_path_increments();
+  int64 state= fast_path_state();
+  bitmap_t result= 0;
+
+  for (uint type= 0; type < MDL_TYPE_END; type++)
+  {
+    if (state & (increment[type] * FAST_PATH_COUNTER_MAX))
+      result|= MDL_BIT(type);
+  }
+  return result;
+}
+
+
+/**
+  Try to grant lock on the fast path.
+
+  @param increment  Value to be added to m_fast_path_state.
+
+  @retval TRUE   Lock granted.
+  @retval FALSE  There are granted or waiting obtrusive locks (or the
+                 counter is full), lock should be acquired on the slow path.
+*/
+
+bool MDL_lock::fast_path_acquire(int64 increment)
+{
+  int64 counter_mask= increment * FAST_PATH_COUNTER_MAX;
+  int64 old_state;
+  bool res= FALSE;
+
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  old_state= my_atomic_load64(&m_fast_path_state);
+  while (!(old_state & FAST_PATH_HAS_OBTRUSIVE) &&
+         (old_state & counter_mask) != counter_mask)
+  {
+    if (my_atomic_cas64(&m_fast_path_state, &old_state,
+                        old_state + increment))
+    {
+      res= TRUE;
+      break;
+    }
+  }
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+  return res;
+}
+
+
+/**
+  Release lock which was granted on the fast path.
+
+  Decrements the counter without taking m_rwlock unless this is the
+  last fast path lock (so the object might have to be removed from
+  MDL_map) or there are obtrusive locks (which might be waiting for
+  this lock to go away).
+
+  @param increment  Value which was added to m_fast_path_state when
+                    the lock was granted.
+*/
+
+void MDL_lock::fast_path_release(int64 increment)
+{
+  int64 old_state;
+
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  old_state= my_atomic_load64(&m_fast_path_state);
+  while (!(old_state & FAST_PATH_HAS_OBTRUSIVE) &&
+         (old_state & FAST_PATH_COUNTERS) != increment)
+  {
+    if (my_atomic_cas64(&m_fast_path_state, &old_state,
+                        old_state - increment))
+    {
+      my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+      return;
+    }
+  }
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+
+  mysql_prlock_wrlock(&m_rwlock);
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  my_atomic_add64(&m_fast_path_state, -increment);
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+  unlock_or_remove();
+}
+
+
+/**
+  Convert lock granted on the fast path to an ordinary lock represented
+  by ticket in the m_granted list, so that it becomes visible to other
+  contexts (e.g. to the deadlock detector).
+*/
+
+void MDL_lock::materialize_fast_path_ticket(MDL_ticket *ticket)
+{
+  mysql_prlock_wrlock(&m_rwlock);
+  m_granted.add_ticket(ticket);
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  my_atomic_add64(&m_fast_path_state,
+                  -fast_path_increments()[ticket->get_type()]);
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+  mysql_prlock_unlock(&m_rwlock);
+}
+
+
+/**
+  Set FAST_PATH_HAS_OBTRUSIVE flag, so no more locks are granted on the
+  fast path and fast path counters become stable.
+
+  @pre m_rwlock is write-locked.
+*/
+
+void MDL_lock::set_fast_path_obtrusive_flag()
+{
+  int64 old_state;
+
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  old_state= my_atomic_load64(&m_fast_path_state);
+  while (!(old_state & FAST_PATH_HAS_OBTRUSIVE) &&
+         !my_atomic_cas64(&m_fast_path_state, &old_state,
+                          old_state | FAST_PATH_HAS_OBTRUSIVE))
+  {}
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+}
+
+
+/**
+  Set or clear FAST_PATH_HAS_OBTRUSIVE flag according to the presence
+  of obtrusive locks among granted and waiting tickets.
+
+  @pre m_rwlock is write-locked.
+*/
+
+void MDL_lock::update_fast_path_obtrusive_flag()
+{
+  bool has_obtrusive= test((m_granted.bitmap() | m_waiting.bitmap()) &
+                           obtrusive_types_bitmap());
+  int64 old_state;
+
+  my_atomic_rwlock_wrlock(&LOCK_mdl_fast_path);
+  old_state= my_atomic_load64(&m_fast_path_state);
+  while (test(old_state & FAST_PATH_HAS_OBTRUSIVE) != has_obtrusive &&
+         !my_atomic_cas64(&m_fast_path_state, &old_state,
+                          old_state ^ FAST_PATH_HAS_OBTRUSIVE))
+  {}
+  my_atomic_rwlock_wrunlock(&LOCK_mdl_fast_path);
+}
+
+
 /**
   Check if request for the metadata lock can be satisfied given its
   current state.
@@ -1781,7 +2117,14 @@ MDL_lock::can_grant_lock(enum_mdl_type type_arg,
   */
   if (ignore_lock_priority || !(m_waiting.bitmap() & waiting_incompat_map))
   {
-    if (! (m_granted.bitmap() & granted_incompat_map))
+    /*
+      Locks granted on the fast path always belong to other contexts,
+      as requests which might conflict with them are preceded by
+      MDL_context::materialize_fast_path_locks().
+    */
+    if (fast_path_granted_bitmap() & granted_incompat_map)
+      can_grant= FALSE;
+    else if (! (m_granted.bitmap() & granted_incompat_map))
       can_grant= TRUE;
     else
     {
@@ -1826,8 +2169,24 @@ void MDL_lock::remove_ticket(Ticket_list MDL_lock::*list, MDL_ticket *ticket)
 {
   mysql_prlock_wrlock(&m_rwlock);
   (this->*list).remove_ticket(ticket);
-  if (is_empty())
+  unlock_or_remove();
+}
+
+
+/**
+  Wake up waiters after some lock was released and unlock m_rwlock, or
+  remove the object from MDL_map if it is not used anymore.
+
+  @pre m_rwlock is write-locked.
+*/
+
+void MDL_lock::unlock_or_remove()
+{
+  if (is_empty() && ! has_fast_path_locks())
+  {
+    update_fast_path_obtrusive_flag();
     mdl_locks.remove(this);
+  }
   else
   {
     /*
@@ -1845,6 +2204,7 @@ void MDL_lock::remove_ticket(Ticket_list MDL_lock::*list, MDL_ticket *ticket)
       pending request).
     */
     reschedule_waiters();
+    update_fast_path_obtrusive_flag();
     mysql_prlock_unlock(&m_rwlock);
   }
 }
@@ -1863,8 +2223,6 @@ bool MDL_lock::has_pending_conflicting_lock(enum_mdl_type type)
 {
   bool result;
 
-  mysql_mutex_assert_not_owner(&LOCK_open);
-
   mysql_prlock_rdlock(&m_rwlock);
   result= (m_waiting.bitmap() & incompatible_granted_types_bitmap()[type]);
   mysql_prlock_unlock(&m_rwlock);
@@ -1999,8 +2357,10 @@ MDL_context::try_acquire_lock(MDL_request *mdl_request)
       We can't get here if we allocated a new lock object so there
       is no need to release it.
     */
-    DBUG_ASSERT(! ticket->m_lock->is_empty());
-    mysql_prlock_unlock(&ticket->m_lock->m_rwlock);
+    MDL_lock *lock= ticket->m_lock;
+    DBUG_ASSERT(! lock->is_empty() || lock->has_fast_path_locks());
+    lock->update_fast_path_obtrusive_flag();
+    mysql_prlock_unlock(&lock->m_rwlock);
     MDL_ticket::destroy(ticket);
   }
 
@@ -2032,6 +2392,8 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
   MDL_key *key= &mdl_request->key;
   MDL_ticket *ticket;
   enum_mdl_duration found_duration;
+  int64 fast_path_increment;
+  bool fast_path;
 
   DBUG_ASSERT(mdl_request->type != MDL_EXCLUSIVE ||
               is_lock_owner(MDL_key::GLOBAL, "", "", MDL_INTENTION_EXCLUSIVE));
@@ -2039,7 +2401,6 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
 
   /* Don't take chances in production. */
   mdl_request->ticket= NULL;
-  mysql_mutex_assert_not_owner(&LOCK_open);
 
   /*
     Check whether the context already holds a shared lock on the object,
@@ -2085,8 +2446,25 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
                                    )))
     return TRUE;
 
-  /* The below call implicitly locks MDL_lock::m_rwlock on success. */
-  if (!(lock= mdl_locks.find_or_insert(key)))
+  /*
+    Locks of "unobtrusive" types are granted on the fast path, unless
+    this context needs to be notified about conflicting requests (which
+    can't find locks granted on the fast path).
+    Before trying to acquire any other lock we make our fast path locks
+    visible to other contexts, since the request might conflict with
+    them and only locks of other contexts are accounted for in fast path
+    counters (@sa MDL_lock::can_grant_lock()).
+  */
+  fast_path_increment= m_needs_thr_lock_abort ? 0 :
+                       MDL_lock::fast_path_increment(key, mdl_request->type);
+  if (! fast_path_increment)
+    materialize_fast_path_locks();
+
+  /*
+    The below call implicitly locks MDL_lock::m_rwlock on success,
+    unless the lock was granted on the fast path.
+  */
+  if (!(lock= mdl_locks.find_or_insert(key, fast_path_increment, &fast_path)))
   {
     MDL_ticket::destroy(ticket);
     return TRUE;
@@ -2094,6 +2472,19 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
 
   ticket->m_lock= lock;
 
+  if (fast_path)
+  {
+    ticket->m_is_fast_path= true;
+    m_has_fast_path_locks= TRUE;
+    m_tickets[mdl_request->duration].push_front(ticket);
+    mdl_request->ticket= ticket;
+    return FALSE;
+  }
+
+  /* Obtrusive request must be accounted for before looking at counters. */
+  if (MDL_BIT(mdl_request->type) & lock->obtrusive_types_bitmap())
+    lock->set_fast_path_obtrusive_flag();
+
   if (lock->can_grant_lock(mdl_request->type, this, false))
   {
     lock->m_granted.add_ticket(ticket);
@@ -2129,7 +2520,6 @@ MDL_context::clone_ticket(MDL_request *mdl_request)
 {
   MDL_ticket *ticket;
 
-  mysql_mutex_assert_not_owner(&LOCK_open);
   /*
     By submitting mdl_request->type to MDL_ticket::create()
     we effectively downgrade the cloned lock to the level of
@@ -2790,9 +3180,11 @@ void MDL_context::release_lock(enum_mdl_duration duration, MDL_ticket *ticket)
                        lock->key.db_name(), lock->key.name()));
 
   DBUG_ASSERT(this == ticket->get_ctx());
-  mysql_mutex_assert_not_owner(&LOCK_open);
 
-  lock->remove_ticket(&MDL_lock::m_granted, ticket);
+  if (ticket->m_is_fast_path)
+    lock->fast_path_release(lock->fast_path_increments()[ticket->m_type]);
+  else
+    lock->remove_ticket(&MDL_lock::m_granted, ticket);
 
   m_tickets[duration].remove(ticket);
   MDL_ticket::destroy(ticket);
@@ -2875,6 +3267,40 @@ void MDL_context::release_all_locks_for_name(MDL_ticket *name)
 }
 
 
+/**
+  Make all locks of this context which were granted on the fast path
+  visible to other contexts, by turning them into ordinary tickets in
+  the MDL_lock::m_granted lists.
+
+  Must be done before waiting (so that the deadlock detector can see
+  all edges of the wait-for graph going from other contexts to this
+  one) and before requesting locks which can conflict with the locks
+  granted on the fast path.
+*/
+
+void MDL_context::materialize_fast_path_locks()
+{
+  if (! m_has_fast_path_locks)
+    return;
+
+  for (int i= 0; i < MDL_DURATION_END; i++)
+  {
+    Ticket_iterator it(m_tickets[i]);
+    MDL_ticket *ticket;
+
+    while ((ticket= it++))
+    {
+      if (ticket->m_is_fast_path)
+      {
+        ticket->m_lock->materialize_fast_path_ticket(ticket);
+        ticket->m_is_fast_path= false;
+      }
+    }
+  }
+  m_has_fast_path_locks= FALSE;
+}
+
+
 /**
   Downgrade an EXCLUSIVE or SHARED_NO_WRITE lock to shared metadata lock.
 
@@ -2883,8 +3309,6 @@ void MDL_context::release_all_locks_for_name(MDL_ticket *name)
 
 void MDL_ticket::downgrade_lock(enum_mdl_type type)
 {
-  mysql_mutex_assert_not_owner(&LOCK_open);
-
   /*
     Do nothing if already downgraded. Used when we FLUSH TABLE under
     LOCK TABLES and a table is listed twice in LOCK TABLES list.
@@ -2908,6 +3332,7 @@ void MDL_ticket::downgrade_lock(enum_mdl_type type)
   m_type= type;
   m_lock->m_granted.add_ticket(this);
   m_lock->reschedule_waiters();
+  m_lock->update_fast_path_obtrusive_flag();
   mysql_prlock_unlock(&m_lock->m_rwlock);
 }
 
@@ -504,17 +504,15 @@ public:
 
   virtual bool inspect_edge(MDL_context *dest) = 0;
   virtual ~MDL_wait_for_graph_visitor();
-  MDL_wait_for_graph_visitor() :m_lock_open_count(0) {}
+  MDL_wait_for_graph_visitor() :m_tc_lock_count(0) {}
 public:
   /**
    XXX, hack: During deadlock search, we may need to
-   inspect TABLE_SHAREs and acquire LOCK_open. Since
-   LOCK_open is not a recursive mutex, count here how many
-   times we "took" it (but only take and release once).
-   Not using a native recursive mutex or rwlock in 5.5 for
-   LOCK_open since it has significant performance impacts.
+   inspect TABLE_SHAREs and lock all table cache instances.
+   Since those mutexes are not recursive, count here how many
+   times we "took" them (but only take and release once).
   */
-  uint m_lock_open_count;
+  uint m_tc_lock_count;
 };
 
 /**
@@ -615,7 +613,8 @@ private:
      m_duration(duration_arg),
 #endif
      m_ctx(ctx_arg),
-     m_lock(NULL)
+     m_lock(NULL),
+     m_is_fast_path(false)
   {}
 
   static MDL_ticket *create(MDL_context *ctx_arg, enum_mdl_type type_arg
@@ -644,6 +643,13 @@ private:
   */
   MDL_lock *m_lock;
 
+  /**
+    TRUE if the lock was granted on the fast path, i.e. it is accounted
+    for in MDL_lock::m_fast_path_state rather than in the list of granted
+    tickets for the lock. Context private.
+  */
+  bool m_is_fast_path;
+
 private:
   MDL_ticket(const MDL_ticket &);               /* not implemented */
   MDL_ticket &operator=(const MDL_ticket &);    /* not implemented */
@@ -807,6 +813,12 @@ public:
             will see the new value eventually.
     */
     m_needs_thr_lock_abort= needs_thr_lock_abort;
+    /*
+      Locks granted on the fast path are invisible to other contexts,
+      so they can't be notified to abort table-level lock waits.
+    */
+    if (needs_thr_lock_abort)
+      materialize_fast_path_locks();
   }
   bool get_needs_thr_lock_abort() const
   {
@@ -885,6 +897,11 @@ private:
     FALSE - Otherwise.
   */
   bool m_needs_thr_lock_abort;
+  /**
+    TRUE if some of the tickets in m_tickets may have been granted on
+    the fast path (@sa MDL_ticket::m_is_fast_path).
+  */
+  bool m_has_fast_path_locks;
 
   /**
     Read-write lock protecting m_waiting_for member.
@@ -910,6 +927,7 @@ private:
   void release_lock(enum_mdl_duration duration, MDL_ticket *ticket);
   bool try_acquire_lock_impl(MDL_request *mdl_request,
                              MDL_ticket **out_ticket);
+  void materialize_fast_path_locks();
 
 public:
   void find_deadlock();
@@ -921,6 +939,11 @@ public:
   /** Inform the deadlock detector there is an edge in the wait-for graph. */
   void will_wait_for(MDL_wait_for_subgraph *waiting_for_arg)
   {
+    /*
+      The deadlock detector only sees granted tickets, so a waiting
+      context must not hold any locks granted on the fast path.
+    */
+    materialize_fast_path_locks();
     mysql_prlock_wrlock(&m_LOCK_waiting_for);
     m_waiting_for=  waiting_for_arg;
     mysql_prlock_unlock(&m_LOCK_waiting_for);
@@ -962,11 +985,6 @@ extern "C" unsigned long thd_get_thread_id(const MYSQL_THD thd);
 */
 extern "C" int thd_is_connected(MYSQL_THD thd);
 
-#ifndef DBUG_OFF
-extern mysql_mutex_t LOCK_open;
-#endif
-
-
 /*
   Start-up parameter for the maximum size of the unused MDL_lock objects cache
   and a constant for its default value.
@@ -428,6 +428,7 @@ handlerton *partition_hton;
 my_bool read_only= 0, opt_readonly= 0;
 my_bool use_temp_pool, relay_log_purge;
 my_bool relay_log_recovery;
+ulong relay_log_batch_size;
 my_bool opt_sync_frm, opt_allow_suspicious_udfs;
 my_bool opt_secure_auth= 0;
 char* opt_secure_file_priv;
@@ -454,8 +455,12 @@ my_bool opt_noacl;
 my_bool sp_automatic_privileges= 1;
 
 ulong opt_binlog_rows_event_max_size;
+ulong binlog_dump_cache_size;
 my_bool opt_master_verify_checksum= 0;
+my_bool opt_log_bin_compress= 0;
+ulong opt_log_bin_compress_min_len= 256;
 my_bool opt_slave_sql_verify_checksum= 1;
+my_bool opt_slave_rows_hash_scan= 0;
 const char *binlog_format_names[]= {"MIXED", "STATEMENT", "ROW", NullS};
 #ifdef HAVE_INITGROUPS
 volatile sig_atomic_t calling_initgroups= 0; /**< Used in SIGSEGV handler. */
@@ -858,7 +863,8 @@ PSI_mutex_key key_BINLOG_LOCK_index, key_BINLOG_LOCK_xid_list,
   key_PARTITION_LOCK_auto_inc;
 PSI_mutex_key key_RELAYLOG_LOCK_index;
 PSI_mutex_key key_LOCK_slave_state, key_LOCK_binlog_state,
-  key_LOCK_rpl_thread, key_LOCK_rpl_thread_pool, key_LOCK_parallel_entry;
+  key_LOCK_rpl_thread, key_LOCK_rpl_thread_pool, key_LOCK_parallel_entry,
+  key_LOCK_binlog_dump_cache;
 
 PSI_mutex_key key_LOCK_stats,
   key_LOCK_global_user_client_stats, key_LOCK_global_table_stats,
@@ -936,6 +942,7 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_PARTITION_LOCK_auto_inc, "HA_DATA_PARTITION::LOCK_auto_inc", 0},
   { &key_LOCK_slave_state, "LOCK_slave_state", 0},
   { &key_LOCK_binlog_state, "LOCK_binlog_state", 0},
+  { &key_LOCK_binlog_dump_cache, "LOCK_binlog_dump_cache", PSI_FLAG_GLOBAL},
   { &key_LOCK_rpl_thread, "LOCK_rpl_thread", 0},
   { &key_LOCK_rpl_thread_pool, "LOCK_rpl_thread_pool", 0},
   { &key_LOCK_parallel_entry, "LOCK_parallel_entry", 0}
@@ -1443,6 +1450,7 @@ struct st_VioSSLFd *ssl_acceptor_fd;
 uint connection_count= 0, extra_connection_count= 0;
 
 my_bool opt_gtid_strict_mode= FALSE;
+ulong opt_gtid_cleanup_batch_size= 64;
 
 
 /* Function declarations */
@@ -1946,6 +1954,7 @@ static void mysqld_exit(int exit_code)
     spawn the kill_server_thread thread, which is running concurrently.
   */
   rpl_deinit_gtid_slave_state();
+  destroy_binlog_dump_cache();
   wait_for_signal_thread_to_end();
   mysql_audit_finalize();
   clean_up_mutexes();
@@ -3825,6 +3834,8 @@ static void my_malloc_size_cb_func(long long size, my_bool is_thread_specific)
         DBUG_PRINT("info", ("memory_used: %lld  size: %lld",
                             (longlong) thd->status_var.memory_used, size));
         thd->status_var.memory_used+= size;
+        set_if_bigger(thd->statement_memory_peak,
+                      thd->status_var.memory_used);
 #ifdef ENABLE_BEFORE_END_OF_MERGE_QQ
         DBUG_ASSERT((longlong) thd->status_var.memory_used >= 0);
 #endif
@@ -4406,6 +4417,7 @@ static int init_thread_environment()
 
 #ifdef HAVE_REPLICATION
   rpl_init_gtid_slave_state();
+  init_binlog_dump_cache();
 #endif
 
   DBUG_RETURN(0);
@@ -7595,6 +7607,78 @@ static int show_default_keycache(THD *thd, SHOW_VAR *var, char *buff)
   return 0;
 }
 
+static int show_mem_root_cache(THD *thd, SHOW_VAR *var, char *buff)
+{
+  struct st_data {
+    ulonglong bytes, hits, misses;
+    SHOW_VAR var[4];
+  } *data;
+  SHOW_VAR *v;
+
+  data=(st_data *)buff;
+  v= data->var;
+
+  var->type= SHOW_ARRAY;
+  var->value= (char*)v;
+
+  get_mem_root_cache_stats(&data->hits, &data->misses, &data->bytes);
+
+#define set_one_mem_root_cache_var(X,Y) \
+  v->name= X;                           \
+  v->type= SHOW_LONGLONG;               \
+  v->value= (char*)&data->Y;            \
+  v++;
+
+  set_one_mem_root_cache_var("bytes",  bytes);
+  set_one_mem_root_cache_var("hits",   hits);
+  set_one_mem_root_cache_var("misses", misses);
+
+  v->name= 0;
+
+  DBUG_ASSERT((char*)(v+1) <= buff + SHOW_VAR_FUNC_BUFF_SIZE);
+
+#undef set_one_mem_root_cache_var
+
+  return 0;
+}
+
+#if defined(MY_PTHREAD_FASTMUTEX) && !defined(SAFE_MUTEX)
+static int show_mutex_stats(THD *thd, SHOW_VAR *var, char *buff)
+{
+  struct st_data {
+    ulonglong spin_waits, spin_rounds, os_waits;
+    SHOW_VAR var[4];
+  } *data;
+  SHOW_VAR *v;
+
+  data=(st_data *)buff;
+  v= data->var;
+
+  var->type= SHOW_ARRAY;
+  var->value= (char*)v;
+
+  get_fastmutex_stats(&data->spin_waits, &data->spin_rounds, &data->os_waits);
+
+#define set_one_mutex_var(X,Y)          \
+  v->name= X;                           \
+  v->type= SHOW_LONGLONG;               \
+  v->value= (char*)&data->Y;            \
+  v++;
+
+  set_one_mutex_var("os_waits",    os_waits);
+  set_one_mutex_var("spin_rounds", spin_rounds);
+  set_one_mutex_var("spin_waits",  spin_waits);
+
+  v->name= 0;
+
+  DBUG_ASSERT((char*)(v+1) <= buff + SHOW_VAR_FUNC_BUFF_SIZE);
+
+#undef set_one_mutex_var
+
+  return 0;
+}
+#endif
+
 #ifndef DBUG_OFF
 static int debug_status_func(THD *thd, SHOW_VAR *var, char *buff)
 {
@@ -7715,8 +7799,13 @@ SHOW_VAR status_vars[]= {
   {"Handler_write",            (char*) offsetof(STATUS_VAR, ha_write_count), SHOW_LONG_STATUS},
   {"Key",                      (char*) &show_default_keycache, SHOW_FUNC},
   {"Last_query_cost",          (char*) offsetof(STATUS_VAR, last_query_cost), SHOW_DOUBLE_STATUS},
+  {"Max_statement_memory_used",(char*) offsetof(STATUS_VAR, max_statement_memory_used), SHOW_LONGLONG_STATUS},
   {"Max_used_connections",     (char*) &max_used_connections,  SHOW_LONG},
+  {"Mem_root_cache",           (char*) &show_mem_root_cache, SHOW_FUNC},
   {"Memory_used",              (char*) offsetof(STATUS_VAR, memory_used), SHOW_LONGLONG_STATUS},
+#if defined(MY_PTHREAD_FASTMUTEX) && !defined(SAFE_MUTEX)
+  {"Mutex",                    (char*) &show_mutex_stats,       SHOW_FUNC},
+#endif
   {"Not_flushed_delayed_rows", (char*) &delayed_rows_in_use,    SHOW_LONG_NOFLUSH},
   {"Open_files",               (char*) &my_file_opened,         SHOW_LONG_NOFLUSH},
   {"Open_streams",             (char*) &my_stream_opened,       SHOW_LONG_NOFLUSH},
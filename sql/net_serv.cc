@@ -195,6 +195,13 @@ my_bool net_realloc(NET *net, size_t length)
     DBUG_RETURN(1);
   }
   pkt_length = (length+IO_SIZE-1) & ~(IO_SIZE-1); 
+  /*
+    Packets that are read or built piece by piece call us for every piece.
+    Grow to at least twice the old size to make the number of reallocs
+    (and copies of the buffer) logarithmic in the final size.
+  */
+  set_if_bigger(pkt_length, MY_MIN((size_t) net->max_packet * 2,
+                                   (size_t) net->max_packet_size));
   /*
     We must allocate some extra bytes for the end 0 and to be able to
     read big compressed blocks + 1 safety byte since uint3korr() in
@@ -616,7 +623,7 @@ net_real_write(NET *net,const uchar *packet, size_t len)
     size_t complen;
     uchar *b;
     uint header_length=NET_HEADER_SIZE+COMP_HEADER_SIZE;
-    if (!(b= (uchar*) my_malloc(len + NET_HEADER_SIZE +
+    if (!(b= (uchar*) my_malloc(my_compress_bound(len) + NET_HEADER_SIZE +
                                 COMP_HEADER_SIZE + 1,
                                 MYF(MY_WME |
                                     (net->thread_specific_malloc ?
@@ -628,10 +635,8 @@ net_real_write(NET *net,const uchar *packet, size_t len)
       net->reading_or_writing= 0;
       DBUG_RETURN(1);
     }
-    memcpy(b+header_length,packet,len);
-
-    if (my_compress(b+header_length, &len, &complen))
-      complen=0;
+    /* Compress directly after the header, without a temporary buffer */
+    my_compress_into(b+header_length, packet, &len, &complen);
     int3store(&b[NET_HEADER_SIZE],complen);
     int3store(b,len);
     b[3]=(uchar) (net->compress_pkt_nr++);
@@ -63,6 +63,40 @@ bool Protocol_binary::net_store_data(const uchar *from, size_t length)
 }
 
 
+/*
+  Store the decimal representation of an integer in the packet.
+
+  The digits are written straight into the packet after a one byte
+  length prefix (the longest number, with sign, is 20 characters), so
+  there is no temporary buffer to copy from as with net_store_data().
+  The radix is -10 for signed and 10 for unsigned numbers.
+*/
+
+#ifndef EMBEDDED_LIBRARY
+bool Protocol::net_store_integer(longlong from, int radix)
+{
+  ulong packet_length= packet->length();
+  /* length byte + up to 20 characters + end NUL written by the converter */
+  if (packet_length + 22 > packet->alloced_length() &&
+      packet->realloc(packet_length + 22))
+    return 1;
+  char *to= (char*) packet->ptr() + packet_length;
+  char *end= longlong10_to_str(from, to + 1, radix);
+  *to= (char) (end - to - 1);
+  packet->length((uint32) (end - packet->ptr()));
+  return 0;
+}
+#else
+bool Protocol::net_store_integer(longlong from, int radix)
+{
+  char buff[22];
+  return net_store_data((uchar*) buff,
+                        (size_t) (longlong10_to_str(from, buff, radix) -
+                                  buff));
+}
+#endif
+
+
 /*
   net_store_data() - extended version with character set conversion.
   
@@ -1057,9 +1091,7 @@ bool Protocol_text::store_tiny(longlong from)
   DBUG_ASSERT(field_types == 0 || field_types[field_pos] == MYSQL_TYPE_TINY);
   field_pos++;
 #endif
-  char buff[20];
-  return net_store_data((uchar*) buff,
-			(size_t) (int10_to_str((int) from, buff, -10) - buff));
+  return net_store_integer((int) from, -10);
 }
 
 
@@ -1071,10 +1103,7 @@ bool Protocol_text::store_short(longlong from)
 	      field_types[field_pos] == MYSQL_TYPE_SHORT);
   field_pos++;
 #endif
-  char buff[20];
-  return net_store_data((uchar*) buff,
-			(size_t) (int10_to_str((int) from, buff, -10) -
-                                  buff));
+  return net_store_integer((int) from, -10);
 }
 
 
@@ -1086,10 +1115,7 @@ bool Protocol_text::store_long(longlong from)
               field_types[field_pos] == MYSQL_TYPE_LONG);
   field_pos++;
 #endif
-  char buff[20];
-  return net_store_data((uchar*) buff,
-			(size_t) (int10_to_str((long int)from, buff,
-                                               (from <0)?-10:10)-buff));
+  return net_store_integer(from, -10);
 }
 
 
@@ -1100,11 +1126,7 @@ bool Protocol_text::store_longlong(longlong from, bool unsigned_flag)
 	      field_types[field_pos] == MYSQL_TYPE_LONGLONG);
   field_pos++;
 #endif
-  char buff[22];
-  return net_store_data((uchar*) buff,
-			(size_t) (longlong10_to_str(from,buff,
-                                                    unsigned_flag ? 10 : -10)-
-                                  buff));
+  return net_store_integer(from, unsigned_flag ? 10 : -10);
 }
 
 
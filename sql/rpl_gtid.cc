@@ -173,6 +173,7 @@ rpl_slave_state::get_element(uint32 domain_id)
     return NULL;
   elem->list= NULL;
   elem->domain_id= domain_id;
+  elem->list_len= 0;
   if (my_hash_insert(&hash, (uchar *)elem))
   {
     my_free(elem);
@@ -388,7 +389,18 @@ rpl_slave_state::record_gtid(THD *thd, const rpl_gtid *gtid, uint64 sub_id,
     err= 1;
     goto end;
   }
-  if ((elist= elem->grab_list()) != NULL)
+  /*
+    Old rows are deleted in batches: only once more than
+    gtid_cleanup_batch_size of them have accumulated for the domain do we
+    grab the list and delete all but the most recent one. Each row is
+    still looked up and deleted on its own, but this is done once per
+    batch, within a single ha_index_init(), rather than on every
+    replicated transaction. A range delete is not possible, as rows of
+    transactions that have not committed yet may lie between the listed
+    sub_ids.
+  */
+  if (elem->list_len > opt_gtid_cleanup_batch_size &&
+      (elist= elem->grab_list()) != NULL)
   {
     /* Delete any old stuff, but keep around the most recent one. */
     list_element *cur= elist;
@@ -411,6 +423,7 @@ rpl_slave_state::record_gtid(THD *thd, const rpl_gtid *gtid, uint64 sub_id,
     *best_ptr_ptr= cur->next;
     cur->next= NULL;
     elem->list= cur;
+    elem->list_len= 1;
   }
   unlock();
 
@@ -61,12 +61,21 @@ struct rpl_slave_state
   {
     struct list_element *list;
     uint32 domain_id;
+    /* Number of entries in list, ie. rows in mysql.gtid_slave_pos. */
+    uint32 list_len;
 
-    list_element *grab_list() { list_element *l= list; list= NULL; return l; }
+    list_element *grab_list()
+    {
+      list_element *l= list;
+      list= NULL;
+      list_len= 0;
+      return l;
+    }
     void add(list_element *l)
     {
       l->next= list;
       list= l;
+      ++list_len;
     }
   };
 
@@ -1122,10 +1122,8 @@ bool event_checksum_test(uchar *event_buf, ulong event_len, uint8 alg)
 
     if (event_buf[EVENT_TYPE_OFFSET] == FORMAT_DESCRIPTION_EVENT)
     {
-#ifndef DBUG_OFF
-      int8 fd_alg= event_buf[event_len - BINLOG_CHECKSUM_LEN - 
-                             BINLOG_CHECKSUM_ALG_DESC_LEN];
-#endif
+      uint8 fd_alg= event_buf[event_len - BINLOG_CHECKSUM_LEN -
+                              BINLOG_CHECKSUM_ALG_DESC_LEN];
       /*
         FD event is checksummed and therefore verified w/o the binlog-in-use flag
       */
@@ -1133,21 +1131,26 @@ bool event_checksum_test(uchar *event_buf, ulong event_len, uint8 alg)
       if (flags & LOG_EVENT_BINLOG_IN_USE_F)
         event_buf[FLAGS_OFFSET] &= ~LOG_EVENT_BINLOG_IN_USE_F;
       /* 
-         The only algorithm currently is CRC32. Zero indicates 
-         the binlog file is checksum-free *except* the FD-event.
+         Zero indicates the binlog file is checksum-free *except* the
+         FD-event, which is then checksummed with CRC32.
+      */
+      DBUG_ASSERT(binlog_checksum_is_on(fd_alg) || fd_alg == 0);
+      DBUG_ASSERT(binlog_checksum_is_on(alg));
+      /*
+        The FD event carries its own algorithm, which may differ from
+        the one of the previous binlog file that the caller passes in.
       */
-      DBUG_ASSERT(fd_alg == BINLOG_CHECKSUM_ALG_CRC32 || fd_alg == 0);
-      DBUG_ASSERT(alg == BINLOG_CHECKSUM_ALG_CRC32);
+      alg= fd_alg ? fd_alg : (uint8) BINLOG_CHECKSUM_ALG_CRC32;
       /*
         Complile time guard to watch over  the max number of alg
       */
       compile_time_assert(BINLOG_CHECKSUM_ALG_ENUM_END <= 0x80);
     }
     incoming= uint4korr(event_buf + event_len - BINLOG_CHECKSUM_LEN);
-    computed= my_checksum(0L, NULL, 0);
+    computed= binlog_checksum(alg, 0L, NULL, 0);
     /* checksum the event content but the checksum part itself */
-    computed= my_checksum(computed, (const uchar*) event_buf, 
-                          event_len - BINLOG_CHECKSUM_LEN);
+    computed= binlog_checksum(alg, computed, (const uchar*) event_buf,
+                              event_len - BINLOG_CHECKSUM_LEN);
     if (flags != 0)
     {
       /* restoring the orig value of flags of FD */
@@ -157,7 +157,8 @@ static int safe_reconnect(THD* thd, MYSQL* mysql, Master_info* mi,
 static int connect_to_master(THD* thd, MYSQL* mysql, Master_info* mi,
                              bool reconnect, bool suppress_warnings);
 static Log_event* next_event(rpl_group_info* rgi, ulonglong *event_size);
-static int queue_event(Master_info* mi,const char* buf,ulong event_len);
+static int queue_event(Master_info* mi,const char* buf,ulong event_len,
+                       bool buffered);
 static int terminate_slave_thread(THD *thd,
                                   mysql_mutex_t *term_lock,
                                   mysql_cond_t *term_cond,
@@ -1831,7 +1832,7 @@ when it try to get the value of TIME_ZONE global variable from master.";
           find_type(master_row[0], &binlog_checksum_typelib, 1) - 1;
         // valid outcome is either of
         DBUG_ASSERT(mi->checksum_alg_before_fd == BINLOG_CHECKSUM_ALG_OFF ||
-                    mi->checksum_alg_before_fd == BINLOG_CHECKSUM_ALG_CRC32);
+                    binlog_checksum_is_on(mi->checksum_alg_before_fd));
       }
       else if (check_io_slave_killed(mi, NULL))
         goto slave_killed_err;
@@ -3666,6 +3667,7 @@ pthread_handler_t handle_slave_io(void *arg)
   uint retry_count;
   bool suppress_warnings;
   int ret;
+  ulong batched= 0;                     // Bytes appended but not flushed
 #ifndef DBUG_OFF
   uint retry_count_reg= 0, retry_count_dump= 0, retry_count_event= 0;
 #endif
@@ -3915,6 +3917,11 @@ reading event"))
       if (event_len == packet_error)
       {
         uint mysql_error_number= mysql_errno(mysql);
+        if (batched)
+        {
+          batched= 0;
+          rli->relay_log.flush_appended();
+        }
         switch (mysql_error_number) {
         case CR_NET_PACKET_TOO_LARGE:
           sql_print_error("\
@@ -3956,10 +3963,24 @@ Stopping slave I/O thread due to out-of-memory error from master");
         goto err;
       }
 
+      /*
+        While more of the master's stream is already waiting to be read,
+        leave the event in the relay log cache. The batch is flushed, and
+        the SQL thread woken up, with the first event that is not followed
+        by more data. Batching is not done when the relay log is synced
+        per event, when its space is limited (the SQL thread must see the
+        events to purge logs), or when a plugin observes the relay log I/O.
+      */
+      bool buffered= (relay_log_batch_size &&
+                      batched + event_len < relay_log_batch_size &&
+                      !sync_relaylog_period && !rli->log_space_limit &&
+                      binlog_relay_io_delegate->is_empty() &&
+                      vio_pending(mysql->net.vio) > 0);
+
       /* XXX: 'synced' should be updated by queue_event to indicate
          whether event has been synced to disk */
       bool synced= 0;
-      if (queue_event(mi, event_buf, event_len))
+      if (queue_event(mi, event_buf, event_len, buffered))
       {
         mi->report(ERROR_LEVEL, ER_SLAVE_RELAY_LOG_WRITE_FAILURE,
                    ER(ER_SLAVE_RELAY_LOG_WRITE_FAILURE),
@@ -3976,7 +3997,21 @@ Stopping slave I/O thread due to out-of-memory error from master");
         goto err;
       }
 
-      if (mi->using_gtid != Master_info::USE_GTID_NO &&
+      if (buffered)
+        batched+= event_len;
+      else if (batched)
+      {
+        batched= 0;
+        if (rli->relay_log.flush_appended())
+        {
+          mi->report(ERROR_LEVEL, ER_SLAVE_RELAY_LOG_WRITE_FAILURE,
+                     ER(ER_SLAVE_RELAY_LOG_WRITE_FAILURE),
+                     "could not flush relay log");
+          goto err;
+        }
+      }
+
+      if (!buffered && mi->using_gtid != Master_info::USE_GTID_NO &&
           flush_master_info(mi, TRUE, TRUE))
       {
         sql_print_error("Failed to flush master info file");
@@ -4053,6 +4088,8 @@ err:
     mysql_close(mysql);
     mi->mysql=0;
   }
+  if (batched)
+    rli->relay_log.flush_appended();
   write_ignored_events_info_to_relay_log(thd, mi);
   if (mi->using_gtid != Master_info::USE_GTID_NO)
     flush_master_info(mi, TRUE, TRUE);
@@ -5001,7 +5038,8 @@ static int queue_old_event(Master_info *mi, const char *buf,
   any >=5.0.0 format.
 */
 
-static int queue_event(Master_info* mi,const char* buf, ulong event_len)
+static int queue_event(Master_info* mi,const char* buf, ulong event_len,
+                       bool buffered)
 {
   int error= 0;
   String error_msg;
@@ -5030,7 +5068,7 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
 
   DBUG_ASSERT(checksum_alg == BINLOG_CHECKSUM_ALG_OFF || 
               checksum_alg == BINLOG_CHECKSUM_ALG_UNDEF || 
-              checksum_alg == BINLOG_CHECKSUM_ALG_CRC32); 
+              binlog_checksum_is_on(checksum_alg));
 
   DBUG_ENTER("queue_event");
   /*
@@ -5125,13 +5163,14 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
     if (uint4korr(&buf[0]) == 0 && checksum_alg == BINLOG_CHECKSUM_ALG_OFF &&
         mi->rli.relay_log.relay_log_checksum_alg != BINLOG_CHECKSUM_ALG_OFF)
     {
-      ha_checksum rot_crc= my_checksum(0L, NULL, 0);
+      uint8 rot_alg= mi->rli.relay_log.relay_log_checksum_alg;
+      ha_checksum rot_crc= binlog_checksum(rot_alg, 0L, NULL, 0);
       event_len += BINLOG_CHECKSUM_LEN;
       memcpy(rot_buf, buf, event_len - BINLOG_CHECKSUM_LEN);
       int4store(&rot_buf[EVENT_LEN_OFFSET],
                 uint4korr(&rot_buf[EVENT_LEN_OFFSET]) + BINLOG_CHECKSUM_LEN);
-      rot_crc= my_checksum(rot_crc, (const uchar *) rot_buf,
-                           event_len - BINLOG_CHECKSUM_LEN);
+      rot_crc= binlog_checksum(rot_alg, rot_crc, (const uchar *) rot_buf,
+                               event_len - BINLOG_CHECKSUM_LEN);
       int4store(&rot_buf[event_len - BINLOG_CHECKSUM_LEN], rot_crc);
       DBUG_ASSERT(event_len == uint4korr(&rot_buf[EVENT_LEN_OFFSET]));
       DBUG_ASSERT(mi->rli.relay_log.description_event_for_queue->checksum_alg ==
@@ -5544,7 +5583,9 @@ static int queue_event(Master_info* mi,const char* buf, ulong event_len)
   }
   else
   {
-    if (likely(!(rli->relay_log.appendv(buf,event_len,0))))
+    if (likely(!(buffered ?
+                 rli->relay_log.append_buffered(buf, event_len) :
+                 rli->relay_log.appendv(buf,event_len,0))))
     {
       mi->master_log_pos+= inc_pos;
       DBUG_PRINT("info", ("master_log_pos: %lu", (ulong) mi->master_log_pos));
@@ -251,6 +251,57 @@ uint get_table_def_key(const TABLE_LIST *table_list, const char **key)
   Functions to handle table definition cache (TABLE_SHARE)
 *****************************************************************************/
 
+struct list_open_tables_arg
+{
+  THD *thd;
+  const char *db;
+  const char *wild;
+  TABLE_LIST table_list;
+  OPEN_TABLE_LIST **start_list, *open_list;
+};
+
+
+static my_bool list_open_tables_callback(TDC_element *element,
+                                         list_open_tables_arg *arg)
+{
+  const char *db= element->m_key;
+  const char *table_name= element->m_key + strlen(element->m_key) + 1;
+  OPEN_TABLE_LIST *entry;
+  TABLE *table;
+
+  if (arg->db && my_strcasecmp(system_charset_info, arg->db, db))
+    return FALSE;
+  if (arg->wild && wild_compare(table_name, arg->wild, 0))
+    return FALSE;
+
+  /* Check if user has SELECT privilege for any column in the table */
+  arg->table_list.db=         (char*) db;
+  arg->table_list.table_name= (char*) table_name;
+  arg->table_list.grant.privilege=0;
+
+  if (check_table_access(arg->thd, SELECT_ACL, &arg->table_list, TRUE, 1, TRUE))
+    return FALSE;
+
+  if (!(entry= (OPEN_TABLE_LIST *) arg->thd->alloc(sizeof(*entry) +
+                                                   element->m_key_length)))
+    return TRUE;                                // Out of memory
+  strmov(entry->table= strmov((entry->db= (char*) (entry + 1)), db) + 1,
+         table_name);
+  entry->in_use= 0;
+  mysql_mutex_lock(&element->LOCK_table_share);
+  TABLE_SHARE::All_share_tables_list::Iterator it(element->all_tables);
+  while ((table= it++))
+    if (table->in_use)
+      ++entry->in_use;
+  mysql_mutex_unlock(&element->LOCK_table_share);
+  entry->locked= 0;                             /* Obsolete. */
+  entry->next= 0;
+  *arg->start_list= entry;
+  arg->start_list= &entry->next;
+  return FALSE;
+}
+
+
 /*
   Create a list for all open tables matching SQL expression
 
@@ -262,7 +313,7 @@ uint get_table_def_key(const TABLE_LIST *table_list, const char **key)
   NOTES
     One gets only a list of tables for which one has any kind of privilege.
     db and table names are allocated in result struct, so one doesn't need
-    a lock on LOCK_open when traversing the return list.
+    to lock the table definition cache when traversing the return list.
 
   RETURN VALUES
     NULL	Error (Probably OOM)
@@ -271,54 +322,21 @@ uint get_table_def_key(const TABLE_LIST *table_list, const char **key)
 
 OPEN_TABLE_LIST *list_open_tables(THD *thd, const char *db, const char *wild)
 {
-  OPEN_TABLE_LIST **start_list, *open_list;
-  TABLE_LIST table_list;
-  TABLE_SHARE *share;
-  TDC_iterator tdc_it;
+  list_open_tables_arg argument;
   DBUG_ENTER("list_open_tables");
 
-  bzero((char*) &table_list,sizeof(table_list));
-  start_list= &open_list;
-  open_list=0;
-
-  tdc_it.init();
-  while ((share= tdc_it.next()))
-  {
-    if (db && my_strcasecmp(system_charset_info, db, share->db.str))
-      continue;
-    if (wild && wild_compare(share->table_name.str, wild, 0))
-      continue;
+  argument.thd= thd;
+  argument.db= db;
+  argument.wild= wild;
+  bzero((char*) &argument.table_list, sizeof(argument.table_list));
+  argument.start_list= &argument.open_list;
+  argument.open_list= 0;
 
-    /* Check if user has SELECT privilege for any column in the table */
-    table_list.db=         share->db.str;
-    table_list.table_name= share->table_name.str;
-    table_list.grant.privilege=0;
+  if (tdc_iterate(thd, (my_hash_walk_action) list_open_tables_callback,
+                  &argument))
+    DBUG_RETURN(0);                             // Out of memory
 
-    if (check_table_access(thd,SELECT_ACL,&table_list, TRUE, 1, TRUE))
-      continue;
-
-    if (!(*start_list = (OPEN_TABLE_LIST *)
-	  sql_alloc(sizeof(**start_list)+share->table_cache_key.length)))
-    {
-      open_list=0;				// Out of memory
-      break;
-    }
-    strmov((*start_list)->table=
-	   strmov(((*start_list)->db= (char*) ((*start_list)+1)),
-		  share->db.str)+1,
-	   share->table_name.str);
-    (*start_list)->in_use= 0;
-    mysql_mutex_lock(&LOCK_open);
-    TABLE_SHARE::TABLE_list::Iterator it(share->tdc.used_tables);
-    while (it++)
-      ++(*start_list)->in_use;
-    mysql_mutex_unlock(&LOCK_open);
-    (*start_list)->locked= 0;                   /* Obsolete. */
-    start_list= &(*start_list)->next;
-    *start_list=0;
-  }
-  tdc_it.deinit();
-  DBUG_RETURN(open_list);
+  DBUG_RETURN(argument.open_list);
 }
 
 /*****************************************************************************
@@ -333,7 +351,6 @@ void intern_close_table(TABLE *table)
                         table->s ? table->s->db.str : "?",
                         table->s ? table->s->table_name.str : "?",
                         (long) table));
-  mysql_mutex_assert_not_owner(&LOCK_open);
 
   free_io_cache(table);
   delete table->triggers;
@@ -366,21 +383,22 @@ void free_io_cache(TABLE *table)
 
    @param share Table share.
 
-   @pre Caller should have LOCK_open mutex.
+   @pre Caller should have locked all table cache instances
+        (tc_lock_all()) and TDC_element::LOCK_table_share.
 */
 
 void kill_delayed_threads_for_table(TABLE_SHARE *share)
 {
-  TABLE_SHARE::TABLE_list::Iterator it(share->tdc.used_tables);
+  TABLE_SHARE::All_share_tables_list::Iterator it(share->tdc->all_tables);
   TABLE *tab;
 
-  mysql_mutex_assert_owner(&LOCK_open);
+  mysql_mutex_assert_owner(&share->tdc->LOCK_table_share);
 
   while ((tab= it++))
   {
     THD *in_use= tab->in_use;
 
-    if ((in_use->system_thread & SYSTEM_THREAD_DELAYED_INSERT) &&
+    if (in_use && (in_use->system_thread & SYSTEM_THREAD_DELAYED_INSERT) &&
         ! in_use->killed)
     {
       in_use->killed= KILL_SYSTEM_THREAD;
@@ -397,6 +415,28 @@ void kill_delayed_threads_for_table(TABLE_SHARE *share)
 }
 
 
+/**
+  Find a table share which has old version.
+
+  On success the share is returned with TDC_element::LOCK_table_share
+  locked, to be waited for with TABLE_SHARE::wait_for_old_version().
+*/
+
+static my_bool close_cached_tables_callback(TDC_element *element,
+                                            TABLE_SHARE **share)
+{
+  mysql_mutex_lock(&element->LOCK_table_share);
+  if (element->share && element->share->has_old_version())
+  {
+    /* wait_for_old_version() will unlock mutex */
+    *share= element->share;
+    return TRUE;
+  }
+  mysql_mutex_unlock(&element->LOCK_table_share);
+  return FALSE;
+}
+
+
 /*
   Close all tables which aren't in use by any thread
 
@@ -513,23 +553,10 @@ bool close_cached_tables(THD *thd, TABLE_LIST *tables,
     set_timespec(abstime, timeout);
     while (found && !thd->killed)
     {
-      TABLE_SHARE *share;
-      TDC_iterator tdc_it;
-      found= false;
-
-      tdc_it.init();
-      while ((share= tdc_it.next()))
-      {
-        mysql_mutex_lock(&share->tdc.LOCK_table_share);
-        if (share->has_old_version())
-        {
-          /* wait_for_old_version() will unlock mutex and free share */
-          found= true;
-          break;
-        }
-        mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-      }
-      tdc_it.deinit();
+      TABLE_SHARE *share= 0;
+      found= tdc_iterate(thd,
+                         (my_hash_walk_action) close_cached_tables_callback,
+                         &share) && share;
 
       if (found)
       {
@@ -578,6 +605,53 @@ err_with_reopen:
 }
 
 
+struct close_cached_connection_tables_arg
+{
+  THD *thd;
+  LEX_STRING *connection;
+  TABLE_LIST *tables;
+};
+
+
+static my_bool close_cached_connection_tables_callback(
+  TDC_element *element, close_cached_connection_tables_arg *arg)
+{
+  TABLE_LIST *tmp;
+
+  mysql_mutex_lock(&element->LOCK_table_share);
+  /* Ignore if table is not open or does not have a connect_string */
+  if (!element->share || element->m_loading ||
+      !element->share->connect_string.length || !element->ref_count)
+    goto end;
+
+  /* Compare the connection string */
+  if (arg->connection &&
+      (arg->connection->length > element->share->connect_string.length ||
+       (arg->connection->length < element->share->connect_string.length &&
+        (element->share->connect_string.str[arg->connection->length] != '/' &&
+         element->share->connect_string.str[arg->connection->length] != '\\')) ||
+       strncasecmp(arg->connection->str, element->share->connect_string.str,
+                   arg->connection->length)))
+    goto end;
+
+  /* close_cached_tables() only uses these elements */
+  if (!(tmp= (TABLE_LIST*) arg->thd->calloc(sizeof(TABLE_LIST))) ||
+      !(tmp->db= arg->thd->strdup(element->share->db.str)) ||
+      !(tmp->table_name= arg->thd->strdup(element->share->table_name.str)))
+  {
+    mysql_mutex_unlock(&element->LOCK_table_share);
+    return TRUE;
+  }
+
+  tmp->next_local= arg->tables;
+  arg->tables= tmp;
+
+end:
+  mysql_mutex_unlock(&element->LOCK_table_share);
+  return FALSE;
+}
+
+
 /**
   Close all tables which match specified connection string or
   if specified string is NULL, then any table with a connection string.
@@ -585,51 +659,22 @@ err_with_reopen:
 
 bool close_cached_connection_tables(THD *thd, LEX_STRING *connection)
 {
-  TABLE_LIST tmp, *tables= NULL;
-  bool result= FALSE;
-  TABLE_SHARE *share;
-  TDC_iterator tdc_it;
+  close_cached_connection_tables_arg argument;
   DBUG_ENTER("close_cached_connections");
   DBUG_ASSERT(thd);
 
-  bzero(&tmp, sizeof(TABLE_LIST));
-
-  tdc_it.init();
-  while ((share= tdc_it.next()))
-  {
-    mysql_mutex_lock(&share->tdc.LOCK_table_share);
-    /* Ignore if table is not open or does not have a connect_string */
-    if (!share->connect_string.length || !share->tdc.ref_count)
-    {
-      mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-      continue;
-    }
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-
-    /* Compare the connection string */
-    if (connection &&
-        (connection->length > share->connect_string.length ||
-         (connection->length < share->connect_string.length &&
-          (share->connect_string.str[connection->length] != '/' &&
-           share->connect_string.str[connection->length] != '\\')) ||
-         strncasecmp(connection->str, share->connect_string.str,
-                     connection->length)))
-      continue;
-
-    /* close_cached_tables() only uses these elements */
-    tmp.db= share->db.str;
-    tmp.table_name= share->table_name.str;
-    tmp.next_local= tables;
+  argument.thd= thd;
+  argument.connection= connection;
+  argument.tables= NULL;
 
-    tables= (TABLE_LIST *) memdup_root(thd->mem_root, (char*)&tmp, 
-                                       sizeof(TABLE_LIST));
-  }
-  tdc_it.deinit();
-
-  if (tables)
-    result= close_cached_tables(thd, tables, FALSE, LONG_TIMEOUT);
+  if (tdc_iterate(thd,
+                  (my_hash_walk_action) close_cached_connection_tables_callback,
+                  &argument))
+    DBUG_RETURN(TRUE);
 
-  DBUG_RETURN(result);
+  DBUG_RETURN(argument.tables ?
+              close_cached_tables(thd, argument.tables, FALSE, LONG_TIMEOUT) :
+              FALSE);
 }
 
 
@@ -759,8 +804,6 @@ static void mark_used_tables_as_free_for_reuse(THD *thd, TABLE *table)
 
 static void close_open_tables(THD *thd)
 {
-  mysql_mutex_assert_not_owner(&LOCK_open);
-
   DBUG_PRINT("info", ("thd->open_tables: 0x%lx", (long) thd->open_tables));
 
   while (thd->open_tables)
@@ -801,7 +844,6 @@ close_all_tables_for_name(THD *thd, TABLE_SHARE *share,
 
   memcpy(key, share->table_cache_key.str, key_length);
 
-  mysql_mutex_assert_not_owner(&LOCK_open);
   for (TABLE **prev= &thd->open_tables; *prev; )
   {
     TABLE *table= *prev;
@@ -997,7 +1039,6 @@ void close_thread_table(THD *thd, TABLE **table_ptr)
                         table->s->table_name.str, (long) table));
   DBUG_ASSERT(table->key_read == 0);
   DBUG_ASSERT(!table->file || table->file->inited == handler::NONE);
-  mysql_mutex_assert_not_owner(&LOCK_open);
 
   /*
     The metadata lock must be released after giving back
@@ -1028,7 +1069,7 @@ void close_thread_table(THD *thd, TABLE **table_ptr)
     table->file->ha_reset();
   }
 
-  /* Do this *before* entering the LOCK_open critical section. */
+  /* Do this *before* entering the table cache critical section. */
   if (table->file != NULL)
     table->file->unbind_psi();
 
@@ -829,6 +829,7 @@ bool Drop_table_error_handler::handle_condition(THD *thd,
 THD::THD()
    :Statement(&main_lex, &main_mem_root, STMT_CONVENTIONAL_EXECUTION,
               /* statement id */ 0),
+   tdc_hash_pins(0),
    rli_fake(0), rgi_fake(0), rgi_slave(NULL),
    in_sub_stmt(0), log_all_errors(0),
    binlog_unsafe_warning_flags(0),
@@ -874,6 +875,7 @@ THD::THD()
   THD *old_THR_THD= current_thd;
   set_current_thd(this);
   status_var.memory_used= 0;
+  statement_memory_peak= 0;
   main_da.init();
 
   /*
@@ -1561,6 +1563,8 @@ THD::~THD()
     cleanup();
 
   mdl_context.destroy();
+  if (tdc_hash_pins)
+    lf_hash_put_pins(tdc_hash_pins);
   ha_close_connection(this);
   mysql_audit_release(this);
   plugin_thdvar_cleanup(this);
@@ -1640,6 +1644,8 @@ void add_to_status(STATUS_VAR *to_var, STATUS_VAR *from_var)
   to_var->binlog_bytes_written+= from_var->binlog_bytes_written;
   to_var->cpu_time+=            from_var->cpu_time;
   to_var->busy_time+=           from_var->busy_time;
+  set_if_bigger(to_var->max_statement_memory_used,
+                from_var->max_statement_memory_used);
 }
 
 /*
@@ -1677,6 +1683,8 @@ void add_diff_to_status(STATUS_VAR *to_var, STATUS_VAR *from_var,
                                  dec_var->binlog_bytes_written;
   to_var->cpu_time+=             from_var->cpu_time - dec_var->cpu_time;
   to_var->busy_time+=            from_var->busy_time - dec_var->busy_time;
+  set_if_bigger(to_var->max_statement_memory_used,
+                from_var->max_statement_memory_used);
 }
 
 #define SECONDS_TO_WAIT_FOR_KILL 2
@@ -1942,10 +1950,12 @@ bool THD::store_globals()
                               STACK_DIRECTION * (long)my_thread_stack_size;
   vio_set_thread_id(net.vio, real_id);
   /*
-    We have to call thr_lock_info_init() again here as THD may have been
-    created in another thread
+    We have to set the thread of lock_info again here as THD may have been
+    created in another thread. Don't use thr_lock_info_init() as the THD
+    may still have table locks (LOCK TABLES and the thread pool).
   */
-  thr_lock_info_init(&lock_info);
+  lock_info.thread=    mysys_var->pthread_self;
+  lock_info.thread_id= mysys_var->id;
 
   return 0;
 }
@@ -3686,6 +3696,7 @@ void select_materialize_with_stats::reset()
   memset(col_stat, 0, table->s->fields * sizeof(Column_statistics));
   max_nulls_in_row= 0;
   count_rows= 0;
+  key_filter= NULL;
 }
 
 
@@ -3725,6 +3736,8 @@ int select_materialize_with_stats::send_data(List<Item> &items)
     return 0;
 
   ++count_rows;
+  if (key_filter && key_filter->add_key())
+    return 1;
 
   while ((cur_item= item_it++))
   {
@@ -6018,10 +6031,18 @@ int THD::binlog_query(THD::enum_binlog_query_type qtype, char const *query_arg,
 void
 THD::wait_for_wakeup_ready()
 {
+  /*
+    We sleep here until the group commit leader has written and synced our
+    transaction. Tell the thread scheduler, so that with the thread pool
+    the worker's group can run other connections in the meantime instead
+    of stalling behind a slow binlog fsync.
+  */
+  thd_wait_begin(this, THD_WAIT_GROUP_COMMIT);
   mysql_mutex_lock(&LOCK_wakeup_ready);
   while (!wakeup_ready)
     mysql_cond_wait(&COND_wakeup_ready, &LOCK_wakeup_ready);
   mysql_mutex_unlock(&LOCK_wakeup_ready);
+  thd_wait_end(this);
 }
 
 void
@@ -731,6 +731,8 @@ typedef struct system_status_var
   ulonglong binlog_bytes_written;
   double last_query_cost;
   double cpu_time, busy_time;
+  /* Most thread specific memory used by one command */
+  ulonglong max_statement_memory_used;
   /* Don't initialize */
   volatile int64 memory_used;             /* This shouldn't be accumulated */
 } STATUS_VAR;
@@ -1758,6 +1760,8 @@ private:
 
 public:
   MDL_context mdl_context;
+  /** Pins for lock-free lookups in the table definition cache. */
+  LF_PINS *tdc_hash_pins;
 
   /* Used to execute base64 coded binlog events in MySQL server */
   Relay_log_info* rli_fake;
@@ -1814,6 +1818,8 @@ public:
   struct  system_status_var status_var; // Per thread statistic vars
   struct  system_status_var org_status_var; // For user statistics
   struct  system_status_var *initial_status_var; /* used by show status */
+  /* Highest status_var.memory_used seen during the current command */
+  int64 statement_memory_peak;
   THR_LOCK_INFO lock_info;              // Locking info of this thread
   /**
     Protects THD data accessed from other threads:
@@ -4165,6 +4171,42 @@ public:
   TMP_TABLE_PARAM *get_tmp_table_param() { return &tmp_table_param; }
 };
 
+
+/*
+  UNION ALL result that is passed directly to the result of the UNION
+  without collecting the rows in a temporary table first.
+
+  The TABLE structure of the union temporary table is still created, but
+  the table itself is never instantiated: its record buffer is only used
+  to convert each row to the column types of the UNION before it is sent
+  to the receiving select_result through unit->item_list.
+*/
+
+class select_union_direct :public select_union
+{
+  select_result *result;            /* Result object of the UNION */
+  ha_rows offset;                   /* Rows of the UNION OFFSET left to skip */
+  ha_rows limit;                    /* Rows left to the UNION LIMIT */
+public:
+  ha_rows send_records;             /* Rows sent to result */
+
+  select_union_direct(select_result *result_arg)
+    :result(result_arg), offset(0), limit(HA_POS_ERROR), send_records(0) {}
+  /*
+    Set the LIMIT of the whole UNION. As for st_select_lex_unit,
+    limit_arg includes the offset.
+  */
+  void set_limit(ha_rows offset_arg, ha_rows limit_arg)
+  {
+    offset= offset_arg;
+    limit= limit_arg;
+    send_records= 0;
+  }
+  ha_rows rows_left() const { return limit; }
+  int send_data(List<Item> &items);
+  void cleanup() {}
+};
+
 /* Base subselect interface class */
 class select_subselect :public select_result_interceptor
 {
@@ -4187,6 +4229,8 @@ public:
 };
 
 
+class Subq_key_filter;
+
 /*
   This class specializes select_union to collect statistics about the
   data stored in the temp table. Currently the class collects statistcs
@@ -4226,7 +4270,10 @@ protected:
   void reset();
 
 public:
-  select_materialize_with_stats() { tmp_table_param.init(); }
+  /* Filter to add the key of every written row to, if any */
+  Subq_key_filter *key_filter;
+
+  select_materialize_with_stats() :key_filter(NULL) { tmp_table_param.init(); }
   bool create_result_table(THD *thd, List<Item> *column_types,
                            bool is_distinct, ulonglong options,
                            const char *alias, 
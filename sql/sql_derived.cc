@@ -595,6 +595,7 @@ bool mysql_derived_prepare(THD *thd, LEX *lex, TABLE_LIST *derived)
   SELECT_LEX_UNIT *unit= derived->get_unit();
   DBUG_ENTER("mysql_derived_prepare");
   bool res= FALSE;
+  ulonglong create_options;
 
   // Skip already prepared views/DT
   if (!unit || unit->prepared ||
@@ -661,11 +662,18 @@ bool mysql_derived_prepare(THD *thd, LEX *lex, TABLE_LIST *derived)
     !unit->union_distinct->next_select() (i.e. it is union and last distinct
     SELECT is last SELECT of UNION).
   */
+  create_options= (first_select->options | thd->variables.option_bits |
+                   TMP_TABLE_ALL_COLUMNS);
+  /*
+    Heap tables can store blobs, but MATCH ... AGAINST on the derived table
+    needs an engine that supports fulltext search.
+  */
+  if (derived->select_lex && derived->select_lex->ftfunc_list->elements)
+    create_options|= TMP_TABLE_FORCE_MYISAM;
+
   thd->create_tmp_table_for_derived= TRUE;
   if (derived->derived_result->create_result_table(thd, &unit->types, FALSE,
-                                                (first_select->options |
-                                                 thd->variables.option_bits |
-                                                 TMP_TABLE_ALL_COLUMNS),
+                                                create_options,
                                                 derived->alias,
                                                 FALSE, FALSE))
   { 
@@ -18,12 +18,8 @@
 #include "sql_expression_cache.h"
 
 /**
-  Minimum hit ration to proceed on disk if in memory table overflowed.
-  hit_rate = hit / (miss + hit);
-*/
-#define EXPCACHE_MIN_HIT_RATE_FOR_DISK_TABLE 0.7
-/**
-  Minimum hit ratio to keep in memory table (do not switch cache off)
+  Minimum hit ratio to keep the cache when it is full (do not switch cache
+  off)
   hit_rate = hit / (miss + hit);
 */
 #define EXPCACHE_MIN_HIT_RATE_FOR_MEM_TABLE  0.2
@@ -32,6 +28,10 @@
   impact in the case when the cache is not applicable)
 */
 #define EXPCACHE_CHECK_HIT_RATIO_AFTER 200
+/**
+  Initial number of slots of the hash table (power of 2)
+*/
+#define EXPCACHE_INITIAL_SLOTS 64
 
 /*
   Expression cache is used only for caching subqueries now, so its statistic
@@ -42,8 +42,9 @@ ulong subquery_cache_miss, subquery_cache_hit;
 Expression_cache_tmptable::Expression_cache_tmptable(THD *thd,
                                                      List<Item> &dependants,
                                                      Item *value)
-  :cache_table(NULL), table_thd(thd), items(dependants), val(value),
-   hit(0), miss(0), inited (0)
+  :cache_table(NULL), table_thd(thd), slots(NULL), slot_mask(0), entries(0),
+   lru_first(NULL), lru_last(NULL), entry_size(0), mem_used(0), mem_limit(0),
+   items(dependants), val(value), hit(0), miss(0), inited (0)
 {
   DBUG_ENTER("Expression_cache_tmptable::Expression_cache_tmptable");
   DBUG_VOID_RETURN;
@@ -56,43 +57,28 @@ Expression_cache_tmptable::Expression_cache_tmptable(THD *thd,
 
 void Expression_cache_tmptable::disable_cache()
 {
-  if (cache_table->file->inited)
-    cache_table->file->ha_index_end();
   free_tmp_table(table_thd, cache_table);
   cache_table= NULL;
+  my_free(slots);
+  slots= NULL;
+  free_root(&entry_root, MYF(0));
+  entries= 0;
+  lru_first= lru_last= NULL;
 }
 
 
 /**
-  Field enumerator for TABLE::add_tmp_key
-
-  @param arg             reference variable with current field number
-
-  @return field number
-*/
-
-static uint field_enumerator(uchar *arg)
-{
-  return ((uint*)arg)[0]++;
-}
-
-
-/**
-  Initialize temporary table and auxiliary structures for the expression
-  cache
+  Initialize the temporary table and the hash table of the expression cache
 
   @details
-  The function creates a temporary table for the expression cache, defines
-  the search index and initializes auxiliary search structures used to check
-  whether a given set of of values of the expression parameters is in some
-  cache entry.
+  The function creates a temporary table describing the records of the
+  expression cache (the result and the parameters of the expression) and
+  allocates the hash table that will hold the records. The temporary table
+  is never opened.
 */
 
 void Expression_cache_tmptable::init()
 {
-  List_iterator<Item> li(items);
-  Item_iterator_list it(li);
-  uint field_counter;
   DBUG_ENTER("Expression_cache_tmptable::init");
   DBUG_ASSERT(!inited);
   inited= TRUE;
@@ -110,7 +96,7 @@ void Expression_cache_tmptable::init()
   cache_table_param.init();
   /* dependent items and result */
   cache_table_param.field_count= items.elements;
-  /* postpone table creation to index description */
+  /* only the record format is needed */
   cache_table_param.skip_create_table= 1;
 
   if (!(cache_table= create_tmp_table(table_thd, &cache_table_param,
@@ -127,33 +113,25 @@ void Expression_cache_tmptable::init()
     DBUG_VOID_RETURN;
   }
 
-  if (cache_table->s->db_type() != heap_hton)
-  {
-    DBUG_PRINT("error", ("we need only heap table"));
-    goto error;
-  }
-
-  field_counter= 1;
+  init_sql_alloc(&entry_root, MEM_ROOT_BLOCK_SIZE, 0,
+                 MYF(MY_THREAD_SPECIFIC));
 
-  if (cache_table->alloc_keys(1) ||
-      cache_table->add_tmp_key(0, items.elements - 1, &field_enumerator,
-                                (uchar*)&field_counter, TRUE) ||
-      ref.tmp_table_index_lookup_init(table_thd, cache_table->key_info, it,
-                                      TRUE, 1 /* skip result field*/))
+  if (cache_table->s->blob_fields)
   {
-    DBUG_PRINT("error", ("creating index failed"));
+    /* Records are copied as they are, so they can't refer to blob values */
+    DBUG_PRINT("error", ("the cache can't store blobs"));
     goto error;
   }
-  cache_table->s->keys= 1;
-  ref.null_rejecting= 1;
-  ref.disable_cache= FALSE;
-  ref.has_record= 0;
-  ref.use_count= 0;
-
 
-  if (open_tmp_table(cache_table))
+  entry_size= ALIGN_SIZE(sizeof(Entry) + cache_table->s->reclength);
+  mem_limit= MY_MIN(table_thd->variables.tmp_table_size,
+                    table_thd->variables.max_heap_table_size);
+  mem_used= EXPCACHE_INITIAL_SLOTS * sizeof(Entry*);
+  slot_mask= EXPCACHE_INITIAL_SLOTS - 1;
+  if (!(slots= (Entry**) my_malloc(EXPCACHE_INITIAL_SLOTS * sizeof(Entry*),
+                                   MYF(MY_ZEROFILL | MY_THREAD_SPECIFIC))))
   {
-    DBUG_PRINT("error", ("Opening (creating) temporary table failed"));
+    DBUG_PRINT("error", ("allocating the hash table failed"));
     goto error;
   }
 
@@ -182,6 +160,176 @@ Expression_cache_tmptable::~Expression_cache_tmptable()
 }
 
 
+/**
+  Calculate the hash value of the parameters in record[0]
+
+  @note
+  The hash value respects the collations of the parameters, the same way
+  key_matches() does.
+*/
+
+ulong Expression_cache_tmptable::hash_record()
+{
+  ulong nr= 1, nr2= 4;
+  Field **field;
+  for (field= cache_table->field + 1; *field; field++)
+    (*field)->hash(&nr, &nr2);
+  return nr;
+}
+
+
+/**
+  Check if the parameters stored in an entry are equal to the ones in
+  record[0]
+
+  @note
+  NULL is considered to be equal to NULL, the cached value is the result of
+  the expression for such parameters as well.
+*/
+
+bool Expression_cache_tmptable::key_matches(Entry *entry)
+{
+  my_ptrdiff_t diff= entry->record() - cache_table->record[0];
+  Field **field;
+  for (field= cache_table->field + 1; *field; field++)
+  {
+    Field *f= *field;
+    bool is_null= f->is_real_null();
+    if (is_null != f->is_real_null(diff))
+      return FALSE;
+    if (is_null)
+      continue;
+    if (f->type() == MYSQL_TYPE_BIT)
+    {
+      /* Some of the bits may be stored together with the null bits */
+      longlong value= f->val_int();
+      bool differs;
+      f->move_field_offset(diff);
+      differs= (f->val_int() != value);
+      f->move_field_offset(-diff);
+      if (differs)
+        return FALSE;
+    }
+    else if (f->cmp(f->ptr, f->ptr + diff))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
+/**
+  Find the slot for the parameters in record[0]
+
+  @return the slot of the entry with these parameters, or the empty slot
+          where such an entry should be put
+*/
+
+uint Expression_cache_tmptable::find_slot(ulong hash_value)
+{
+  uint idx= hash_value & slot_mask;
+  Entry *entry;
+  while ((entry= slots[idx]) &&
+         (entry->hash_value != hash_value || !key_matches(entry)))
+    idx= (idx + 1) & slot_mask;
+  return idx;
+}
+
+
+/**
+  Double the number of slots of the hash table
+
+  @retval FALSE OK
+  @retval TRUE  the memory limit of the cache does not allow it, or out of
+                memory
+*/
+
+bool Expression_cache_tmptable::grow_slots()
+{
+  uint new_mask= (slot_mask << 1) | 1;
+  size_t size= (new_mask + 1) * sizeof(Entry*);
+  Entry **new_slots;
+  if (new_mask == slot_mask ||
+      mem_used + size - (slot_mask + 1) * sizeof(Entry*) > mem_limit)
+    return TRUE;
+  if (!(new_slots= (Entry**) my_malloc(size, MYF(MY_ZEROFILL |
+                                                 MY_THREAD_SPECIFIC))))
+    return TRUE;
+  for (uint i= 0; i <= slot_mask; i++)
+  {
+    Entry *entry;
+    if ((entry= slots[i]))
+    {
+      uint idx= entry->hash_value & new_mask;
+      while (new_slots[idx])
+        idx= (idx + 1) & new_mask;
+      new_slots[idx]= entry;
+    }
+  }
+  my_free(slots);
+  mem_used+= size - (slot_mask + 1) * sizeof(Entry*);
+  slots= new_slots;
+  slot_mask= new_mask;
+  DBUG_PRINT("info", ("hash table grown to %u slots", new_mask + 1));
+  return FALSE;
+}
+
+
+void Expression_cache_tmptable::lru_link_first(Entry *entry)
+{
+  entry->lru_prev= NULL;
+  if ((entry->lru_next= lru_first))
+    lru_first->lru_prev= entry;
+  else
+    lru_last= entry;
+  lru_first= entry;
+}
+
+
+void Expression_cache_tmptable::lru_unlink(Entry *entry)
+{
+  if (entry->lru_prev)
+    entry->lru_prev->lru_next= entry->lru_next;
+  else
+    lru_first= entry->lru_next;
+  if (entry->lru_next)
+    entry->lru_next->lru_prev= entry->lru_prev;
+  else
+    lru_last= entry->lru_prev;
+}
+
+
+/**
+  Remove an entry from the hash table
+
+  @details
+  The entries following the removed one in its probe sequence are moved
+  back, so no deleted markers are needed in the hash table.
+*/
+
+void Expression_cache_tmptable::remove_entry(Entry *entry)
+{
+  uint idx= entry->hash_value & slot_mask;
+  uint next;
+  while (slots[idx] != entry)
+    idx= (idx + 1) & slot_mask;
+
+  for (next= (idx + 1) & slot_mask; slots[next]; next= (next + 1) & slot_mask)
+  {
+    uint home= slots[next]->hash_value & slot_mask;
+    /* Move the entry if its home slot is not between idx and next */
+    if (idx <= next ? (home <= idx || home > next) :
+                      (home <= idx && home > next))
+    {
+      slots[idx]= slots[next];
+      idx= next;
+    }
+  }
+  slots[idx]= NULL;
+  lru_unlink(entry);
+  entries--;
+}
+
+
 /**
   Check if a given set of parameters of the expression is in the cache
 
@@ -199,17 +347,32 @@ Expression_cache_tmptable::~Expression_cache_tmptable()
 
 Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
 {
-  int res;
   DBUG_ENTER("Expression_cache_tmptable::check_value");
 
   if (cache_table)
   {
-    DBUG_PRINT("info", ("status: %u  has_record %u",
-                        (uint)cache_table->status, (uint)ref.has_record));
-    if ((res= join_read_key2(table_thd, NULL, cache_table, &ref)) == 1)
+    enum_check_fields save_count_cuted_fields= table_thd->count_cuted_fields;
+    List_iterator<Item> li(items);
+    Field **field;
+    Entry *entry;
+    uint idx;
+
+    /*
+      Copy the values of the parameters to the record, as put_value() does.
+      save_in_field() could not be used: for a field of an outer table it
+      copies the result field, which may belong to a temporary table of
+      the subquery, and would give the same key for all outer rows.
+    */
+    table_thd->count_cuted_fields= CHECK_FIELD_IGNORE;
+    li++;  // skip result field
+    for (field= cache_table->field + 1; *field; field++)
+      li++->save_val(*field);
+    table_thd->count_cuted_fields= save_count_cuted_fields;
+    if (table_thd->is_error())
       DBUG_RETURN(ERROR);
 
-    if (res)
+    idx= find_slot(hash_record());
+    if (!(entry= slots[idx]))
     {
       if (((++miss) == EXPCACHE_CHECK_HIT_RATIO_AFTER) &&
           ((double)hit / ((double)hit + miss)) <
@@ -223,6 +386,12 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
       DBUG_RETURN(MISS);
     }
 
+    if (entry != lru_first)
+    {
+      lru_unlink(entry);
+      lru_link_first(entry);
+    }
+    memcpy(cache_table->record[0], entry->record(), cache_table->s->reclength);
     hit++;
     *value= cached_result;
     DBUG_RETURN(Expression_cache::HIT);
@@ -238,7 +407,9 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
 
   @details
   The function evaluates 'value' and puts the result into the cache as the
-  result of the expression for the current set of parameters.
+  result of the expression for the current set of parameters. If the cache
+  is full the least recently used entry is replaced, unless the hit rate is
+  too low to keep the cache at all.
 
   @retval FALSE OK
   @retval TRUE  Error
@@ -246,7 +417,10 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
 
 my_bool Expression_cache_tmptable::put_value(Item *value)
 {
-  int error;
+  Entry *entry;
+  ulong hash_value;
+  uint idx;
+  bool full;
   DBUG_ENTER("Expression_cache_tmptable::put_value");
   DBUG_ASSERT(inited);
 
@@ -259,43 +433,47 @@ my_bool Expression_cache_tmptable::put_value(Item *value)
   *(items.head_ref())= value;
   fill_record(table_thd, cache_table, cache_table->field, items, TRUE, TRUE);
   if (table_thd->is_error())
-    goto err;;
+    goto err;
 
-  if ((error= cache_table->file->ha_write_tmp_row(cache_table->record[0])))
+  hash_value= hash_record();
+  if ((entry= slots[find_slot(hash_value)]))
   {
-    /* create_myisam_from_heap will generate error if needed */
-    if (cache_table->file->is_fatal_error(error, HA_CHECK_DUP))
-      goto err;
-    else
+    /* The parameters are already there, just refresh the result */
+    memcpy(entry->record(), cache_table->record[0],
+           cache_table->s->reclength);
+    DBUG_RETURN(FALSE);
+  }
+
+  full= ((entries + 1) * 4 > (slot_mask + 1) * 3 && grow_slots()) ||
+        mem_used + entry_size > mem_limit;
+  if (full)
+  {
+    double hit_rate= ((double)hit / ((double)hit + miss));
+    DBUG_ASSERT(miss > 0);
+    if (!lru_last || hit_rate < EXPCACHE_MIN_HIT_RATE_FOR_MEM_TABLE)
     {
-      double hit_rate= ((double)hit / ((double)hit + miss));
-      DBUG_ASSERT(miss > 0);
-      if (hit_rate < EXPCACHE_MIN_HIT_RATE_FOR_MEM_TABLE)
-      {
-        DBUG_PRINT("info", ("hit rate is not so good to keep the cache"));
-        disable_cache();
-        DBUG_RETURN(FALSE);
-      }
-      else if (hit_rate < EXPCACHE_MIN_HIT_RATE_FOR_DISK_TABLE)
-      {
-        DBUG_PRINT("info", ("hit rate is not so good to go to disk"));
-        if (cache_table->file->ha_delete_all_rows() ||
-            cache_table->file->ha_write_tmp_row(cache_table->record[0]))
-          goto err;
-      }
-      else
-      {
-        if (create_internal_tmp_table_from_heap(table_thd, cache_table,
-                                                cache_table_param.start_recinfo,
-                                                &cache_table_param.recinfo,
-                                                error, 1, NULL))
-          goto err;
-      }
+      DBUG_PRINT("info", ("hit rate is not so good to keep the cache"));
+      disable_cache();
+      DBUG_RETURN(FALSE);
     }
+    DBUG_PRINT("info", ("cache is full, replacing the oldest entry"));
+    entry= lru_last;
+    remove_entry(entry);
+  }
+  else
+  {
+    if (!(entry= (Entry*) alloc_root(&entry_root, entry_size)))
+      goto err;
+    mem_used+= entry_size;
   }
-  cache_table->status= 0; /* cache_table->record contains an existed record */
-  ref.has_record= TRUE; /* the same as above */
-  DBUG_PRINT("info", ("has_record: TRUE  status: 0"));
+
+  memcpy(entry->record(), cache_table->record[0], cache_table->s->reclength);
+  entry->hash_value= hash_value;
+  /* The removed entry may have moved others, so look for the slot again */
+  idx= find_slot(hash_value);
+  slots[idx]= entry;
+  lru_link_first(entry);
+  entries++;
 
   DBUG_RETURN(FALSE);
 
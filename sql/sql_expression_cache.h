@@ -64,13 +64,19 @@ public:
   virtual void init()= 0;
 };
 
-struct st_table_ref;
-struct st_join_table;
 class Item_field;
 
 
 /**
-  Implementation of expression cache over a temporary table
+  Implementation of expression cache over the records of a temporary table
+
+  @details
+  The temporary table is only used to describe the record format and to
+  convert the values of the parameters and of the result; it is never
+  opened. The records themselves are kept in a hash table private to the
+  cache. The hash table is open addressed, grows with the number of
+  entries and is limited in memory by tmp_table_size/max_heap_table_size.
+  When it is full the least recently used entry is replaced.
 */
 
 class Expression_cache_tmptable :public Expression_cache
@@ -86,16 +92,41 @@ public:
   void init();
 
 private:
+  /* Entry of the hash table, the record of the table follows it */
+  struct Entry
+  {
+    Entry *lru_prev, *lru_next;
+    ulong hash_value;
+    uchar *record() { return (uchar*) (this + 1); }
+  };
+
   void disable_cache();
+  ulong hash_record();
+  bool key_matches(Entry *entry);
+  uint find_slot(ulong hash_value);
+  bool grow_slots();
+  void remove_entry(Entry *entry);
+  void lru_link_first(Entry *entry);
+  void lru_unlink(Entry *entry);
 
   /* tmp table parameters */
   TMP_TABLE_PARAM cache_table_param;
-  /* temporary table to store this cache */
+  /* temporary table describing the records of this cache */
   TABLE *cache_table;
   /* Thread handle for the temporary table */
   THD *table_thd;
-  /* TABLE_REF for index lookup */
-  struct st_table_ref ref;
+  /* Memory for the entries */
+  MEM_ROOT entry_root;
+  /* Hash table, slot_mask + 1 slots */
+  Entry **slots;
+  uint slot_mask;
+  /* Number of entries in the hash table */
+  uint entries;
+  /* Most and least recently used entries */
+  Entry *lru_first, *lru_last;
+  /* Size of one entry with its record, and memory used/allowed */
+  size_t entry_size;
+  ulonglong mem_used, mem_limit;
   /* Cached result */
   Item_field *cached_result;
   /* List of parameter items */
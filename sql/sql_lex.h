@@ -547,6 +547,11 @@ protected:
   select_union *union_result;
   ulonglong found_rows_for_union;
   bool saved_error;
+  /* TRUE <=> rows are sent to result without the temporary table */
+  bool union_direct;
+
+  bool union_needs_tmp_table();
+  bool exec_direct();
 
 public:
   // Ensures that at least all members used during cleanup() are initialized.
@@ -69,6 +69,8 @@ class READ_INFO {
   uint	field_term_length,line_term_length,enclosed_length;
   int	field_term_char,line_term_char,enclosed_char,escape_char;
   int	*stack,*stack_pos;
+  /* Characters that read_field() can't copy without looking at them */
+  bool	special_char[256];
   bool	found_end_of_line,start_of_line,eof;
   bool  need_end_io_cache;
   IO_CACHE cache;
@@ -1364,6 +1366,24 @@ READ_INFO::READ_INFO(File file_par, uint tot_length, CHARSET_INFO *cs,
   field_term_char= field_term_length ? (uchar) field_term_ptr[0] : INT_MAX;
   line_term_char= line_term_length ? (uchar) line_term_ptr[0] : INT_MAX;
 
+  bzero(special_char, sizeof(special_char));
+  if (field_term_char != INT_MAX)
+    special_char[field_term_char]= 1;
+  if (line_term_char != INT_MAX)
+    special_char[line_term_char]= 1;
+  if (enclosed_char != INT_MAX)
+    special_char[enclosed_char]= 1;
+  if (escape_char != INT_MAX)
+    special_char[(uchar) escape_char]= 1;
+#ifdef USE_MB
+  if (use_mb(cs))
+  {
+    for (uint i= 0; i < 256; i++)
+      if (my_mbcharlen(cs, i) > 1)
+        special_char[i]= 1;
+  }
+#endif
+
   /* Set of a stack for unget if long terminators */
   uint length= MY_MAX(cs->mbmaxlen, MY_MAX(field_term_length, line_term_length)) + 1;
   set_if_bigger(length,line_start.length());
@@ -1479,6 +1499,26 @@ int READ_INFO::read_field()
   {
     while ( to < end_of_buff)
     {
+      if (stack_pos == stack)
+      {
+        /*
+          Copy the ordinary characters at the read position in one go,
+          the loop below only has to look at the special ones
+        */
+        uchar *start= cache.read_pos, *pos= start;
+        uchar *end= cache.read_end;
+        if ((size_t) (end - pos) > (size_t) (end_of_buff - to))
+          end= pos + (end_of_buff - to);
+        while (pos < end && !special_char[*pos])
+          pos++;
+        if (pos != start)
+        {
+          memcpy(to, start, (size_t) (pos - start));
+          to+= pos - start;
+          cache.read_pos= pos;
+          continue;
+        }
+      }
       chr = GET;
       if (chr == my_b_EOF)
 	goto found_eof;
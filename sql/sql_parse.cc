@@ -1094,6 +1094,7 @@ bool dispatch_command(enum enum_server_command command, THD *thd,
 {
   NET *net= &thd->net;
   bool error= 0;
+  int64 start_memory_used= thd->status_var.memory_used;
   DBUG_ENTER("dispatch_command");
   DBUG_PRINT("info", ("command: %d", command));
 
@@ -1124,6 +1125,7 @@ bool dispatch_command(enum enum_server_command command, THD *thd,
 
   DEBUG_SYNC(thd,"dispatch_command_before_set_time");
 
+  thd->statement_memory_peak= start_memory_used;
   thd->set_time();
   if (!(server_command_flags[command] & CF_SKIP_QUERY_ID))
     thd->set_query_id(next_query_id());
@@ -1726,6 +1728,8 @@ bool dispatch_command(enum enum_server_command command, THD *thd,
   thd->set_time();
   dec_thread_running();
   thd->packet.shrink(thd->variables.net_buffer_length);	// Reclaim some memory
+  set_if_bigger(thd->status_var.max_statement_memory_used,
+                (ulonglong) (thd->statement_memory_peak - start_memory_used));
   free_root(thd->mem_root,MYF(MY_KEEP_PREALLOC));
 
 #if defined(ENABLED_PROFILING)
@@ -47,6 +47,227 @@ static int binlog_dump_count = 0;
 extern TYPELIB binlog_checksum_typelib;
 
 
+/*
+  Shared cache of the tail of the active binary log
+
+  Dump threads of slaves that are close to the end of the active binlog
+  all read the same events. Instead of each of them taking LOCK_log and
+  reading the file for every event, the first dump thread that needs new
+  data reads everything written since the last time into this buffer,
+  and the other dump threads copy the events from here.
+
+  The buffer holds the bytes [start, end) of the binlog file log_name.
+  It's only used while the binlog opened by mysql_bin_log has the open
+  count open_count, so that RESET MASTER, which creates a new file with
+  the same name, can't make us send stale data.
+*/
+
+class Binlog_dump_cache
+{
+public:
+  void init();
+  void destroy();
+  bool read_event(IO_CACHE *log, const char *log_file_name, String *packet,
+                  uint8 checksum_alg);
+
+private:
+  bool fill(IO_CACHE *log, const char *log_file_name, my_off_t pos);
+
+  mysql_mutex_t LOCK_dump_cache;
+  uchar *buffer;
+  size_t size;
+  char log_name[FN_REFLEN];
+  uint32 open_count;
+  my_off_t start, end;
+  bool inited;
+};
+
+static Binlog_dump_cache binlog_dump_cache;
+
+
+void Binlog_dump_cache::init()
+{
+  mysql_mutex_init(key_LOCK_binlog_dump_cache, &LOCK_dump_cache,
+                   MY_MUTEX_INIT_FAST);
+  buffer= 0;
+  size= 0;
+  log_name[0]= 0;
+  open_count= 0;
+  start= end= 0;
+  inited= true;
+}
+
+
+void Binlog_dump_cache::destroy()
+{
+  if (!inited)
+    return;
+  inited= false;
+  my_free(buffer);
+  buffer= 0;
+  mysql_mutex_destroy(&LOCK_dump_cache);
+}
+
+
+/*
+  Read new data from the active binlog into the cache
+
+  SYNOPSIS
+    fill()
+    log            Binlog file of the dump thread
+    log_file_name  Name of that file
+    pos            Position of the dump thread in it
+
+  NOTES
+    Must be called with LOCK_dump_cache locked. LOCK_log is taken
+    while checking how much of the binlog has been written.
+
+  RETURN VALUES
+    TRUE   New data was added to the cache
+    FALSE  Nothing was added; the dump thread should read the file itself
+*/
+
+bool Binlog_dump_cache::fill(IO_CACHE *log, const char *log_file_name,
+                             my_off_t pos)
+{
+  mysql_mutex_t *log_lock= mysql_bin_log.get_log_lock();
+  my_off_t written;
+  uint32 count;
+  size_t length, keep;
+
+  if (size != binlog_dump_cache_size)
+  {
+    my_free(buffer);
+    buffer= 0;
+    log_name[0]= 0;
+    if ((size= binlog_dump_cache_size) &&
+        !(buffer= (uchar*) my_malloc(size, MYF(0))))
+      size= 0;
+  }
+  if (!size)
+    return FALSE;
+
+  mysql_mutex_lock(log_lock);
+  if (!mysql_bin_log.is_active(log_file_name))
+  {
+    mysql_mutex_unlock(log_lock);
+    return FALSE;
+  }
+  /*
+    Everything before pos_in_file has been written to the file, and
+    bytes in the file never change while it's the active binlog.
+  */
+  written= mysql_bin_log.get_log_file()->pos_in_file;
+  count= mysql_bin_log.get_open_count();
+  mysql_mutex_unlock(log_lock);
+
+  if (count != open_count || strcmp(log_file_name, log_name) || pos > end)
+  {
+    /* Start caching from the dump thread that is furthest ahead */
+    strmake_buf(log_name, log_file_name);
+    open_count= count;
+    start= end= pos;
+  }
+  else if (pos < start)
+    return FALSE;                               // Behind the cache
+
+  if (written <= end)
+    return FALSE;
+  length= (size_t) MY_MIN(written - end, size);
+  keep= (size_t) MY_MIN(end - start, size - length);
+  if (end - start > keep)
+  {
+    memmove(buffer, buffer + (end - start - keep), keep);
+    start= end - keep;
+  }
+  if (my_pread(log->file, buffer + keep, length, end, MYF(MY_NABP)))
+    return FALSE;
+  end+= length;
+  return TRUE;
+}
+
+
+/*
+  Read the next event of a dump thread from the cache
+
+  SYNOPSIS
+    read_event()
+    log            Binlog file of the dump thread, positioned at the event
+    log_file_name  Name of that file
+    packet         The event is appended here
+    checksum_alg   Checksum algorithm of the binlog
+
+  NOTES
+    On success log is moved to after the event, as if the event was read
+    with Log_event::read_log_event().
+
+  RETURN VALUES
+    FALSE  The event was appended to packet
+    TRUE   The event is not in the cache; nothing was done
+*/
+
+bool Binlog_dump_cache::read_event(IO_CACHE *log, const char *log_file_name,
+                                   String *packet, uint8 checksum_alg)
+{
+  my_off_t pos= my_b_tell(log);
+  uint32 ev_offset= packet->length();
+  bool filled= FALSE;
+  ulong data_len;
+
+  if (!binlog_dump_cache_size && !buffer)
+    return TRUE;
+  DBUG_EXECUTE_IF("corrupt_read_log_event2", return TRUE;);
+
+  mysql_mutex_lock(&LOCK_dump_cache);
+  for (;;)
+  {
+    if (size && open_count == mysql_bin_log.get_open_count() &&
+        !strcmp(log_file_name, log_name) &&
+        pos >= start && pos + LOG_EVENT_MINIMAL_HEADER_LEN <= end)
+    {
+      uchar *ev= buffer + (pos - start);
+      data_len= uint4korr(ev + EVENT_LEN_OFFSET);
+      /* Let read_log_event() report broken and too big events */
+      if (data_len < LOG_EVENT_MINIMAL_HEADER_LEN ||
+          data_len > current_thd->variables.max_allowed_packet ||
+          data_len > size)
+        break;
+      if (pos + data_len <= end)
+      {
+        bool error= packet->append((char*) ev, data_len);
+        mysql_mutex_unlock(&LOCK_dump_cache);
+        if (error ||
+            (opt_master_verify_checksum &&
+             event_checksum_test((uchar*) packet->ptr() + ev_offset,
+                                 data_len, checksum_alg)))
+        {
+          packet->length(ev_offset);
+          return TRUE;
+        }
+        my_b_seek(log, pos + data_len);
+        return FALSE;
+      }
+    }
+    if (filled || !(filled= fill(log, log_file_name, pos)))
+      break;
+  }
+  mysql_mutex_unlock(&LOCK_dump_cache);
+  return TRUE;
+}
+
+
+void init_binlog_dump_cache()
+{
+  binlog_dump_cache.init();
+}
+
+
+void destroy_binlog_dump_cache()
+{
+  binlog_dump_cache.destroy();
+}
+
+
 static int
 fake_event_header(String* packet, Log_event_type event_type, ulong extra_len,
                   my_bool *do_checksum, ha_checksum *crc, const char** errmsg,
@@ -78,8 +299,9 @@ fake_event_header(String* packet, Log_event_type event_type, ulong extra_len,
   }
   if (*do_checksum)
   {
-    *crc= my_checksum(0L, NULL, 0);
-    *crc= my_checksum(*crc, (uchar*)header, sizeof(header));
+    *crc= binlog_checksum(checksum_alg_arg, 0L, NULL, 0);
+    *crc= binlog_checksum(checksum_alg_arg, *crc, (uchar*)header,
+                          sizeof(header));
   }
   return 0;
 }
@@ -155,8 +377,9 @@ static int fake_rotate_event(NET* net, String* packet, char* log_file_name,
 
   if (do_checksum)
   {
-    crc= my_checksum(crc, (uchar*)buf, ROTATE_HEADER_LEN);
-    crc= my_checksum(crc, (uchar*)p, ident_len);
+    crc= binlog_checksum(checksum_alg_arg, crc, (uchar*)buf,
+                         ROTATE_HEADER_LEN);
+    crc= binlog_checksum(checksum_alg_arg, crc, (uchar*)p, ident_len);
   }
 
   if ((err= fake_event_footer(packet, do_checksum, crc, errmsg)) ||
@@ -191,7 +414,8 @@ static int fake_gtid_list_event(NET* net, String* packet,
   packet->append(str);
   if (do_checksum)
   {
-    crc= my_checksum(crc, (uchar*)str.ptr(), str.length());
+    crc= binlog_checksum(checksum_alg_arg, crc, (uchar*)str.ptr(),
+                         str.length());
   }
 
   if ((err= fake_event_footer(packet, do_checksum, crc, errmsg)) ||
@@ -306,16 +530,16 @@ static int send_file(THD *thd)
    Internal to mysql_binlog_send() routine that recalculates checksum for
    a FD event (asserted) that needs additional arranment prior sending to slave.
 */
-inline void fix_checksum(String *packet, ulong ev_offset)
+inline void fix_checksum(String *packet, ulong ev_offset, uint8 checksum_alg)
 {
   /* recalculate the crc for this event */
   uint data_len = uint4korr(packet->ptr() + ev_offset + EVENT_LEN_OFFSET);
-  ha_checksum crc= my_checksum(0L, NULL, 0);
+  ha_checksum crc= binlog_checksum(checksum_alg, 0L, NULL, 0);
   DBUG_ASSERT(data_len == 
               LOG_EVENT_MINIMAL_HEADER_LEN + FORMAT_DESCRIPTION_HEADER_LEN +
               BINLOG_CHECKSUM_ALG_DESC_LEN + BINLOG_CHECKSUM_LEN);
-  crc= my_checksum(crc, (uchar *)packet->ptr() + ev_offset, data_len -
-                   BINLOG_CHECKSUM_LEN);
+  crc= binlog_checksum(checksum_alg, crc, (uchar *)packet->ptr() + ev_offset,
+                       data_len - BINLOG_CHECKSUM_LEN);
   int4store(packet->ptr() + ev_offset + data_len - BINLOG_CHECKSUM_LEN, crc);
 }
 
@@ -377,7 +601,7 @@ static uint8 get_binlog_checksum_value_at_connect(THD * thd)
     str.copy(entry->value, entry->length, &my_charset_bin, &my_charset_bin,
              &dummy_errors);
     ret= (uint8) find_type ((char*) str.ptr(), &binlog_checksum_typelib, 1) - 1;
-    DBUG_ASSERT(ret <= BINLOG_CHECKSUM_ALG_CRC32); // while it's just on CRC32 alg
+    DBUG_ASSERT(ret < BINLOG_CHECKSUM_ALG_ENUM_END);
   }
   DBUG_RETURN(ret);
 }
@@ -695,9 +919,10 @@ static int send_heartbeat_event(NET* net, String* packet,
   if (do_checksum)
   {
     char b[BINLOG_CHECKSUM_LEN];
-    ha_checksum crc= my_checksum(0L, NULL, 0);
-    crc= my_checksum(crc, (uchar*) header, sizeof(header));
-    crc= my_checksum(crc, (uchar*) p, ident_len);
+    ha_checksum crc= binlog_checksum(checksum_alg_arg, 0L, NULL, 0);
+    crc= binlog_checksum(checksum_alg_arg, crc, (uchar*) header,
+                         sizeof(header));
+    crc= binlog_checksum(checksum_alg_arg, crc, (uchar*) p, ident_len);
     int4store(b, crc);
     packet->append(b, sizeof(b));
   }
@@ -1725,6 +1950,18 @@ send_event_to_slave(THD *thd, NET *net, String* const packet, ushort flags,
     break;
   }
 
+  /*
+    A compressed row event cannot be replaced by a dummy event: the slave
+    would silently miss the rows.
+  */
+  if (unlikely(is_compressed_rows_event(event_type)) &&
+      mariadb_slave_capability < MARIA_SLAVE_CAPABILITY_COMPRESSED_EVENTS)
+  {
+    my_errno= ER_MASTER_FATAL_ERROR_READING_BINLOG;
+    return "Slave can not handle compressed row events that master is "
+           "configured to log (log_bin_compress)";
+  }
+
   /* Do not send annotate_rows events unless slave requested it. */
   if (event_type == ANNOTATE_ROWS_EVENT && !(flags & BINLOG_SEND_ANNOTATE_ROWS_EVENT))
   {
@@ -2154,10 +2391,13 @@ impossible position";
                                                 packet->length() - ev_offset);
          DBUG_ASSERT(current_checksum_alg == BINLOG_CHECKSUM_ALG_OFF ||
                      current_checksum_alg == BINLOG_CHECKSUM_ALG_UNDEF ||
-                     current_checksum_alg == BINLOG_CHECKSUM_ALG_CRC32);
-         if (!is_slave_checksum_aware(thd) &&
-             current_checksum_alg != BINLOG_CHECKSUM_ALG_OFF &&
-             current_checksum_alg != BINLOG_CHECKSUM_ALG_UNDEF)
+                     binlog_checksum_is_on(current_checksum_alg));
+         if ((!is_slave_checksum_aware(thd) &&
+              current_checksum_alg != BINLOG_CHECKSUM_ALG_OFF &&
+              current_checksum_alg != BINLOG_CHECKSUM_ALG_UNDEF) ||
+             (current_checksum_alg == BINLOG_CHECKSUM_ALG_CRC32C &&
+              mariadb_slave_capability <
+              MARIA_SLAVE_CAPABILITY_COMPRESSED_EVENTS))
          {
            my_errno= ER_MASTER_FATAL_ERROR_READING_BINLOG;
            errmsg= "Slave can not handle replication events with the checksum "
@@ -2196,7 +2436,7 @@ impossible position";
 	 /* fix the checksum due to latest changes in header */
 	 if (current_checksum_alg != BINLOG_CHECKSUM_ALG_OFF &&
              current_checksum_alg != BINLOG_CHECKSUM_ALG_UNDEF)
-           fix_checksum(packet, ev_offset);
+           fix_checksum(packet, ev_offset, current_checksum_alg);
 
          /* send it */
          if (my_net_write(net, (uchar*) packet->ptr(), packet->length()))
@@ -2253,10 +2493,12 @@ impossible position";
 
     bool is_active_binlog= false;
     while (!(killed= thd->killed) &&
-           !(error = Log_event::read_log_event(&log, packet, log_lock,
-                                              current_checksum_alg,
-                                              log_file_name,
-                                              &is_active_binlog)))
+           (!binlog_dump_cache.read_event(&log, log_file_name, packet,
+                                          current_checksum_alg) ||
+            !(error = Log_event::read_log_event(&log, packet, log_lock,
+                                               current_checksum_alg,
+                                               log_file_name,
+                                               &is_active_binlog))))
     {
 #ifndef DBUG_OFF
       if (max_binlog_dump_events && !left_events--)
@@ -2302,10 +2544,13 @@ impossible position";
                                                packet->length() - ev_offset);
         DBUG_ASSERT(current_checksum_alg == BINLOG_CHECKSUM_ALG_OFF ||
                     current_checksum_alg == BINLOG_CHECKSUM_ALG_UNDEF ||
-                    current_checksum_alg == BINLOG_CHECKSUM_ALG_CRC32);
-        if (!is_slave_checksum_aware(thd) &&
-            current_checksum_alg != BINLOG_CHECKSUM_ALG_OFF &&
-            current_checksum_alg != BINLOG_CHECKSUM_ALG_UNDEF)
+                    binlog_checksum_is_on(current_checksum_alg));
+        if ((!is_slave_checksum_aware(thd) &&
+             current_checksum_alg != BINLOG_CHECKSUM_ALG_OFF &&
+             current_checksum_alg != BINLOG_CHECKSUM_ALG_UNDEF) ||
+            (current_checksum_alg == BINLOG_CHECKSUM_ALG_CRC32C &&
+             mariadb_slave_capability <
+             MARIA_SLAVE_CAPABILITY_COMPRESSED_EVENTS))
         {
           my_errno= ER_MASTER_FATAL_ERROR_READING_BINLOG;
           errmsg= "Slave can not handle replication events with the checksum "
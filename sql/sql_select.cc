@@ -3009,9 +3009,25 @@ void JOIN::exec_inner()
           "select SQL_CALC_FOUND_ROWS * from t1 order by b desc limit 1;"
         select_limit == HA_POS_ERROR (we need a full table scan)
         unit->select_limit_cnt == 1 (we only need one row in the result set)
+
+        If grouping (or the join) has already been done into a temporary
+        table and HAVING has either been evaluated or attached to the
+        sort condition, every row of the temporary table is a result row.
+        Then we can also use the LIMIT (which includes OFFSET) for queries
+        like:
+          "select a, count(*) from t1 group by a order by 2 desc limit 10;"
        */
+      const bool sort_result_rows= curr_tmp_table &&
+                                   !curr_join->group &&
+                                   !curr_join->group_list &&
+                                   !curr_join->sort_and_group &&
+                                   !curr_join->select_distinct &&
+                                   !curr_join->tmp_having &&
+                                   !curr_join->procedure &&
+                                   curr_join->rollup.state ==
+                                     ROLLUP::STATE_NONE;
       const ha_rows filesort_limit_arg=
-        (has_group_by || curr_join->table_count > 1)
+        ((has_group_by && !sort_result_rows) || curr_join->table_count > 1)
         ? curr_join->select_limit : unit->select_limit_cnt;
       const ha_rows select_limit_arg=
         select_options & OPTION_FOUND_ROWS
@@ -15277,6 +15293,26 @@ void setup_tmp_table_column_bitmaps(TABLE *table, uchar *bitmaps)
 }
 
 
+/*
+  Check if a blob column of a temporary table stores values of a BLOB or
+  TEXT type, and not strings that are only too long for a VARCHAR column
+*/
+
+static bool is_real_blob(Item *item)
+{
+  switch (item->field_type()) {
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_BLOB:
+  case MYSQL_TYPE_GEOMETRY:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+
 /**
   Create a temp table according to a field list.
 
@@ -15317,6 +15353,7 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
   uint  copy_func_count= param->func_count;
   uint  hidden_null_count, hidden_null_pack_length, hidden_field_count;
   uint  blob_count,group_null_items, string_count;
+  uint  real_blob_count;
   uint  temp_pool_slot=MY_BIT_NONE;
   uint fieldnr= 0;
   ulong reclength, string_total_length;
@@ -15490,6 +15527,7 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
 
   reclength= string_total_length= 0;
   blob_count= string_count= null_count= hidden_null_count= group_null_items= 0;
+  real_blob_count= 0;
   param->using_indirect_summary_function=0;
 
   List_iterator_fast<Item> li(fields);
@@ -15542,6 +15580,8 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
 	  {
 	    *blob_field++= fieldnr;
 	    blob_count++;
+            if (is_real_blob(arg))
+              real_blob_count++;
 	  }
           if (new_field->type() == MYSQL_TYPE_BIT)
             total_uneven_bit_length+= new_field->field_length & 7;
@@ -15649,6 +15689,8 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
       {
         *blob_field++= fieldnr;
 	blob_count++;
+        if (is_real_blob(item))
+          real_blob_count++;
       }
       if (new_field->real_type() == MYSQL_TYPE_STRING ||
           new_field->real_type() == MYSQL_TYPE_VARCHAR)
@@ -15695,9 +15737,16 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
   share->fields= field_count;
   share->column_bitmap_size= bitmap_buffer_size(share->fields);
 
-  /* If result table is small; use a heap */
+  /*
+    If result table is small; use a heap.
+    Heap tables store strings that are too long for a VARCHAR column as
+    blobs. BLOB/TEXT values, columns of schema tables (which are used to
+    create user tables with CREATE ... LIKE) and a distinct key over blobs
+    (which needs a unique constraint) still need the disk engine.
+  */
   /* future: storage engine selection can be made dynamic? */
-  if (blob_count || using_unique_constraint
+  if (real_blob_count || (blob_count && (distinct || param->schema_table))
+      || using_unique_constraint
       || (thd->variables.big_tables && !(select_options & SELECT_SMALL_RESULT))
       || (select_options & TMP_TABLE_FORCE_MYISAM)
       || thd->variables.tmp_table_size == 0)
@@ -18733,8 +18782,29 @@ end_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
     if ((error= table->file->ha_update_tmp_row(table->record[1],
                                                table->record[0])))
     {
-      table->file->print_error(error,MYF(0));	/* purecov: inspected */
-      DBUG_RETURN(NESTED_LOOP_ERROR);            /* purecov: inspected */
+      bool is_duplicate;
+      /*
+        A HEAP table with blobs can get full on update. The old row is
+        copied to the new table with the others; update it there.
+      */
+      if (create_internal_tmp_table_from_heap(join->thd, table,
+                                              join->tmp_table_param.start_recinfo,
+                                              &join->tmp_table_param.recinfo,
+                                              error, 1, &is_duplicate))
+        DBUG_RETURN(NESTED_LOOP_ERROR);            // Not a table_is_full error
+      DBUG_ASSERT(is_duplicate);
+      if ((error= table->file->ha_index_init(0, 0)) ||
+          (error= table->file->ha_index_read_map(table->record[1],
+                                                 join->tmp_table_param.group_buff,
+                                                 HA_WHOLE_KEY,
+                                                 HA_READ_KEY_EXACT)) ||
+          (error= table->file->ha_update_tmp_row(table->record[1],
+                                                 table->record[0])))
+      {
+        table->file->print_error(error, MYF(0));
+        DBUG_RETURN(NESTED_LOOP_ERROR);
+      }
+      join->join_tab[join->top_join_tab_count-1].next_select=end_unique_update;
     }
     goto end;
   }
@@ -20450,8 +20520,8 @@ remove_duplicates(JOIN *join, TABLE *table, List<Item> &fields, Item *having)
 
   free_io_cache(table);				// Safety
   table->file->info(HA_STATUS_VARIABLE);
-  if (table->s->db_type() == heap_hton ||
-      (!table->s->blob_fields &&
+  if (!table->s->blob_fields &&
+      (table->s->db_type() == heap_hton ||
        ((ALIGN_SIZE(keylength) + HASH_OVERHEAD) * table->file->stats.records <
 	thd->variables.sortbuff_size)))
     error=remove_dup_with_hash_index(join->thd, table, field_count, first_field,
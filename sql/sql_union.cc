@@ -115,6 +115,35 @@ bool select_union::flush()
   return 0;
 }
 
+/***************************************************************************
+** send records of UNION ALL directly to the result of the UNION
+***************************************************************************/
+
+int select_union_direct::send_data(List<Item> &items)
+{
+  if (unit->offset_limit_cnt)
+  {						// OFFSET of this SELECT
+    unit->offset_limit_cnt--;
+    return 0;
+  }
+  if (!limit)
+    return 0;
+  limit--;
+  if (offset)
+  {						// OFFSET of the UNION
+    offset--;
+    return 0;
+  }
+  if (thd->killed == ABORT_QUERY)
+    return 0;
+  fill_record(thd, table, table->field, items, TRUE, FALSE);
+  if (thd->is_error())
+    return 1;
+  send_records++;
+  return result->send_data(unit->item_list);
+}
+
+
 /*
   Create a temporary table to store the result of select_union.
 
@@ -273,9 +302,17 @@ bool st_select_lex_unit::prepare(THD *thd_arg, select_result *sel_result,
 
   /* Global option */
 
+  union_direct= FALSE;
   if (is_union_select)
   {
-    if (!(tmp_result= union_result= new select_union))
+    if (is_union() && !union_needs_tmp_table())
+    {
+      union_direct= TRUE;
+      tmp_result= union_result= new select_union_direct(sel_result);
+    }
+    else
+      tmp_result= union_result= new select_union;
+    if (!union_result)
       goto err;
     if (describe)
       tmp_result= sel_result;
@@ -443,7 +480,8 @@ bool st_select_lex_unit::prepare(THD *thd_arg, select_result *sel_result,
       create_options= create_options | TMP_TABLE_FORCE_MYISAM;
 
     if (union_result->create_result_table(thd, &types, test(union_distinct),
-                                          create_options, "", FALSE, TRUE))
+                                          create_options, "", FALSE,
+                                          !union_direct))
       goto err;
     if (fake_select_lex && !fake_select_lex->first_cond_optimization)
     {
@@ -524,6 +562,13 @@ bool st_select_lex_unit::prepare(THD *thd_arg, select_result *sel_result,
       */
       table->reset_item_list(&item_list);
     }
+
+    /*
+      The rows of a direct UNION ALL bypass the fake SELECT, so the result
+      is prepared here instead of in its JOIN::prepare().
+    */
+    if (union_direct && sel_result && sel_result->prepare(item_list, this))
+      goto err;
   }
 
   thd_arg->lex->current_select= lex_select_save;
@@ -638,6 +683,13 @@ bool st_select_lex_unit::exec()
   if (!saved_error && !was_executed)
     save_union_explain(thd->lex->explain);
 
+  if (union_direct)
+  {
+    if (!saved_error)
+      saved_error= exec_direct();
+    DBUG_RETURN(saved_error);
+  }
+
   if (uncacheable || !item || !item->assigned() || describe)
   {
     for (SELECT_LEX *sl= select_cursor; sl; sl= sl->next_select())
@@ -847,6 +899,118 @@ err:
 }
 
 
+/**
+  Check if the rows of the SELECTs must be collected in the temporary table
+  of the UNION before they can be sent to the result.
+
+  This is not needed for a top level UNION ALL of a SELECT statement
+  without ORDER BY for the whole UNION: the rows can then be sent in the
+  order they are produced, see select_union_direct and exec_direct().
+  SQL_CALC_FOUND_ROWS and EXPLAIN still use the temporary table, as do
+  UNIONs in subqueries and derived tables, which may be executed many
+  times or read by their outer SELECT.
+
+  @retval TRUE   the temporary table is needed
+  @retval FALSE  the rows can be sent directly to the result
+*/
+
+bool st_select_lex_unit::union_needs_tmp_table()
+{
+  return (union_distinct != NULL ||
+          global_parameters->order_list.elements != 0 ||
+          found_rows_for_union ||
+          describe ||
+          this != &thd->lex->unit ||
+          thd->lex->describe ||
+          thd->lex->sql_command != SQLCOM_SELECT);
+}
+
+
+/**
+  Execute a UNION ALL whose rows are sent directly to the result.
+
+  The SELECTs are executed one after another and each row is sent through
+  select_union_direct as soon as it is produced. The LIMIT of the UNION is
+  enforced across the SELECTs: every SELECT is limited to the rows that
+  can still be sent, and the remaining SELECTs are not executed at all
+  once the limit has been reached.
+
+  @return FALSE on success, TRUE on error
+*/
+
+bool st_select_lex_unit::exec_direct()
+{
+  SELECT_LEX *lex_select_save= thd->lex->current_select;
+  select_union_direct *direct_result= (select_union_direct*) union_result;
+  ha_rows examined_rows= 0;
+  bool res;
+  DBUG_ENTER("st_select_lex_unit::exec_direct");
+
+  set_limit(global_parameters);
+  direct_result->set_limit(offset_limit_cnt, select_limit_cnt);
+
+  (void) result->prepare2();
+  if (result->send_result_set_metadata(item_list, Protocol::SEND_NUM_ROWS |
+                                                  Protocol::SEND_EOF))
+    DBUG_RETURN(TRUE);
+
+  for (SELECT_LEX *sl= first_select(); sl; sl= sl->next_select())
+  {
+    ha_rows rows_left= direct_result->rows_left();
+    if (!rows_left)
+      break;
+
+    thd->lex->current_select= sl;
+    set_limit(sl);
+    if (sl == global_parameters)
+    {
+      /* The LIMIT of the whole UNION is applied by direct_result */
+      offset_limit_cnt= 0;
+      select_limit_cnt= HA_POS_ERROR;
+    }
+    /* Don't let the SELECT produce rows that could not be sent anyway */
+    if (rows_left != HA_POS_ERROR &&
+        select_limit_cnt - offset_limit_cnt > rows_left)
+      select_limit_cnt= offset_limit_cnt + rows_left;
+
+    if (!(saved_error= sl->join->optimize()))
+    {
+      sl->join->exec();
+      saved_error= sl->join->error;
+    }
+    if (saved_error)
+    {
+      thd->lex->current_select= lex_select_save;
+      DBUG_RETURN(saved_error);
+    }
+    examined_rows+= thd->get_examined_row_count();
+    thd->set_examined_row_count(0);
+
+    if (thd->killed == ABORT_QUERY)
+    {
+      /*
+        Stop execution of the remaining queries in the UNIONS, and produce
+        the current result.
+      */
+      push_warning_printf(thd, Sql_condition::WARN_LEVEL_WARN,
+                          ER_QUERY_EXCEEDED_ROWS_EXAMINED_LIMIT,
+                          ER(ER_QUERY_EXCEEDED_ROWS_EXAMINED_LIMIT),
+                          thd->accessed_rows_and_keys,
+                          thd->lex->limit_rows_examined->val_uint());
+      thd->reset_killed();
+      break;
+    }
+  }
+  thd->lex->current_select= lex_select_save;
+
+  res= result->send_eof();
+  thd->limit_found_rows= direct_result->send_records;
+  thd->inc_examined_row_count(examined_rows);
+  thd->lex->set_limit_rows_examined();
+  DBUG_RETURN(res);
+}
+
+
 bool st_select_lex_unit::cleanup()
 {
   int error= 0;
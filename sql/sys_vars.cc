@@ -1099,6 +1099,21 @@ static Sys_var_mybool Sys_log_bin(
        "log_bin", "Whether the binary log is enabled",
        READ_ONLY GLOBAL_VAR(opt_bin_log), NO_CMD_LINE, DEFAULT(FALSE));
 
+static Sys_var_mybool Sys_log_bin_compress(
+       "log_bin_compress",
+       "Whether the binary log can be compressed. Row events with rows that "
+       "take at least log_bin_compress_min_len bytes are written as "
+       "compressed row events, which only slaves and mysqlbinlog of this "
+       "version or later can read",
+       GLOBAL_VAR(opt_log_bin_compress), CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
+static Sys_var_ulong Sys_log_bin_compress_min_len(
+       "log_bin_compress_min_len",
+       "Minimum length of the rows of a row event for the event to be "
+       "compressed when log_bin_compress is set",
+       GLOBAL_VAR(opt_log_bin_compress_min_len), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(10, 1024*1024), DEFAULT(256), BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_trust_function_creators(
        "log_bin_trust_function_creators",
        "If set to FALSE (the default), then when --log-bin is used, creation "
@@ -1240,6 +1255,16 @@ static Sys_var_ulong Sys_slave_max_allowed_packet(
        DEFAULT(MAX_MAX_ALLOWED_PACKET),
        BLOCK_SIZE(1024));
 
+static Sys_var_ulong Sys_binlog_dump_cache_size(
+       "binlog_dump_cache_size",
+       "Size of the in-memory copy of the end of the active binary log that "
+       "is shared by all binlog dump threads, so that slaves that are "
+       "close to the master don't each read the binlog file. "
+       "0 disables the cache",
+       GLOBAL_VAR(binlog_dump_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024*1024*1024), DEFAULT(1024*1024),
+       BLOCK_SIZE(IO_SIZE));
+
 static Sys_var_ulonglong Sys_max_binlog_cache_size(
        "max_binlog_cache_size",
        "Sets the total size of the transactional cache",
@@ -1336,6 +1361,22 @@ static Sys_var_ulonglong Sys_max_heap_table_size(
        VALID_RANGE(16384, (ulonglong)~(intptr)0), DEFAULT(16*1024*1024),
        BLOCK_SIZE(1024));
 
+static bool fix_mem_root_cache_size(sys_var *self, THD *thd,
+                                    enum_var_type type)
+{
+  trim_mem_root_cache();
+  return false;
+}
+static Sys_var_ulong Sys_mem_root_cache_size(
+       "mem_root_cache_size",
+       "Size of the cache of freed memory root blocks that are reused by "
+       "later statements and connections instead of being malloced again. "
+       "0 disables the cache",
+       GLOBAL_VAR(my_mem_root_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(8*1024*1024), BLOCK_SIZE(1024),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_mem_root_cache_size));
+
 static Sys_var_ulong Sys_metadata_locks_cache_size(
        "metadata_locks_cache_size", "Size of unused metadata locks cache",
        READ_ONLY GLOBAL_VAR(mdl_locks_cache_size), CMD_LINE(REQUIRED_ARG),
@@ -1590,6 +1631,16 @@ static Sys_var_mybool Sys_gtid_strict_mode(
        CMD_LINE(OPT_ARG), DEFAULT(FALSE));
 
 
+static Sys_var_ulong Sys_gtid_cleanup_batch_size(
+       "gtid_cleanup_batch_size",
+       "Number of old rows that may accumulate in mysql.gtid_slave_pos for "
+       "each replication domain before they are deleted in one batch. "
+       "Larger values mean fewer, bigger deletes on the slave at the cost "
+       "of a larger table. 0 deletes old rows on every transaction",
+       GLOBAL_VAR(opt_gtid_cleanup_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, UINT_MAX32), DEFAULT(64), BLOCK_SIZE(1));
+
+
 struct gtid_binlog_state_data { rpl_gtid *list; uint32 list_len; };
 
 bool
@@ -2285,6 +2336,23 @@ static Sys_var_ulong Sys_multi_range_count(
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0), ON_UPDATE(0),
        DEPRECATED("'@@mrr_buffer_size'"));
 
+#if defined(MY_PTHREAD_FASTMUTEX) && !defined(SAFE_MUTEX)
+static Sys_var_uint Sys_mutex_spin_loops(
+       "mutex_spin_loops",
+       "How many times a thread retries to get a busy server mutex before "
+       "it goes to sleep. 0 means sleep right away",
+       GLOBAL_VAR(my_fastmutex_spin_loops), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1000), DEFAULT(8), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_mutex_spin_delay(
+       "mutex_spin_delay",
+       "Initial delay between the retries of mutex_spin_loops, in units of "
+       "about 10 PAUSE instructions. The delay grows randomly with every "
+       "retry",
+       GLOBAL_VAR(my_fastmutex_spin_delay), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1000), DEFAULT(4), BLOCK_SIZE(1));
+#endif
+
 static bool fix_thd_mem_root(sys_var *self, THD *thd, enum_var_type type)
 {
   if (type != OPT_GLOBAL)
@@ -2613,6 +2681,14 @@ static Sys_var_set Slave_type_conversions(
        slave_type_conversions_name,
        DEFAULT(0));
 
+static Sys_var_mybool Sys_slave_rows_hash_scan(
+       "slave_rows_hash_scan",
+       "When applying an UPDATE or DELETE row event to a table without a "
+       "usable index, locate all rows of the event with a single table scan "
+       "instead of scanning the table once per row",
+       GLOBAL_VAR(opt_slave_rows_hash_scan), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE));
+
 static Sys_var_mybool Sys_slave_sql_verify_checksum(
        "slave_sql_verify_checksum",
        "Force checksum verification of replication events after reading them "
@@ -3839,6 +3915,15 @@ static Sys_var_charptr Sys_relay_log_info_file(
        READ_ONLY GLOBAL_VAR(relay_log_info_file), CMD_LINE(REQUIRED_ARG),
        IN_FS_CHARSET, DEFAULT(0));
 
+static Sys_var_ulong Sys_relay_log_batch_size(
+       "relay_log_batch_size",
+       "While more events from the master are already waiting to be read, "
+       "the slave I/O thread appends up to this many bytes of them to the "
+       "relay log before flushing it and waking up the SQL thread. "
+       "0 flushes the relay log after every event",
+       GLOBAL_VAR(relay_log_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024L*1024*1024), DEFAULT(64*1024), BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_relay_log_purge(
        "relay_log_purge", "if disabled - do not purge relay logs. "
        "if enabled - purge them as soon as they are no more needed",
@@ -3807,16 +3807,16 @@ bool TABLE_SHARE::visit_subgraph(Wait_for_flush *wait_for_flush,
   bool result= TRUE;
 
   /*
-    To protect used_tables list from being concurrently modified
-    while we are iterating through it we acquire LOCK_open.
-    This does not introduce deadlocks in the deadlock detector
-    because we won't try to acquire LOCK_open while
-    holding a write-lock on MDL_lock::m_rwlock.
+    To protect all_tables list and TABLE::in_use from being concurrently
+    modified while we are iterating through it we lock all table cache
+    instances. This does not introduce deadlocks in the deadlock detector
+    because we won't try to acquire those locks while holding a write-lock
+    on MDL_lock::m_rwlock.
   */
-  if (gvisitor->m_lock_open_count++ == 0)
-    mysql_mutex_lock(&LOCK_open);
+  if (gvisitor->m_tc_lock_count++ == 0)
+    tc_lock_all();
 
-  TABLE_list::Iterator tables_it(tdc.used_tables);
+  All_share_tables_list::Iterator tables_it(tdc->all_tables);
 
   /*
     In case of multiple searches running in parallel, avoid going
@@ -3834,7 +3834,7 @@ bool TABLE_SHARE::visit_subgraph(Wait_for_flush *wait_for_flush,
 
   while ((table= tables_it++))
   {
-    if (gvisitor->inspect_edge(&table->in_use->mdl_context))
+    if (table->in_use && gvisitor->inspect_edge(&table->in_use->mdl_context))
     {
       goto end_leave_node;
     }
@@ -3843,7 +3843,7 @@ bool TABLE_SHARE::visit_subgraph(Wait_for_flush *wait_for_flush,
   tables_it.rewind();
   while ((table= tables_it++))
   {
-    if (table->in_use->mdl_context.visit_subgraph(gvisitor))
+    if (table->in_use && table->in_use->mdl_context.visit_subgraph(gvisitor))
     {
       goto end_leave_node;
     }
@@ -3855,8 +3855,8 @@ end_leave_node:
   gvisitor->leave_node(src_ctx);
 
 end:
-  if (gvisitor->m_lock_open_count-- == 1)
-    mysql_mutex_unlock(&LOCK_open);
+  if (gvisitor->m_tc_lock_count-- == 1)
+    tc_unlock_all();
 
   return result;
 }
@@ -3864,7 +3864,7 @@ end:
 
 /**
   Wait until the subject share is removed from the table
-  definition cache and make sure it's destroyed.
+  definition cache.
 
   @param mdl_context     MDL context for thread which is going to wait.
   @param abstime         Timeout for waiting as absolute time value.
@@ -3891,14 +3891,14 @@ bool TABLE_SHARE::wait_for_old_version(THD *thd, struct timespec *abstime,
   Wait_for_flush ticket(mdl_context, this, deadlock_weight);
   MDL_wait::enum_wait_status wait_status;
 
-  mysql_mutex_assert_owner(&tdc.LOCK_table_share);
+  mysql_mutex_assert_owner(&tdc->LOCK_table_share);
   DBUG_ASSERT(has_old_version());
 
-  tdc.m_flush_tickets.push_front(&ticket);
+  tdc->m_flush_tickets.push_front(&ticket);
 
   mdl_context->m_wait.reset_status();
 
-  mysql_mutex_unlock(&tdc.LOCK_table_share);
+  mysql_mutex_unlock(&tdc->LOCK_table_share);
 
   mdl_context->will_wait_for(&ticket);
 
@@ -3909,34 +3909,18 @@ bool TABLE_SHARE::wait_for_old_version(THD *thd, struct timespec *abstime,
 
   mdl_context->done_waiting_for();
 
-  mysql_mutex_lock(&tdc.LOCK_table_share);
-
-  tdc.m_flush_tickets.remove(&ticket);
-
-  if (tdc.m_flush_tickets.is_empty() && tdc.ref_count == 0)
-  {
-    /*
-      If our thread was the last one using the share,
-      we must destroy it here.
-    */
-    mysql_mutex_unlock(&tdc.LOCK_table_share);
-    destroy();
-  }
-  else
-    mysql_mutex_unlock(&tdc.LOCK_table_share);
+  mysql_mutex_lock(&tdc->LOCK_table_share);
 
+  tdc->m_flush_tickets.remove(&ticket);
 
   /*
-    In cases when our wait was aborted by KILL statement,
-    a deadlock or a timeout, the share might still be referenced,
-    so we don't delete it. Note, that we can't determine this
-    condition by checking wait_status alone, since, for example,
-    a timeout can happen after all references to the table share
-    were released, but before the share is removed from the
-    cache and we receive the notification. This is why
-    we first destroy the share, and then look at
-    wait_status.
+    If the share is being destroyed, the thread doing it waits for all
+    flush tickets to be removed.
   */
+  if (tdc->m_flush_tickets.is_empty())
+    mysql_cond_broadcast(&tdc->COND_release);
+  mysql_mutex_unlock(&tdc->LOCK_table_share);
+
   switch (wait_status)
   {
   case MDL_wait::GRANTED:
@@ -3969,7 +3953,7 @@ bool TABLE_SHARE::wait_for_old_version(THD *thd, struct timespec *abstime,
 
 void TABLE::init(THD *thd, TABLE_LIST *tl)
 {
-  DBUG_ASSERT(s->tdc.ref_count > 0 || s->tmp_table != NO_TMP_TABLE);
+  DBUG_ASSERT(s->tmp_table != NO_TMP_TABLE || s->tdc->ref_count > 0);
 
   if (thd->lex->need_correct_ident())
     alias_name_used= my_strcasecmp(table_alias_charset,
@@ -479,6 +479,8 @@ TABLE_CATEGORY get_table_category(const LEX_STRING *db,
 
 
 struct TABLE_share;
+struct All_share_tables;
+struct TDC_element;
 
 extern ulong tdc_refresh_version(void);
 
@@ -603,25 +605,12 @@ struct TABLE_SHARE
   mysql_mutex_t LOCK_share;             /* To protect TABLE_SHARE */
 
   typedef I_P_List <TABLE, TABLE_share> TABLE_list;
-  struct
-  {
-    /**
-      Protects ref_count and m_flush_tickets.
-    */
-    mysql_mutex_t LOCK_table_share;
-    TABLE_SHARE *next, **prev;            /* Link to unused shares */
-    uint ref_count;                       /* How many TABLE objects uses this */
-    /**
-      List of tickets representing threads waiting for the share to be flushed.
-    */
-    Wait_for_flush_list m_flush_tickets;
-    /*
-      Doubly-linked (back-linked) lists of used and unused TABLE objects
-      for this share.
-    */
-    TABLE_list used_tables;
-    TABLE_list free_tables;
-  } tdc;
+  typedef I_P_List <TABLE, All_share_tables> All_share_tables_list;
+  /*
+    Table definition cache entry of this share, 0 if the share is not
+    in the cache. See TDC_element in table_cache.h.
+  */
+  TDC_element *tdc;
 
   LEX_CUSTRING tabledef_version;
 
@@ -1009,13 +998,16 @@ struct TABLE
 
 private:
   /**
-     Links for the lists of used/unused TABLE objects for this share.
+     Links for the lists of unused TABLE objects and of all TABLE objects
+     for this share.
      Declared as private to avoid direct manipulation with those objects.
      One should use methods of I_P_List template instead.
   */
   TABLE *share_next, **share_prev;
+  TABLE *share_all_next, **share_all_prev;
 
   friend struct TABLE_share;
+  friend struct All_share_tables;
 
 public:
 
@@ -1363,7 +1355,7 @@ public:
 
 /**
    Helper class which specifies which members of TABLE are used for
-   participation in the list of used/unused TABLE objects for the share.
+   participation in the list of unused TABLE objects for the share.
 */
 
 struct TABLE_share
@@ -1379,6 +1371,24 @@ struct TABLE_share
 };
 
 
+/**
+   Helper class which specifies which members of TABLE are used for
+   participation in the list of all TABLE objects for the share.
+*/
+
+struct All_share_tables
+{
+  static inline TABLE **next_ptr(TABLE *l)
+  {
+    return &l->share_all_next;
+  }
+  static inline TABLE ***prev_ptr(TABLE *l)
+  {
+    return &l->share_all_prev;
+  }
+};
+
+
 enum enum_schema_table_state
 { 
   NOT_PROCESSED= 0,
@@ -42,82 +42,103 @@
   - alloc_table_share()
   - free_table_share()
 
+  Table definition cache lookups don't take any global lock: TDC_element
+  objects are kept in a lock-free hash and each has its own mutex. TABLE
+  objects are cached in several table cache instances, each with its own
+  mutex and LRU list of unused objects. A connection returns TABLE objects
+  to the instance selected by its thread id, so that connections mostly
+  don't contend for the same instance.
+
   Table cache invariants:
-  - TABLE_SHARE::used_tables shall not contain objects with TABLE::in_use == 0
-  - TABLE_SHARE::free_tables shall not contain objects with TABLE::in_use != 0
-  - unused_tables shall not contain objects with TABLE::in_use != 0
-  - cached TABLE object must be either in TABLE_SHARE::used_tables or in
-    TABLE_SHARE::free_tables
+  - TDC_element::free_tables shall not contain objects with TABLE::in_use != 0
+  - Table_cache_instance::unused_tables shall not contain objects with
+    TABLE::in_use != 0
+  - cached TABLE object must be in TDC_element::all_tables
+  - unused TABLE object must be in both TDC_element::free_tables and
+    Table_cache_instance::unused_tables of the same instance
+
+  Lock order:
+  - LOCK_table_cache of instances in ascending order, then
+    TDC_element::LOCK_table_share
+  - LOCK_unused_shares, then TDC_element::LOCK_table_share
 */
 
 #include "my_global.h"
-#include "hash.h"
+#include "lf.h"
 #include "table.h"
 #include "sql_base.h"
 
 /** Configuration. */
 ulong tdc_size; /**< Table definition cache threshold for LRU eviction. */
 ulong tc_size; /**< Table cache threshold for LRU eviction. */
+static uint tc_instances; /**< Number of table cache instances in use. */
 
 /** Data collections. */
-static HASH tdc_hash; /**< Collection of TABLE_SHARE objects. */
+static LF_HASH tdc_hash; /**< Collection of TDC_element objects. */
 /** Collection of unused TABLE_SHARE objects. */
-static TABLE_SHARE *oldest_unused_share, end_of_unused_share;
-TABLE *unused_tables; /**< Collection of unused TABLE objects. */
+static TDC_element *oldest_unused_share, end_of_unused_share;
 
-static int64 tdc_version;  /* Increments on each reload */ 
+static int64 tdc_version;  /* Increments on each reload */
 static int64 last_table_id;
 static bool tdc_inited;
 
-static uint tc_count; /**< Number of TABLE objects in table cache. */
+static int32 tc_count; /**< Number of TABLE objects in table cache. */
 
 
 /**
-  Protects used and unused lists in the TABLE_SHARE object,
-  LRU lists of used TABLEs.
+  Table cache instance.
 
-  tc_count
+  LOCK_table_cache protects
   unused_tables
-  TABLE::next
-  TABLE::prev
-  TABLE_SHARE::tdc.free_tables
-  TABLE_SHARE::tdc.used_tables
+  TABLE::next, TABLE::prev of unused TABLE objects of this instance
+  TABLE::in_use of TABLE objects released to this instance
+  TDC_element::free_tables[] of this instance
 */
 
-mysql_mutex_t LOCK_open;
+struct Table_cache_instance
+{
+  mysql_mutex_t LOCK_table_cache;
+  TABLE *unused_tables; /**< Collection of unused TABLE objects. */
+} MY_ALIGNED(64); /* Keep instances in separate cache lines */
+
+static Table_cache_instance tc[TC_MAX_INSTANCES];
 
 
 /**
   Protects unused shares list.
 
-  TABLE_SHARE::tdc.prev
-  TABLE_SHARE::tdc.next
+  TDC_element::prev
+  TDC_element::next
   oldest_unused_share
   end_of_unused_share
 */
 
 static mysql_mutex_t LOCK_unused_shares;
-static mysql_rwlock_t LOCK_tdc; /**< Protects tdc_hash. */
 static mysql_rwlock_t LOCK_flush; /**< Sync tc_purge() and tdc_remove_table(). */
-my_atomic_rwlock_t LOCK_tdc_atomics; /**< Protects tdc_version. */
+my_atomic_rwlock_t LOCK_tdc_atomics; /**< Protects tdc_version, tc_count. */
 
 #ifdef HAVE_PSI_INTERFACE
-static PSI_mutex_key key_LOCK_open, key_LOCK_unused_shares,
-                     key_TABLE_SHARE_LOCK_table_share;
+static PSI_mutex_key key_LOCK_table_cache, key_LOCK_unused_shares,
+                     key_TDC_element_LOCK_table_share;
 static PSI_mutex_info all_tc_mutexes[]=
 {
-  { &key_LOCK_open, "LOCK_open", PSI_FLAG_GLOBAL },
+  { &key_LOCK_table_cache, "LOCK_table_cache", 0 },
   { &key_LOCK_unused_shares, "LOCK_unused_shares", PSI_FLAG_GLOBAL },
-  { &key_TABLE_SHARE_LOCK_table_share, "TABLE_SHARE::tdc.LOCK_table_share", 0 }
+  { &key_TDC_element_LOCK_table_share, "TDC_element::LOCK_table_share", 0 }
 };
 
-static PSI_rwlock_key key_rwlock_LOCK_tdc, key_rwlock_LOCK_flush;
+static PSI_rwlock_key key_rwlock_LOCK_flush;
 static PSI_rwlock_info all_tc_rwlocks[]=
 {
-  { &key_rwlock_LOCK_tdc, "LOCK_tdc", PSI_FLAG_GLOBAL },
   { &key_rwlock_LOCK_flush, "LOCK_flush", PSI_FLAG_GLOBAL }
 };
 
+static PSI_cond_key key_TDC_element_COND_release;
+static PSI_cond_info all_tc_conds[]=
+{
+  { &key_TDC_element_COND_release, "TDC_element::COND_release", 0 }
+};
+
 
 static void init_tc_psi_keys(void)
 {
@@ -129,13 +150,16 @@ static void init_tc_psi_keys(void)
 
   count= array_elements(all_tc_rwlocks);
   mysql_rwlock_register(category, all_tc_rwlocks, count);
+
+  count= array_elements(all_tc_conds);
+  mysql_cond_register(category, all_tc_conds, count);
 }
 #endif
 
 
 /*
-  Auxiliary routines for manipulating with per-share used/unused and
-  global unused lists of TABLE objects and tc_count counter.
+  Auxiliary routines for manipulating with per-share all/unused and
+  per-instance unused lists of TABLE objects and tc_count counter.
   Responsible for preserving invariants between those lists, counter
   and TABLE::in_use member.
   In fact those routines implement sort of implicit table cache as
@@ -144,14 +168,152 @@ static void init_tc_psi_keys(void)
 
 
 /**
-  Get number of TABLE objects (used and unused) in table cache.
+  Get table cache instance which connection releases TABLE objects to.
+*/
 
-  @todo Protect tc_count so it is read atomically.
+static inline uint tc_instance(THD *thd)
+{
+  return (uint) (thd->thread_id % tc_instances);
+}
+
+
+/**
+  Get number of TABLE objects (used and unused) in table cache.
 */
 
 uint tc_records(void)
 {
-  return tc_count;
+  uint count;
+  my_atomic_rwlock_rdlock(&LOCK_tdc_atomics);
+  count= my_atomic_load32(&tc_count);
+  my_atomic_rwlock_rdunlock(&LOCK_tdc_atomics);
+  return count;
+}
+
+
+/**
+  Add to number of TABLE objects in table cache.
+
+  @return Number of TABLE objects after the change.
+*/
+
+static uint tc_count_add(int32 count)
+{
+  int32 old_count;
+  my_atomic_rwlock_wrlock(&LOCK_tdc_atomics);
+  old_count= my_atomic_add32(&tc_count, count);
+  my_atomic_rwlock_wrunlock(&LOCK_tdc_atomics);
+  return (uint) (old_count + count);
+}
+
+
+/**
+  Lock all table cache instances.
+
+  While all instances are locked no TABLE object can be acquired,
+  released, added to or removed from table cache, so that
+  TDC_element::all_tables and TABLE::in_use of cached objects are stable.
+*/
+
+void tc_lock_all(void)
+{
+  for (uint i= 0; i < tc_instances; i++)
+    mysql_mutex_lock(&tc[i].LOCK_table_cache);
+}
+
+
+/**
+  Unlock all table cache instances locked by tc_lock_all().
+*/
+
+void tc_unlock_all(void)
+{
+  for (uint i= 0; i < tc_instances; i++)
+    mysql_mutex_unlock(&tc[i].LOCK_table_cache);
+}
+
+
+/**
+  Free TABLE objects removed from table cache.
+
+  @pre LOCK_flush is read locked, objects are linked through TABLE::next
+  and are already removed from TDC_element::all_tables.
+*/
+
+static void tc_free_tables(TABLE *purge_tables)
+{
+  TABLE *table, *next;
+  for (table= purge_tables; table; table= next)
+  {
+    next= table->next;
+    intern_close_table(table);
+  }
+}
+
+
+/**
+  Remove unused TABLE object from table cache.
+
+  @pre LOCK_table_cache of the instance is locked, table is not used.
+
+  While locked:
+  - remove object from TDC_element::free_tables
+  - remove object from unused_tables of the instance
+  - remove object from TDC_element::all_tables
+
+  @note This is helper routine, supposed to be used by table cache
+  methods only.
+*/
+
+static void tc_remove_table(TABLE *table, uint instance)
+{
+  Table_cache_instance *tci= &tc[instance];
+  TDC_element *element= table->s->tdc;
+  mysql_mutex_assert_owner(&tci->LOCK_table_cache);
+  DBUG_ASSERT(!table->in_use);
+  /* Remove from per-share chain of unused TABLE objects. */
+  element->free_tables[instance].remove(table);
+
+  /* And instance unused chain. */
+  table->next->prev= table->prev;
+  table->prev->next= table->next;
+  if (table == tci->unused_tables)
+  {
+    tci->unused_tables= tci->unused_tables->next;
+    if (table == tci->unused_tables)
+      tci->unused_tables= 0;
+  }
+
+  mysql_mutex_lock(&element->LOCK_table_share);
+  element->all_tables.remove(table);
+  mysql_mutex_unlock(&element->LOCK_table_share);
+  tc_count_add(-1);
+}
+
+
+/**
+  Evict LRU object of instance if we reached table cache threshold.
+
+  @pre LOCK_table_cache of the instance is locked. It is unlocked
+  on return.
+*/
+
+static void tc_evict_and_unlock(uint instance)
+{
+  Table_cache_instance *tci= &tc[instance];
+  TABLE *purge_table;
+
+  if (tc_records() > tc_size && (purge_table= tci->unused_tables))
+  {
+    tc_remove_table(purge_table, instance);
+    purge_table->next= 0;
+    mysql_rwlock_rdlock(&LOCK_flush);
+    mysql_mutex_unlock(&tci->LOCK_table_cache);
+    tc_free_tables(purge_table);
+    mysql_rwlock_unlock(&LOCK_flush);
+  }
+  else
+    mysql_mutex_unlock(&tci->LOCK_table_cache);
 }
 
 
@@ -159,7 +321,7 @@ uint tc_records(void)
   Free all unused TABLE objects.
 
   While locked:
-  - remove unused objects from TABLE_SHARE::tdc.free_tables lists
+  - remove unused objects from TDC_element::free_tables lists
   - reset unused_tables
   - decrement tc_count
 
@@ -172,99 +334,66 @@ uint tc_records(void)
 
 void tc_purge(void)
 {
-  mysql_mutex_lock(&LOCK_open);
-  if (unused_tables)
+  for (uint i= 0; i < tc_instances; i++)
   {
-    TABLE *table= unused_tables, *next;
-    unused_tables->prev->next= 0;
-    do
+    Table_cache_instance *tci= &tc[i];
+    TABLE *purge_tables= 0;
+
+    mysql_mutex_lock(&tci->LOCK_table_cache);
+    while (tci->unused_tables)
     {
-      unused_tables->s->tdc.free_tables.remove(unused_tables);
-      tc_count--;
-    } while ((unused_tables= unused_tables->next));
+      TABLE *table= tci->unused_tables;
+      tc_remove_table(table, i);
+      table->next= purge_tables;
+      purge_tables= table;
+    }
     mysql_rwlock_rdlock(&LOCK_flush);
-    mysql_mutex_unlock(&LOCK_open);
+    mysql_mutex_unlock(&tci->LOCK_table_cache);
 
-    do
-    {
-      next= table->next;
-      intern_close_table(table);
-    } while ((table= next));
+    tc_free_tables(purge_tables);
     mysql_rwlock_unlock(&LOCK_flush);
   }
-  else
-    mysql_mutex_unlock(&LOCK_open);
 }
 
 
 /**
-  Verify consistency of used/unused lists (for debugging).
+  Verify consistency of unused lists (for debugging).
 */
 
 #ifdef EXTRA_DEBUG
-static void check_unused(THD *thd)
+static void check_unused(THD *thd __attribute__((unused)))
 {
-  uint count= 0, open_files= 0;
-  TABLE *cur_link, *start_link, *entry;
-  TABLE_SHARE *share;
-  TDC_iterator tdc_it;
-
-  tdc_it.init();
-  mysql_mutex_lock(&LOCK_open);
-  if ((start_link=cur_link=unused_tables))
-  {
-    do
-    {
-      if (cur_link != cur_link->next->prev || cur_link != cur_link->prev->next)
-      {
-	DBUG_PRINT("error",("Unused_links aren't linked properly")); /* purecov: inspected */
-	return; /* purecov: inspected */
-      }
-    } while (count++ < tc_count &&
-	     (cur_link=cur_link->next) != start_link);
-    if (cur_link != start_link)
-    {
-      DBUG_PRINT("error",("Unused_links aren't connected")); /* purecov: inspected */
-    }
-  }
-  while ((share= tdc_it.next()))
+  for (uint i= 0; i < tc_instances; i++)
   {
-    TABLE_SHARE::TABLE_list::Iterator it(share->tdc.free_tables);
-    while ((entry= it++))
-    {
-      /*
-        We must not have TABLEs in the free list that have their file closed.
-      */
-      DBUG_ASSERT(entry->db_stat && entry->file);
-      /* Merge children should be detached from a merge parent */
-      if (entry->in_use)
-      {
-        DBUG_PRINT("error",("Used table is in share's list of unused tables")); /* purecov: inspected */
-      }
-      /* extra() may assume that in_use is set */
-      entry->in_use= thd;
-      DBUG_ASSERT(!thd || !entry->file->extra(HA_EXTRA_IS_ATTACHED_CHILDREN));
-      entry->in_use= 0;
+    uint count= 0;
+    TABLE *cur_link, *start_link;
 
-      count--;
-      open_files++;
-    }
-    it.init(share->tdc.used_tables);
-    while ((entry= it++))
+    mysql_mutex_lock(&tc[i].LOCK_table_cache);
+    if ((start_link= cur_link= tc[i].unused_tables))
     {
-      if (!entry->in_use)
+      do
+      {
+        if (cur_link != cur_link->next->prev ||
+            cur_link != cur_link->prev->next)
+        {
+          DBUG_PRINT("error",("Unused_links aren't linked properly")); /* purecov: inspected */
+          break; /* purecov: inspected */
+        }
+        /* We must not have TABLEs in the free list that are in use. */
+        if (cur_link->in_use)
+        {
+          DBUG_PRINT("error",("Used table is in list of unused tables")); /* purecov: inspected */
+        }
+        /* We must not have TABLEs in the free list that have their file closed. */
+        DBUG_ASSERT(cur_link->db_stat && cur_link->file);
+      } while (count++ < tc_records() &&
+               (cur_link= cur_link->next) != start_link);
+      if (cur_link != start_link)
       {
-        DBUG_PRINT("error",("Unused table is in share's list of used tables")); /* purecov: inspected */
+        DBUG_PRINT("error",("Unused_links aren't connected")); /* purecov: inspected */
       }
-      open_files++;
     }
-  }
-  mysql_mutex_unlock(&LOCK_open);
-  tdc_it.deinit();
-  if (count != 0)
-  {
-    DBUG_PRINT("error",("Unused_links doesn't match open_cache: diff: %d", /* purecov: inspected */
-                       count)); /* purecov: inspected */
+    mysql_mutex_unlock(&tc[i].LOCK_table_cache);
   }
 }
 #else
@@ -272,39 +401,6 @@ static void check_unused(THD *thd)
 #endif
 
 
-/**
-  Remove unused TABLE object from table cache.
-
-  @pre LOCK_open is locked, table is not used.
-
-  While locked:
-  - remove object from TABLE_SHARE::tdc.free_tables
-  - remove object from unused_tables
-
-  @note This is helper routine, supposed to be used by table cache
-  methods only.
-*/
-
-static void tc_remove_table(TABLE *table)
-{
-  mysql_mutex_assert_owner(&LOCK_open);
-  DBUG_ASSERT(!table->in_use);
-  /* Remove from per-share chain of unused TABLE objects. */
-  table->s->tdc.free_tables.remove(table);
-
-  /* And global unused chain. */
-  table->next->prev= table->prev;
-  table->prev->next= table->next;
-  if (table == unused_tables)
-  {
-    unused_tables= unused_tables->next;
-    if (table == unused_tables)
-      unused_tables= 0;
-  }
-  tc_count--;
-}
-
-
 /**
   Add new TABLE object to table cache.
 
@@ -313,81 +409,82 @@ static void tc_remove_table(TABLE *table)
   Added object cannot be evicted or acquired.
 
   While locked:
-  - add object to TABLE_SHARE::tdc.used_tables
+  - add object to TDC_element::all_tables
   - increment tc_count
   - evict LRU object from table cache if we reached threshold
 
-  While unlocked: 
+  While unlocked:
   - free evicted object
 */
 
 void tc_add_table(THD *thd, TABLE *table)
 {
+  uint i= tc_instance(thd);
+  TDC_element *element= table->s->tdc;
   DBUG_ASSERT(table->in_use == thd);
-  mysql_mutex_lock(&LOCK_open);
-  table->s->tdc.used_tables.push_front(table);
-  tc_count++;
+
+  mysql_mutex_lock(&tc[i].LOCK_table_cache);
+  mysql_mutex_lock(&element->LOCK_table_share);
+  element->all_tables.push_front(table);
+  mysql_mutex_unlock(&element->LOCK_table_share);
+  tc_count_add(1);
   /* If we have too many TABLE instances around, try to get rid of them */
-  if (tc_count > tc_size && unused_tables)
-  {
-    TABLE *purge_table= unused_tables;
-    tc_remove_table(purge_table);
-    mysql_rwlock_rdlock(&LOCK_flush);
-    mysql_mutex_unlock(&LOCK_open);
-    intern_close_table(purge_table);
-    mysql_rwlock_unlock(&LOCK_flush);
-    check_unused(thd);
-  }
-  else
-    mysql_mutex_unlock(&LOCK_open);
+  tc_evict_and_unlock(i);
+  check_unused(thd);
 }
 
 
 /**
   Acquire TABLE object from table cache.
 
-  @pre share must be protected against removal.
+  @pre element must be protected against removal.
 
   Acquired object cannot be evicted or acquired again.
 
+  Instance of the connection is tried first, then all other instances.
+
   While locked:
-  - pop object from TABLE_SHARE::tdc.free_tables()
-  - remove share protection
-  - remove object from unused_tables
-  - add object to TABLE_SHARE::tdc.used_tables()
+  - pop object from TDC_element::free_tables[]
+  - remove object from unused_tables of the instance
   - mark object used by thd
 
-  @note share protection is kept if there are no unused objects.
-
   @return TABLE object, or NULL if no unused objects.
 */
 
-static TABLE *tc_acquire_table(THD *thd, TABLE_SHARE *share)
+static TABLE *tc_acquire_table(THD *thd, TDC_element *element)
 {
-  TABLE *table;
+  uint i= tc_instance(thd);
+  TABLE *table= 0;
 
-  mysql_mutex_lock(&LOCK_open);
-  if (!(table= share->tdc.free_tables.pop_front()))
+  for (uint n= 0; n < tc_instances; n++, i= (i + 1) % tc_instances)
   {
-    mysql_mutex_unlock(&LOCK_open);
-    return 0;
-  }
-  mysql_rwlock_unlock(&LOCK_tdc);
-  DBUG_ASSERT(!table->in_use);
+    Table_cache_instance *tci= &tc[i];
 
-  /* Unlink table from global unused tables list. */
-  if (table == unused_tables)
-  {                                             // First unused
-    unused_tables=unused_tables->next;	        // Remove from link
-    if (table == unused_tables)
-      unused_tables=0;
+    /* Peek without lock: skip instances which have no objects for us. */
+    if (n && element->free_tables[i].is_empty())
+      continue;
+
+    mysql_mutex_lock(&tci->LOCK_table_cache);
+    if ((table= element->free_tables[i].pop_front()))
+    {
+      DBUG_ASSERT(!table->in_use);
+      /* Unlink table from unused tables list of the instance. */
+      if (table == tci->unused_tables)
+      {                                           // First unused
+        tci->unused_tables= tci->unused_tables->next; // Remove from link
+        if (table == tci->unused_tables)
+          tci->unused_tables= 0;
+      }
+      table->prev->next= table->next;             /* Remove from unused list */
+      table->next->prev= table->prev;
+      table->in_use= thd;
+      mysql_mutex_unlock(&tci->LOCK_table_cache);
+      break;
+    }
+    mysql_mutex_unlock(&tci->LOCK_table_cache);
   }
-  table->prev->next=table->next;		/* Remove from unused list */
-  table->next->prev=table->prev;
-  table->in_use= thd;
-  /* Add table to list of used tables for this share. */
-  table->s->tdc.used_tables.push_front(table);
-  mysql_mutex_unlock(&LOCK_open);
+  if (!table)
+    return 0;
 
   /* The ex-unused table must be fully functional. */
   DBUG_ASSERT(table->db_stat && table->file);
@@ -407,19 +504,19 @@ static TABLE *tc_acquire_table(THD *thd, TABLE_SHARE *share)
 
   While locked:
   - mark object not in use by any thread
-  - remove object from TABLE_SHARE::tdc.used_tables
-  - if object is marked for purge, decrement tc_count
-  - add object to TABLE_SHARE::tdc.free_tables
-  - add object to unused_tables
-  - evict LRU object from table cache if we reached threshold
+  - if object is marked for purge, remove it from TDC_element::all_tables
+    and decrement tc_count
+  - add object to TDC_element::free_tables[] of the instance
+  - add object to unused_tables of the instance
+  - evict LRU object of the instance if we reached threshold
 
-  While unlocked: 
+  While unlocked:
   - free evicted/purged object
 
   @note Another thread may mark share for purge any moment (even
   after version check). It means to-be-purged object may go to
   unused lists. This other thread is expected to call tc_purge(),
-  which is synchronized with us on LOCK_open.
+  which is synchronized with us on LOCK_table_cache.
 
   @return
     @retval true  object purged
@@ -428,50 +525,44 @@ static TABLE *tc_acquire_table(THD *thd, TABLE_SHARE *share)
 
 bool tc_release_table(TABLE *table)
 {
-  THD *thd __attribute__((unused))= table->in_use;
+  THD *thd= table->in_use;
+  uint i= tc_instance(thd);
+  Table_cache_instance *tci= &tc[i];
   DBUG_ASSERT(table->in_use);
   DBUG_ASSERT(table->file);
 
-  mysql_mutex_lock(&LOCK_open);
-  /* Remove table from the list of tables used in this share. */
-  table->s->tdc.used_tables.remove(table);
+  mysql_mutex_lock(&tci->LOCK_table_cache);
   table->in_use= 0;
   if (table->s->has_old_version() || table->needs_reopen() || !tdc_size)
   {
-    tc_count--;
+    TDC_element *element= table->s->tdc;
+    mysql_mutex_lock(&element->LOCK_table_share);
+    element->all_tables.remove(table);
+    mysql_mutex_unlock(&element->LOCK_table_share);
+    tc_count_add(-1);
     mysql_rwlock_rdlock(&LOCK_flush);
-    mysql_mutex_unlock(&LOCK_open);
+    mysql_mutex_unlock(&tci->LOCK_table_cache);
     intern_close_table(table);
     mysql_rwlock_unlock(&LOCK_flush);
     return true;
   }
   /* Add table to the list of unused TABLE objects for this share. */
-  table->s->tdc.free_tables.push_front(table);
-  /* Also link it last in the global list of unused TABLE objects. */
-  if (unused_tables)
+  table->s->tdc->free_tables[i].push_front(table);
+  /* Also link it last in the list of unused TABLE objects of the instance. */
+  if (tci->unused_tables)
   {
-    table->next=unused_tables;
-    table->prev=unused_tables->prev;
-    unused_tables->prev=table;
-    table->prev->next=table;
+    table->next= tci->unused_tables;
+    table->prev= tci->unused_tables->prev;
+    tci->unused_tables->prev= table;
+    table->prev->next= table;
   }
   else
-    unused_tables=table->next=table->prev=table;
+    tci->unused_tables= table->next= table->prev= table;
   /*
     We free the least used table, not the subject table,
     to keep the LRU order.
   */
-  if (tc_count > tc_size)
-  {
-    TABLE *purge_table= unused_tables;
-    tc_remove_table(purge_table);
-    mysql_rwlock_rdlock(&LOCK_flush);
-    mysql_mutex_unlock(&LOCK_open);
-    intern_close_table(purge_table);
-    mysql_rwlock_unlock(&LOCK_flush);
-  }
-  else
-    mysql_mutex_unlock(&LOCK_open);
+  tc_evict_and_unlock(i);
   check_unused(thd);
   return false;
 }
@@ -480,58 +571,139 @@ bool tc_release_table(TABLE *table)
 extern "C" uchar *tdc_key(const uchar *record, size_t *length,
                           my_bool not_used __attribute__((unused)))
 {
-  TABLE_SHARE *entry= (TABLE_SHARE*) record;
-  *length= entry->table_cache_key.length;
-  return (uchar*) entry->table_cache_key.str;
+  TDC_element *element= (TDC_element*) record;
+  *length= element->m_key_length;
+  return (uchar*) element->m_key;
+}
+
+
+/**
+  Initialize TDC_element when its memory is allocated by tdc_hash.
+*/
+
+static void lf_alloc_constructor(uchar *arg)
+{
+  TDC_element *element= (TDC_element*) (arg + LF_HASH_OVERHEAD);
+  DBUG_ENTER("lf_alloc_constructor");
+  mysql_mutex_init(key_TDC_element_LOCK_table_share,
+                   &element->LOCK_table_share, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_TDC_element_COND_release, &element->COND_release, 0);
+  element->m_flush_tickets.empty();
+  element->all_tables.empty();
+  for (uint i= 0; i < TC_MAX_INSTANCES; i++)
+    element->free_tables[i].empty();
+  element->next= 0;
+  element->prev= 0;
+  element->ref_count= 0;
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Deinitialize TDC_element when its memory is freed by tdc_hash.
+*/
+
+static void lf_alloc_destructor(uchar *arg)
+{
+  TDC_element *element= (TDC_element*) (arg + LF_HASH_OVERHEAD);
+  DBUG_ENTER("lf_alloc_destructor");
+  DBUG_ASSERT(element->ref_count == 0);
+  DBUG_ASSERT(element->m_flush_tickets.is_empty());
+  DBUG_ASSERT(element->all_tables.is_empty());
+  mysql_cond_destroy(&element->COND_release);
+  mysql_mutex_destroy(&element->LOCK_table_share);
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Get pins for accessing tdc_hash.
+
+  Connections keep their pins in THD, other threads get temporary ones
+  which must be returned with tdc_put_pins().
+
+  @return pins, or 0 if out of memory.
+*/
+
+static LF_PINS *tdc_get_pins(THD *thd)
+{
+  if (!thd)
+    return lf_hash_get_pins(&tdc_hash);
+  if (unlikely(!thd->tdc_hash_pins))
+    thd->tdc_hash_pins= lf_hash_get_pins(&tdc_hash);
+  return thd->tdc_hash_pins;
+}
+
+
+static void tdc_put_pins(THD *thd, LF_PINS *pins)
+{
+  if (!thd)
+    lf_hash_put_pins(pins);
 }
 
 
 /**
   Delete share from hash and free share object.
 
+  @pre LOCK_table_share of the element is locked, caller holds reference
+  to the share. Lock is released and the reference is dropped on return.
+
+  If there are threads waiting for the share to be flushed, they are
+  notified and we wait until they are gone before destroying the share.
+
   @return
     @retval 0 Success
     @retval 1 Share is referenced
 */
 
-static int tdc_delete_share_from_hash(TABLE_SHARE *share)
+static int tdc_delete_share_from_hash(TDC_element *element)
 {
+  THD *thd= current_thd;
+  TABLE_SHARE *share;
+  LF_PINS *pins;
+  char key[MAX_DBKEY_LENGTH];
+  uint key_length;
   DBUG_ENTER("tdc_delete_share_from_hash");
-  mysql_rwlock_wrlock(&LOCK_tdc);
-  mysql_mutex_lock(&share->tdc.LOCK_table_share);
-  if (--share->tdc.ref_count)
+  mysql_mutex_assert_owner(&element->LOCK_table_share);
+
+  if (--element->ref_count)
   {
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-    mysql_rwlock_unlock(&LOCK_tdc);
+    mysql_mutex_unlock(&element->LOCK_table_share);
     DBUG_RETURN(1);
   }
-  my_hash_delete(&tdc_hash, (uchar*) share);
+  share= element->share;
+  DBUG_ASSERT(share);
+  /* Concurrent lookups will see the share is gone and retry. */
+  element->share= 0;
   /* Notify PFS early, while still locked. */
   PSI_CALL_release_table_share(share->m_psi);
   share->m_psi= 0;
-  mysql_rwlock_unlock(&LOCK_tdc);
 
-  if (share->tdc.m_flush_tickets.is_empty())
-  {
-    /* No threads are waiting for this share to be flushed, destroy it. */
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-    free_table_share(share);
-  }
-  else
+  if (!element->m_flush_tickets.is_empty())
   {
-    Wait_for_flush_list::Iterator it(share->tdc.m_flush_tickets);
+    Wait_for_flush_list::Iterator it(element->m_flush_tickets);
     Wait_for_flush *ticket;
     while ((ticket= it++))
       (void) ticket->get_ctx()->m_wait.set_status(MDL_wait::GRANTED);
-    /*
-      If there are threads waiting for this share to be flushed,
-      the last one to receive the notification will destroy the
-      share. At this point the share is removed from the table
-      definition cache, so is OK to proceed here without waiting
-      for this thread to do the work.
-    */
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+
+    do
+    {
+      mysql_cond_wait(&element->COND_release, &element->LOCK_table_share);
+    } while (!element->m_flush_tickets.is_empty());
   }
+
+  key_length= element->m_key_length;
+  memcpy(key, element->m_key, key_length);
+  mysql_mutex_unlock(&element->LOCK_table_share);
+
+  if ((pins= tdc_get_pins(thd)))
+  {
+    lf_hash_delete(&tdc_hash, pins, key, key_length);
+    tdc_put_pins(thd, pins);
+  }
+  else
+    DBUG_ASSERT(0);
+  free_table_share(share);
   DBUG_RETURN(0);
 }
 
@@ -550,23 +722,28 @@ int tdc_init(void)
   init_tc_psi_keys();
 #endif
   tdc_inited= true;
-  mysql_mutex_init(key_LOCK_open, &LOCK_open, MY_MUTEX_INIT_FAST);
-  mysql_mutex_record_order(&LOCK_active_mi, &LOCK_open);
-  /*
-    We must have LOCK_open before LOCK_global_system_variables because
-    LOCK_open is held while sql_plugin.cc::intern_sys_var_ptr() is called.
-  */
-  mysql_mutex_record_order(&LOCK_open, &LOCK_global_system_variables);
+  tc_instances= MY_MIN(MY_MAX(my_getncpus(), 1), TC_MAX_INSTANCES);
+  for (uint i= 0; i < tc_instances; i++)
+  {
+    mysql_mutex_init(key_LOCK_table_cache, &tc[i].LOCK_table_cache,
+                     MY_MUTEX_INIT_FAST);
+    mysql_mutex_record_order(&LOCK_active_mi, &tc[i].LOCK_table_cache);
+    tc[i].unused_tables= 0;
+  }
   mysql_mutex_init(key_LOCK_unused_shares, &LOCK_unused_shares,
                    MY_MUTEX_INIT_FAST);
-  mysql_rwlock_init(key_rwlock_LOCK_tdc, &LOCK_tdc);
   mysql_rwlock_init(key_rwlock_LOCK_flush, &LOCK_flush);
   my_atomic_rwlock_init(&LOCK_tdc_atomics);
   oldest_unused_share= &end_of_unused_share;
-  end_of_unused_share.tdc.prev= &oldest_unused_share;
+  end_of_unused_share.prev= &oldest_unused_share;
   tdc_version= 1L;  /* Increments on each reload */
-  DBUG_RETURN(my_hash_init(&tdc_hash, &my_charset_bin, tdc_size, 0, 0, tdc_key,
-                           0, 0));
+  lf_hash_init(&tdc_hash, sizeof(TDC_element), LF_HASH_UNIQUE, 0, 0, tdc_key,
+               &my_charset_bin);
+  tdc_hash.alloc.constructor= lf_alloc_constructor;
+  tdc_hash.alloc.destructor= lf_alloc_destructor;
+  /* Only the key and share are copied in by lf_hash_insert() */
+  tdc_hash.element_size= my_offsetof(TDC_element, LOCK_table_share);
+  DBUG_RETURN(0);
 }
 
 
@@ -605,12 +782,12 @@ void tdc_deinit(void)
   if (tdc_inited)
   {
     tdc_inited= false;
-    my_hash_free(&tdc_hash);
+    lf_hash_destroy(&tdc_hash);
     my_atomic_rwlock_destroy(&LOCK_tdc_atomics);
     mysql_rwlock_destroy(&LOCK_flush);
-    mysql_rwlock_destroy(&LOCK_tdc);
     mysql_mutex_destroy(&LOCK_unused_shares);
-    mysql_mutex_destroy(&LOCK_open);
+    for (uint i= 0; i < tc_instances; i++)
+      mysql_mutex_destroy(&tc[i].LOCK_table_cache);
   }
   DBUG_VOID_RETURN;
 }
@@ -624,51 +801,35 @@ void tdc_deinit(void)
 
 ulong tdc_records(void)
 {
-  ulong records;
-  DBUG_ENTER("tdc_records");
-  mysql_rwlock_rdlock(&LOCK_tdc);
-  records= tdc_hash.records;
-  mysql_rwlock_unlock(&LOCK_tdc);
-  DBUG_RETURN(records);
+  return my_atomic_load32(&tdc_hash.count);
 }
 
 
 void tdc_purge(bool all)
 {
   DBUG_ENTER("tdc_purge");
-  for (;;)
+  while (all || tdc_records() > tdc_size)
   {
-    TABLE_SHARE *share;
-    if (!all)
-    {
-      mysql_rwlock_rdlock(&LOCK_tdc);
-      if (tdc_hash.records <= tdc_size)
-      {
-        mysql_rwlock_unlock(&LOCK_tdc);
-        break;
-      }
-      mysql_rwlock_unlock(&LOCK_tdc);
-    }
+    TDC_element *element;
 
     mysql_mutex_lock(&LOCK_unused_shares);
-    if (!oldest_unused_share->tdc.next)
+    if (!oldest_unused_share->next)
     {
       mysql_mutex_unlock(&LOCK_unused_shares);
       break;
     }
 
-    share= oldest_unused_share;
-    *share->tdc.prev= share->tdc.next;
-    share->tdc.next->tdc.prev= share->tdc.prev;
+    element= oldest_unused_share;
+    *element->prev= element->next;
+    element->next->prev= element->prev;
     /* Concurrent thread may start using share again, reset prev and next. */
-    share->tdc.prev= 0;
-    share->tdc.next= 0;
-    mysql_mutex_lock(&share->tdc.LOCK_table_share);
-    share->tdc.ref_count++;
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+    element->prev= 0;
+    element->next= 0;
+    mysql_mutex_lock(&element->LOCK_table_share);
+    element->ref_count++;
     mysql_mutex_unlock(&LOCK_unused_shares);
 
-    tdc_delete_share_from_hash(share);
+    tdc_delete_share_from_hash(element);
   }
   DBUG_VOID_RETURN;
 }
@@ -681,11 +842,7 @@ void tdc_purge(bool all)
 void tdc_init_share(TABLE_SHARE *share)
 {
   DBUG_ENTER("tdc_init_share");
-  mysql_mutex_init(key_TABLE_SHARE_LOCK_table_share,
-                   &share->tdc.LOCK_table_share, MY_MUTEX_INIT_FAST);
-  share->tdc.m_flush_tickets.empty();
-  share->tdc.used_tables.empty();
-  share->tdc.free_tables.empty();
+  share->tdc= 0;
   tdc_assign_new_table_id(share);
   share->version= tdc_refresh_version();
   DBUG_VOID_RETURN;
@@ -699,11 +856,7 @@ void tdc_init_share(TABLE_SHARE *share)
 void tdc_deinit_share(TABLE_SHARE *share)
 {
   DBUG_ENTER("tdc_deinit_share");
-  DBUG_ASSERT(share->tdc.ref_count == 0);
-  DBUG_ASSERT(share->tdc.m_flush_tickets.is_empty());
-  DBUG_ASSERT(share->tdc.used_tables.is_empty());
-  DBUG_ASSERT(share->tdc.free_tables.is_empty());
-  mysql_mutex_destroy(&share->tdc.LOCK_table_share);
+  DBUG_ASSERT(!share->tdc || share->tdc->share != share);
   DBUG_VOID_RETURN;
 }
 
@@ -721,25 +874,44 @@ void tdc_deinit_share(TABLE_SHARE *share)
   Caller is expected to unlock table share with tdc_unlock_share().
 
   @retval  0 Share not found
-  @retval !0 Pointer to locked table share 
+  @retval !0 Pointer to locked table share
 */
 
 TABLE_SHARE *tdc_lock_share(const char *db, const char *table_name)
 {
+  THD *thd= current_thd;
+  TDC_element *element;
+  TABLE_SHARE *share= 0;
+  LF_PINS *pins;
   char key[MAX_DBKEY_LENGTH];
   uint key_length;
 
   DBUG_ENTER("tdc_lock_share");
+  if (!(pins= tdc_get_pins(thd)))
+    DBUG_RETURN(0);
   key_length= tdc_create_key(key, db, table_name);
 
-  mysql_rwlock_rdlock(&LOCK_tdc);
-  TABLE_SHARE* share= (TABLE_SHARE*) my_hash_search(&tdc_hash,
-                                                    (uchar*) key, key_length);
-  if (share && !share->error)
-    mysql_mutex_lock(&share->tdc.LOCK_table_share);
-  else
-    share= 0;
-  mysql_rwlock_unlock(&LOCK_tdc);
+retry:
+  element= (TDC_element*) lf_hash_search(&tdc_hash, pins, key, key_length);
+  if (element && element != MY_ERRPTR)
+  {
+    mysql_mutex_lock(&element->LOCK_table_share);
+    if (!(share= element->share))
+    {
+      /* The element is being deleted, look it up again. */
+      mysql_mutex_unlock(&element->LOCK_table_share);
+      lf_hash_search_unpin(pins);
+      goto retry;
+    }
+    /* Share being loaded is not complete yet, don't wait for it. */
+    if (element->m_loading || share->error)
+    {
+      mysql_mutex_unlock(&element->LOCK_table_share);
+      share= 0;
+    }
+  }
+  lf_hash_search_unpin(pins);
+  tdc_put_pins(thd, pins);
   DBUG_RETURN(share);
 }
 
@@ -751,7 +923,7 @@ TABLE_SHARE *tdc_lock_share(const char *db, const char *table_name)
 void tdc_unlock_share(TABLE_SHARE *share)
 {
   DBUG_ENTER("tdc_unlock_share");
-  mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+  mysql_mutex_unlock(&share->tdc->LOCK_table_share);
   DBUG_VOID_RETURN;
 }
 
@@ -770,6 +942,9 @@ void tdc_unlock_share(TABLE_SHARE *share)
     Get a table definition from the table definition cache.
     If it doesn't exist, create a new from the table definition file.
 
+    The new share is inserted to the cache before it is read, so that
+    concurrent threads wait for it instead of reading it too.
+
   RETURN
    0  Error
    #  Share for table
@@ -780,63 +955,72 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
                                TABLE **out_table)
 {
   TABLE_SHARE *share;
+  TDC_element *element;
+  LF_PINS *pins;
   bool was_unused;
-  my_hash_value_type hash_value;
   DBUG_ENTER("tdc_acquire_share");
 
-  hash_value= my_calc_hash(&tdc_hash, (uchar*) key, key_length);
+  if (!(pins= tdc_get_pins(thd)))
+    DBUG_RETURN(0);
 
-  mysql_rwlock_rdlock(&LOCK_tdc);
-  share= (TABLE_SHARE*) my_hash_search_using_hash_value(&tdc_hash, hash_value,
-                                                        (uchar*) key,
-                                                        key_length);
-  if (!share)
+retry:
+  element= (TDC_element*) lf_hash_search(&tdc_hash, pins, key, key_length);
+  if (element == MY_ERRPTR)
   {
-    TABLE_SHARE *new_share;
-    mysql_rwlock_unlock(&LOCK_tdc);
+    tdc_put_pins(thd, pins);
+    DBUG_RETURN(0);
+  }
+  if (!element)
+  {
+    TDC_element new_element;
+    int res;
 
-    if (!(new_share= alloc_table_share(db, table_name, key, key_length)))
+    if (!(share= alloc_table_share(db, table_name, key, key_length)))
+    {
+      tdc_put_pins(thd, pins);
       DBUG_RETURN(0);
-    new_share->error= OPEN_FRM_OPEN_ERROR;
+    }
+    share->error= OPEN_FRM_OPEN_ERROR;
 
-    mysql_rwlock_wrlock(&LOCK_tdc);
-    share= (TABLE_SHARE*) my_hash_search_using_hash_value(&tdc_hash, hash_value,
-                                                          (uchar*) key,
-                                                          key_length);
-    if (!share)
+    memcpy(new_element.m_key, key, key_length);
+    new_element.m_key_length= key_length;
+    new_element.share= share;
+    new_element.m_loading= true;
+    if ((res= lf_hash_insert(&tdc_hash, pins, &new_element)))
     {
-      bool need_purge;
-
-      share= new_share;
-      mysql_mutex_lock(&share->tdc.LOCK_table_share);
-      if (my_hash_insert(&tdc_hash, (uchar*) share))
-      {
-        mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-        mysql_rwlock_unlock(&LOCK_tdc);
-        free_table_share(share);
-        DBUG_RETURN(0);
-      }
-      need_purge= tdc_hash.records > tdc_size;
-      mysql_rwlock_unlock(&LOCK_tdc);
-
-      /* note that tdc_acquire_share() *always* uses discovery */
-      open_table_def(thd, share, flags | GTS_USE_DISCOVERY);
-      share->tdc.ref_count++;
-      mysql_mutex_unlock(&share->tdc.LOCK_table_share);
-
-      if (share->error)
-      {
-        tdc_delete_share_from_hash(share);
-        DBUG_RETURN(0);
-      }
-      else if (need_purge)
-        tdc_purge(false);
-      if (out_table)
-        *out_table= 0;
-      share->m_psi= PSI_CALL_get_table_share(false, share);
-      goto end;
+      free_table_share(share);
+      /* Concurrent thread inserted the same share, use it. */
+      if (res > 0)
+        goto retry;
+      tdc_put_pins(thd, pins);
+      DBUG_RETURN(0);
     }
-    free_table_share(new_share);
+    /* Elements being loaded are never deleted, so it must be there. */
+    element= (TDC_element*) lf_hash_search(&tdc_hash, pins, key, key_length);
+    lf_hash_search_unpin(pins);
+    tdc_put_pins(thd, pins);
+    DBUG_ASSERT(element && element != MY_ERRPTR && element->share == share);
+    share->tdc= element;
+
+    /* note that tdc_acquire_share() *always* uses discovery */
+    open_table_def(thd, share, flags | GTS_USE_DISCOVERY);
+
+    mysql_mutex_lock(&element->LOCK_table_share);
+    element->m_loading= false;
+    element->ref_count++;
+    mysql_cond_broadcast(&element->COND_release);
+    if (share->error)
+    {
+      tdc_delete_share_from_hash(element);
+      DBUG_RETURN(0);
+    }
+    mysql_mutex_unlock(&element->LOCK_table_share);
+
+    tdc_purge(false);
+    if (out_table)
+      *out_table= 0;
+    share->m_psi= PSI_CALL_get_table_share(false, share);
+    goto end;
   }
 
   /* cannot force discovery of a cached share */
@@ -844,8 +1028,11 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
 
   if (out_table && (flags & GTS_TABLE))
   {
-    if ((*out_table= tc_acquire_table(thd, share)))
+    if ((*out_table= tc_acquire_table(thd, element)))
     {
+      lf_hash_search_unpin(pins);
+      tdc_put_pins(thd, pins);
+      share= (*out_table)->s;
       DBUG_ASSERT(!(flags & GTS_NOLOCK));
       DBUG_ASSERT(!share->error);
       DBUG_ASSERT(!share->is_view);
@@ -853,8 +1040,18 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
     }
   }
 
-  mysql_mutex_lock(&share->tdc.LOCK_table_share);
-  mysql_rwlock_unlock(&LOCK_tdc);
+  mysql_mutex_lock(&element->LOCK_table_share);
+  while (element->m_loading)
+    mysql_cond_wait(&element->COND_release, &element->LOCK_table_share);
+  if (!(share= element->share))
+  {
+    /* The element is being deleted, look it up again. */
+    mysql_mutex_unlock(&element->LOCK_table_share);
+    lf_hash_search_unpin(pins);
+    goto retry;
+  }
+  lf_hash_search_unpin(pins);
+  tdc_put_pins(thd, pins);
 
   /*
      We found an existing table definition. Return it if we didn't get
@@ -877,30 +1074,30 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
     goto err;
   }
 
-  was_unused= !share->tdc.ref_count;
-  share->tdc.ref_count++;
-  mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+  was_unused= !element->ref_count;
+  element->ref_count++;
+  mysql_mutex_unlock(&element->LOCK_table_share);
   if (was_unused)
   {
     mysql_mutex_lock(&LOCK_unused_shares);
-    if (share->tdc.prev)
+    if (element->prev)
     {
       /*
         Share was not used before and it was in the old_unused_share list
         Unlink share from this list
       */
       DBUG_PRINT("info", ("Unlinking from not used list"));
-      *share->tdc.prev= share->tdc.next;
-      share->tdc.next->tdc.prev= share->tdc.prev;
-      share->tdc.next= 0;
-      share->tdc.prev= 0;
-    } 
+      *element->prev= element->next;
+      element->next->prev= element->prev;
+      element->next= 0;
+      element->prev= 0;
+    }
     mysql_mutex_unlock(&LOCK_unused_shares);
   }
 
 end:
   DBUG_PRINT("exit", ("share: 0x%lx  ref_count: %u",
-                      (ulong) share, share->tdc.ref_count));
+                      (ulong) share, share->tdc->ref_count));
   if (flags & GTS_NOLOCK)
   {
     tdc_release_share(share);
@@ -916,7 +1113,7 @@ end:
   DBUG_RETURN(share);
 
 err:
-  mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+  mysql_mutex_unlock(&element->LOCK_table_share);
   DBUG_RETURN(0);
 }
 
@@ -927,46 +1124,46 @@ err:
 
 void tdc_release_share(TABLE_SHARE *share)
 {
+  TDC_element *element= share->tdc;
   DBUG_ENTER("tdc_release_share");
-  
-  mysql_mutex_lock(&share->tdc.LOCK_table_share);
+
+  mysql_mutex_lock(&element->LOCK_table_share);
   DBUG_PRINT("enter",
              ("share: 0x%lx  table: %s.%s  ref_count: %u  version: %lu",
               (ulong) share, share->db.str, share->table_name.str,
-              share->tdc.ref_count, share->version));
-  DBUG_ASSERT(share->tdc.ref_count);
+              element->ref_count, share->version));
+  DBUG_ASSERT(element->ref_count);
 
-  if (share->tdc.ref_count > 1)
+  if (element->ref_count > 1)
   {
-    share->tdc.ref_count--;
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+    element->ref_count--;
+    mysql_mutex_unlock(&element->LOCK_table_share);
     DBUG_VOID_RETURN;
   }
-  mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+  mysql_mutex_unlock(&element->LOCK_table_share);
 
   mysql_mutex_lock(&LOCK_unused_shares);
-  mysql_mutex_lock(&share->tdc.LOCK_table_share);
+  mysql_mutex_lock(&element->LOCK_table_share);
   if (share->has_old_version())
   {
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
     mysql_mutex_unlock(&LOCK_unused_shares);
-    tdc_delete_share_from_hash(share);
+    tdc_delete_share_from_hash(element);
     DBUG_VOID_RETURN;
   }
-  if (--share->tdc.ref_count)
+  if (--element->ref_count)
   {
-    mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+    mysql_mutex_unlock(&element->LOCK_table_share);
     mysql_mutex_unlock(&LOCK_unused_shares);
     DBUG_VOID_RETURN;
   }
   /* Link share last in used_table_share list */
   DBUG_PRINT("info", ("moving share to unused list"));
-  DBUG_ASSERT(share->tdc.next == 0);
-  share->tdc.prev= end_of_unused_share.tdc.prev;
-  *end_of_unused_share.tdc.prev= share;
-  end_of_unused_share.tdc.prev= &share->tdc.next;
-  share->tdc.next= &end_of_unused_share;
-  mysql_mutex_unlock(&share->tdc.LOCK_table_share);
+  DBUG_ASSERT(element->next == 0);
+  element->prev= end_of_unused_share.prev;
+  *end_of_unused_share.prev= element;
+  end_of_unused_share.prev= &element->next;
+  element->next= &end_of_unused_share;
+  mysql_mutex_unlock(&element->LOCK_table_share);
   mysql_mutex_unlock(&LOCK_unused_shares);
 
   /* Delete the least used share to preserve LRU order. */
@@ -982,8 +1179,9 @@ static TABLE_SHARE *tdc_delete_share(const char *db, const char *table_name)
 
   while ((share= tdc_lock_share(db, table_name)))
   {
-    share->tdc.ref_count++;
-    if (share->tdc.ref_count > 1)
+    TDC_element *element= share->tdc;
+    element->ref_count++;
+    if (element->ref_count > 1)
     {
       tdc_unlock_share(share);
       DBUG_RETURN(share);
@@ -991,17 +1189,18 @@ static TABLE_SHARE *tdc_delete_share(const char *db, const char *table_name)
     tdc_unlock_share(share);
 
     mysql_mutex_lock(&LOCK_unused_shares);
-    if (share->tdc.prev)
+    if (element->prev)
     {
-      *share->tdc.prev= share->tdc.next;
-      share->tdc.next->tdc.prev= share->tdc.prev;
+      *element->prev= element->next;
+      element->next->prev= element->prev;
       /* Concurrent thread may start using share again, reset prev and next. */
-      share->tdc.prev= 0;
-      share->tdc.next= 0;
-    } 
+      element->prev= 0;
+      element->next= 0;
+    }
     mysql_mutex_unlock(&LOCK_unused_shares);
 
-    if (!tdc_delete_share_from_hash(share))
+    mysql_mutex_lock(&element->LOCK_table_share);
+    if (!tdc_delete_share_from_hash(element))
       break;
   }
   DBUG_RETURN(0);
@@ -1063,22 +1262,23 @@ bool tdc_remove_table(THD *thd, enum_tdc_remove_table_type remove_type,
 
   if ((share= tdc_delete_share(db, table_name)))
   {
-    I_P_List <TABLE, TABLE_share> purge_tables;
-    purge_tables.empty();
+    TDC_element *element= share->tdc;
+    TABLE *purge_tables= 0;
 
-    mysql_mutex_lock(&LOCK_open);
+    tc_lock_all();
+    mysql_mutex_lock(&element->LOCK_table_share);
     if (kill_delayed_threads)
       kill_delayed_threads_for_table(share);
 
-    TABLE_SHARE::TABLE_list::Iterator it(share->tdc.free_tables);
 #ifndef DBUG_OFF
-    if (remove_type == TDC_RT_REMOVE_ALL)
-      DBUG_ASSERT(share->tdc.used_tables.is_empty());
-    else if (remove_type == TDC_RT_REMOVE_NOT_OWN)
+    if (remove_type == TDC_RT_REMOVE_ALL ||
+        remove_type == TDC_RT_REMOVE_NOT_OWN)
     {
-      TABLE_SHARE::TABLE_list::Iterator it2(share->tdc.used_tables);
-      while ((table= it2++))
-        DBUG_ASSERT(table->in_use == thd);
+      TABLE_SHARE::All_share_tables_list::Iterator it(element->all_tables);
+      while ((table= it++))
+        DBUG_ASSERT(!table->in_use ||
+                    (remove_type == TDC_RT_REMOVE_NOT_OWN &&
+                     table->in_use == thd));
     }
 #endif
     /*
@@ -1091,17 +1291,21 @@ bool tdc_remove_table(THD *thd, enum_tdc_remove_table_type remove_type,
     */
     if (remove_type != TDC_RT_REMOVE_NOT_OWN_KEEP_SHARE)
       share->version= 0;
+    mysql_mutex_unlock(&element->LOCK_table_share);
 
-    while ((table= it++))
+    for (uint i= 0; i < tc_instances; i++)
     {
-      tc_remove_table(table);
-      purge_tables.push_front(table);
+      while ((table= element->free_tables[i].front()))
+      {
+        tc_remove_table(table, i);
+        table->next= purge_tables;
+        purge_tables= table;
+      }
     }
     mysql_rwlock_rdlock(&LOCK_flush);
-    mysql_mutex_unlock(&LOCK_open);
+    tc_unlock_all();
 
-    while ((table= purge_tables.pop_front()))
-      intern_close_table(table);
+    tc_free_tables(purge_tables);
     mysql_rwlock_unlock(&LOCK_flush);
 
     check_unused(thd);
@@ -1176,50 +1380,35 @@ void tdc_increment_refresh_version(void)
 
 
 /**
-  Initialize table definition cache iterator.
-*/
+  Call action for each element of table definition cache.
 
-void TDC_iterator::init(void)
-{
-  DBUG_ENTER("TDC_iterator::init");
-  idx= 0;
-  mysql_rwlock_rdlock(&LOCK_tdc);
-  DBUG_VOID_RETURN;
-}
+  Elements are protected against reuse while action is called, but
+  action must lock TDC_element::LOCK_table_share and check that the
+  element holds a share which is not being loaded before looking at it.
+  Action must not call other table definition cache functions.
 
+  @param thd       Thread context (may be 0)
+  @param action    Called as action(TDC_element *element, void *argument),
+                   stops iteration by returning TRUE
+  @param argument  Passed to action
 
-/**
-  Deinitialize table definition cache iterator.
+  @retval 0 Iterated over all elements
+  @retval 1 Iteration was stopped by action, or out of memory
 */
 
-void TDC_iterator::deinit(void)
+int tdc_iterate(THD *thd, my_hash_walk_action action, void *argument)
 {
-  DBUG_ENTER("TDC_iterator::deinit");
-  mysql_rwlock_unlock(&LOCK_tdc);
-  DBUG_VOID_RETURN;
-}
-
-
-/**
-  Get next TABLE_SHARE object from table definition cache.
-
-  Object is protected against removal from table definition cache.
+  LF_PINS *pins;
+  int res;
+  DBUG_ENTER("tdc_iterate");
 
-  @note Returned TABLE_SHARE is not guaranteed to be fully initialized:
-  tdc_acquire_share() added new share, but didn't open it yet. If caller
-  needs fully initializer share, it must lock table share mutex.
-*/
-
-TABLE_SHARE *TDC_iterator::next(void)
-{
-  TABLE_SHARE *share= 0;
-  DBUG_ENTER("TDC_iterator::next");
-  if (idx < tdc_hash.records)
-  {
-    share= (TABLE_SHARE*) my_hash_element(&tdc_hash, idx);
-    idx++;
-  }
-  DBUG_RETURN(share);
+  if (!tdc_inited)
+    DBUG_RETURN(0);
+  if (!(pins= tdc_get_pins(thd)))
+    DBUG_RETURN(1);
+  res= lf_hash_iterate(&tdc_hash, pins, action, argument);
+  tdc_put_pins(thd, pins);
+  DBUG_RETURN(res);
 }
 
 
@@ -24,10 +24,58 @@ enum enum_tdc_remove_table_type
   TDC_RT_REMOVE_NOT_OWN_KEEP_SHARE
 };
 
+/** Maximum number of table cache instances, see tc_instances. */
+#define TC_MAX_INSTANCES 16
+
+
+/**
+  Table definition cache element.
+
+  Elements are kept in a lock-free hash. Memory of deleted elements is
+  only reused for other elements, never returned to the system while the
+  cache is in use, so a thread that found (and pinned) an element may
+  always lock it. Whether the element still holds a share must then be
+  checked under LOCK_table_share.
+*/
+
+struct TDC_element
+{
+  /* Copied by lf_hash_insert(), see tdc_hash.element_size. */
+  char m_key[MAX_DBKEY_LENGTH];
+  uint m_key_length;
+  /** 0 if the share is being removed from the hash. */
+  TABLE_SHARE *share;
+  /** share is being read by open_table_def(). */
+  bool m_loading;
+
+  /* Initialized once when element memory is allocated. */
+  /**
+    Protects share, m_loading, ref_count, m_flush_tickets and all_tables.
+  */
+  mysql_mutex_t LOCK_table_share;
+  /** Signalled when loading is done and when a flush ticket is removed. */
+  mysql_cond_t COND_release;
+  TDC_element *next, **prev;            /* Link to unused shares */
+  uint ref_count;                       /* How many TABLE objects uses this */
+  /**
+    List of tickets representing threads waiting for the share to be flushed.
+  */
+  Wait_for_flush_list m_flush_tickets;
+  /**
+    All TABLE objects of the share, used and unused. Modified while
+    holding both LOCK_table_share and a table cache instance lock.
+  */
+  TABLE_SHARE::All_share_tables_list all_tables;
+  /**
+    Unused TABLE objects of the share, one list per table cache instance.
+    Protected by LOCK_table_cache of the instance.
+  */
+  TABLE_SHARE::TABLE_list free_tables[TC_MAX_INSTANCES];
+};
+
+
 extern ulong tdc_size;
 extern ulong tc_size;
-extern TABLE *unused_tables;    /* FIXME: make private */
-extern mysql_mutex_t LOCK_open; /* FIXME: make private */
 
 extern int tdc_init(void);
 extern void tdc_start_shutdown(void);
@@ -52,11 +100,14 @@ extern int tdc_wait_for_old_version(THD *thd, const char *db,
 extern ulong tdc_refresh_version(void);
 extern void tdc_increment_refresh_version(void);
 extern void tdc_assign_new_table_id(TABLE_SHARE *share);
+extern int tdc_iterate(THD *thd, my_hash_walk_action action, void *argument);
 
 extern uint tc_records(void);
 extern void tc_purge(void);
 extern void tc_add_table(THD *thd, TABLE *table);
 extern bool tc_release_table(TABLE *table);
+extern void tc_lock_all(void);
+extern void tc_unlock_all(void);
 
 /**
   Create a table cache key for non-temporary table.
@@ -123,12 +174,3 @@ static inline TABLE_SHARE *tdc_acquire_share_shortlived(THD *thd, TABLE_LIST *tl
   return tdc_acquire_share(thd, tl->db, tl->table_name, key, key_length, flags);
 }
 
-
-class TDC_iterator
-{
-  ulong idx;
-public:
-  void init(void);
-  void deinit(void);
-  TABLE_SHARE *next(void);
-};
@@ -712,9 +712,9 @@ void tp_wait_begin(THD *thd, int type)
 
   /*
     Signal to the threadpool whenever callback can run long. Currently, binlog
-    waits are a good candidate, its waits are really long
+    and group commit waits are good candidates, their waits are really long
   */
-  if (type == THD_WAIT_BINLOG)
+  if (type == THD_WAIT_BINLOG || type == THD_WAIT_GROUP_COMMIT)
   {
     connection_t *connection= (connection_t *)thd->event_scheduler.data;
     if(connection && connection->callback_instance)
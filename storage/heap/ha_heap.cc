@@ -369,6 +369,27 @@ void ha_heap::position(const uchar *record)
   *(HEAP_PTR*) ref= heap_position(file);	// Ref is aligned
 }
 
+/*
+  Save the scan position, so that the scan can continue from the current
+  row after other rows have been read (used by remove_dup_with_compare()
+  for internal temporary tables with blobs).
+*/
+
+int ha_heap::remember_rnd_pos()
+{
+  saved_current_record= file->current_record;
+  saved_next_block= file->next_block;
+  saved_current_ptr= file->current_ptr;
+  return 0;
+}
+
+int ha_heap::restart_rnd_next(uchar *buf)
+{
+  file->current_record= saved_current_record;
+  file->next_block= saved_next_block;
+  return rnd_pos(buf, (uchar*) &saved_current_ptr);
+}
+
 int ha_heap::info(uint flag)
 {
   HEAPINFO hp_info;
@@ -614,6 +635,7 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   ha_rows max_rows;
   HP_KEYDEF *keydef;
   HA_KEYSEG *seg;
+  HP_BLOB_DESC *blob_desc;
   TABLE_SHARE *share= table_arg->s;
   bool found_real_auto_increment= 0;
 
@@ -623,10 +645,27 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
     parts+= table_arg->key_info[key].user_defined_key_parts;
 
   if (!(keydef= (HP_KEYDEF*) my_malloc(keys * sizeof(HP_KEYDEF) +
-				       parts * sizeof(HA_KEYSEG),
+				       parts * sizeof(HA_KEYSEG) +
+                                       share->blob_fields *
+                                       sizeof(HP_BLOB_DESC),
 				       MYF(MY_WME | MY_THREAD_SPECIFIC))))
     return my_errno;
   seg= reinterpret_cast<HA_KEYSEG*>(keydef + keys);
+  blob_desc= reinterpret_cast<HP_BLOB_DESC*>(seg + parts);
+
+  /*
+    Blobs are only created for internal temporary tables, as the
+    handler reports HA_NO_BLOBS for other tables. Their values are
+    stored outside of the fixed-size row, see hp_blob.c.
+  */
+  for (uint i= 0; i < share->blob_fields; i++)
+  {
+    Field_blob *field= (Field_blob*) table_arg->field[share->blob_field[i]];
+    blob_desc[i].offset= (uint) (field->ptr - table_arg->record[0]);
+    blob_desc[i].packlength= field->pack_length_no_ptr();
+  }
+  hp_create_info->blob_descs= blob_desc;
+  hp_create_info->blobs= share->blob_fields;
   for (key= 0; key < keys; key++)
   {
     KEY *pos= table_arg->key_info+key;
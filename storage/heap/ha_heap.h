@@ -34,6 +34,9 @@ class ha_heap: public handler
   uint    records_changed;
   uint    key_stat_version;
   my_bool internal_table;
+  /* Scan position saved by remember_rnd_pos() */
+  ulong   saved_current_record, saved_next_block;
+  uchar   *saved_current_ptr;
 public:
   ha_heap(handlerton *hton, TABLE_SHARE *table);
   ~ha_heap() {}
@@ -91,6 +94,8 @@ public:
   int rnd_next(uchar *buf);
   int rnd_pos(uchar * buf, uchar *pos);
   void position(const uchar *record);
+  int remember_rnd_pos();
+  int restart_rnd_next(uchar *buf);
   int can_continue_handler_scan();
   int info(uint);
   int extra(enum ha_extra_function operation);
@@ -0,0 +1,229 @@
+/* Copyright (c) 2013, Monty Program Ab.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA */
+
+/*
+  Storage of blob values for heap tables
+
+  The fixed-size part of a row is stored in share->block as for any other
+  heap table. A blob column in that part holds, as in the server record
+  format, the length of the value followed by a pointer to the data.
+  For a stored row the pointer refers to a copy of the value that is owned
+  by the table, so the row can be returned to the caller with a plain
+  memcpy() and the value stays valid until the row is updated or deleted.
+  The memory used by the copies is accounted in share->data_length.
+*/
+
+#include "heapdef.h"
+
+static ulong hp_blob_length(HP_BLOB_DESC *blob, const uchar *record)
+{
+  const uchar *pos= record + blob->offset;
+  switch (blob->packlength) {
+  case 1:
+    return (ulong) *pos;
+  case 2:
+    return (ulong) uint2korr(pos);
+  case 3:
+    return (ulong) uint3korr(pos);
+  case 4:
+    return (ulong) uint4korr(pos);
+  default:
+    DBUG_ASSERT(0);
+    break;
+  }
+  return 0;
+}
+
+
+static uchar *hp_blob_data(HP_BLOB_DESC *blob, const uchar *record)
+{
+  uchar *data;
+  memcpy(&data, record + blob->offset + blob->packlength, sizeof(data));
+  return data;
+}
+
+
+/*
+  Make table owned copies of all blob values in a record
+
+  SYNOPSIS
+    hp_copy_blobs()
+    share       Heap table
+    record      Record whose blob values should be copied
+    copies      Store pointers to the copies here, one for each blob column.
+                Empty values get a null pointer.
+    check_size  Fail if the copies would make the table exceed
+                max_table_size.
+    replaced    Row whose blob values are freed once the copies are
+                stored (update), or 0. Only the growth over its values
+                counts against max_table_size.
+
+  NOTES
+    Nothing is changed in the table rows, so the copies can be made before
+    any key is written. Use hp_store_blobs() to attach the copies to a row,
+    or hp_free_blob_copies() to give them back on error.
+
+  RETURN
+    0   ok
+    #   error number. HA_ERR_RECORD_FILE_FULL if check_size is set and
+        the values would make the table exceed max_table_size.
+*/
+
+int hp_copy_blobs(HP_SHARE *share, const uchar *record, uchar **copies,
+                  my_bool check_size, const uchar *replaced)
+{
+  HP_BLOB_DESC *blob, *end;
+  uchar **copy;
+  ulonglong replaced_length= 0;
+  DBUG_ENTER("hp_copy_blobs");
+
+  if (replaced)
+  {
+    for (blob= share->blob_descs, end= blob + share->blobs; blob < end;
+         blob++)
+      replaced_length+= hp_blob_length(blob, replaced);
+  }
+  for (blob= share->blob_descs, end= blob + share->blobs, copy= copies;
+       blob < end; blob++, copy++)
+  {
+    ulong length= hp_blob_length(blob, record);
+    *copy= 0;
+    if (!length)
+      continue;
+    if (check_size &&
+        share->data_length + share->index_length + length >
+        share->max_table_size + replaced_length)
+    {
+      DBUG_PRINT("error",
+                 ("record file full. blob length: %lu  data_length: %llu  "
+                  "index_length: %llu  max_table_size: %llu",
+                  length, share->data_length, share->index_length,
+                  share->max_table_size));
+      my_errno= HA_ERR_RECORD_FILE_FULL;
+      goto err;
+    }
+    if (!(*copy= (uchar*) my_malloc(length,
+                                    MYF(MY_WME |
+                                        (share->internal ?
+                                         MY_THREAD_SPECIFIC : 0)))))
+      goto err;
+    memcpy(*copy, hp_blob_data(blob, record), length);
+    share->data_length+= length;
+  }
+  DBUG_RETURN(0);
+
+err:
+  hp_free_blob_copies(share, record, copies,
+                      (uint) (blob - share->blob_descs));
+  DBUG_RETURN(my_errno);
+}
+
+
+/*
+  Give back copies made by hp_copy_blobs() that were not stored in a row
+
+  SYNOPSIS
+    hp_free_blob_copies()
+    share       Heap table
+    record      Record the copies were made from
+    copies      Copies to free
+    count       Number of blob columns for which copies were made
+*/
+
+void hp_free_blob_copies(HP_SHARE *share, const uchar *record, uchar **copies,
+                         uint count)
+{
+  HP_BLOB_DESC *blob, *end;
+  for (blob= share->blob_descs, end= blob + count; blob < end;
+       blob++, copies++)
+  {
+    if (*copies)
+    {
+      share->data_length-= hp_blob_length(blob, record);
+      my_free(*copies);
+    }
+  }
+}
+
+
+/*
+  Make a row point to the copies made by hp_copy_blobs()
+
+  SYNOPSIS
+    hp_store_blobs()
+    share       Heap table
+    pos         Row in share->block. Must already contain the record the
+                copies were made from.
+    copies      Copies from hp_copy_blobs()
+*/
+
+void hp_store_blobs(HP_SHARE *share, uchar *pos, uchar **copies)
+{
+  HP_BLOB_DESC *blob, *end;
+  for (blob= share->blob_descs, end= blob + share->blobs; blob < end;
+       blob++, copies++)
+    memcpy(pos + blob->offset + blob->packlength, copies, sizeof(*copies));
+}
+
+
+/*
+  Free the blob values owned by a row
+
+  SYNOPSIS
+    hp_free_blobs()
+    share       Heap table
+    pos         Row in share->block
+*/
+
+void hp_free_blobs(HP_SHARE *share, uchar *pos)
+{
+  HP_BLOB_DESC *blob, *end;
+  for (blob= share->blob_descs, end= blob + share->blobs; blob < end; blob++)
+  {
+    uchar *data= hp_blob_data(blob, pos);
+    if (data)
+    {
+      share->data_length-= hp_blob_length(blob, pos);
+      my_free(data);
+    }
+  }
+}
+
+
+/*
+  Free the blob values of all rows in the table
+
+  SYNOPSIS
+    hp_free_all_blobs()
+    share       Heap table
+
+  NOTES
+    Used when all rows are removed at once. Deleted rows have already had
+    their values freed by heap_delete().
+*/
+
+void hp_free_all_blobs(HP_SHARE *share)
+{
+  ulong pos, end= share->records + share->deleted;
+  DBUG_ENTER("hp_free_all_blobs");
+
+  for (pos= 0; pos < end; pos++)
+  {
+    uchar *record= hp_find_block(&share->block, pos);
+    if (record[share->reclength])
+      hp_free_blobs(share, record);
+  }
+  DBUG_VOID_RETURN;
+}
@@ -30,8 +30,9 @@ HP_INFO *heap_open_from_share(HP_SHARE *share, int mode)
   HP_INFO *info;
   DBUG_ENTER("heap_open_from_share");
 
-  if (!(info= (HP_INFO*) my_malloc((uint) sizeof(HP_INFO) +
-				  2 * share->max_key_length,
+  if (!(info= (HP_INFO*) my_malloc((uint) ALIGN_SIZE(sizeof(HP_INFO) +
+                                                   2 * share->max_key_length) +
+                                   share->blobs * sizeof(uchar*),
                                    MYF(MY_ZEROFILL +
                                        (share->internal ?
                                         MY_THREAD_SPECIFIC : 0)))))
@@ -43,6 +44,9 @@ HP_INFO *heap_open_from_share(HP_SHARE *share, int mode)
   info->s= share;
   info->lastkey= (uchar*) (info + 1);
   info->recbuf= (uchar*) (info->lastkey + share->max_key_length);
+  info->blob_copies= (uchar**) ((uchar*) info +
+                                ALIGN_SIZE(sizeof(HP_INFO) +
+                                           2 * share->max_key_length));
   info->mode= mode;
   info->current_record= (ulong) ~0L;		/* No current record */
   info->lastinx= info->errkey= -1;
@@ -30,6 +30,13 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 
   if (info->opt_flag & READ_CHECK_USED && hp_rectest(info,old))
     DBUG_RETURN(my_errno);				/* Record changed */
+  /*
+    Copy the new blob values before anything is changed; the new record
+    may point to the values owned by the row we are updating.
+  */
+  if (share->blobs &&
+      hp_copy_blobs(share, heap_new, info->blob_copies, 1, pos))
+    DBUG_RETURN(my_errno);
   if (--(share->records) < share->blength >> 1) share->blength>>= 1;
   share->changed=1;
 
@@ -46,7 +53,14 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
     }
   }
 
-  memcpy(pos,heap_new,(size_t) share->reclength);
+  if (share->blobs)
+  {
+    hp_free_blobs(share, pos);
+    memcpy(pos,heap_new,(size_t) share->reclength);
+    hp_store_blobs(share, pos, info->blob_copies);
+  }
+  else
+    memcpy(pos,heap_new,(size_t) share->reclength);
   if (++(share->records) == share->blength) share->blength+= share->blength;
 
 #if !defined(DBUG_OFF) && defined(EXTRA_HEAP_DEBUG)
@@ -67,6 +81,9 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
       /* we don't need to delete non-inserted key from rb-tree */
       if ((*keydef->write_key)(info, keydef, old, pos))
       {
+        if (share->blobs)
+          hp_free_blob_copies(share, heap_new, info->blob_copies,
+                              share->blobs);
         if (++(share->records) == share->blength)
 	  share->blength+= share->blength;
         DBUG_RETURN(my_errno);
@@ -84,6 +101,8 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
       keydef--;
     }
   }
+  if (share->blobs)
+    hp_free_blob_copies(share, heap_new, info->blob_copies, share->blobs);
   if (++(share->records) == share->blength)
     share->blength+= share->blength;
   DBUG_RETURN(my_errno);
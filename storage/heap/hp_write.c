@@ -44,6 +44,14 @@ int heap_write(HP_INFO *info, const uchar *record)
 #endif
   if (!(pos=next_free_record_pos(share)))
     DBUG_RETURN(my_errno);
+  if (share->blobs && hp_copy_blobs(share, record, info->blob_copies, 1, 0))
+  {
+    share->deleted++;
+    *((uchar**) pos)=share->del_link;
+    share->del_link=pos;
+    pos[share->reclength]=0;			/* Record deleted */
+    DBUG_RETURN(my_errno);
+  }
   share->changed=1;
 
   for (keydef = share->keydef, end = keydef + share->keys; keydef < end;
@@ -54,6 +62,8 @@ int heap_write(HP_INFO *info, const uchar *record)
   }
 
   memcpy(pos,record,(size_t) share->reclength);
+  if (share->blobs)
+    hp_store_blobs(share, pos, info->blob_copies);
   pos[share->reclength]=1;		/* Mark record as not deleted */
   if (++share->records == share->blength)
     share->blength+= share->blength;
@@ -89,6 +99,8 @@ err:
     keydef--;
   } 
 
+  if (share->blobs)
+    hp_free_blob_copies(share, record, info->blob_copies, share->blobs);
   share->deleted++;
   *((uchar**) pos)=share->del_link;
   share->del_link=pos;
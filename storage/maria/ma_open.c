@@ -902,6 +902,7 @@ MARIA_HA *maria_open(const char *name, int mode, uint open_flags)
       }
     }
     thr_lock_init(&share->lock);
+    share->lock.allow_fast_read= 1;
     mysql_mutex_init(key_SHARE_intern_lock,
                      &share->intern_lock, MY_MUTEX_INIT_FAST);
     mysql_mutex_init(key_SHARE_key_del_lock,
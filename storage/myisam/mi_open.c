@@ -534,6 +534,7 @@ MI_INFO *mi_open(const char *name, int mode, uint open_flags)
     mi_setup_functions(share);
     share->is_log_table= FALSE;
     thr_lock_init(&share->lock);
+    share->lock.allow_fast_read= 1;
     mysql_mutex_init(mi_key_mutex_MYISAM_SHARE_intern_lock,
                      &share->intern_lock, MY_MUTEX_INIT_FAST);
     for (i=0; i<keys; i++)
@@ -36,6 +36,13 @@ const char _dig_vec_upper[] =
 const char _dig_vec_lower[] =
   "0123456789abcdefghijklmnopqrstuvwxyz";
 
+/* Two decimal digits for each number 0..99, used by int10_to_str() */
+static const char dig_pairs[]=
+  "00010203040506070809101112131415161718192021222324"
+  "25262728293031323334353637383940414243444546474849"
+  "50515253545556575859606162636465666768697071727374"
+  "75767778798081828384858687888990919293949596979899";
+
 
 /*
   Convert integer to its string representation in given scale of notation.
@@ -146,7 +153,7 @@ char *int10_to_str(long int val,char *dst,int radix)
 {
   char buffer[65];
   register char *p;
-  long int new_val;
+  size_t length;
   unsigned long int uval = (unsigned long int) val;
 
   if (radix < 0)				/* -10 */
@@ -159,18 +166,28 @@ char *int10_to_str(long int val,char *dst,int radix)
     }
   }
 
+  /* Produce two digits per division, the divisions are the slow part */
   p = &buffer[sizeof(buffer)-1];
   *p = '\0';
-  new_val= (long) (uval / 10);
-  *--p = '0'+ (char) (uval - (unsigned long) new_val * 10);
-  val = new_val;
-
-  while (val != 0)
+  while (uval >= 100)
   {
-    new_val=val/10;
-    *--p = '0' + (char) (val-new_val*10);
-    val= new_val;
+    unsigned long int new_val= uval / 100;
+    uint rem= (uint) (uval - new_val * 100);
+    p-= 2;
+    p[0]= dig_pairs[rem * 2];
+    p[1]= dig_pairs[rem * 2 + 1];
+    uval= new_val;
   }
-  while ((*dst++ = *p++) != 0) ;
-  return dst-1;
+  if (uval >= 10)
+  {
+    p-= 2;
+    p[0]= dig_pairs[uval * 2];
+    p[1]= dig_pairs[uval * 2 + 1];
+  }
+  else
+    *--p = '0' + (char) uval;
+
+  length= (size_t) (&buffer[sizeof(buffer)-1] - p);
+  memcpy(dst, p, length + 1);
+  return dst + length;
 }
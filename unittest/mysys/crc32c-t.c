@@ -0,0 +1,57 @@
+/* Copyright (c) 2014, MariaDB
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <tap.h>
+#include <string.h>
+
+#define CRC32C_LOOP_COUNT 200
+
+int
+main(int argc __attribute__((unused)),char *argv[])
+{
+  uchar buf[1024];
+  int i;
+  MY_INIT(argv[0]);
+
+  plan(4 + CRC32C_LOOP_COUNT);
+
+  /* Check values from RFC 3720, appendix B.4 */
+  ok(my_crc32c(0, NULL, 0) == 0, "empty buffer");
+  ok(my_crc32c(0, (uchar*) "123456789", 9) == 0xE3069283, "123456789");
+  memset(buf, 0, 32);
+  ok(my_crc32c(0, buf, 32) == 0x8A9136AA, "32 bytes of zeroes");
+  memset(buf, 0xFF, 32);
+  ok(my_crc32c(0, buf, 32) == 0x62A8AB43, "32 bytes of ones");
+
+  /* A checksum computed in pieces must match the one computed at once */
+  for (i= 0; i < CRC32C_LOOP_COUNT; i++)
+  {
+    size_t j, len= rand() % (sizeof(buf) - 1) + 1;
+    size_t start= rand() % len, split= start + rand() % (len - start + 1);
+    ha_checksum crc;
+
+    for (j= 0; j < len; j++)
+      buf[j]= (uchar) rand();
+    crc= my_crc32c(0, buf + start, split - start);
+    crc= my_crc32c(crc, buf + split, len - split);
+    ok(crc == my_crc32c(0, buf + start, len - start),
+       "split at %u of %u", (uint) (split - start), (uint) (len - start));
+  }
+
+  my_end(0);
+  return exit_status();
+}
@@ -23,7 +23,7 @@
 
 #include <lf.h>
 
-int32 inserts= 0, N;
+int32 inserts= 0, N, bench_count= 0;
 LF_ALLOCATOR lf_allocator;
 LF_HASH lf_hash;
 
@@ -167,9 +167,134 @@ pthread_handler_t test_lf_hash(void *arg)
 }
 
 
+/*
+  lf_hash benchmark - a read-mostly mix of searches, inserts and deletes
+  on a hash that stays about the same size, like the table cache or the
+  performance schema hashes see it
+*/
+#define N_BENCH_KEYS 10000
+pthread_handler_t test_lf_hash_bench(void *arg)
+{
+  int    m= *(int *)arg * 10;
+  int32 x, z, count= 0;
+  LF_PINS *pins;
+
+  pins= lf_hash_get_pins(&lf_hash);
+
+  for (x= ((int)(intptr)(&m)); m ; m--)
+  {
+    x= (x*m+0x87654321) & INT_MAX32;
+    z= x % N_BENCH_KEYS;
+    switch (x % 20) {
+    case 0:
+      if (!lf_hash_insert(&lf_hash, pins, &z))
+        count++;
+      break;
+    case 1:
+      if (!lf_hash_delete(&lf_hash, pins, (uchar *)&z, sizeof(z)))
+        count--;
+      break;
+    default:
+    {
+      int32 *found= lf_hash_search(&lf_hash, pins, &z, sizeof(z));
+      if (found && found != MY_ERRPTR && *found != z)
+        bad|= 1;
+      lf_hash_search_unpin(pins);
+    }
+    }
+  }
+  lf_hash_put_pins(pins);
+  pthread_mutex_lock(&mutex);
+  bench_count+= count;
+  if (!--running_threads) pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+void test_lf_hash_benchmark()
+{
+  int32 i;
+  ulonglong now;
+  LF_PINS *pins= lf_hash_get_pins(&lf_hash);
+
+  for (i= 0; i < N_BENCH_KEYS; i+= 2)
+    lf_hash_insert(&lf_hash, pins, &i);
+  bench_count= lf_hash.count;
+
+  now= my_interval_timer();
+  test_concurrently("lf_hash benchmark", test_lf_hash_bench, THREADS,
+                    CYCLES);
+  now= my_interval_timer() - now;
+  diag("%g operations per second, %d mallocs, %d pins in stack",
+       THREADS * CYCLES * 10 / (now / 1e9), lf_hash.alloc.mallocs,
+       lf_hash.alloc.pinbox.pins_in_array);
+  ok(lf_hash.count == bench_count, "lf_hash benchmark: %d elements, "
+     "expected %d", lf_hash.count, bench_count);
+
+  for (i= 0; i < N_BENCH_KEYS; i++)
+    lf_hash_delete(&lf_hash, pins, (uchar *) &i, sizeof(i));
+  lf_hash_put_pins(pins);
+}
+
+
+/*
+  an object that is still pinned by another thread when its owner puts
+  the pins back is freed by a later purgatory scan
+*/
+void test_lf_pinbox_orphans()
+{
+  LF_PINS *pins1, *pins2;
+  TLA *node, *nodes[LF_PURGATORY_SIZE];
+  void *el;
+  int i;
+
+  pins1= lf_alloc_get_pins(&lf_allocator);
+  pins2= lf_alloc_get_pins(&lf_allocator);
+  node= (TLA *)lf_alloc_new(pins1);
+  lf_pin(pins2, 0, node);
+  lf_alloc_free(pins1, node);
+  lf_alloc_put_pins(pins1);
+  lf_unpin(pins2, 0);
+
+  for (i= 0; i < LF_PURGATORY_SIZE; i++)
+    nodes[i]= (TLA *)lf_alloc_new(pins2);
+  for (i= 0; i < LF_PURGATORY_SIZE; i++)
+    lf_alloc_free(pins2, nodes[i]);
+  lf_alloc_put_pins(pins2);
+
+  for (el= lf_allocator.top; el && el != node; el= ((TLA *)el)->not_used)
+    /* no op */;
+  ok(el == node, "lf_pinbox: pinned object freed after put_pins");
+}
+
+
+/*
+  lf_hash_iterate() - visit all elements of a hash
+*/
+static my_bool sum_element(void *element, void *arg)
+{
+  *(int32 *) arg+= *(int32 *) element;
+  return 0;
+}
+
+void test_lf_hash_iterate()
+{
+  int32 i, sum= 0;
+  LF_PINS *pins= lf_hash_get_pins(&lf_hash);
+
+  for (i= 1; i <= 100; i++)
+    lf_hash_insert(&lf_hash, pins, &i);
+  lf_hash_iterate(&lf_hash, pins, sum_element, &sum);
+  for (i= 1; i <= 100; i++)
+    lf_hash_delete(&lf_hash, pins, (uchar *) &i, sizeof(i));
+  lf_hash_put_pins(pins);
+  ok(sum == 5050 && !lf_hash.count, "lf_hash_iterate: sum %d", sum);
+}
+
+
 void do_tests()
 {
-  plan(7);
+  plan(11);
 
   lf_alloc_init(&lf_allocator, sizeof(TLA), offsetof(TLA, not_used));
   lf_hash_init(&lf_hash, sizeof(int), LF_HASH_UNIQUE, 0, sizeof(int), 0,
@@ -187,6 +312,9 @@ void do_tests()
   test_concurrently("lf_pinbox (without my_thread_init)", test_lf_pinbox, N= THREADS, CYCLES);
   test_concurrently("lf_alloc (without my_thread_init)",  test_lf_alloc,  N= THREADS, CYCLES);
   test_concurrently("lf_hash (without my_thread_init)",   test_lf_hash,   N= THREADS, CYCLES/10);
+  test_lf_hash_iterate();
+  test_lf_pinbox_orphans();
+  test_lf_hash_benchmark();
 
   lf_hash_destroy(&lf_hash);
   lf_alloc_destroy(&lf_allocator);
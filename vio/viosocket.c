@@ -1219,8 +1219,6 @@ my_bool vio_is_connected(Vio *vio)
   DBUG_RETURN(bytes ? TRUE : FALSE);
 }
 
-#ifndef DBUG_OFF
-
 /**
   Number of bytes in the read or socket buffer
 
@@ -1253,8 +1251,6 @@ ssize_t vio_pending(Vio *vio)
   return (ssize_t) bytes;
 }
 
-#endif /* DBUG_OFF */
-
 /**
   Checks if the error code, returned by vio_getnameinfo(), means it was the
   "No-name" error.